@@ -0,0 +1,90 @@
+/**
+ * $Id: $
+ *
+ * @brief Testing procedure for the headroom of ADC buffer views
+ *
+ * The acquisition is stopped with a software trigger, then views are taken before, after and
+ * across the write pointer. A view that reaches past the write pointer must have no headroom and
+ * must be reported as overrun as soon as the writer runs again.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "redpitaya/rp.h"
+
+#define VIEW_LEN    100
+
+static int failed = 0;
+
+static void checkHeadroom(const char* name, uint32_t start, uint32_t expected)
+{
+    rp_acq_buffer_view_t view;
+
+    if (rp_AcqGetBufferView(RP_CH_1, start, VIEW_LEN, &view) != RP_OK) {
+        printf("%-24s (FAILED) no view\n", name);
+        failed++;
+        return;
+    }
+    if (view.headroom != expected) {
+        printf("%-24s (FAILED) headroom %u, expected %u\n", name, view.headroom, expected);
+        failed++;
+        return;
+    }
+    printf("%-24s (OK)\n", name);
+}
+
+int main(int argc, char *argv[]){
+
+    const uint32_t mask = ADC_BUFFER_SIZE - 1;
+    rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
+    rp_acq_buffer_view_t view;
+    uint32_t wp;
+
+    if (rp_Init() != RP_OK) {
+        fprintf(stderr, "Rp api init failed!\n");
+        return 1;
+    }
+
+    /* Fill the buffer, then let the writer stop behind the trigger */
+    rp_AcqReset();
+    rp_AcqStart();
+    usleep(100000);
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+    while (state != RP_TRIG_STATE_TRIGGERED) {
+        rp_AcqGetTriggerState(&state);
+    }
+    usleep(100000);
+    rp_AcqGetWritePointer(&wp);
+
+    checkHeadroom("oldest samples",        (wp + 1) & mask,              0);
+    checkHeadroom("behind write pointer",  (wp + 1 + VIEW_LEN) & mask,   VIEW_LEN);
+    checkHeadroom("ending at write ptr",   (wp + 1 - VIEW_LEN) & mask,   ADC_BUFFER_SIZE - VIEW_LEN);
+    checkHeadroom("across write pointer",  (wp - 10) & mask,             0);
+
+    /* Run the writer again, the view across the write pointer is overrun by its first sample */
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_DISABLED);
+    rp_AcqStart();
+    rp_AcqGetWritePointer(&wp);
+    rp_AcqGetBufferView(RP_CH_1, (wp - 10) & mask, VIEW_LEN, &view);
+    usleep(1000);
+    if (rp_AcqBufferViewCheck(&view) != RP_EOVR) {
+        printf("%-24s (FAILED) not overrun\n", "overrun across write ptr");
+        failed++;
+    }
+    else {
+        printf("%-24s (OK)\n", "overrun across write ptr");
+    }
+
+    rp_AcqStop();
+    rp_Release();
+    return failed ? 1 : 0;
+}
@@ -25,6 +25,8 @@ extern "C" {
 #include <stdbool.h>
 
 #define ADC_BUFFER_SIZE             (16*1024)
+/** Samples per channel of one acquisition stream block */
+#define RP_ACQ_STREAM_BLOCK_LEN     (4*1024)
 
 /** @name Error codes
  *  Various error codes returned by the API.
@@ -77,6 +79,14 @@ extern "C" {
 #define RP_EFRB   21
 /** Failed to write to the bus */
 #define RP_EFWB   22
+/** Acquisition stream is not started */
+#define RP_ENST   23
+/** Timeout elapsed */
+#define RP_ETMO   24
+/** Buffer overrun */
+#define RP_EOVR   25
+/** Failed to allocate memory */
+#define RP_EAA    26
 
 #define SPECTR_OUT_SIG_LEN (2*1024)
 
@@ -226,6 +236,53 @@ typedef enum {
     RP_TRIG_STATE_WAITING,   //!< Trigger is set up and waiting (to be triggered)
 } rp_acq_trig_state_t;
 
+/**
+ * Linear part of a view into the ADC buffer, 14 bit two's complement counts in the low bits
+ */
+typedef struct {
+    const volatile uint32_t* data;  //!< First sample, points into the FPGA buffer
+    uint32_t len;                   //!< Count of samples, 0 for an unused segment
+} rp_acq_buffer_seg_t;
+
+/**
+ * View into the circular ADC buffer of one channel, without copying the samples.
+ */
+typedef struct {
+    rp_acq_buffer_seg_t seg[2];     //!< Samples in buffer order, seg[1] is used when the view wraps around
+    rp_channel_t channel;           //!< Channel of the view
+    uint32_t start;                 //!< Buffer position of the first sample
+    uint32_t len;                   //!< Count of samples
+    uint32_t wp;                    //!< Write pointer when the view was taken
+    uint64_t time_ns;               //!< CLOCK_MONOTONIC time when the view was taken
+    uint32_t headroom;              //!< Samples the writer may write before the view is overrun
+    uint32_t generation;            //!< Buffer generation when the view was taken
+} rp_acq_buffer_view_t;
+
+/**
+ * Called by rp_AcqBufferViewForEach() for each segment of a view.
+ * @param data Samples of the segment.
+ * @param len Count of samples of the segment.
+ * @param offset Index of the first sample of the segment within the view.
+ * @param ctx Context given to rp_AcqBufferViewForEach().
+ * @return RP_OK to continue with the next segment.
+ */
+typedef int (*rp_acq_buffer_view_fn_t)(const volatile uint32_t* data, uint32_t len, uint32_t offset, void* ctx);
+
+/**
+ * Block of the acquisition stream, both channels in calibrated ADC counts.
+ * The first sample of the block is sample number 'sample' since rp_AcqStreamStart(),
+ * which is always seq * RP_ACQ_STREAM_BLOCK_LEN. Lost blocks show as gaps of seq.
+ */
+typedef struct {
+    uint64_t seq;                               //!< Block sequence number
+    uint64_t sample;                            //!< Number of the first sample since the stream start
+    uint64_t time_ns;                           //!< CLOCK_MONOTONIC time the block was read from the ADC buffer
+    uint32_t lost;                              //!< Blocks lost by overruns right before this block
+    uint32_t decimation;                        //!< Decimation factor the block was acquired with
+    float    scale[2];                          //!< Volts per count of channel A and B
+    int16_t  data[2][RP_ACQ_STREAM_BLOCK_LEN];  //!< Samples of channel A and B
+} rp_acq_stream_block_t;
+
 
 /**
  * Calibration parameters, stored in the EEPROM device
@@ -990,6 +1047,18 @@ int rp_AcqGetDataV(rp_channel_t channel, uint32_t pos, uint32_t* size, float* bu
  */
 int rp_AcqGetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2);
 
+/**
+ * Returns the ADC buffer of both channels in Volt units from specified position and desired size,
+ * the samples are interleaved as channel 1, channel 2, channel 1, ...
+ * Output buffer must be at least 2 * 'size' long.
+ * @param pos Starting position of the ADC buffer to retrieve
+ * @param size Length of the ADC buffer to retrieve per channel. Returns length of filled buffer per channel.
+ * @param buffer The output buffer gets filled with the selected part of the ADC buffer of both channels.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqGetDataVInterleaved(uint32_t pos, uint32_t* size, float* buffer);
+
 /**
  * Returns the ADC buffer in Volt units from the oldest sample to the newest one.
  * Output buffer must be at least 'size' long.
@@ -1016,6 +1085,117 @@ int rp_AcqGetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int rp_AcqGetBufSize(uint32_t* size);
 
+/**
+ * Returns a view into the ADC buffer without copying the samples.
+ * The view points into the FPGA buffer, the samples are the raw ADC counts (see rp_AcqGetDataRaw()
+ * for the calibrated ones). While the acquisition is running the writer overwrites the view
+ * eventually, check it with rp_AcqBufferViewCheck() after the samples have been used.
+ * @param channel Channel A or B.
+ * @param start Buffer position of the first sample.
+ * @param len Count of samples, ADC_BUFFER_SIZE at most.
+ * @param view Gets the view.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqGetBufferView(rp_channel_t channel, uint32_t start, uint32_t len, rp_acq_buffer_view_t* view);
+
+/**
+ * Checks whether the samples of a view are still the ones of the time the view was taken.
+ * The check is conservative, a view of an acquisition that stopped after the view was taken may
+ * be reported as overrun.
+ * @param view View taken by rp_AcqGetBufferView().
+ * @return RP_OK if the view is intact, RP_EOVR if the acquisition was armed again or the writer
+ * has overwritten samples of the view.
+ */
+int rp_AcqBufferViewCheck(const rp_acq_buffer_view_t* view);
+
+/**
+ * Calls fn for each segment of the view, in sample order.
+ * @param view View taken by rp_AcqGetBufferView().
+ * @param fn Function called for each segment.
+ * @param ctx Context passed to fn.
+ * @return RP_OK, or the first value other than RP_OK returned by fn.
+ */
+int rp_AcqBufferViewForEach(const rp_acq_buffer_view_t* view, rp_acq_buffer_view_fn_t fn, void* ctx);
+
+/**
+ * Returns the buffer generation, it is incremented whenever the acquisition is armed or reset.
+ * @param generation Gets the generation.
+ * @return If the function is successful, the return value is RP_OK.
+ */
+int rp_AcqGetBufferGeneration(uint32_t* generation);
+
+/**
+ * Starts the gapless acquisition stream.
+ * The acquisition is armed with the trigger disabled, thus the ADC buffer is written continuously
+ * with the current decimation and gain. A reader thread follows the write pointer and queues
+ * blocks of RP_ACQ_STREAM_BLOCK_LEN samples per channel. A running stream is restarted.
+ * @param ring_len Count of queued blocks, 0 selects the default of 16, rounded up to a power of two.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamStart(uint32_t ring_len);
+
+/**
+ * Takes the next block of the acquisition stream.
+ * Blocks are lost when the reader thread falls behind the ADC or the queue is full,
+ * the count is reported by the lost field of the next block.
+ * @param block The block gets filled with the next queued block.
+ * @param timeout_ms Time to wait for a block, 0 returns immediately.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETMO if no block was queued in time, RP_ENST if the stream is not started or is stopped
+ * while waiting. When the reader thread failed, its error is returned once the queue is empty.
+ */
+int rp_AcqStreamRead(rp_acq_stream_block_t* block, uint32_t timeout_ms);
+
+/**
+ * Stops the acquisition stream and the acquisition.
+ * @param blocks Optional, gets the count of blocks read from the ADC buffer.
+ * @param lost Optional, gets the count of lost blocks.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamStop(uint64_t* blocks, uint64_t* lost);
+
+/**
+ * Starts the acquisition stream with software decimation.
+ * The stream of rp_AcqStreamStart() is decimated by any integer factor with a CIC filter followed
+ * by a compensating FIR filter, which cuts off at the output Nyquist frequency. The output sample
+ * rate is 125 MS/s / (decimation * factor), the decimation of the FPGA is the current one.
+ * The stream reader can not follow the ADC at RP_DEC_1, the FPGA decimation must be RP_DEC_8
+ * or higher. RP_DEC_8 gives for instance 625 kS/s with a factor of 25 or 125 kS/s with 125,
+ * blocks may be lost under load; from RP_DEC_64 (1.953 MS/s) on the stream is sustained.
+ * A running stream is restarted.
+ * @param factor Decimation factor; a factor that does not split into a CIC part of at most 50
+ * and a FIR part of at most 256 returns RP_EOOR.
+ * @param ring_len Count of queued stream blocks, 0 selects the default of 16.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EOOR if the FPGA decimation is below RP_DEC_8 or the factor can not be split, RP_EAA if
+ * the filter can not be allocated. Otherwise any of RP_E* values that indicate an error.
+ */
+int rp_AcqDecimStart(uint32_t factor, uint32_t ring_len);
+
+/**
+ * Decimates the next block of the acquisition stream.
+ * The filter state is kept between the calls, after lost stream blocks it starts over.
+ * @param buffer1 Gets the decimated samples of channel 1 in Volts.
+ * @param buffer2 Gets the decimated samples of channel 2 in Volts.
+ * @param size Capacity of each buffer, at least RP_ACQ_STREAM_BLOCK_LEN / factor rounded up.
+ * Gets the count of decimated samples.
+ * @param lost Optional, gets the count of stream blocks lost before this block.
+ * @param timeout_ms Time to wait for a block, 0 returns immediately.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETMO if no block was queued in time, RP_ENST if the stream is not started.
+ */
+int rp_AcqDecimRead(float* buffer1, float* buffer2, uint32_t* size, uint64_t* lost, uint32_t timeout_ms);
+
+/**
+ * Stops the decimated acquisition stream and the acquisition.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqDecimStop();
+
 
 ///@}
 /** @name Generate
@@ -1025,6 +1205,9 @@ int rp_AcqGetBufSize(uint32_t* size);
 
 /**
 * Sets generate to default values.
+* The library writes to the generator buffers only the samples that differ from its last upload,
+* it assumes to be the only writer of the buffers. After the buffers have been written by anything
+* else, e.g. another process or a reloaded FPGA image, call rp_GenReset() before the next upload.
 */
 int rp_GenReset();
 
@@ -0,0 +1,327 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library software decimation of the acquisition stream implementation
+ *
+ * The blocks of the gapless acquisition stream are decimated by any integer factor in two stages.
+ * A CIC filter of order DCM_CIC_ORDER decimates by the larger part of the factor in integer
+ * arithmetic, its integrators wrap around freely since only the output has to fit into 32 bits.
+ * A FIR filter decimates by the rest, it compensates the droop of the CIC filter and cuts off at
+ * the output Nyquist frequency. The FIR taps are designed by frequency sampling with a Blackman
+ * window, DCM_TAPS_PER_PHASE taps for each output phase, and evaluated only at the output
+ * instants, i.e. as a polyphase filter.
+ *
+ * Both channels run through the same filter state. On ARM the CIC stage keeps both channels in
+ * one NEON vector and the FIR dot products are four wide, elsewhere the same is done by scalar code.
+ * The state is kept between blocks; a lost stream block restarts it.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DCM_NEON 1
+#endif
+
+#include "common.h"
+#include "acq_handler.h"
+#include "acq_stream.h"
+#include "acq_decim.h"
+
+// Largest decimation of the FIR stage, it bounds the size of the taps
+#define DCM_FIR_MAX             256
+// Frequency points of the FIR design
+#define DCM_DESIGN_POINTS       256
+// Smallest FPGA decimation the stream reader keeps up with
+#define DCM_FPGA_DEC_MIN        8
+
+static dcm_filter_t decim_filter;
+static bool decim_started = false;
+static rp_acq_stream_block_t decim_block;
+
+
+/**
+ * Splits the factor: the FIR stage takes the smallest divisor that leaves a CIC decimation
+ * within range, small factors are filtered by the FIR stage alone.
+ */
+static int splitFactor(uint32_t factor, uint32_t* cic_r, uint32_t* fir_r)
+{
+    if (factor < 4) {
+        *cic_r = 1;
+        *fir_r = factor;
+        return RP_OK;
+    }
+    for (uint32_t d = 2; d <= MIN(factor, DCM_FIR_MAX); d++) {
+        if (factor % d == 0 && factor / d <= DCM_CIC_MAX) {
+            *cic_r = factor / d;
+            *fir_r = d;
+            return RP_OK;
+        }
+    }
+    return RP_EOOR;
+}
+
+/**
+ * Inverse of the CIC response at f cycles per CIC output sample
+ */
+static double cicCompensation(double f, uint32_t cic_r)
+{
+    if (cic_r == 1 || f == 0) {
+        return 1;
+    }
+    return pow(cic_r * sin(M_PI * f / cic_r) / sin(M_PI * f), DCM_CIC_ORDER);
+}
+
+static int designFir(float* coef, uint32_t taps, uint32_t cic_r, uint32_t fir_r)
+{
+    const double fc = 0.5 / fir_r;
+    const double c = (taps - 1) / 2.0;
+    double sum = 0;
+    double* h = malloc(taps * sizeof(double));
+    if (!h) {
+        return RP_EAA;
+    }
+
+    for (uint32_t n = 0; n < taps; n++) {
+        double acc = 0;
+        for (int k = 0; k < DCM_DESIGN_POINTS; k++) {
+            double f = (k + 0.5) * fc / DCM_DESIGN_POINTS;
+            acc += cicCompensation(f, cic_r) * cos(2 * M_PI * f * (n - c));
+        }
+        double w = 0.42 - 0.5 * cos(2 * M_PI * (n + 1) / (taps + 1)) + 0.08 * cos(4 * M_PI * (n + 1) / (taps + 1));
+        h[n] = acc * w;
+        sum += h[n];
+    }
+    // Unity gain at DC, the taps are symmetric thus their order does not matter
+    for (uint32_t n = 0; n < taps; n++) {
+        coef[n] = (float) (h[n] / sum);
+    }
+    free(h);
+    return RP_OK;
+}
+
+static inline float dot(const float* a, const float* b, uint32_t n)
+{
+    uint32_t i = 0;
+    float s = 0;
+
+#ifdef DCM_NEON
+    float32x4_t acc = vdupq_n_f32(0);
+    for (; i + 4 <= n; i += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float32x2_t t = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    s = vget_lane_f32(vpadd_f32(t, t), 0);
+#endif
+    for (; i < n; i++) {
+        s += a[i] * b[i];
+    }
+    return s;
+}
+
+/*----------------------------------------------------------------------------*/
+int dcm_Init(dcm_filter_t* f, uint32_t factor)
+{
+    memset(f, 0, sizeof(*f));
+    if (!factor) {
+        return RP_EOOR;
+    }
+    ECHECK(splitFactor(factor, &f->cic_r, &f->fir_r));
+
+    f->factor = factor;
+    f->taps = DCM_TAPS_PER_PHASE * f->fir_r;
+    f->cic_gain = (float) (1.0 / pow(f->cic_r, DCM_CIC_ORDER));
+    f->coef = malloc(f->taps * sizeof(float));
+    f->hist[0] = malloc(2 * f->taps * sizeof(float));
+    f->hist[1] = malloc(2 * f->taps * sizeof(float));
+    if (!f->coef || !f->hist[0] || !f->hist[1]) {
+        dcm_Free(f);
+        return RP_EAA;
+    }
+
+    int status = designFir(f->coef, f->taps, f->cic_r, f->fir_r);
+    if (status != RP_OK) {
+        dcm_Free(f);
+        return status;
+    }
+    dcm_Reset(f);
+    return RP_OK;
+}
+
+/*----------------------------------------------------------------------------*/
+void dcm_Reset(dcm_filter_t* f)
+{
+    memset(f->integ, 0, sizeof(f->integ));
+    memset(f->comb, 0, sizeof(f->comb));
+    f->cic_phase = 0;
+    f->fir_phase = 0;
+    f->hist_pos = 0;
+    if (f->hist[0] && f->hist[1]) {
+        memset(f->hist[0], 0, 2 * f->taps * sizeof(float));
+        memset(f->hist[1], 0, 2 * f->taps * sizeof(float));
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+void dcm_Free(dcm_filter_t* f)
+{
+    free(f->coef);
+    free(f->hist[0]);
+    free(f->hist[1]);
+    f->coef = NULL;
+    f->hist[0] = NULL;
+    f->hist[1] = NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+uint32_t dcm_Process(dcm_filter_t* f, const int16_t* in1, const int16_t* in2, uint32_t n,
+                     float scale1, float scale2, float* out1, float* out2)
+{
+    const float k1 = scale1 * f->cic_gain;
+    const float k2 = scale2 * f->cic_gain;
+    const uint32_t taps = f->taps;
+    uint32_t outs = 0;
+
+#ifdef DCM_NEON
+    uint32x2_t integ[DCM_CIC_ORDER], comb[DCM_CIC_ORDER];
+    for (int s = 0; s < DCM_CIC_ORDER; s++) {
+        integ[s] = vld1_u32(f->integ[s]);
+        comb[s] = vld1_u32(f->comb[s]);
+    }
+#endif
+
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t y1, y2;
+
+#ifdef DCM_NEON
+        uint32x2_t x = vset_lane_u32((uint32_t) (int32_t) in2[i], vdup_n_u32((uint32_t) (int32_t) in1[i]), 1);
+        integ[0] = vadd_u32(integ[0], x);
+        for (int s = 1; s < DCM_CIC_ORDER; s++) {
+            integ[s] = vadd_u32(integ[s], integ[s - 1]);
+        }
+        if (++f->cic_phase < f->cic_r) {
+            continue;
+        }
+        uint32x2_t y = integ[DCM_CIC_ORDER - 1];
+        for (int s = 0; s < DCM_CIC_ORDER; s++) {
+            uint32x2_t t = vsub_u32(y, comb[s]);
+            comb[s] = y;
+            y = t;
+        }
+        y1 = (int32_t) vget_lane_u32(y, 0);
+        y2 = (int32_t) vget_lane_u32(y, 1);
+#else
+        f->integ[0][0] += (uint32_t) (int32_t) in1[i];
+        f->integ[0][1] += (uint32_t) (int32_t) in2[i];
+        for (int s = 1; s < DCM_CIC_ORDER; s++) {
+            f->integ[s][0] += f->integ[s - 1][0];
+            f->integ[s][1] += f->integ[s - 1][1];
+        }
+        if (++f->cic_phase < f->cic_r) {
+            continue;
+        }
+        uint32_t u1 = f->integ[DCM_CIC_ORDER - 1][0];
+        uint32_t u2 = f->integ[DCM_CIC_ORDER - 1][1];
+        for (int s = 0; s < DCM_CIC_ORDER; s++) {
+            uint32_t t1 = u1 - f->comb[s][0];
+            uint32_t t2 = u2 - f->comb[s][1];
+            f->comb[s][0] = u1;
+            f->comb[s][1] = u2;
+            u1 = t1;
+            u2 = t2;
+        }
+        y1 = (int32_t) u1;
+        y2 = (int32_t) u2;
+#endif
+        f->cic_phase = 0;
+
+        uint32_t pos = f->hist_pos;
+        f->hist[0][pos] = f->hist[0][pos + taps] = (float) y1 * k1;
+        f->hist[1][pos] = f->hist[1][pos + taps] = (float) y2 * k2;
+        f->hist_pos = (pos + 1 == taps) ? 0 : pos + 1;
+
+        if (++f->fir_phase == f->fir_r) {
+            f->fir_phase = 0;
+            out1[outs] = dot(f->coef, f->hist[0] + f->hist_pos, taps);
+            out2[outs] = dot(f->coef, f->hist[1] + f->hist_pos, taps);
+            outs++;
+        }
+    }
+
+#ifdef DCM_NEON
+    for (int s = 0; s < DCM_CIC_ORDER; s++) {
+        vst1_u32(f->integ[s], integ[s]);
+        vst1_u32(f->comb[s], comb[s]);
+    }
+#endif
+    return outs;
+}
+
+/*----------------------------------------------------------------------------*/
+int acq_DecimStart(uint32_t factor, uint32_t ring_len)
+{
+    if (decim_started) {
+        acq_DecimStop();
+    }
+
+    uint32_t decimation;
+    ECHECK(acq_GetDecimationFactor(&decimation));
+    if (decimation < DCM_FPGA_DEC_MIN) {
+        return RP_EOOR;
+    }
+
+    ECHECK(dcm_Init(&decim_filter, factor));
+
+    int status = acq_StreamStart(ring_len);
+    if (status != RP_OK) {
+        dcm_Free(&decim_filter);
+        return status;
+    }
+    decim_started = true;
+    return RP_OK;
+}
+
+/*----------------------------------------------------------------------------*/
+int acq_DecimRead(float* buffer1, float* buffer2, uint32_t* size, uint64_t* lost, uint32_t timeout_ms)
+{
+    if (!decim_started) {
+        return RP_ENST;
+    }
+    if (*size < (RP_ACQ_STREAM_BLOCK_LEN + decim_filter.factor - 1) / decim_filter.factor) {
+        return RP_EOOR;
+    }
+
+    ECHECK(acq_StreamRead(&decim_block, timeout_ms));
+
+    if (decim_block.lost) {
+        // The input has a gap, the filter starts over
+        dcm_Reset(&decim_filter);
+    }
+    *size = dcm_Process(&decim_filter, decim_block.data[0], decim_block.data[1], RP_ACQ_STREAM_BLOCK_LEN,
+                        decim_block.scale[0], decim_block.scale[1], buffer1, buffer2);
+    if (lost) {
+        *lost = decim_block.lost;
+    }
+    return RP_OK;
+}
+
+/*----------------------------------------------------------------------------*/
+int acq_DecimStop()
+{
+    if (!decim_started) {
+        return RP_ENST;
+    }
+    decim_started = false;
+    dcm_Free(&decim_filter);
+    return acq_StreamStop(NULL, NULL);
+}
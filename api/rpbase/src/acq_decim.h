@@ -0,0 +1,52 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library software decimation of the acquisition stream interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_ACQ_DECIM_H_
+#define SRC_ACQ_DECIM_H_
+
+#include <stdint.h>
+#include "redpitaya/rp.h"
+
+#define DCM_CIC_ORDER           3
+// The CIC output must fit into 32 bits: 8192 * DCM_CIC_MAX^DCM_CIC_ORDER < 2^31
+#define DCM_CIC_MAX             50
+#define DCM_TAPS_PER_PHASE      32
+
+/** State of the decimation filter of both channels */
+typedef struct dcm_filter_s {
+    uint32_t factor;                        // total decimation factor
+    uint32_t cic_r;                         // decimation of the CIC stage
+    uint32_t fir_r;                         // decimation of the FIR stage
+    uint32_t taps;                          // DCM_TAPS_PER_PHASE * fir_r
+    uint32_t cic_phase;
+    uint32_t fir_phase;
+    uint32_t integ[DCM_CIC_ORDER][2];       // integrators, wrapping around is intended
+    uint32_t comb[DCM_CIC_ORDER][2];
+    float    cic_gain;                      // 1 / cic_r^DCM_CIC_ORDER
+    float*   coef;                          // FIR taps, oldest sample first
+    float*   hist[2];                       // last taps inputs, stored twice for a linear window
+    uint32_t hist_pos;
+} dcm_filter_t;
+
+int dcm_Init(dcm_filter_t* f, uint32_t factor);
+void dcm_Reset(dcm_filter_t* f);
+void dcm_Free(dcm_filter_t* f);
+uint32_t dcm_Process(dcm_filter_t* f, const int16_t* in1, const int16_t* in2, uint32_t n,
+                     float scale1, float scale2, float* out1, float* out2);
+
+int acq_DecimStart(uint32_t factor, uint32_t ring_len);
+int acq_DecimRead(float* buffer1, float* buffer2, uint32_t* size, uint64_t* lost, uint32_t timeout_ms);
+int acq_DecimStop();
+
+#endif /* SRC_ACQ_DECIM_H_ */
@@ -15,11 +15,14 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <math.h>
+#include <string.h>
+#include <time.h>
 
 #include "common.h"
 #include "calib.h"
 #include "oscilloscope.h"
 #include "acq_handler.h"
+#include "acq_readout.h"
 
 
 // Decimation constants
@@ -39,13 +42,13 @@ static const uint64_t ADC_SAMPLE_PERIOD = 8;
 /* @brief Number of ADC acquisition bits. */
 static const int ADC_BITS = 14;
 
-/* @brief ADC acquisition bits mask. */
-static const int ADC_BITS_MAK = 0x3FFF;
-
 /* @brief Currently set Gain state */
 static rp_pinState_t gain_ch_a = RP_LOW;
 static rp_pinState_t gain_ch_b = RP_LOW;
 
+/* @brief Incremented whenever the acquisition is armed, the buffer content is replaced then */
+static uint32_t buffer_generation = 0;
+
 /* @brief Determines whether TriggerDelay was set in time or sample units */
 static bool triggerDelayInNs = false;
 
@@ -70,9 +73,14 @@ static const uint32_t GAIN_HI_CHB_FILT_PP = 0x2666;
 static const uint32_t GAIN_HI_CHB_FILT_KK = 0xd9999a;
 
 
-#define GET_OFFSET_CH1(gain, calib) (gain == RP_HIGH ? calib.fe_ch1_hi_offs : calib.fe_ch1_lo_offs)
-#define GET_OFFSET_CH2(gain, calib) (gain == RP_HIGH ? calib.fe_ch2_hi_offs : calib.fe_ch2_lo_offs)
-#define GET_OFFSET(channel, gain, calib) (channel == RP_CH_1 ? GET_OFFSET_CH1(gain, calib) : GET_OFFSET_CH2(gain, calib) )
+/**
+ * Returns the count to volt conversion of the channel for the currently set gain.
+ * It is rebuilt by the calibration module whenever the calibration parameters change.
+ */
+static const calib_conv_t* getConv(rp_channel_t channel)
+{
+    return calib_GetFrontEndConv(channel, channel == RP_CH_1 ? gain_ch_a : gain_ch_b);
+}
 
 
 /*----------------------------------------------------------------------------*/
@@ -521,6 +529,50 @@ int acq_GetWritePointerAtTrig(uint32_t* pos)
     return osc_GetWritePointerAtTrig(pos);
 }
 
+/**
+ * Returns the write pointer together with the CLOCK_MONOTONIC time it was read at [ns]
+ */
+int acq_GetWritePointerTime(uint32_t* pos, uint64_t* time_ns)
+{
+    struct timespec ts;
+
+    ECHECK(osc_GetWritePointer(pos));
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    *time_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    return RP_OK;
+}
+
+/**
+ * Returns the count of samples written since the write pointer was 'pos' at 'time_ns'.
+ * The write pointer alone cannot tell how often the writer has wrapped around meanwhile, the laps
+ * are estimated from the elapsed time. A pointer that did not move at all is taken as a stopped
+ * acquisition. The current write pointer and time are returned by pos_now and time_now.
+ */
+int acq_GetWrittenSince(uint32_t pos, uint64_t time_ns, uint64_t* written, uint32_t* pos_now, uint64_t* time_now)
+{
+    uint32_t decimation, wp;
+    uint64_t now;
+
+    ECHECK(acq_GetDecimationFactor(&decimation));
+    ECHECK(acq_GetWritePointerTime(&wp, &now));
+
+    uint64_t adv = (wp - pos) & (ADC_BUFFER_SIZE - 1);
+    uint64_t est = (now - time_ns) / (ADC_SAMPLE_PERIOD * decimation);
+
+    if (adv && est > adv + ADC_BUFFER_SIZE / 2) {
+        adv += ((est - adv + ADC_BUFFER_SIZE / 2) / ADC_BUFFER_SIZE) * ADC_BUFFER_SIZE;
+    }
+
+    *written = adv;
+    if (pos_now) {
+        *pos_now = wp;
+    }
+    if (time_now) {
+        *time_now = now;
+    }
+    return RP_OK;
+}
+
 int acq_SetTriggerLevel(float voltage)
 {
     ECHECK(acq_SetChannelThreshold(RP_CH_1, voltage));
@@ -536,21 +588,16 @@ int acq_GetTriggerLevel(float *voltage)
 
 int acq_SetChannelThreshold(rp_channel_t channel, float voltage)
 {
-    float gainV;
     rp_pinState_t gain;
+    ECHECK(acq_GetGain(channel, &gain));
 
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));;
+    const calib_conv_t* conv = calib_GetFrontEndConv(channel, gain);
 
-    if (fabs(voltage) - fabs(gainV) > FLOAT_EPS) {
+    if (fabs(voltage) - fabs(conv->max_v) > FLOAT_EPS) {
         return RP_EOOR;
     }
 
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
-
-    uint32_t cnt = cmn_CnvVToCnt(ADC_BITS, voltage, gainV, gain == RP_HIGH ? false : true, calibScale, dc_offs, 0.0);
+    uint32_t cnt = cmn_CnvVToCnt(ADC_BITS, voltage, conv->max_v, gain == RP_HIGH ? false : true, conv->fs, conv->dc_offs, 0.0);
 
     // We cut high bits of negative numbers
     cnt = cnt & ((1 << ADC_BITS) - 1);
@@ -565,8 +612,6 @@ int acq_SetChannelThreshold(rp_channel_t channel, float voltage)
 
 int acq_GetChannelThreshold(rp_channel_t channel, float* voltage)
 {
-    float gainV;
-    rp_pinState_t gain;
     uint32_t cnts;
 
     if (channel == RP_CH_1) {
@@ -576,14 +621,8 @@ int acq_GetChannelThreshold(rp_channel_t channel, float* voltage)
         ECHECK(osc_GetThresholdChB(&cnts));
     }
 
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
-
-    *voltage = cmn_CnvCntToV(ADC_BITS, cnts, gainV, calibScale, dc_offs, 0.0);
+    const calib_conv_t* conv = getConv(channel);
+    *voltage = cmn_CalibCnts(ADC_BITS, cnts, conv->dc_offs) * conv->scale;
 
     return RP_OK;
 }
@@ -604,21 +643,17 @@ int acq_GetTriggerHyst(float *voltage)
 
 int acq_SetChannelThresholdHyst(rp_channel_t channel, float voltage)
 {
-    float gainV;
     rp_pinState_t gain;
+    ECHECK(acq_GetGain(channel, &gain));
 
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));;
+    const calib_conv_t* conv = calib_GetFrontEndConv(channel, gain);
 
-    if (fabs(voltage) - fabs(gainV) > FLOAT_EPS) {
+    if (fabs(voltage) - fabs(conv->max_v) > FLOAT_EPS) {
         return RP_EOOR;
     }
 
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
+    uint32_t cnt = cmn_CnvVToCnt(ADC_BITS, voltage, conv->max_v, gain == RP_HIGH ? false : true, conv->fs, conv->dc_offs, 0.0);
 
-    uint32_t cnt = cmn_CnvVToCnt(ADC_BITS, voltage, gainV, gain == RP_HIGH ? false : true, calibScale, dc_offs, 0.0);
     if (channel == RP_CH_1) {
         return osc_SetHysteresisChA(cnt);
     }
@@ -629,8 +664,6 @@ int acq_SetChannelThresholdHyst(rp_channel_t channel, float voltage)
 
 int acq_GetChannelThresholdHyst(rp_channel_t channel, float* voltage)
 {
-    float gainV;
-    rp_pinState_t gain;
     uint32_t cnts;
 
     if (channel == RP_CH_1) {
@@ -640,20 +673,15 @@ int acq_GetChannelThresholdHyst(rp_channel_t channel, float* voltage)
         ECHECK(osc_GetHysteresisChB(&cnts));
     }
 
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
-
-    *voltage = cmn_CnvCntToV(ADC_BITS, cnts, gainV, calibScale, dc_offs, 0.0);
+    const calib_conv_t* conv = getConv(channel);
+    *voltage = cmn_CalibCnts(ADC_BITS, cnts, conv->dc_offs) * conv->scale;
 
     return RP_OK;
 }
 
 int acq_Start()
 {
+    __atomic_add_fetch(&buffer_generation, 1, __ATOMIC_RELEASE);
     ECHECK(osc_WriteDataIntoMemory(true));
     return RP_OK;
 }
@@ -665,6 +693,7 @@ int acq_Stop()
 
 int acq_Reset()
 {
+    __atomic_add_fetch(&buffer_generation, 1, __ATOMIC_RELEASE);
     ECHECK(acq_SetDefault());
     return osc_ResetWriteStateMachine();
 }
@@ -702,20 +731,15 @@ int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t*
 
     *size = MIN(*size, ADC_BUFFER_SIZE);
 
-    uint32_t cnts;
-
     const volatile uint32_t* raw_buffer = getRawBuffer(channel);
+    int32_t dc_offs = getConv(channel)->dc_offs;
 
-    rp_pinState_t gain;
-    ECHECK(acq_GetGain(channel, &gain));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
+    rdo_segment_t seg[2];
+    int segs = rdo_Split(pos, *size, seg);
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        cnts = (raw_buffer[(pos + i) % ADC_BUFFER_SIZE]) & ADC_BITS_MAK;
-
-        buffer[i] = cmn_CalibCnts(ADC_BITS, cnts, dc_offs);
+    for (int s = 0; s < segs; ++s) {
+        rdo_CntsToRaw(buffer, raw_buffer + seg[s].pos, seg[s].len, dc_offs);
+        buffer += seg[s].len;
     }
 
     return RP_OK;
@@ -729,9 +753,14 @@ int acq_GetDataRawV2(uint32_t pos, uint32_t* size, uint16_t* buffer, uint16_t* b
     const volatile uint32_t* raw_buffer = getRawBuffer(RP_CH_1);
     const volatile uint32_t* raw_buffer2 = getRawBuffer(RP_CH_2);
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        buffer[i] = (raw_buffer[(pos + i) % ADC_BUFFER_SIZE]) & ADC_BITS_MAK;
-        buffer2[i] = (raw_buffer2[(pos + i) % ADC_BUFFER_SIZE]) & ADC_BITS_MAK;
+    rdo_segment_t seg[2];
+    int segs = rdo_Split(pos, *size, seg);
+
+    for (int s = 0; s < segs; ++s) {
+        rdo_CntsToCnts(buffer, raw_buffer + seg[s].pos, seg[s].len);
+        rdo_CntsToCnts(buffer2, raw_buffer2 + seg[s].pos, seg[s].len);
+        buffer += seg[s].len;
+        buffer2 += seg[s].len;
     }
 
     return RP_OK;
@@ -783,21 +812,16 @@ int acq_GetDataV(rp_channel_t channel,  uint32_t pos, uint32_t* size, float* buf
 {
     *size = MIN(*size, ADC_BUFFER_SIZE);
 
-    float gainV;
-    rp_pinState_t gain;
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
+    const calib_conv_t* conv = getConv(channel);
 
     const volatile uint32_t* raw_buffer = getRawBuffer(channel);
 
-    uint32_t cnts;
-    for (uint32_t i = 0; i < (*size); ++i) {
-        cnts = raw_buffer[(pos + i) % ADC_BUFFER_SIZE];
-        buffer[i] = cmn_CnvCntToV(ADC_BITS, cnts, gainV, calibScale, dc_offs, 0.0);
+    rdo_segment_t seg[2];
+    int segs = rdo_Split(pos, *size, seg);
+
+    for (int s = 0; s < segs; ++s) {
+        rdo_CntsToV(buffer, raw_buffer + seg[s].pos, seg[s].len, conv->dc_offs, conv->scale);
+        buffer += seg[s].len;
     }
 
     return RP_OK;
@@ -807,40 +831,42 @@ int acq_GetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2)
 {
     *size = MIN(*size, ADC_BUFFER_SIZE);
 
-    float gainV1, gainV2;
-    rp_pinState_t gain1, gain2;
-    ECHECK(acq_GetGainV(RP_CH_1, &gainV1));
-    ECHECK(acq_GetGain(RP_CH_1, &gain1));
-    ECHECK(acq_GetGainV(RP_CH_2, &gainV2));
-    ECHECK(acq_GetGain(RP_CH_2, &gain2));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs1 = gain1 == RP_HIGH ? calib.fe_ch1_hi_offs : calib.fe_ch1_lo_offs;
-    uint32_t calibScale1 = calib_GetFrontEndScale(RP_CH_1, gain1);
-
-    int32_t dc_offs2 = gain2 == RP_HIGH ? calib.fe_ch2_hi_offs : calib.fe_ch2_lo_offs;
-    uint32_t calibScale2 = calib_GetFrontEndScale(RP_CH_2, gain2);
+    const calib_conv_t* conv1 = getConv(RP_CH_1);
+    const calib_conv_t* conv2 = getConv(RP_CH_2);
 
     const volatile uint32_t* raw_buffer1 = getRawBuffer(RP_CH_1);
     const volatile uint32_t* raw_buffer2 = getRawBuffer(RP_CH_2);
 
-    uint32_t cnts1[*size];
-    uint32_t cnts2[*size];
-    uint32_t* ptr1 = cnts1;
-    uint32_t* ptr2 = cnts2;
+    rdo_segment_t seg[2];
+    int segs = rdo_Split(pos, *size, seg);
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        *ptr1++ = raw_buffer1[pos];
-        *ptr2++ = raw_buffer2[pos];
-        pos = (pos + 1) % ADC_BUFFER_SIZE;
+    for (int s = 0; s < segs; ++s) {
+        rdo_CntsToV(buffer1, raw_buffer1 + seg[s].pos, seg[s].len, conv1->dc_offs, conv1->scale);
+        rdo_CntsToV(buffer2, raw_buffer2 + seg[s].pos, seg[s].len, conv2->dc_offs, conv2->scale);
+        buffer1 += seg[s].len;
+        buffer2 += seg[s].len;
     }
 
-    ptr1 = cnts1;
-    ptr2 = cnts2;
+    return RP_OK;
+}
+
+int acq_GetDataVInterleaved(uint32_t pos, uint32_t* size, float* buffer)
+{
+    *size = MIN(*size, ADC_BUFFER_SIZE);
+
+    const calib_conv_t* conv1 = getConv(RP_CH_1);
+    const calib_conv_t* conv2 = getConv(RP_CH_2);
+
+    const volatile uint32_t* raw_buffer1 = getRawBuffer(RP_CH_1);
+    const volatile uint32_t* raw_buffer2 = getRawBuffer(RP_CH_2);
+
+    rdo_segment_t seg[2];
+    int segs = rdo_Split(pos, *size, seg);
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        *buffer1++ = cmn_CnvCntToV(ADC_BITS, *ptr1++, gainV1, calibScale1, dc_offs1, 0.0);
-        *buffer2++ = cmn_CnvCntToV(ADC_BITS, *ptr2++, gainV2, calibScale2, dc_offs2, 0.0);
+    for (int s = 0; s < segs; ++s) {
+        rdo_CntsToVInterleaved(buffer, raw_buffer1 + seg[s].pos, raw_buffer2 + seg[s].pos, seg[s].len,
+                               conv1->dc_offs, conv1->scale, conv2->dc_offs, conv2->scale);
+        buffer += seg[s].len << 1;
     }
 
     return RP_OK;
@@ -882,6 +908,70 @@ int acq_GetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer)
 }
 
 
+int acq_GetBufferView(rp_channel_t channel, uint32_t start, uint32_t len, rp_acq_buffer_view_t* view)
+{
+    if (len > ADC_BUFFER_SIZE) {
+        return RP_EOOR;
+    }
+
+    const volatile uint32_t* raw_buffer = getRawBuffer(channel);
+    rdo_segment_t seg[2];
+    int segs = rdo_Split(start, len, seg);
+
+    memset(view, 0, sizeof(*view));
+    for (int s = 0; s < segs; ++s) {
+        view->seg[s].data = raw_buffer + seg[s].pos;
+        view->seg[s].len = seg[s].len;
+    }
+    view->channel = channel;
+    view->start = acq_GetNormalizedDataPos(start);
+    view->len = len;
+    view->generation = __atomic_load_n(&buffer_generation, __ATOMIC_ACQUIRE);
+    ECHECK(acq_GetWritePointerTime(&view->wp, &view->time_ns));
+
+    // The writer continues behind the write pointer, the first sample of the view is overwritten
+    // after this many samples. A view that reaches past the write pointer is overwritten already
+    // by the next sample.
+    if (((view->wp + 1 - view->start) & (ADC_BUFFER_SIZE - 1)) < len) {
+        view->headroom = 0;
+    }
+    else {
+        view->headroom = (view->start - view->wp - 1) & (ADC_BUFFER_SIZE - 1);
+    }
+    return RP_OK;
+}
+
+int acq_BufferViewCheck(const rp_acq_buffer_view_t* view)
+{
+    uint64_t written;
+
+    if (view->generation != __atomic_load_n(&buffer_generation, __ATOMIC_ACQUIRE)) {
+        return RP_EOVR;
+    }
+    ECHECK(acq_GetWrittenSince(view->wp, view->time_ns, &written, NULL, NULL));
+    return (written > view->headroom) ? RP_EOVR : RP_OK;
+}
+
+int acq_BufferViewForEach(const rp_acq_buffer_view_t* view, rp_acq_buffer_view_fn_t fn, void* ctx)
+{
+    uint32_t offset = 0;
+
+    for (int s = 0; s < 2 && view->seg[s].len; ++s) {
+        int status = fn(view->seg[s].data, view->seg[s].len, offset, ctx);
+        if (status != RP_OK) {
+            return status;
+        }
+        offset += view->seg[s].len;
+    }
+    return RP_OK;
+}
+
+int acq_GetBufferGeneration(uint32_t* generation)
+{
+    *generation = __atomic_load_n(&buffer_generation, __ATOMIC_ACQUIRE);
+    return RP_OK;
+}
+
 int acq_GetBufferSize(uint32_t *size) {
     *size = ADC_BUFFER_SIZE;
     return RP_OK;
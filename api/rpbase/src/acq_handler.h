@@ -49,6 +49,8 @@ int acq_SetChannelThresholdHyst(rp_channel_t channel, float voltage);
 int acq_GetChannelThresholdHyst(rp_channel_t channel, float* voltage);
 int acq_GetWritePointer(uint32_t* pos);
 int acq_GetWritePointerAtTrig(uint32_t* pos);
+int acq_GetWritePointerTime(uint32_t* pos, uint64_t* time_ns);
+int acq_GetWrittenSince(uint32_t pos, uint64_t time_ns, uint64_t* written, uint32_t* pos_now, uint64_t* time_now);
 int acq_Start();
 int acq_Stop();
 int acq_Reset();
@@ -62,10 +64,15 @@ int acq_GetOldestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer);
 int acq_GetLatestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer);
 int acq_GetDataV(rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer);
 int acq_GetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2);
+int acq_GetDataVInterleaved(uint32_t pos, uint32_t* size, float* buffer);
 int acq_GetOldestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 int acq_GetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int acq_GetBufferSize(uint32_t *size);
+int acq_GetBufferView(rp_channel_t channel, uint32_t start, uint32_t len, rp_acq_buffer_view_t* view);
+int acq_BufferViewCheck(const rp_acq_buffer_view_t* view);
+int acq_BufferViewForEach(const rp_acq_buffer_view_t* view, rp_acq_buffer_view_fn_t fn, void* ctx);
+int acq_GetBufferGeneration(uint32_t* generation);
 
 int acq_SetDefault();
 
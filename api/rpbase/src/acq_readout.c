@@ -0,0 +1,173 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library bulk ADC buffer readout kernels implementation
+ *
+ * The circular ADC buffer is split into at most two linear segments, each segment is converted by
+ * one call of a kernel without any modulo per sample. On ARM the kernels read four 32 bit words of
+ * the FPGA window into registers and sign-extend, correct and scale them with NEON, elsewhere the
+ * same conversion is done sample by sample. The FPGA window is always read with single 32 bit
+ * loads, the AXI slave answers wider bursts with an error.
+ *
+ * The results are the same as of cmn_CalibCnts() and cmn_CnvCntToV() with a user offset of 0.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdint.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RDO_NEON 1
+#endif
+
+#include "common.h"
+#include "acq_readout.h"
+
+// The ADC buffer field is 14 bits wide, two's complement
+#define RDO_BITS        14
+#define RDO_MASK        ((1 << RDO_BITS) - 1)
+#define RDO_SHIFT       (32 - RDO_BITS)
+#define RDO_MAX_CNT     (1 << (RDO_BITS - 1))
+
+static inline int32_t rdo_Calib(uint32_t cnts, int32_t calib_dc_off)
+{
+    int32_t m = ((int32_t) (cnts << RDO_SHIFT) >> RDO_SHIFT) - calib_dc_off;
+
+    return (m < -RDO_MAX_CNT) ? -RDO_MAX_CNT : (m > RDO_MAX_CNT) ? RDO_MAX_CNT : m;
+}
+
+#ifdef RDO_NEON
+// Four 32 bit volatile loads, a vld1q_u32() straight from the FPGA window would be one 128 bit access
+static inline uint32x4_t rdo_LoadQ(const volatile uint32_t* src)
+{
+    const uint32_t w[4] = { src[0], src[1], src[2], src[3] };
+
+    return vld1q_u32(w);
+}
+
+static inline int32x4_t rdo_CalibQ(const volatile uint32_t* src, int32x4_t dc, int32x4_t lo, int32x4_t hi)
+{
+    uint32x4_t c = rdo_LoadQ(src);
+    int32x4_t  m = vshrq_n_s32(vreinterpretq_s32_u32(vshlq_n_u32(c, RDO_SHIFT)), RDO_SHIFT);
+
+    return vminq_s32(vmaxq_s32(vsubq_s32(m, dc), lo), hi);
+}
+#endif
+
+/*----------------------------------------------------------------------------*/
+int rdo_Split(uint32_t pos, uint32_t size, rdo_segment_t seg[2])
+{
+    pos %= ADC_BUFFER_SIZE;
+    if (size > ADC_BUFFER_SIZE) {
+        size = ADC_BUFFER_SIZE;
+    }
+    if (!size) {
+        return 0;
+    }
+
+    seg[0].pos = pos;
+    seg[0].len = MIN(size, ADC_BUFFER_SIZE - pos);
+    if (seg[0].len == size) {
+        return 1;
+    }
+    seg[1].pos = 0;
+    seg[1].len = size - seg[0].len;
+    return 2;
+}
+
+/*----------------------------------------------------------------------------*/
+void rdo_CntsToRaw(int16_t* dst, const volatile uint32_t* src, uint32_t n, int32_t calib_dc_off)
+{
+    uint32_t i = 0;
+
+#ifdef RDO_NEON
+    const int32x4_t dc = vdupq_n_s32(calib_dc_off);
+    const int32x4_t lo = vdupq_n_s32(-RDO_MAX_CNT);
+    const int32x4_t hi = vdupq_n_s32(RDO_MAX_CNT);
+
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t a = rdo_CalibQ(src + i,     dc, lo, hi);
+        int32x4_t b = rdo_CalibQ(src + i + 4, dc, lo, hi);
+        vst1q_s16(dst + i, vcombine_s16(vmovn_s32(a), vmovn_s32(b)));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = (int16_t) rdo_Calib(src[i], calib_dc_off);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+void rdo_CntsToCnts(uint16_t* dst, const volatile uint32_t* src, uint32_t n)
+{
+    uint32_t i = 0;
+
+#ifdef RDO_NEON
+    const uint32x4_t mask = vdupq_n_u32(RDO_MASK);
+
+    for (; i + 8 <= n; i += 8) {
+        uint32x4_t a = vandq_u32(rdo_LoadQ(src + i),     mask);
+        uint32x4_t b = vandq_u32(rdo_LoadQ(src + i + 4), mask);
+        vst1q_u16(dst + i, vcombine_u16(vmovn_u32(a), vmovn_u32(b)));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = (uint16_t) (src[i] & RDO_MASK);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+void rdo_CntsToV(float* dst, const volatile uint32_t* src, uint32_t n, int32_t calib_dc_off, float scale)
+{
+    uint32_t i = 0;
+
+#ifdef RDO_NEON
+    const int32x4_t   dc = vdupq_n_s32(calib_dc_off);
+    const int32x4_t   lo = vdupq_n_s32(-RDO_MAX_CNT);
+    const int32x4_t   hi = vdupq_n_s32(RDO_MAX_CNT);
+    const float32x4_t k  = vdupq_n_f32(scale);
+
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t a = rdo_CalibQ(src + i,     dc, lo, hi);
+        int32x4_t b = rdo_CalibQ(src + i + 4, dc, lo, hi);
+        vst1q_f32(dst + i,     vmulq_f32(vcvtq_f32_s32(a), k));
+        vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(b), k));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = (float) rdo_Calib(src[i], calib_dc_off) * scale;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+void rdo_CntsToVInterleaved(float* dst, const volatile uint32_t* src1, const volatile uint32_t* src2, uint32_t n,
+                            int32_t calib_dc_off1, float scale1, int32_t calib_dc_off2, float scale2)
+{
+    uint32_t i = 0;
+
+#ifdef RDO_NEON
+    const int32x4_t   dc1 = vdupq_n_s32(calib_dc_off1);
+    const int32x4_t   dc2 = vdupq_n_s32(calib_dc_off2);
+    const int32x4_t   lo  = vdupq_n_s32(-RDO_MAX_CNT);
+    const int32x4_t   hi  = vdupq_n_s32(RDO_MAX_CNT);
+    const float32x4_t k1  = vdupq_n_f32(scale1);
+    const float32x4_t k2  = vdupq_n_f32(scale2);
+    float32x4x2_t     v;
+
+    for (; i + 4 <= n; i += 4) {
+        v.val[0] = vmulq_f32(vcvtq_f32_s32(rdo_CalibQ(src1 + i, dc1, lo, hi)), k1);
+        v.val[1] = vmulq_f32(vcvtq_f32_s32(rdo_CalibQ(src2 + i, dc2, lo, hi)), k2);
+        vst2q_f32(dst + (i << 1), v);
+    }
+#endif
+    for (; i < n; i++) {
+        dst[(i << 1)]     = (float) rdo_Calib(src1[i], calib_dc_off1) * scale1;
+        dst[(i << 1) + 1] = (float) rdo_Calib(src2[i], calib_dc_off2) * scale2;
+    }
+}
@@ -0,0 +1,34 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library bulk ADC buffer readout kernels interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_ACQ_READOUT_H_
+#define SRC_ACQ_READOUT_H_
+
+#include <stdint.h>
+
+/** Linear part of the circular ADC buffer */
+typedef struct rdo_segment_s {
+    uint32_t pos;   // first sample, 0 .. ADC_BUFFER_SIZE - 1
+    uint32_t len;   // number of samples up to the end of the buffer at most
+} rdo_segment_t;
+
+int rdo_Split(uint32_t pos, uint32_t size, rdo_segment_t seg[2]);
+
+void rdo_CntsToRaw(int16_t* dst, const volatile uint32_t* src, uint32_t n, int32_t calib_dc_off);
+void rdo_CntsToCnts(uint16_t* dst, const volatile uint32_t* src, uint32_t n);
+void rdo_CntsToV(float* dst, const volatile uint32_t* src, uint32_t n, int32_t calib_dc_off, float scale);
+void rdo_CntsToVInterleaved(float* dst, const volatile uint32_t* src1, const volatile uint32_t* src2, uint32_t n,
+                            int32_t calib_dc_off1, float scale1, int32_t calib_dc_off2, float scale2);
+
+#endif /* SRC_ACQ_READOUT_H_ */
@@ -0,0 +1,339 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library gapless acquisition stream implementation
+ *
+ * The acquisition is armed with the trigger disabled, so the FPGA keeps writing the circular ADC
+ * buffer. A reader thread follows the write pointer and copies each completed block of both
+ * channels into a single producer / single consumer ring, the client takes the blocks with
+ * acq_StreamRead(). The ring indices are free running counters masked by the power of two ring
+ * length, the producer owns the head and the consumer owns the tail, a semaphore counts the
+ * published blocks for the waiting client. A post without a published block wakes the client when
+ * the reader thread failed or the stream is stopped, the woken client posts again for the next one.
+ *
+ * The samples written since the last poll are counted by acq_GetWrittenSince(). Samples the
+ * writer is about to overwrite are skipped in whole blocks, blocks that do not fit into the ring
+ * are dropped. Both show as a gap of the sequence numbers and as the lost count of the next
+ * published block.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+
+#include "common.h"
+#include "calib.h"
+#include "oscilloscope.h"
+#include "acq_handler.h"
+#include "acq_readout.h"
+#include "acq_stream.h"
+
+#define STREAM_BLOCK            RP_ACQ_STREAM_BLOCK_LEN
+#define STREAM_RING_LEN_DEFAULT 16
+#define STREAM_RING_LEN_MAX     1024
+
+// Bounds of the sleep of the reader thread while a block is being written [ns]
+#define STREAM_SLEEP_MIN        50000
+#define STREAM_SLEEP_MAX        10000000
+
+/* @brief Sampling period [ns] */
+static const uint64_t ADC_SAMPLE_PERIOD = 8;
+
+static pthread_t stream_thread;
+static bool stream_started = false;
+static bool stream_running = false;
+
+// Ring of blocks, head is written by the reader thread only, tail by the client only
+static rp_acq_stream_block_t* stream_ring = NULL;
+static uint32_t stream_ring_mask = 0;
+static uint32_t stream_ring_head = 0;
+static uint32_t stream_ring_tail = 0;
+static sem_t stream_ring_avail;
+static int stream_error = RP_OK;        // error of the reader thread, set once before it exits
+static uint32_t stream_clients = 0;     // clients inside acq_StreamRead()
+
+// Position of the reader thread
+static uint32_t stream_wp;              // write pointer of the last poll
+static uint64_t stream_wp_time;         // time of the last poll [ns]
+static uint32_t stream_rd;              // next sample to read
+static uint64_t stream_unread;          // samples written but not read yet
+static uint64_t stream_seq;             // sequence number of the next block
+static uint32_t stream_lost_pending;    // blocks lost since the last published block
+
+static uint64_t stream_stat_blocks;
+static uint64_t stream_stat_lost;
+
+
+/**
+ * Adds the samples written since the last poll to the unread count
+ */
+static int pollWritePointer()
+{
+    uint64_t written;
+    ECHECK(acq_GetWrittenSince(stream_wp, stream_wp_time, &written, &stream_wp, &stream_wp_time));
+
+    stream_unread += written;
+    return RP_OK;
+}
+
+static void skipBlocks(uint64_t blocks)
+{
+    stream_rd = (stream_rd + blocks * STREAM_BLOCK) % ADC_BUFFER_SIZE;
+    stream_unread -= blocks * STREAM_BLOCK;
+    stream_seq += blocks;
+    stream_lost_pending += blocks;
+    stream_stat_lost += blocks;
+}
+
+static void readBlock(rp_acq_stream_block_t* block)
+{
+    const volatile uint32_t* raw[2] = { osc_GetDataBufferChA(), osc_GetDataBufferChB() };
+    rdo_segment_t seg[2];
+    int segs = rdo_Split(stream_rd, STREAM_BLOCK, seg);
+
+    for (int ch = 0; ch < 2; ++ch) {
+        rp_pinState_t gain;
+        acq_GetGain(ch, &gain);
+        const calib_conv_t* conv = calib_GetFrontEndConv(ch, gain);
+        int16_t* dst = block->data[ch];
+
+        for (int s = 0; s < segs; ++s) {
+            rdo_CntsToRaw(dst, raw[ch] + seg[s].pos, seg[s].len, conv->dc_offs);
+            dst += seg[s].len;
+        }
+        block->scale[ch] = conv->scale;
+    }
+}
+
+static void* streamThread(void* arg)
+{
+    int status = RP_OK;
+
+    while (__atomic_load_n(&stream_running, __ATOMIC_ACQUIRE)) {
+        uint32_t decimation;
+        status = acq_GetDecimationFactor(&decimation);
+        if (status == RP_OK) {
+            status = pollWritePointer();
+        }
+        if (status != RP_OK) {
+            break;
+        }
+        const uint64_t period_ns = ADC_SAMPLE_PERIOD * decimation;
+
+        if (stream_unread > ADC_BUFFER_SIZE - STREAM_BLOCK) {
+            // The writer is about to overwrite unread samples, resume one block behind it
+            skipBlocks((stream_unread - (ADC_BUFFER_SIZE - STREAM_BLOCK) + STREAM_BLOCK - 1) / STREAM_BLOCK);
+        }
+
+        if (stream_unread < STREAM_BLOCK) {
+            uint64_t ns = (STREAM_BLOCK - stream_unread) * period_ns;
+            struct timespec ts;
+
+            ns = MIN(MAX(ns, STREAM_SLEEP_MIN), STREAM_SLEEP_MAX);
+            ts.tv_sec = ns / 1000000000ULL;
+            ts.tv_nsec = ns % 1000000000ULL;
+            nanosleep(&ts, NULL);
+            continue;
+        }
+
+        uint32_t head = stream_ring_head;
+        if (head - __atomic_load_n(&stream_ring_tail, __ATOMIC_ACQUIRE) > stream_ring_mask) {
+            // The client does not keep up
+            skipBlocks(1);
+            continue;
+        }
+
+        rp_acq_stream_block_t* block = &stream_ring[head & stream_ring_mask];
+        readBlock(block);
+
+        status = pollWritePointer();
+        if (status != RP_OK) {
+            break;
+        }
+        if (stream_unread > ADC_BUFFER_SIZE) {
+            // The writer has passed the block while it was copied
+            skipBlocks(1);
+            continue;
+        }
+
+        block->seq = stream_seq;
+        block->sample = stream_seq * STREAM_BLOCK;
+        block->time_ns = stream_wp_time;
+        block->lost = stream_lost_pending;
+        block->decimation = decimation;
+        __atomic_store_n(&stream_ring_head, head + 1, __ATOMIC_RELEASE);
+        sem_post(&stream_ring_avail);
+
+        stream_lost_pending = 0;
+        stream_rd = (stream_rd + STREAM_BLOCK) % ADC_BUFFER_SIZE;
+        stream_unread -= STREAM_BLOCK;
+        stream_seq++;
+        stream_stat_blocks++;
+    }
+
+    if (status != RP_OK) {
+        // Wake the client, it reports the error once the published blocks are taken
+        __atomic_store_n(&stream_error, status, __ATOMIC_RELEASE);
+        sem_post(&stream_ring_avail);
+    }
+    return NULL;
+}
+
+int acq_StreamStart(uint32_t ring_len)
+{
+    if (stream_started) {
+        acq_StreamStop(NULL, NULL);
+    }
+
+    if (!ring_len) {
+        ring_len = STREAM_RING_LEN_DEFAULT;
+    }
+    if (ring_len > STREAM_RING_LEN_MAX) {
+        return RP_EOOR;
+    }
+    // Round up to a power of two, the free running indices then stay consistent when they wrap
+    uint32_t len = 1;
+    while (len < ring_len) {
+        len <<= 1;
+    }
+
+    stream_ring = calloc(len, sizeof(rp_acq_stream_block_t));
+    if (!stream_ring) {
+        return RP_EOOR;
+    }
+    stream_ring_mask = len - 1;
+    stream_ring_head = 0;
+    stream_ring_tail = 0;
+    stream_error = RP_OK;
+    sem_init(&stream_ring_avail, 0, 0);
+
+    bool acquiring = false;
+    int status = acq_SetTriggerSrc(RP_TRIG_SRC_DISABLED);
+    if (status == RP_OK) {
+        status = acq_Start();
+        acquiring = (status == RP_OK);
+    }
+    if (status == RP_OK) {
+        status = acq_GetWritePointerTime(&stream_wp, &stream_wp_time);
+    }
+
+    if (status == RP_OK) {
+        stream_rd = (stream_wp + 1) % ADC_BUFFER_SIZE;
+        stream_unread = 0;
+        stream_seq = 0;
+        stream_lost_pending = 0;
+        stream_stat_blocks = 0;
+        stream_stat_lost = 0;
+
+        __atomic_store_n(&stream_running, true, __ATOMIC_RELEASE);
+        if (pthread_create(&stream_thread, NULL, streamThread, NULL)) {
+            __atomic_store_n(&stream_running, false, __ATOMIC_RELEASE);
+            status = RP_EUF;
+        }
+    }
+
+    if (status != RP_OK) {
+        if (acquiring) {
+            acq_Stop();
+        }
+        sem_destroy(&stream_ring_avail);
+        free(stream_ring);
+        stream_ring = NULL;
+        return status;
+    }
+
+    __atomic_store_n(&stream_started, true, __ATOMIC_SEQ_CST);
+    return RP_OK;
+}
+
+int acq_StreamRead(rp_acq_stream_block_t* block, uint32_t timeout_ms)
+{
+    // Announce the client before the check, acq_StreamStop() then waits for it to leave
+    __atomic_add_fetch(&stream_clients, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&stream_started, __ATOMIC_SEQ_CST)) {
+        __atomic_sub_fetch(&stream_clients, 1, __ATOMIC_SEQ_CST);
+        return RP_ENST;
+    }
+
+    int status = RP_OK;
+    int ret;
+    if (!timeout_ms) {
+        ret = sem_trywait(&stream_ring_avail);
+    }
+    else {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += timeout_ms / 1000;
+        ts.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        while ((ret = sem_timedwait(&stream_ring_avail, &ts)) && errno == EINTR);
+    }
+
+    uint32_t tail = stream_ring_tail;
+    if (!__atomic_load_n(&stream_started, __ATOMIC_SEQ_CST)) {
+        status = RP_ENST;
+    }
+    else if (ret) {
+        status = __atomic_load_n(&stream_error, __ATOMIC_ACQUIRE);
+        status = (status != RP_OK) ? status : RP_ETMO;
+    }
+    else if (tail == __atomic_load_n(&stream_ring_head, __ATOMIC_ACQUIRE)) {
+        // Woken by the failed reader thread, pass the wake-up on
+        sem_post(&stream_ring_avail);
+        status = __atomic_load_n(&stream_error, __ATOMIC_ACQUIRE);
+    }
+    else {
+        memcpy(block, &stream_ring[tail & stream_ring_mask], sizeof(rp_acq_stream_block_t));
+        __atomic_store_n(&stream_ring_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    if (status == RP_ENST) {
+        // Woken by acq_StreamStop(), pass the wake-up on
+        sem_post(&stream_ring_avail);
+    }
+    __atomic_sub_fetch(&stream_clients, 1, __ATOMIC_SEQ_CST);
+    return status;
+}
+
+int acq_StreamStop(uint64_t* blocks, uint64_t* lost)
+{
+    if (!stream_started) {
+        return RP_ENST;
+    }
+
+    __atomic_store_n(&stream_started, false, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&stream_running, false, __ATOMIC_RELEASE);
+    pthread_join(stream_thread, NULL);
+
+    // Wake the waiting clients and let them leave before the ring and the semaphore go away
+    sem_post(&stream_ring_avail);
+    while (__atomic_load_n(&stream_clients, __ATOMIC_SEQ_CST)) {
+        sched_yield();
+    }
+    sem_destroy(&stream_ring_avail);
+    free(stream_ring);
+    stream_ring = NULL;
+
+    if (blocks) {
+        *blocks = stream_stat_blocks;
+    }
+    if (lost) {
+        *lost = stream_stat_lost;
+    }
+    return acq_Stop();
+}
@@ -0,0 +1,25 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library gapless acquisition stream interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_ACQ_STREAM_H_
+#define SRC_ACQ_STREAM_H_
+
+#include <stdint.h>
+#include "redpitaya/rp.h"
+
+int acq_StreamStart(uint32_t ring_len);
+int acq_StreamRead(rp_acq_stream_block_t* block, uint32_t timeout_ms);
+int acq_StreamStop(uint64_t* blocks, uint64_t* lost);
+
+#endif /* SRC_ACQ_STREAM_H_ */
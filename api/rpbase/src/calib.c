@@ -13,7 +13,8 @@
  */
 
 #include <stdlib.h>
-#include <unistd.h>
+#include <string.h>
+#include <time.h>
 #include "redpitaya/rp.h"
 #include "common.h"
 #include "generate.h"
@@ -21,7 +22,16 @@
 
 #define CALIB_MAGIC 0xAABBCCDD
 
+// Histogram bins of the raw ADC counts
+#define CALIB_HIST_LEN      (1 << 14)
+// Age up to which a capture of terminated inputs is reused [ns]
+#define CALIB_REUSE_NS      1000000000ULL
+// Bounds of the wait for an acquisition [ns]
+#define CALIB_POLL_MIN_NS   50000ULL
+#define CALIB_TIMEOUT_NS    2000000000ULL
+
 int calib_ReadParams(rp_calib_params_t *calib_params);
+static int32_t getDataMedian(rp_channel_t channel, rp_pinState_t gain, bool reuse);
 
 static const char eeprom_device[]="/sys/bus/i2c/devices/0-0050/eeprom";
 static const int  eeprom_calib_off=0x0008;
@@ -29,10 +39,49 @@ static const int  eeprom_calib_off=0x0008;
 // Cached parameter values.
 static rp_calib_params_t calib, failsafa_params;
 
+// Conversions derived from the cached parameter values, indexed by channel and gain.
+static calib_conv_t fe_conv[2][2];
+static calib_conv_t be_conv[2];
+
+static const int ADC_BITS = 14;
+
+/* @brief Sampling period (non-decimated) [ns] */
+static const uint64_t ADC_SAMPLE_PERIOD = 8;
+
+static void setConv(calib_conv_t* conv, uint32_t field_len, int32_t dc_offs, uint32_t fs, float max_v)
+{
+    conv->dc_offs = dc_offs;
+    conv->fs = fs;
+    conv->fs_v = cmn_CalibFullScaleToVoltage(fs);
+    conv->max_v = max_v;
+    conv->scale = cmn_CnvCalibCntToV(field_len, 1, max_v, conv->fs_v, 0.0);
+}
+
+/**
+ * Rebuilds the conversions after the cached parameter values have changed.
+ */
+static void calib_UpdateConv()
+{
+    setConv(&fe_conv[RP_CH_1][RP_LOW],  ADC_BITS, calib.fe_ch1_lo_offs, calib.fe_ch1_fs_g_lo, 1.0);
+    setConv(&fe_conv[RP_CH_1][RP_HIGH], ADC_BITS, calib.fe_ch1_hi_offs, calib.fe_ch1_fs_g_hi, 20.0);
+    setConv(&fe_conv[RP_CH_2][RP_LOW],  ADC_BITS, calib.fe_ch2_lo_offs, calib.fe_ch2_fs_g_lo, 1.0);
+    setConv(&fe_conv[RP_CH_2][RP_HIGH], ADC_BITS, calib.fe_ch2_hi_offs, calib.fe_ch2_fs_g_hi, 20.0);
+
+    setConv(&be_conv[RP_CH_1], DATA_BIT_LENGTH, calib.be_ch1_dc_offs, calib.be_ch1_fs, AMPLITUDE_MAX);
+    setConv(&be_conv[RP_CH_2], DATA_BIT_LENGTH, calib.be_ch2_dc_offs, calib.be_ch2_fs, AMPLITUDE_MAX);
+}
+
+static void calib_SetCached(rp_calib_params_t params)
+{
+    calib = params;
+    calib_UpdateConv();
+}
+
 int calib_Init()
 {
-    ECHECK(calib_ReadParams(&calib));
-    return RP_OK;
+    int status = calib_ReadParams(&calib);
+    calib_UpdateConv();
+    return status;
 }
 
 int calib_Release()
@@ -148,6 +197,8 @@ int calib_WriteParams(rp_calib_params_t calib_params) {
     }
     fclose(fp);
 
+    /* the EEPROM content is in use from now on */
+    calib_SetCached(calib_params);
     return RP_OK;
 }
 
@@ -165,6 +216,7 @@ void calib_SetToZero() {
     calib.fe_ch1_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
     calib.fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20);
     calib.fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
+    calib_UpdateConv();
 }
 
 uint32_t calib_GetFrontEndScale(rp_channel_t channel, rp_pinState_t gain) {
@@ -176,6 +228,20 @@ uint32_t calib_GetFrontEndScale(rp_channel_t channel, rp_pinState_t gain) {
     }
 }
 
+/**
+ * Returns the conversion of the front end, it is valid until the calibration changes.
+ */
+const calib_conv_t* calib_GetFrontEndConv(rp_channel_t channel, rp_pinState_t gain) {
+    return &fe_conv[channel == RP_CH_1 ? RP_CH_1 : RP_CH_2][gain == RP_HIGH ? RP_HIGH : RP_LOW];
+}
+
+/**
+ * Returns the conversion of the back end, it is valid until the calibration changes.
+ */
+const calib_conv_t* calib_GetBackEndConv(rp_channel_t channel) {
+    return &be_conv[channel == RP_CH_1 ? RP_CH_1 : RP_CH_2];
+}
+
 int calib_SetFrontEndOffset(rp_channel_t channel, rp_pinState_t gain, rp_calib_params_t* out_params) {
     rp_calib_params_t params;
     ECHECK(calib_ReadParams(&params));
@@ -192,16 +258,17 @@ int calib_SetFrontEndOffset(rp_channel_t channel, rp_pinState_t gain, rp_calib_p
             params.fe_ch2_hi_offs = 0)
 	}
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    calib_SetCached(params);
 
+    /* Both inputs are terminated, the capture is shared with the step of the other channel */
 	if (gain == RP_LOW) {
 		CHANNEL_ACTION(channel,
-			params.fe_ch1_lo_offs = calib_GetDataMedian(channel, RP_LOW),
-			params.fe_ch2_lo_offs = calib_GetDataMedian(channel, RP_LOW))
+			params.fe_ch1_lo_offs = getDataMedian(channel, RP_LOW, true),
+			params.fe_ch2_lo_offs = getDataMedian(channel, RP_LOW, true))
 	} else {
 		CHANNEL_ACTION(channel,
-			params.fe_ch1_hi_offs = calib_GetDataMedian(channel, RP_HIGH),
-			params.fe_ch2_hi_offs = calib_GetDataMedian(channel, RP_HIGH))
+			params.fe_ch1_hi_offs = getDataMedian(channel, RP_HIGH, true),
+			params.fe_ch2_hi_offs = getDataMedian(channel, RP_HIGH, true))
 	}
 
     /* Set new local parameter */
@@ -232,7 +299,7 @@ int calib_SetFrontEndScaleLV(rp_channel_t channel, float referentialVoltage, rp_
             params.fe_ch1_fs_g_lo = cmn_CalibFullScaleFromVoltage(20),
             params.fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20))
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    calib_SetCached(params);
 
     /* Calculate real max adc voltage */
     float value = calib_GetDataMedianFloat(channel, RP_LOW);
@@ -264,7 +331,7 @@ int calib_SetFrontEndScaleHV(rp_channel_t channel, float referentialVoltage, rp_
             params.fe_ch1_fs_g_hi = cmn_CalibFullScaleFromVoltage(1),
             params.fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(1))
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    calib_SetCached(params);
 
     /* Calculate real max adc voltage */
     float value = calib_GetDataMedianFloat(channel, RP_HIGH);
@@ -296,7 +363,7 @@ int calib_SetBackEndOffset(rp_channel_t channel) {
             params.be_ch1_dc_offs = 0,
             params.be_ch2_dc_offs = 0)
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    calib_SetCached(params);
 
     /* Generate zero signal */
     ECHECK(rp_GenReset());
@@ -324,7 +391,7 @@ int calib_SetBackEndScale(rp_channel_t channel) {
             params.be_ch1_fs = cmn_CalibFullScaleFromVoltage(1),
             params.be_ch2_fs = cmn_CalibFullScaleFromVoltage(1))
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    calib_SetCached(params);
 
     /* Generate constant signal signal */
     ECHECK(rp_GenReset());
@@ -381,7 +448,7 @@ int calib_CalibrateBackEnd(rp_channel_t channel, rp_calib_params_t* out_params)
             params.be_ch2_dc_offs = 0)
 
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    calib_SetCached(params);
 
     float value1, value2;
     getGenAmp(channel, CONSTANT_SIGNAL_AMPLITUDE, &value1, &value2);
@@ -426,73 +493,190 @@ int calib_Reset() {
     return calib_Init();
 }
 
-int32_t calib_GetDataMedian(rp_channel_t channel, rp_pinState_t gain) {
-    /* Acquire data */
+/* Statistics of the calibrated counts of one channel */
+typedef struct {
+    int64_t sum;
+    int32_t min;
+    int32_t max;
+} calib_stats_t;
+
+/*
+ * The last capture of both channels, as histograms of the raw counts. The statistics are evaluated
+ * with the current DC offset, thus a capture stays valid while the offsets are reset and
+ * recalculated. A capture of terminated inputs is reused by the next step of the same gain
+ * within CALIB_REUSE_NS, as long as no other acquisition has been started meanwhile.
+ */
+static struct {
+    bool valid;
+    bool shared;
+    rp_pinState_t gain;
+    rp_acq_decimation_t decimation;
+    uint32_t generation;
+    uint64_t time_ns;
+    uint32_t hist[2][CALIB_HIST_LEN];
+} capture;
+
+static uint64_t getTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleepNs(uint64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * Waits until the acquisition has triggered and the write pointer has stopped after the delay.
+ */
+static int waitAcquired(uint32_t decimation) {
+    const uint64_t period_ns = ADC_SAMPLE_PERIOD * decimation;
+    const uint64_t timeout_ns = MAX(CALIB_TIMEOUT_NS, 4 * ADC_BUFFER_SIZE * period_ns);
+    const uint64_t start_ns = getTimeNs();
+    uint32_t wp, last_wp = UINT32_MAX;
+    rp_acq_trig_state_t state;
+
+    /* The buffer can not be complete before it was written once */
+    sleepNs(ADC_BUFFER_SIZE * period_ns);
+    for (;;) {
+        ECHECK(rp_AcqGetTriggerState(&state));
+        ECHECK(rp_AcqGetWritePointer(&wp));
+        if (state == RP_TRIG_STATE_TRIGGERED && wp == last_wp) {
+            return RP_OK;
+        }
+        if (getTimeNs() - start_ns > timeout_ns) {
+            return RP_ETMO;
+        }
+        last_wp = wp;
+        sleepNs(MAX(2 * period_ns, CALIB_POLL_MIN_NS));
+    }
+}
+
+static int addHist(const volatile uint32_t* data, uint32_t len, uint32_t offset, void* ctx) {
+    uint32_t* hist = ctx;
+
+    for (uint32_t i = 0; i < len; ++i) {
+        hist[data[i] & (CALIB_HIST_LEN - 1)]++;
+    }
+    return RP_OK;
+}
+
+/**
+ * Acquires one buffer of both channels and takes the histograms in place, without copying.
+ * Both channels are set to gain, the caller restores the other one.
+ */
+static int acquireHist(rp_pinState_t gain, bool shared) {
+    const rp_acq_decimation_t decimation = RP_DEC_64;
+    uint32_t factor;
+
+    capture.valid = false;
     ECHECK(rp_AcqReset());
-    ECHECK(rp_AcqSetGain(channel, gain));
-    ECHECK(rp_AcqSetDecimation(RP_DEC_64));
+    ECHECK(rp_AcqSetGain(RP_CH_1, gain));
+    ECHECK(rp_AcqSetGain(RP_CH_2, gain));
+    ECHECK(rp_AcqSetDecimation(decimation));
+    ECHECK(rp_AcqGetDecimationFactor(&factor));
+    /* The whole buffer is written after the trigger */
+    ECHECK(rp_AcqSetTriggerDelay(ADC_BUFFER_SIZE / 2));
     ECHECK(rp_AcqStart());
     ECHECK(rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW));
-    usleep(1000000);
+    int status = waitAcquired(factor);
     ECHECK(rp_AcqStop());
+    ECHECK(status);
 
-    int16_t data[BUFFER_LENGTH];
-    uint32_t bufferSize = (uint32_t) BUFFER_LENGTH;
-    ECHECK(rp_AcqGetDataRaw(channel, 0, &bufferSize, data));
+    for (int ch = 0; ch < 2; ++ch) {
+        rp_acq_buffer_view_t view;
+        ECHECK(rp_AcqGetBufferView(ch, 0, ADC_BUFFER_SIZE, &view));
+        memset(capture.hist[ch], 0, sizeof(capture.hist[ch]));
+        ECHECK(rp_AcqBufferViewForEach(&view, addHist, capture.hist[ch]));
+    }
 
-    long long avg = 0;
-    for(int i = 0; i < BUFFER_LENGTH; ++i)
-        avg += data[i];
+    ECHECK(rp_AcqGetBufferGeneration(&capture.generation));
+    capture.gain = gain;
+    capture.decimation = decimation;
+    capture.shared = shared;
+    capture.time_ns = getTimeNs();
+    capture.valid = true;
+    return RP_OK;
+}
 
-    avg /= BUFFER_LENGTH;
-    fprintf(stderr, "\ncalib_GetDataMedian: avg = %d\n", (int32_t)avg);
-    return avg;
+/**
+ * Acquires a new capture for channel, the gain of the other channel is left as it was.
+ */
+static int acquire(rp_channel_t channel, rp_pinState_t gain, bool shared) {
+    rp_channel_t other = (channel == RP_CH_1) ? RP_CH_2 : RP_CH_1;
+    rp_pinState_t other_gain;
+    ECHECK(rp_AcqGetGain(other, &other_gain));
+
+    int status = acquireHist(gain, shared);
+    ECHECK(rp_AcqSetGain(other, other_gain));
+    return status;
 }
 
-float calib_GetDataMedianFloat(rp_channel_t channel, rp_pinState_t gain) {
-    ECHECK(rp_AcqReset());
-    ECHECK(rp_AcqSetGain(channel, gain));
-    ECHECK(rp_AcqSetDecimation(RP_DEC_64));
-    ECHECK(rp_AcqStart());
-    ECHECK(rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW));
-    usleep(1000000);
-    int BUF_SIZE = BUFFER_LENGTH;
+/**
+ * Evaluates the capture of a channel, a new one is acquired unless the last one can be reused.
+ */
+static int getDataStats(rp_channel_t channel, rp_pinState_t gain, bool reuse, calib_stats_t* stats) {
+    uint32_t generation;
+    ECHECK(rp_AcqGetBufferGeneration(&generation));
 
-    ECHECK(rp_AcqStop());
+    if (!(reuse && capture.valid && capture.shared && capture.gain == gain &&
+            capture.generation == generation && getTimeNs() - capture.time_ns < CALIB_REUSE_NS)) {
+        ECHECK(acquire(channel, gain, reuse));
+    }
 
-    float data[BUF_SIZE];
-    uint32_t bufferSize = (uint32_t) BUF_SIZE;
-    ECHECK(rp_AcqGetDataV(channel, 0, &bufferSize, data));
+    const uint32_t* hist = capture.hist[channel == RP_CH_1 ? RP_CH_1 : RP_CH_2];
+    int32_t dc_offs = calib_GetFrontEndConv(channel, gain)->dc_offs;
+
+    stats->sum = 0;
+    stats->min = 1 << ADC_BITS;
+    stats->max = -(1 << ADC_BITS);
+    for (uint32_t raw = 0; raw < CALIB_HIST_LEN; ++raw) {
+        if (hist[raw]) {
+            int32_t cnts = cmn_CalibCnts(ADC_BITS, raw, dc_offs);
+            stats->sum += (int64_t) cnts * hist[raw];
+            stats->min = (stats->min > cnts) ? cnts : stats->min;
+            stats->max = (stats->max < cnts) ? cnts : stats->max;
+        }
+    }
+    return RP_OK;
+}
 
-    double avg = 0;
-    for(int i = 0; i < BUFFER_LENGTH; ++i)
-        avg += data[i];
+static int32_t getDataMedian(rp_channel_t channel, rp_pinState_t gain, bool reuse) {
+    calib_stats_t stats;
+    ECHECK(getDataStats(channel, gain, reuse, &stats));
 
-    avg /= BUFFER_LENGTH;
-    fprintf(stderr, "\ncalib_GetDataMedianFloat: avg = %f\n", (float)avg);
+    long long avg = stats.sum / ADC_BUFFER_SIZE;
+    fprintf(stderr, "\ncalib_GetDataMedian: avg = %d\n", (int32_t)avg);
     return avg;
 }
 
-int calib_GetDataMinMaxFloat(rp_channel_t channel, rp_pinState_t gain, float* min, float* max) {
-    ECHECK(rp_AcqReset());
-    ECHECK(rp_AcqSetGain(channel, gain));
-    ECHECK(rp_AcqSetDecimation(RP_DEC_64));
-    ECHECK(rp_AcqStart());
-    ECHECK(rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW));
-    usleep(1000000);
-    int BUF_SIZE = BUFFER_LENGTH;
+int32_t calib_GetDataMedian(rp_channel_t channel, rp_pinState_t gain) {
+    return getDataMedian(channel, gain, false);
+}
 
-    ECHECK(rp_AcqStop());
+float calib_GetDataMedianFloat(rp_channel_t channel, rp_pinState_t gain) {
+    calib_stats_t stats;
+    ECHECK(getDataStats(channel, gain, false, &stats));
 
-    float data[BUF_SIZE];
-    uint32_t bufferSize = (uint32_t) BUF_SIZE;
-    ECHECK(rp_AcqGetDataV(channel, 0, &bufferSize, data));
+    double avg = (double)stats.sum / ADC_BUFFER_SIZE * calib_GetFrontEndConv(channel, gain)->scale;
+    fprintf(stderr, "\ncalib_GetDataMedianFloat: avg = %f\n", (float)avg);
+    return avg;
+}
 
-    float _min = data[0];
-    float _max = data[0];
-    for(int i = 1; i < BUFFER_LENGTH; ++i) {
-        _min = (_min > data[i]) ? data[i] : _min;
-        _max = (_max < data[i]) ? data[i] : _max;
+int calib_GetDataMinMaxFloat(rp_channel_t channel, rp_pinState_t gain, float* min, float* max) {
+    calib_stats_t stats;
+    ECHECK(getDataStats(channel, gain, false, &stats));
+
+    float scale = calib_GetFrontEndConv(channel, gain)->scale;
+    float _min = stats.min * scale;
+    float _max = stats.max * scale;
+    if (_min > _max) {
+        float tmp = _min;
+        _min = _max;
+        _max = tmp;
     }
 
     fprintf(stderr, "\ncalib_GetDataMinMaxFloat: min = %f, max = %f\n", _min, _max);
@@ -504,7 +688,7 @@ int calib_GetDataMinMaxFloat(rp_channel_t channel, rp_pinState_t gain, float* mi
 int calib_setCachedParams() {
 	fprintf(stderr, "write FAILSAFE PARAMS\n");
     ECHECK(calib_WriteParams(failsafa_params));
-    calib = failsafa_params;
+    calib_SetCached(failsafa_params);
 
     return 0;
 }
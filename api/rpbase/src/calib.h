@@ -21,6 +21,18 @@
 
 #define CONSTANT_SIGNAL_AMPLITUDE 0.8
 
+/**
+ * Count to volt conversion of one front end (channel, gain) or back end (channel) setting,
+ * derived from the cached calibration parameters
+ */
+typedef struct calib_conv_s {
+    int32_t  dc_offs;   // calibrated DC offset [counts]
+    uint32_t fs;        // calibration full scale, EEPROM format
+    float    fs_v;      // calibration full scale [V], 1 if not calibrated
+    float    max_v;     // full range of the counts [V]
+    float    scale;     // [V] per calibrated count
+} calib_conv_t;
+
 int calib_Init();
 int calib_Release();
 
@@ -29,6 +41,8 @@ int calib_WriteParams(rp_calib_params_t calib_params);
 void calib_SetToZero();
 
 uint32_t calib_GetFrontEndScale(rp_channel_t channel, rp_pinState_t gain);
+const calib_conv_t* calib_GetFrontEndConv(rp_channel_t channel, rp_pinState_t gain);
+const calib_conv_t* calib_GetBackEndConv(rp_channel_t channel);
 int calib_SetFrontEndOffset(rp_channel_t channel, rp_pinState_t gain, rp_calib_params_t* out_params);
 int calib_SetFrontEndScaleLV(rp_channel_t channel, float referentialVoltage, rp_calib_params_t* out_params);
 int calib_SetFrontEndScaleHV(rp_channel_t channel, float referentialVoltage, rp_calib_params_t* out_params);
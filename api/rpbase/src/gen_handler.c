@@ -34,8 +34,30 @@ uint32_t      chA_arb_size = BUFFER_LENGTH, chB_arb_size = BUFFER_LENGTH;
 
 float chA_arbitraryData[BUFFER_LENGTH];
 float chB_arbitraryData[BUFFER_LENGTH];
+uint32_t chA_arbitraryVersion = 0, chB_arbitraryVersion = 0;
+
+// Count of quantized waveform tables kept
+#define WAVE_CACHE_LEN 4
+
+/**
+ * Quantized waveform table. The table does not depend on the phase, which is applied by rotating
+ * the start index of the upload, nor on amplitude and offset, which are FPGA registers.
+ */
+typedef struct {
+    bool valid;
+    rp_waveform_t waveform;
+    int param;                      // PWM: high samples, square: transition samples, arbitrary: version
+    rp_channel_t channel;           // arbitrary only
+    uint32_t used;                  // LRU stamp
+    uint16_t cnts[BUFFER_LENGTH];
+} wave_cache_t;
+
+static wave_cache_t wave_cache[WAVE_CACHE_LEN];
+static uint32_t wave_cache_clock = 0;
 
 int gen_SetDefaultValues() {
+    // The buffers are rewritten in full, whoever else may have written them
+    generate_invalidateShadow();
     ECHECK(gen_Disable(RP_CH_1));
     ECHECK(gen_Disable(RP_CH_2));
     ECHECK(gen_setFrequency(RP_CH_1, 1000));
@@ -215,6 +237,9 @@ int gen_setArbWaveform(rp_channel_t channel, float *data, uint32_t length) {
     for(i = length; i < BUFFER_LENGTH; i++) { // clear the rest of the buffer
         pointer[i] = 0;
     }
+    CHANNEL_ACTION(channel,
+            chA_arbitraryVersion++,
+            chB_arbitraryVersion++)
 
     if (channel == RP_CH_1) {
         chA_arb_size = length;
@@ -446,8 +471,68 @@ int gen_Synchronise() {
     return generate_Synchronise();
 }
 
-int synthesize_signal(rp_channel_t channel) {
+static int squareTransition(float frequency) {
+    // Various locally used constants - HW specific parameters
+    const int trans0 = 30;
+    const int trans1 = 300;
+
+    int trans = (int) (frequency / 1e6 * trans1); // 300 samples at 1 MHz
+
+    if (trans <= 10)  trans = trans0;
+    return trans;
+}
+
+/**
+ * Returns the quantized table of the waveform, it is synthesized only if not cached yet
+ */
+static const uint16_t* getWaveTable(rp_channel_t channel, rp_waveform_t waveform, float dutyCycle, float frequency) {
+    int param = 0;
+
+    switch (waveform) {
+        case RP_WAVEFORM_SQUARE   : param = squareTransition(frequency);                      break;
+        case RP_WAVEFORM_PWM      : param = (int) (BUFFER_LENGTH/2 * dutyCycle);              break;
+        case RP_WAVEFORM_ARBITRARY: param = channel == RP_CH_1 ? chA_arbitraryVersion : chB_arbitraryVersion; break;
+        default:                                                                              break;
+    }
+
+    wave_cache_t *entry = &wave_cache[0];
+    for (int i = 0; i < WAVE_CACHE_LEN; i++) {
+        wave_cache_t *e = &wave_cache[i];
+        if (e->valid && e->waveform == waveform && e->param == param &&
+                (waveform != RP_WAVEFORM_ARBITRARY || e->channel == channel)) {
+            e->used = ++wave_cache_clock;
+            return e->cnts;
+        }
+        if (!e->valid || (entry->valid && e->used < entry->used)) {
+            entry = e;
+        }
+    }
+
     float data[BUFFER_LENGTH];
+    uint32_t size;
+
+    switch (waveform) {
+        case RP_WAVEFORM_SINE     : synthesis_sin      (data);                 break;
+        case RP_WAVEFORM_TRIANGLE : synthesis_triangle (data);                 break;
+        case RP_WAVEFORM_SQUARE   : synthesis_square   (frequency, data);      break;
+        case RP_WAVEFORM_RAMP_UP  : synthesis_rampUp   (data);                 break;
+        case RP_WAVEFORM_RAMP_DOWN: synthesis_rampDown (data);                 break;
+        case RP_WAVEFORM_DC       : synthesis_DC       (data);                 break;
+        case RP_WAVEFORM_PWM      : synthesis_PWM      (dutyCycle, data);      break;
+        case RP_WAVEFORM_ARBITRARY: synthesis_arbitrary(channel, data, &size); break;
+        default:                    return NULL;
+    }
+
+    generate_cnvVToCnts(data, entry->cnts, BUFFER_LENGTH);
+    entry->valid = true;
+    entry->waveform = waveform;
+    entry->param = param;
+    entry->channel = channel;
+    entry->used = ++wave_cache_clock;
+    return entry->cnts;
+}
+
+int synthesize_signal(rp_channel_t channel) {
     rp_waveform_t waveform;
     float dutyCycle, frequency;
     uint32_t size, phase;
@@ -470,18 +555,14 @@ int synthesize_signal(rp_channel_t channel) {
         return RP_EPN;
     }
 
-    switch (waveform) {
-        case RP_WAVEFORM_SINE     : synthesis_sin      (data);                 break;
-        case RP_WAVEFORM_TRIANGLE : synthesis_triangle (data);                 break;
-        case RP_WAVEFORM_SQUARE   : synthesis_square   (frequency, data);      break;
-        case RP_WAVEFORM_RAMP_UP  : synthesis_rampUp   (data);                 break;
-        case RP_WAVEFORM_RAMP_DOWN: synthesis_rampDown (data);                 break;
-        case RP_WAVEFORM_DC       : synthesis_DC       (data);                 break;
-        case RP_WAVEFORM_PWM      : synthesis_PWM      (dutyCycle, data);      break;
-        case RP_WAVEFORM_ARBITRARY: synthesis_arbitrary(channel, data, &size); break;
-        default:                    return RP_EIPV;
+    const uint16_t *cnts = getWaveTable(channel, waveform, dutyCycle, frequency);
+    if (!cnts) {
+        return RP_EIPV;
+    }
+    if (waveform == RP_WAVEFORM_ARBITRARY) {
+        size = channel == RP_CH_1 ? chA_arb_size : chB_arb_size;
     }
-    return generate_writeData(channel, data, phase, size);
+    return generate_writeDataCnts(channel, cnts, phase, size);
 }
 
 int synthesis_sin(float *data_out) {
@@ -550,13 +631,7 @@ int synthesis_arbitrary(rp_channel_t channel, float *data_out, uint32_t * size)
 }
 
 int synthesis_square(float frequency, float *data_out) {
-    // Various locally used constants - HW specific parameters
-    const int trans0 = 30;
-    const int trans1 = 300;
-
-    int trans = (int) (frequency / 1e6 * trans1); // 300 samples at 1 MHz
-
-    if (trans <= 10)  trans = trans0;
+    int trans = squareTransition(frequency);
 
     for(int unsigned i = 0; i < BUFFER_LENGTH; i++) {
         if      ((0 <= i                      ) && (i <  BUFFER_LENGTH/2 - trans))  data_out[i] =  1.0f;
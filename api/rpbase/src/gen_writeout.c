@@ -0,0 +1,114 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library bulk AWG buffer write kernels implementation
+ *
+ * A waveform is quantized once into a table of 14 bit DAC counts, the scaling and the offset are
+ * folded into one multiply-add per sample, followed by rounding and saturation. The table is
+ * written to the FPGA buffer in linear runs. On ARM both steps handle eight samples at once with
+ * NEON: the quantizer narrows two float vectors into one vector of counts in the RAM table, the
+ * writer compares eight counts with the shadow of the buffer and, when any of them differs, writes
+ * them to the FPGA with eight single word stores. Elsewhere the same is done sample by sample.
+ *
+ * The counts are the same as of cmn_CnvVToCnt() without calibration and user offset.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdint.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WRO_NEON 1
+#endif
+
+#include "gen_writeout.h"
+
+#define WRO_MASK        ((1 << WRO_BITS) - 1)
+
+static inline uint16_t wro_Quant(float v, float scale, float offs)
+{
+    float x = v * scale + offs;
+
+    // Round half away from zero like round(), then saturate, NaN gives 0
+    x += (x < 0.0f) ? -0.5f : 0.5f;
+    int32_t c = (x >= (float) WRO_MAX_CNT) ? WRO_MAX_CNT - 1 : (x <= (float) -WRO_MAX_CNT) ? -WRO_MAX_CNT :
+                (x == x) ? (int32_t) x : 0;
+    return (uint16_t) (c & WRO_MASK);
+}
+
+#ifdef WRO_NEON
+static inline int32x4_t wro_QuantQ(const float* src, float32x4_t k, float32x4_t d, int32x4_t lo, int32x4_t hi)
+{
+    float32x4_t x    = vmlaq_f32(d, vld1q_f32(src), k);
+    uint32x4_t  sign = vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0x80000000));
+    float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(sign, vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+
+    // The conversion truncates towards zero and saturates, NaN gives 0
+    return vminq_s32(vmaxq_s32(vcvtq_s32_f32(vaddq_f32(x, half)), lo), hi);
+}
+#endif
+
+/*----------------------------------------------------------------------------*/
+void wro_VToCnts(uint16_t* dst, const float* src, uint32_t n, float scale, float offs)
+{
+    uint32_t i = 0;
+
+#ifdef WRO_NEON
+    const float32x4_t k    = vdupq_n_f32(scale);
+    const float32x4_t d    = vdupq_n_f32(offs);
+    const int32x4_t   lo   = vdupq_n_s32(-WRO_MAX_CNT);
+    const int32x4_t   hi   = vdupq_n_s32(WRO_MAX_CNT - 1);
+    const uint16x8_t  mask = vdupq_n_u16(WRO_MASK);
+
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t a = wro_QuantQ(src + i,     k, d, lo, hi);
+        int32x4_t b = wro_QuantQ(src + i + 4, k, d, lo, hi);
+        vst1q_u16(dst + i, vandq_u16(vreinterpretq_u16_s16(vcombine_s16(vmovn_s32(a), vmovn_s32(b))), mask));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = wro_Quant(src[i], scale, offs);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+uint32_t wro_WriteChanged(volatile int32_t* dst, uint16_t* shadow, const uint16_t* src, uint32_t n, bool force)
+{
+    uint32_t written = 0;
+    uint32_t i = 0;
+
+#ifdef WRO_NEON
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t c = vld1q_u16(src + i);
+
+        if (!force) {
+            uint16x8_t d = veorq_u16(c, vld1q_u16(shadow + i));
+            uint64x2_t d2 = vreinterpretq_u64_u16(d);
+            if (!(vgetq_lane_u64(d2, 0) | vgetq_lane_u64(d2, 1))) {
+                continue;
+            }
+        }
+        // The AXI slave takes single 32 bit writes only, a vst1q_u32() to the buffer would be lost
+        for (uint32_t j = i; j < i + 8; j++) {
+            dst[j] = src[j];
+        }
+        vst1q_u16(shadow + i, c);
+        written += 8;
+    }
+#endif
+    for (; i < n; i++) {
+        if (force || shadow[i] != src[i]) {
+            dst[i] = src[i];
+            shadow[i] = src[i];
+            written++;
+        }
+    }
+    return written;
+}
@@ -0,0 +1,28 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library bulk AWG buffer write kernels interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_GEN_WRITEOUT_H_
+#define SRC_GEN_WRITEOUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The AWG buffer field is 14 bits wide, two's complement
+#define WRO_BITS        14
+#define WRO_MAX_CNT     (1 << (WRO_BITS - 1))
+
+void wro_VToCnts(uint16_t* dst, const float* src, uint32_t n, float scale, float offs);
+uint32_t wro_WriteChanged(volatile int32_t* dst, uint16_t* shadow, const uint16_t* src, uint32_t n, bool force);
+
+#endif /* SRC_GEN_WRITEOUT_H_ */
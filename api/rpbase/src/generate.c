@@ -20,17 +20,24 @@
 #include "common.h"
 #include "generate.h"
 #include "calib.h"
+#include "gen_writeout.h"
 
 static volatile generate_control_t *generate = NULL;
 static volatile int32_t *data_chA = NULL;
 static volatile int32_t *data_chB = NULL;
 
+// Words last written to the FPGA buffers, an upload writes only the words that differ
+static uint16_t shadow_chA[BUFFER_LENGTH];
+static uint16_t shadow_chB[BUFFER_LENGTH];
+static bool shadow_valid[2] = { false, false };
+
 
 int generate_Init() {
 //  ECHECK(cmn_Init());
     ECHECK(cmn_Map(GENERATE_BASE_SIZE, GENERATE_BASE_ADDR, (void **) &generate));
     data_chA = (int32_t *) ((char *) generate + (CHA_DATA_OFFSET));
     data_chB = (int32_t *) ((char *) generate + (CHB_DATA_OFFSET));
+    generate_invalidateShadow();
     return RP_OK;
 }
 
@@ -39,9 +46,19 @@ int generate_Release() {
 //  ECHECK(cmn_Release());
     data_chA = NULL;
     data_chB = NULL;
+    generate_invalidateShadow();
     return RP_OK;
 }
 
+/**
+ * Forgets the words last written, the next upload writes the whole buffers. Needed whenever the
+ * buffers may have been written by anybody else than generate_writeDataCnts().
+ */
+void generate_invalidateShadow() {
+    shadow_valid[RP_CH_1] = false;
+    shadow_valid[RP_CH_2] = false;
+}
+
 int getChannelPropertiesAddress(volatile ch_properties_t **ch_properties, rp_channel_t channel) {
     CHANNEL_ACTION(channel,
             *ch_properties = &generate->properties_chA,
@@ -74,46 +91,40 @@ int generate_getOutputEnabled(rp_channel_t channel, bool *enabled) {
 int generate_setAmplitude(rp_channel_t channel, float amplitude) {
     volatile ch_properties_t *ch_properties;
 
-    rp_calib_params_t calib = calib_GetParams();
-    uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
+    const calib_conv_t* conv = calib_GetBackEndConv(channel);
 
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    ch_properties->amplitudeScale = cmn_CnvVToCnt(DATA_BIT_LENGTH, amplitude, AMPLITUDE_MAX, false, amp_max, 0, 0.0);
+    ch_properties->amplitudeScale = cmn_CnvVToCnt(DATA_BIT_LENGTH, amplitude, AMPLITUDE_MAX, false, conv->fs, 0, 0.0);
     return RP_OK;
 }
 
 int generate_getAmplitude(rp_channel_t channel, float *amplitude) {
     volatile ch_properties_t *ch_properties;
 
-    rp_calib_params_t calib = calib_GetParams();
-    uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
+    const calib_conv_t* conv = calib_GetBackEndConv(channel);
 
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    *amplitude = cmn_CnvCntToV(DATA_BIT_LENGTH, ch_properties->amplitudeScale, AMPLITUDE_MAX, amp_max, 0, 0.0);
+    *amplitude = cmn_CalibCnts(DATA_BIT_LENGTH, ch_properties->amplitudeScale, 0) * conv->scale;
     return RP_OK;
 }
 
 int generate_setDCOffset(rp_channel_t channel, float offset) {
     volatile ch_properties_t *ch_properties;
 
-    rp_calib_params_t calib = calib_GetParams();
-    int dc_offs = channel == RP_CH_1 ? calib.be_ch1_dc_offs: calib.be_ch2_dc_offs;
-    uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
+    const calib_conv_t* conv = calib_GetBackEndConv(channel);
 
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    ch_properties->amplitudeOffset = cmn_CnvVToCnt(DATA_BIT_LENGTH, offset, (float) (OFFSET_MAX/2.f), false, amp_max, dc_offs, 0);
+    ch_properties->amplitudeOffset = cmn_CnvVToCnt(DATA_BIT_LENGTH, offset, (float) (OFFSET_MAX/2.f), false, conv->fs, conv->dc_offs, 0);
     return RP_OK;
 }
 
 int generate_getDCOffset(rp_channel_t channel, float *offset) {
     volatile ch_properties_t *ch_properties;
 
-    rp_calib_params_t calib = calib_GetParams();
-    int dc_offs = channel == RP_CH_1 ? calib.be_ch1_dc_offs: calib.be_ch2_dc_offs;
-    uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
+    const calib_conv_t* conv = calib_GetBackEndConv(channel);
 
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    *offset = cmn_CnvCntToV(DATA_BIT_LENGTH, ch_properties->amplitudeOffset, (float) (OFFSET_MAX/2.f), amp_max, dc_offs, 0);
+    *offset = cmn_CnvCalibCntToV(DATA_BIT_LENGTH, cmn_CalibCnts(DATA_BIT_LENGTH, ch_properties->amplitudeOffset, conv->dc_offs), (float) (OFFSET_MAX/2.f), conv->fs_v, 0);
     return RP_OK;
 }
 
@@ -222,22 +233,43 @@ int generate_Synchronise() {
     return RP_OK;
 }
 
-int generate_writeData(rp_channel_t channel, float *data, uint32_t start, uint32_t length) {
+/**
+ * Quantizes normalized samples [-1, 1] to the DAC counts written to the FPGA buffer
+ */
+void generate_cnvVToCnts(const float *data, uint16_t *cnts, uint32_t length) {
+    wro_VToCnts(cnts, data, length, (float) WRO_MAX_CNT / AMPLITUDE_MAX, 0.0f);
+}
+
+/**
+ * Writes a whole buffer of DAC counts, rotated by start: word (start + i) gets cnts[i].
+ * Words that already hold the value are not written again.
+ */
+int generate_writeDataCnts(rp_channel_t channel, const uint16_t *cnts, uint32_t start, uint32_t length) {
     volatile int32_t *dataOut;
+    uint16_t *shadow;
     CHANNEL_ACTION(channel,
             dataOut = data_chA,
             dataOut = data_chB)
+    CHANNEL_ACTION(channel,
+            shadow = shadow_chA,
+            shadow = shadow_chB)
 
-    volatile ch_properties_t *properties;
-    ECHECK(getChannelPropertiesAddress(&properties, channel));
     generate_setWrapCounter(channel, length);
 
-    //rp_calib_params_t calib = calib_GetParams();
-    int dc_offs = 0;//channel == RP_CH_1 ? calib.be_ch1_dc_offs: calib.be_ch2_dc_offs;
-    uint32_t amp_max = 0; //channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
+    bool force = !shadow_valid[channel];
+    start %= BUFFER_LENGTH;
 
-    for(int i = start; i < start+BUFFER_LENGTH; i++) {
-        dataOut[i % BUFFER_LENGTH] = cmn_CnvVToCnt(DATA_BIT_LENGTH, data[i-start], AMPLITUDE_MAX, false, amp_max, dc_offs, 0.0);
-    }
+    // Two linear runs instead of a modulo per word
+    uint32_t first = BUFFER_LENGTH - start;
+    wro_WriteChanged(dataOut + start, shadow + start, cnts, first, force);
+    wro_WriteChanged(dataOut, shadow, cnts + first, start, force);
+    shadow_valid[channel] = true;
     return RP_OK;
 }
+
+int generate_writeData(rp_channel_t channel, float *data, uint32_t start, uint32_t length) {
+    uint16_t cnts[BUFFER_LENGTH];
+
+    generate_cnvVToCnts(data, cnts, BUFFER_LENGTH);
+    return generate_writeDataCnts(channel, cnts, start, length);
+}
@@ -109,5 +109,8 @@ int generate_simultaneousTrigger();
 int generate_Synchronise();
 
 int generate_writeData(rp_channel_t channel, float *data, uint32_t start, uint32_t length);
+int generate_writeDataCnts(rp_channel_t channel, const uint16_t *cnts, uint32_t start, uint32_t length);
+void generate_cnvVToCnts(const float *data, uint16_t *cnts, uint32_t length);
+void generate_invalidateShadow();
 
 #endif //__GENERATE_H
@@ -20,6 +20,8 @@
 #include "housekeeping.h"
 #include "oscilloscope.h"
 #include "acq_handler.h"
+#include "acq_stream.h"
+#include "acq_decim.h"
 #include "analog_mixed_signals.h"
 #include "calib.h"
 #include "generate.h"
@@ -57,6 +59,9 @@ int rp_CalibInit()
 
 int rp_Release()
 {
+    // The stream reader thread uses the oscilloscope memory, it must end first
+    acq_DecimStop();
+    acq_StreamStop(NULL, NULL);
     ECHECK(osc_Release())
     ECHECK(generate_Release());
     ECHECK(ams_Release());
@@ -131,6 +136,14 @@ const char* rp_GetError(int errorCode) {
             return "Failed to read from the bus";
         case RP_EFWB:
             return "Failed to write to the bus";
+        case RP_ENST:
+            return "Acquisition stream is not started";
+        case RP_ETMO:
+            return "Timeout elapsed";
+        case RP_EOVR:
+            return "Buffer overrun";
+        case RP_EAA:
+            return "Failed to allocate memory";
         default:
             return "Unknown error";
     }
@@ -689,6 +702,11 @@ int rp_AcqGetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2
     return acq_GetDataV2(pos, size, buffer1, buffer2);
 }
 
+int rp_AcqGetDataVInterleaved(uint32_t pos, uint32_t* size, float* buffer)
+{
+    return acq_GetDataVInterleaved(pos, size, buffer);
+}
+
 int rp_AcqGetOldestDataV(rp_channel_t channel, uint32_t* size, float* buffer)
 {
     return acq_GetOldestDataV(channel, size, buffer);
@@ -703,6 +721,56 @@ int rp_AcqGetBufSize(uint32_t *size) {
     return acq_GetBufferSize(size);
 }
 
+int rp_AcqGetBufferView(rp_channel_t channel, uint32_t start, uint32_t len, rp_acq_buffer_view_t* view)
+{
+    return acq_GetBufferView(channel, start, len, view);
+}
+
+int rp_AcqBufferViewCheck(const rp_acq_buffer_view_t* view)
+{
+    return acq_BufferViewCheck(view);
+}
+
+int rp_AcqBufferViewForEach(const rp_acq_buffer_view_t* view, rp_acq_buffer_view_fn_t fn, void* ctx)
+{
+    return acq_BufferViewForEach(view, fn, ctx);
+}
+
+int rp_AcqGetBufferGeneration(uint32_t* generation)
+{
+    return acq_GetBufferGeneration(generation);
+}
+
+int rp_AcqStreamStart(uint32_t ring_len)
+{
+    return acq_StreamStart(ring_len);
+}
+
+int rp_AcqStreamRead(rp_acq_stream_block_t* block, uint32_t timeout_ms)
+{
+    return acq_StreamRead(block, timeout_ms);
+}
+
+int rp_AcqStreamStop(uint64_t* blocks, uint64_t* lost)
+{
+    return acq_StreamStop(blocks, lost);
+}
+
+int rp_AcqDecimStart(uint32_t factor, uint32_t ring_len)
+{
+    return acq_DecimStart(factor, ring_len);
+}
+
+int rp_AcqDecimRead(float* buffer1, float* buffer2, uint32_t* size, uint64_t* lost, uint32_t timeout_ms)
+{
+    return acq_DecimRead(buffer1, buffer2, size, lost, timeout_ms);
+}
+
+int rp_AcqDecimStop()
+{
+    return acq_DecimStop();
+}
+
 /**
 * Generate methods
 */
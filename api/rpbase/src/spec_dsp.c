@@ -23,7 +23,7 @@
 #include "spec_dsp.h"
 //#include "spectrometerApp.h"
 #include "spec_fpga.h"
-#include "kiss_fftr.h"
+#include "spec_fft.h"
 
 extern float g_spectr_fpga_adc_max_v;
 extern const int c_spectr_fpga_adc_bits;
@@ -32,9 +32,10 @@ extern const int c_spectr_fpga_adc_bits;
 
 /* Internal structures used in DSP  */
 double                *rp_hann_window   = NULL;
-kiss_fft_cpx         *rp_kiss_fft_out1 = NULL;
-kiss_fft_cpx         *rp_kiss_fft_out2 = NULL;
-kiss_fftr_cfg         rp_kiss_fft_cfg  = NULL;
+float                 *rp_fft_in1       = NULL;
+float                 *rp_fft_in2       = NULL;
+float                 *rp_fft_pw1       = NULL;
+float                 *rp_fft_pw2       = NULL;
 
 /* constants - calibration dependant */
 /* Power calc. impedance*/
@@ -132,35 +133,34 @@ int rp_spectr_hann_filter(double *cha_in, double *chb_in,
 
 int rp_spectr_fft_init()
 {
-    if(rp_kiss_fft_out1 || rp_kiss_fft_out2 || rp_kiss_fft_cfg) {
+    if(rp_fft_in1 || rp_fft_in2 || rp_fft_pw1 || rp_fft_pw2) {
         rp_spectr_fft_clean();
     }
 
-    rp_kiss_fft_out1 = 
-        (kiss_fft_cpx *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(kiss_fft_cpx));
-    rp_kiss_fft_out2 =
-        (kiss_fft_cpx *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(kiss_fft_cpx));
-
-    rp_kiss_fft_cfg = kiss_fftr_alloc(SPECTR_FPGA_SIG_LEN, 0, NULL, NULL);
-
+    rp_fft_in1 = (float *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(float));
+    rp_fft_in2 = (float *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(float));
+    rp_fft_pw1 = (float *)malloc(c_dsp_sig_len * sizeof(float));
+    rp_fft_pw2 = (float *)malloc(c_dsp_sig_len * sizeof(float));
+    if(!rp_fft_in1 || !rp_fft_in2 || !rp_fft_pw1 || !rp_fft_pw2 ||
+       !spectr_fft_get_plan(SPECTR_FPGA_SIG_LEN)) {
+        fprintf(stderr, "rp_spectr_fft_init() can not allocate mem\n");
+        rp_spectr_fft_clean();
+        return -1;
+    }
     return 0;
 }
 
 int rp_spectr_fft_clean()
 {
-    kiss_fft_cleanup();
-    if(rp_kiss_fft_out1) {
-        free(rp_kiss_fft_out1);
-        rp_kiss_fft_out1 = NULL;
-    }
-    if(rp_kiss_fft_out2) {
-        free(rp_kiss_fft_out2);
-        rp_kiss_fft_out2 = NULL;
-    }
-    if(rp_kiss_fft_cfg) {
-        free(rp_kiss_fft_cfg);
-        rp_kiss_fft_cfg = NULL;
-    }
+    spectr_fft_clean();
+    free(rp_fft_in1);
+    free(rp_fft_in2);
+    free(rp_fft_pw1);
+    free(rp_fft_pw2);
+    rp_fft_in1 = NULL;
+    rp_fft_in2 = NULL;
+    rp_fft_pw1 = NULL;
+    rp_fft_pw2 = NULL;
     return 0;
 }
 
@@ -169,27 +169,44 @@ int rp_spectr_fft(double *cha_in, double *chb_in,
 {
     double *cha_o = *cha_out;
     double *chb_o = *chb_out;
+    const spectr_fft_plan_t *plan;
     int i;
     if(!cha_in || !chb_in || !*cha_out || !*chb_out)
         return -1;
 
-    if(!rp_kiss_fft_out1 || !rp_kiss_fft_out2 || !rp_kiss_fft_cfg) {
+    if(!rp_fft_in1 || !rp_fft_in2 || !rp_fft_pw1 || !rp_fft_pw2) {
         fprintf(stderr, "rp_spect_fft not initialized");
         return -1;
     }
 
-    kiss_fftr(rp_kiss_fft_cfg, (kiss_fft_scalar *)cha_in, rp_kiss_fft_out1);
-    kiss_fftr(rp_kiss_fft_cfg, (kiss_fft_scalar *)chb_in, rp_kiss_fft_out2);
+    /* Cached by rp_spectr_fft_init() */
+    plan = spectr_fft_get_plan(SPECTR_FPGA_SIG_LEN);
+
+    for(i = 0; i < SPECTR_FPGA_SIG_LEN; i++) {
+        rp_fft_in1[i] = (float)cha_in[i];
+        rp_fft_in2[i] = (float)chb_in[i];
+    }
+    if(spectr_fft_power2(plan, rp_fft_in1, rp_fft_in2, NULL,
+                         rp_fft_pw1, rp_fft_pw2) < 0)
+        return -1;
 
-    for(i = 0; i < c_dsp_sig_len; i++) {                     // FFT limited to fs/2, specter of amplitudes
-        cha_o[i] = sqrt(pow(rp_kiss_fft_out1[i].r, 2) + 
-                        pow(rp_kiss_fft_out1[i].i, 2));
-        chb_o[i] = sqrt(pow(rp_kiss_fft_out2[i].r, 2) + 
-                        pow(rp_kiss_fft_out2[i].i, 2));
+    for(i = 0; i < c_dsp_sig_len; i++) {                     // FFT limited to fs/2, specter of powers
+        cha_o[i] = rp_fft_pw1[i];
+        chb_o[i] = rp_fft_pw2[i];
     }
     return 0;
 }
 
+/* Conversion of |X[k]|^2 of a FFT of length fft_len to power [W] */
+static double rp_spectr_pw_factor(int fft_len)
+{
+    /* Conversion factor from ADC counts to Volts */
+    double c2v = g_spectr_fpga_adc_max_v/(float)((int)(1<<(c_spectr_fpga_adc_bits-1)));
+
+    return c2v * c2v / c_imp /                                  // c_imp = 50 Ohms, is the transmission line impdeance
+        (double)fft_len / (double)fft_len * 2;                  // x 2 for unilateral spectral density representation
+}
+
 int rp_spectr_decimate(double *cha_in, double *chb_in, 
                        float **cha_out, float **chb_out,
                        int in_len, int out_len)
@@ -198,6 +215,7 @@ int rp_spectr_decimate(double *cha_in, double *chb_in,
     int i, j;
     float *cha_o = *cha_out;
     float *chb_o = *chb_out;
+    const double k_pw = rp_spectr_pw_factor(SPECTR_FPGA_SIG_LEN);
 
     if(!cha_in || !chb_in || !*cha_out || !*chb_out)
         return -1;
@@ -215,21 +233,11 @@ int rp_spectr_decimate(double *cha_in, double *chb_in,
         }
         cha_o[i] = 0;
         chb_o[i] = 0;
-	
-	/* Conversion factor from ADC counts to Volts */
-    	double c2v = g_spectr_fpga_adc_max_v/(float)((int)(1<<(c_spectr_fpga_adc_bits-1)));
-	
+
         for(k=j; k < j+step; k++) {
-	
-	/* Conversion to power (Watts) */  
-        double cha_p = pow(cha_in[k] * c2v, 2) / c_imp /
-            (double)SPECTR_FPGA_SIG_LEN / (double)SPECTR_FPGA_SIG_LEN * 2; // x 2 for unilateral spectral density representation
-        double chb_p = pow(chb_in[k] * c2v, 2) / c_imp /                   // c_imp = 50 Ohms, is the transmission line impdeance   
-            (double)SPECTR_FPGA_SIG_LEN / (double)SPECTR_FPGA_SIG_LEN * 2;
-	  
-	  
-            cha_o[i] += (float)cha_p;  // Summing the power expressed in Watts associated to each FFT bin
-            chb_o[i] += (float)chb_p;
+            /* Conversion to power (Watts), summing the power associated to each FFT bin */
+            cha_o[i] += (float)(cha_in[k] * k_pw);
+            chb_o[i] += (float)(chb_in[k] * k_pw);
         }
     }
 
@@ -39,8 +39,8 @@ int rp_spectr_fft_clean();
 
 /* Inputs length: SPECTR_FPGA_SIG_LEN
  * Outputs length: floor(SPECTR_FPGA_SIG_LEN/2) 
- * Output is not complex number as usually is from the FFT but abs() value of the
- * calculation.
+ * Output is not complex number as usually is from the FFT but the power
+ * |X[k]|^2 of the calculation.
  */
 int rp_spectr_fft(double *cha_in, double *chb_in, 
                   double **cha_out, double **chb_out);
@@ -48,6 +48,8 @@ int rp_spectr_fft(double *cha_in, double *chb_in,
 
 /*
  * Decimation (usually from internal 8k -> output 2k)
+ * Input is the power |X[k]|^2 of rp_spectr_fft(), output the power [W] of
+ * each group of bins.
 */
 int rp_spectr_decimate(double *cha_in, double *chb_in,
                        float **cha_out, float **chb_out,
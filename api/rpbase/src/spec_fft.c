@@ -0,0 +1,222 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya Spectrum Analyzer packed real FFT.
+ *
+ * Two real signals a and b are transformed at once as z = a + j*b by a radix-2
+ * complex FFT in single precision. Their spectra follow from the symmetry of
+ * real signals:
+ *   A[k] = (Z[k] + conj(Z[N-k])) / 2,  B[k] = (Z[k] - conj(Z[N-k])) / 2j
+ * Only the powers |A[k]|^2 and |B[k]|^2 are needed, so neither the spectra nor
+ * any square root are formed.
+ *
+ * The window, the packing and the bit reversed reordering are done in one pass.
+ * Each stage takes its twiddle factors from a contiguous table, thus on ARM the
+ * butterflies handle four complex values at once with NEON.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SPECTR_FFT_NEON 1
+#endif
+
+#include "spec_fft.h"
+
+struct spectr_fft_plan_s {
+    int       len;
+    uint32_t  used;
+    uint32_t *bitrev;  /* bit reversed index of each input sample */
+    float    *tw_r;    /* twiddles of the stage of half size h at [h .. 2h-1] */
+    float    *tw_i;
+    float    *work;    /* interleaved complex, 2*len */
+};
+
+static spectr_fft_plan_t spectr_fft_plans[SPECTR_FFT_PLANS];
+static uint32_t spectr_fft_clock = 0;
+
+static void spectr_fft_free_plan(spectr_fft_plan_t *plan)
+{
+    free(plan->bitrev);
+    free(plan->tw_r);
+    free(plan->tw_i);
+    free(plan->work);
+    plan->bitrev = NULL;
+    plan->tw_r = NULL;
+    plan->tw_i = NULL;
+    plan->work = NULL;
+    plan->len = 0;
+}
+
+static int spectr_fft_init_plan(spectr_fft_plan_t *plan, int len)
+{
+    int bits = 0, i, h, j;
+
+    while((1 << bits) < len)
+        bits++;
+
+    plan->bitrev = (uint32_t *)malloc(len * sizeof(uint32_t));
+    plan->tw_r   = (float *)malloc(len * sizeof(float));
+    plan->tw_i   = (float *)malloc(len * sizeof(float));
+    plan->work   = (float *)malloc(2 * len * sizeof(float));
+    if(!plan->bitrev || !plan->tw_r || !plan->tw_i || !plan->work) {
+        spectr_fft_free_plan(plan);
+        fprintf(stderr, "spectr_fft_get_plan() can not allocate mem\n");
+        return -1;
+    }
+
+    for(i = 0; i < len; i++) {
+        uint32_t r = 0;
+        for(j = 0; j < bits; j++)
+            r |= ((i >> j) & 1) << (bits - 1 - j);
+        plan->bitrev[i] = r;
+    }
+
+    plan->tw_r[0] = 0;
+    plan->tw_i[0] = 0;
+    for(h = 1; h < len; h <<= 1) {
+        for(j = 0; j < h; j++) {
+            plan->tw_r[h + j] =  (float)cos(M_PI * j / h);
+            plan->tw_i[h + j] = -(float)sin(M_PI * j / h);
+        }
+    }
+
+    plan->len = len;
+    return 0;
+}
+
+const spectr_fft_plan_t *spectr_fft_get_plan(int len)
+{
+    spectr_fft_plan_t *plan = &spectr_fft_plans[0];
+    int i;
+
+    if(len < SPECTR_FFT_LEN_MIN || len > SPECTR_FFT_LEN_MAX || (len & (len - 1))) {
+        fprintf(stderr, "spectr_fft_get_plan() unsupported length %d\n", len);
+        return NULL;
+    }
+
+    for(i = 0; i < SPECTR_FFT_PLANS; i++) {
+        spectr_fft_plan_t *p = &spectr_fft_plans[i];
+        if(p->len == len) {
+            p->used = ++spectr_fft_clock;
+            return p;
+        }
+        if(!p->len || (plan->len && p->used < plan->used))
+            plan = p;
+    }
+
+    spectr_fft_free_plan(plan);
+    if(spectr_fft_init_plan(plan, len) < 0)
+        return NULL;
+    plan->used = ++spectr_fft_clock;
+    return plan;
+}
+
+void spectr_fft_clean()
+{
+    int i;
+
+    for(i = 0; i < SPECTR_FFT_PLANS; i++)
+        spectr_fft_free_plan(&spectr_fft_plans[i]);
+}
+
+/* In place radix-2 decimation in time, the input is in bit reversed order */
+static void spectr_fft_transform(const spectr_fft_plan_t *plan, float *z)
+{
+    const int n = plan->len;
+    int h, b, j;
+
+    for(h = 1; h < n; h <<= 1) {
+        const float *wr = plan->tw_r + h;
+        const float *wi = plan->tw_i + h;
+
+        for(b = 0; b < n; b += 2 * h) {
+            float *top = z + 2 * b;
+            float *bot = z + 2 * (b + h);
+
+            j = 0;
+#ifdef SPECTR_FFT_NEON
+            for(; j + 4 <= h; j += 4) {
+                float32x4x2_t x  = vld2q_f32(top + 2 * j);
+                float32x4x2_t y  = vld2q_f32(bot + 2 * j);
+                float32x4_t   cr = vld1q_f32(wr + j);
+                float32x4_t   ci = vld1q_f32(wi + j);
+                float32x4_t   tr = vmlsq_f32(vmulq_f32(y.val[0], cr), y.val[1], ci);
+                float32x4_t   ti = vmlaq_f32(vmulq_f32(y.val[0], ci), y.val[1], cr);
+
+                y.val[0] = vsubq_f32(x.val[0], tr);
+                y.val[1] = vsubq_f32(x.val[1], ti);
+                x.val[0] = vaddq_f32(x.val[0], tr);
+                x.val[1] = vaddq_f32(x.val[1], ti);
+                vst2q_f32(top + 2 * j, x);
+                vst2q_f32(bot + 2 * j, y);
+            }
+#endif
+            for(; j < h; j++) {
+                float yr = bot[2 * j], yi = bot[2 * j + 1];
+                float tr = yr * wr[j] - yi * wi[j];
+                float ti = yr * wi[j] + yi * wr[j];
+
+                bot[2 * j]     = top[2 * j]     - tr;
+                bot[2 * j + 1] = top[2 * j + 1] - ti;
+                top[2 * j]     += tr;
+                top[2 * j + 1] += ti;
+            }
+        }
+    }
+}
+
+int spectr_fft_power2(const spectr_fft_plan_t *plan,
+                      const float *cha_in, const float *chb_in, const float *window,
+                      float *cha_pw, float *chb_pw)
+{
+    int n, i, k;
+    float *z;
+
+    if(!plan || !cha_in || !chb_in || !cha_pw || !chb_pw)
+        return -1;
+
+    n = plan->len;
+    z = plan->work;
+
+    if(window) {
+        for(i = 0; i < n; i++) {
+            uint32_t r = plan->bitrev[i];
+            z[2 * r]     = cha_in[i] * window[i];
+            z[2 * r + 1] = chb_in[i] * window[i];
+        }
+    } else {
+        for(i = 0; i < n; i++) {
+            uint32_t r = plan->bitrev[i];
+            z[2 * r]     = cha_in[i];
+            z[2 * r + 1] = chb_in[i];
+        }
+    }
+
+    spectr_fft_transform(plan, z);
+
+    cha_pw[0] = z[0] * z[0];
+    chb_pw[0] = z[1] * z[1];
+    for(k = 1; k < (n >> 1); k++) {
+        int   m  = n - k;
+        float sr = z[2 * k]     + z[2 * m];
+        float dr = z[2 * k]     - z[2 * m];
+        float si = z[2 * k + 1] + z[2 * m + 1];
+        float di = z[2 * k + 1] - z[2 * m + 1];
+
+        cha_pw[k] = 0.25f * (sr * sr + di * di);
+        chb_pw[k] = 0.25f * (si * si + dr * dr);
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+/**
+ * $Id$
+ *
+ * @brief Red Pitaya Spectrum Analyzer packed real FFT.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __SPEC_FFT_H
+#define __SPEC_FFT_H
+
+#include <stdint.h>
+
+/* Count of cached plans, the least recently used one is replaced */
+#define SPECTR_FFT_PLANS    4
+/* Supported lengths, powers of two */
+#define SPECTR_FFT_LEN_MIN  16
+#define SPECTR_FFT_LEN_MAX  (64*1024)
+
+typedef struct spectr_fft_plan_s spectr_fft_plan_t;
+
+/* Returns the cached plan of length len, it is created if needed. NULL for
+ * unsupported lengths or when out of memory. A plan stays valid until
+ * SPECTR_FFT_PLANS other lengths have been requested or spectr_fft_clean().
+ * Neither the cache nor the plans are thread safe: a plan holds the work
+ * buffer of spectr_fft_power2(), so all of them must be used by one thread. */
+const spectr_fft_plan_t *spectr_fft_get_plan(int len);
+void spectr_fft_clean();
+
+/* Power spectra |X[k]|^2, k = 0 .. len/2 - 1, of two real signals of length len,
+ * transformed by one complex FFT. The optional window (length len) is applied
+ * to both signals. The transform is not normalized. */
+int spectr_fft_power2(const spectr_fft_plan_t *plan,
+                      const float *cha_in, const float *chb_in, const float *window,
+                      float *cha_pw, float *chb_pw);
+
+#endif //__SPEC_FFT_H
@@ -17,6 +17,7 @@
 #include "worker.h"
 #include "calib.h"
 #include "fpga.h"
+#include "rb_pstore.h"
 
 #include "cb_http.h"
 
@@ -30,15 +31,13 @@ extern rp_calib_params_t    g_rp_main_calib_params;
 /** @brief Describes app. parameters with some info/limitations */
 extern rb_app_params_t      g_rb_default_params[];
 
-/** @brief CallBack copy of params to inform the worker */
-extern rp_app_params_t*     g_rp_cb_in_params;
 /** @brief Holds mutex to access on parameters from outside to the worker thread */
 extern pthread_mutex_t      g_rp_cb_in_params_mutex;
 
-/** @brief Current copy of params of the worker thread */
-extern rb_app_params_t*     g_rb_info_worker_params;
 /** @brief Holds mutex to access parameters from the worker thread to any other context */
 extern pthread_mutex_t      g_rb_info_worker_params_mutex;
+/** @brief Signals that the worker thread has exported its current params data */
+extern pthread_cond_t       g_rb_info_worker_params_cond;
 
 /** @brief params initialized */
 extern int                  g_params_init_done;
@@ -118,8 +117,6 @@ int rp_app_exit(void)
 /*----------------------------------------------------------------------------*/
 int rp_set_params(rp_app_params_t* p, int len)
 {
-    rp_app_params_t* p_copy = NULL;
-
     //fprintf(stderr, "!!! rp_set_params: BEGIN\n");
 
     if (!p || (len < 0)) {
@@ -130,27 +127,20 @@ int rp_set_params(rp_app_params_t* p, int len)
         return 0;
     }
 
-    /* create a local copy to release the caller */
-    pthread_mutex_lock(&g_rp_cb_in_params_mutex);
-    do {
-        p_copy = g_rp_cb_in_params;
-        if (!p_copy) {
-            //fprintf(stderr, "DEBUG rp_set_params: g_rp_cb_in_params - rp_copy_params(&g_rp_cb_in_params, p, ) ...\n");
-            rp_copy_params(&g_rp_cb_in_params, p, len, !g_params_init_done);                            // piping to the worker thread
-            break;
-
-        } else {
-            pthread_mutex_unlock(&g_rp_cb_in_params_mutex);
-            /* wait for the worker to process previous job */
-            usleep(10000);
-            pthread_mutex_lock(&g_rp_cb_in_params_mutex);
-        }
-    } while (1);
-    pthread_mutex_unlock(&g_rp_cb_in_params_mutex);
-
-    /* set current pktIdx */
+    /* write the values into the parameter store, the caller is released without any deep copy */
+    if (rb_pstore_write_rp(p) < 0) {
+        fprintf(stderr, "ERROR rp_set_params - parameter store not initialized\n");
+        return -1;
+    }
+
+    /* set current pktIdx - before the worker is able to drop the flag */
     int idx = rp_find_parms_index(p, TRANSPORT_pktIdx);
+    pthread_mutex_lock(&g_rb_info_worker_params_mutex);
     g_transport_pktIdx = (int) (p[idx].value) | 0x80;                                                   // 0x80 flag: processing changed data
+    pthread_mutex_unlock(&g_rb_info_worker_params_mutex);
+
+    /* wake up the worker */
+    (void) worker_post(worker_cmd_params);
 
     //fprintf(stderr, "!!! rp_set_params: END - pktIdx = %s = %lf\n", p[0].name, p[0].value);
     return 0;
@@ -160,40 +150,22 @@ int rp_set_params(rp_app_params_t* p, int len)
 int rp_get_params(rp_app_params_t** p)
 {
     rp_app_params_t* p_copy = NULL;
+    rb_app_params_t l_params[RB_PSTORE_LEN + 1];
     int count = 0;
 
     //fprintf(stderr, "??? rp_get_params: BEGIN\n");
 
-    /* wait until the worker has processed the input data */
-    //fprintf(stderr, "?.. rp_get_params: waiting for worker has processed the input data - waiting ...\n");
-    do {
-        if (!(g_transport_pktIdx & 0x80)) {
-            break;
-
-        } else {
-            /* wait for the worker to process previous job */
-            usleep(1000);
-        }
-    } while (1);
-    //fprintf(stderr, "?.. rp_get_params: waiting for worker has processed data - done.\n");
-
+    /* wait until the worker has processed the input data and has exported the current params data */
     //fprintf(stderr, "?.. rp_get_params: waiting for worker has exported the current params data - waiting ...\n");
     pthread_mutex_lock(&g_rb_info_worker_params_mutex);
-    do {
-        if (g_rb_info_worker_params) {
-            /* get the memory - free() is called by the caller */
-            count = rp_copy_params_rb2rp(&p_copy, g_rb_info_worker_params);
-            break;
-
-        } else {
-            pthread_mutex_unlock(&g_rb_info_worker_params_mutex);
-            /* wait for the worker to export its current params data */
-            //pthread_yield();
-            usleep(1000);
-            pthread_mutex_lock(&g_rb_info_worker_params_mutex);
-        }
-    } while (1);
+    while ((g_transport_pktIdx & 0x80) || !rb_pstore_generation()) {
+        pthread_cond_wait(&g_rb_info_worker_params_cond, &g_rb_info_worker_params_mutex);
+    }
     pthread_mutex_unlock(&g_rb_info_worker_params_mutex);
+
+    /* consistent snapshot of the parameter store - get the memory, free() is called by the caller */
+    rb_pstore_snapshot(l_params);
+    count = rp_copy_params_rb2rp(&p_copy, l_params);
     //fprintf(stderr, "?.. rp_get_params: waiting for worker has exported the current params data - done.\n");
 
     //fprintf(stderr, "?-> rp_get_params - having list with count = %d\n", count);
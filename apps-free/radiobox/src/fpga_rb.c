@@ -33,8 +33,6 @@
 /** @brief calibration data layout within the EEPROM device */
 extern rp_calib_params_t    g_rp_main_calib_params;
 
-/** @brief CallBack copy of params from the worker when requested */
-extern rb_app_params_t*     g_rb_info_worker_params;
 /** @brief Holds mutex to access on parameters from the worker thread to any other context */
 extern pthread_mutex_t      g_rb_info_worker_params_mutex;
 
@@ -148,15 +148,13 @@ const rb_app_params_t g_rb_default_params[RB_PARAMS_NUM + 1] = {
         NULL,                       0.0,  -1, -1, 0.0,      0.0  }
 };
 
-/** @brief CallBack copy of params to inform the worker */
-rp_app_params_t*                g_rp_cb_in_params = NULL;
 /** @brief Holds mutex to access on parameters from outside to the worker thread */
 pthread_mutex_t                 g_rp_cb_in_params_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-/** @brief Current copy of params of the worker thread */
-rb_app_params_t*                g_rb_info_worker_params = NULL;
 /** @brief Holds mutex to access parameters from the worker thread to any other context */
 pthread_mutex_t                 g_rb_info_worker_params_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Signals that the worker thread has exported its current params data */
+pthread_cond_t                  g_rb_info_worker_params_cond = PTHREAD_COND_INITIALIZER;
 
 
 /** @brief params initialized */
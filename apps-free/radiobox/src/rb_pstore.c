@@ -0,0 +1,310 @@
+/**
+ * @brief Red Pitaya RadioBox shared parameter store.
+ *
+ * The parameter names are interned once by rb_pstore_init(), afterwards a parameter is addressed
+ * by its index into flat arrays. The values are protected by a sequence lock: writers are
+ * serialized by a mutex and make the sequence counter odd while they are active, readers copy the
+ * values without any lock and retry when the counter was odd or has changed meanwhile. Changed
+ * values set a bit of the dirty bitmap, the worker takes the bitmap to find the FPGA updates.
+ *
+ * This replaces the deep copies of rp_copy_params()/rb_copy_params() on the control path, that
+ * allocated each list and each name and matched the entries by strcmp() in O(n^2).
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "rb_pstore.h"
+
+
+/** @brief Count of slots of the name hash table, a power of two of at least 2 * RB_PSTORE_LEN */
+#define RB_PSTORE_HASH_LEN      64
+
+/** @brief name of the param element for the packet counter */
+extern const char           TRANSPORT_pktIdx[];
+extern const char           CAST_NAME_EXT_SE[];
+extern const char           CAST_NAME_EXT_HI[];
+extern const char           CAST_NAME_EXT_MI[];
+extern const char           CAST_NAME_EXT_LO[];
+extern const int            CAST_NAME_EXT_LEN;
+
+
+/** @brief Interned parameters, the names and the attributes besides the value are taken from here */
+static const rb_app_params_t* s_pstore_params = NULL;
+/** @brief Count of interned parameters */
+static int                  s_pstore_cnt = 0;
+/** @brief Open addressing hash table of the names, index + 1 of each parameter, 0 is empty */
+static uint8_t              s_pstore_hash[RB_PSTORE_HASH_LEN];
+
+/** @brief Current values, guarded by s_pstore_seq */
+static double               s_pstore_value[RB_PSTORE_LEN];
+/** @brief Sequence counter, odd while a writer is active */
+static uint32_t             s_pstore_seq = 0;
+/** @brief Serializes the writers, the readers do not use it */
+static pthread_mutex_t      s_pstore_wr_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** @brief Entries changed since the last rb_pstore_take_dirty() */
+static uint32_t             s_pstore_dirty[RB_PSTORE_DIRTY_WORDS];
+/** @brief Count of write-backs by the worker */
+static uint32_t             s_pstore_gen = 0;
+
+
+/** @brief FNV-1a hash of a name */
+static uint32_t rb_pstore_hash(const char* name)
+{
+    uint32_t h = 2166136261U;
+
+    while (*name) {
+        h ^= (uint8_t) *name++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+static void rb_pstore_wr_begin(void)
+{
+    pthread_mutex_lock(&s_pstore_wr_mutex);
+    __atomic_store_n(&s_pstore_seq, s_pstore_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);  // the odd counter is visible before any value changes
+}
+
+static void rb_pstore_wr_end(void)
+{
+    __atomic_store_n(&s_pstore_seq, s_pstore_seq + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&s_pstore_wr_mutex);
+}
+
+static inline void rb_pstore_mark_dirty(int idx)
+{
+    __atomic_fetch_or(&s_pstore_dirty[idx >> 5], 1U << (idx & 31), __ATOMIC_RELEASE);
+}
+
+
+/*----------------------------------------------------------------------------*/
+int rb_pstore_init(const rb_app_params_t defaults[])
+{
+    int cnt, i;
+
+    rb_pstore_exit();
+
+    if (!defaults) {
+        fprintf(stderr, "ERROR - rb_pstore_init: bad parameter\n");
+        return -1;
+    }
+    for (cnt = 0; defaults[cnt].name; cnt++) {
+        if (cnt >= RB_PSTORE_LEN || (cnt << 1) >= RB_PSTORE_HASH_LEN) {
+            fprintf(stderr, "ERROR - rb_pstore_init: more than %d parameters\n", cnt);
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&s_pstore_wr_mutex);
+    memset(s_pstore_hash, 0, sizeof(s_pstore_hash));
+    for (i = 0; i < cnt; i++) {
+        uint32_t h = rb_pstore_hash(defaults[i].name);
+
+        while (s_pstore_hash[h & (RB_PSTORE_HASH_LEN - 1)]) {
+            h++;  // linear probing
+        }
+        s_pstore_hash[h & (RB_PSTORE_HASH_LEN - 1)] = (uint8_t) (i + 1);
+
+        s_pstore_value[i] = defaults[i].value;
+        rb_pstore_mark_dirty(i);
+    }
+    s_pstore_params = defaults;
+    s_pstore_gen    = 0;
+    __atomic_store_n(&s_pstore_cnt, cnt, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&s_pstore_wr_mutex);
+    return cnt;
+}
+
+/*----------------------------------------------------------------------------*/
+void rb_pstore_exit(void)
+{
+    pthread_mutex_lock(&s_pstore_wr_mutex);
+    __atomic_store_n(&s_pstore_cnt, 0, __ATOMIC_RELEASE);
+    s_pstore_params = NULL;
+    memset(s_pstore_dirty, 0, sizeof(s_pstore_dirty));
+    pthread_mutex_unlock(&s_pstore_wr_mutex);
+}
+
+/*----------------------------------------------------------------------------*/
+int rb_pstore_count(void)
+{
+    return __atomic_load_n(&s_pstore_cnt, __ATOMIC_ACQUIRE);
+}
+
+/*----------------------------------------------------------------------------*/
+int rb_pstore_index(const char* name)
+{
+    uint32_t h;
+    int idx;
+
+    if (!name || !rb_pstore_count()) {
+        return -1;
+    }
+
+    h = rb_pstore_hash(name);
+    while ((idx = s_pstore_hash[h & (RB_PSTORE_HASH_LEN - 1)])) {
+        if (!strcmp(s_pstore_params[idx - 1].name, name)) {
+            return idx - 1;
+        }
+        h++;
+    }
+    return -1;
+}
+
+/*----------------------------------------------------------------------------*/
+int rb_pstore_write_rp(const rp_app_params_t src[])
+{
+    float   quad[RB_PSTORE_LEN][4];
+    uint8_t quad_mask[RB_PSTORE_LEN] = { 0 };
+    double  value[RB_PSTORE_LEN];
+    uint8_t valid[RB_PSTORE_LEN] = { 0 };
+    int     count = 0;
+    int     i, idx;
+
+    if (!src || !rb_pstore_count()) {
+        return -1;
+    }
+
+    /* decode the transport list before entering the write section */
+    for (i = 0; src[i].name; i++) {
+        const char* name = src[i].name;
+        int part = -1;
+
+        if (!strcmp(TRANSPORT_pktIdx, name)) {
+            continue;
+        }
+
+        if (is_quad(name)) {
+            if (!strncmp(CAST_NAME_EXT_SE, name, CAST_NAME_EXT_LEN)) {
+                part = 0;
+            } else if (!strncmp(CAST_NAME_EXT_HI, name, CAST_NAME_EXT_LEN)) {
+                part = 1;
+            } else if (!strncmp(CAST_NAME_EXT_MI, name, CAST_NAME_EXT_LEN)) {
+                part = 2;
+            } else if (!strncmp(CAST_NAME_EXT_LO, name, CAST_NAME_EXT_LEN)) {
+                part = 3;
+            }
+            if (part >= 0) {
+                name += CAST_NAME_EXT_LEN;  // the extension is stripped away before the lookup
+            }
+        }
+
+        idx = rb_pstore_index(name);
+        if (idx < 0) {
+            // discard new entry if not already known in the store
+            fprintf(stderr, "WARNING rb_pstore_write_rp - input element of vector is unknown - name = %s\n", src[i].name);
+            continue;
+        }
+
+        if (part >= 0) {                                                                                // QUAD element
+            quad[idx][part] = src[i].value;
+            quad_mask[idx] |= 1 << part;
+            if (quad_mask[idx] == 0xf) {
+                value[idx] = cast_4xbf_to_1xdouble(quad[idx][0], quad[idx][1], quad[idx][2], quad[idx][3]);
+                valid[idx] = 1;
+            }
+
+        } else {                                                                                        // SINGLE element
+            value[idx] = src[i].value;
+            valid[idx] = 1;
+        }
+    }
+
+    rb_pstore_wr_begin();
+    for (idx = 0; idx < s_pstore_cnt; idx++) {
+        if (valid[idx] && s_pstore_value[idx] != value[idx]) {
+            s_pstore_value[idx] = value[idx];
+            rb_pstore_mark_dirty(idx);
+            count++;
+        }
+    }
+    rb_pstore_wr_end();
+    return count;
+}
+
+/*----------------------------------------------------------------------------*/
+int rb_pstore_write_back(const rb_app_params_t cur[], const rb_app_params_t prev[])
+{
+    int count = 0;
+    int idx;
+
+    if (!cur || !prev) {
+        return -1;
+    }
+
+    rb_pstore_wr_begin();
+    for (idx = 0; idx < s_pstore_cnt && cur[idx].name && prev[idx].name; idx++) {
+        if (cur[idx].value != prev[idx].value && s_pstore_value[idx] == prev[idx].value) {
+            s_pstore_value[idx] = cur[idx].value;
+            count++;
+        }
+    }
+    __atomic_fetch_add(&s_pstore_gen, 1, __ATOMIC_RELEASE);
+    rb_pstore_wr_end();
+    return count;
+}
+
+/*----------------------------------------------------------------------------*/
+int rb_pstore_snapshot(rb_app_params_t dst[])
+{
+    const int cnt = rb_pstore_count();
+    uint32_t seq;
+    int idx;
+
+    if (!dst) {
+        return -1;
+    }
+
+    for (idx = 0; idx < cnt; idx++) {
+        dst[idx]              = s_pstore_params[idx];
+        dst[idx].fpga_update &= ~0x80;
+    }
+    dst[cnt].name  = NULL;
+    dst[cnt].value = -1;
+
+    do {
+        seq = __atomic_load_n(&s_pstore_seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            sched_yield();  // a writer is active
+            continue;
+        }
+        for (idx = 0; idx < cnt; idx++) {
+            dst[idx].value = s_pstore_value[idx];
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);  // the values are read before the counter is checked again
+    } while ((seq & 1) || seq != __atomic_load_n(&s_pstore_seq, __ATOMIC_RELAXED));
+    return cnt;
+}
+
+/*----------------------------------------------------------------------------*/
+int rb_pstore_take_dirty(uint32_t dirty[RB_PSTORE_DIRTY_WORDS])
+{
+    int count = 0;
+    int w;
+
+    for (w = 0; w < RB_PSTORE_DIRTY_WORDS; w++) {
+        dirty[w] = __atomic_exchange_n(&s_pstore_dirty[w], 0, __ATOMIC_ACQ_REL);
+        count   += __builtin_popcount(dirty[w]);
+    }
+    return count;
+}
+
+/*----------------------------------------------------------------------------*/
+uint32_t rb_pstore_generation(void)
+{
+    return __atomic_load_n(&s_pstore_gen, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,128 @@
+/**
+ * @brief Red Pitaya RadioBox shared parameter store.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __RB_PSTORE_H
+#define __RB_PSTORE_H
+
+#include <stdint.h>
+
+#include "main.h"
+
+
+/** @defgroup rb_pstore_h Lock-free snapshot store of the RadioBox parameters
+ * @{
+ */
+
+/** @brief Capacity of the store, one slot for each entry of g_rb_default_params. */
+#define RB_PSTORE_LEN           RB_PARAMS_NUM
+
+/** @brief Count of 32 bit words of the dirty bitmap. */
+#define RB_PSTORE_DIRTY_WORDS   ((RB_PSTORE_LEN + 31) >> 5)
+
+
+/* function declarations, detailed descriptions is in apparent implementation file  */
+
+/**
+ * @brief Interns the parameter names and loads the default values
+ *
+ * The index of a parameter is its position within the defaults list, the name strings are
+ * referenced and not copied. All entries are marked dirty.
+ *
+ * @param[in]  defaults  Parameter list terminated by a NULL name, e.g. g_rb_default_params.
+ *
+ * @retval     int       Count of parameters interned.
+ * @retval     -1        Bad argument or the list exceeds RB_PSTORE_LEN.
+ */
+int rb_pstore_init(const rb_app_params_t defaults[]);
+
+/**
+ * @brief Forgets all parameters
+ */
+void rb_pstore_exit(void);
+
+/**
+ * @brief Count of parameters in the store
+ *
+ * @retval     int       Count of parameters, 0 before rb_pstore_init().
+ */
+int rb_pstore_count(void);
+
+/**
+ * @brief Index of a parameter name, hashed lookup
+ *
+ * @param[in]  name      Parameter name.
+ *
+ * @retval     int       Index 0..(rb_pstore_count() - 1).
+ * @retval     -1        Unknown name.
+ */
+int rb_pstore_index(const char* name);
+
+/**
+ * @brief Writes the values of a transport list received from the client
+ *
+ * Quad entries SE_/HI_/MI_/LO_xxx are recombined to the double value of xxx. A value that differs
+ * from the stored one marks its entry dirty. Unknown and incomplete entries and pktIdx are ignored.
+ *
+ * @param[in]  src       Transport list terminated by a NULL name.
+ *
+ * @retval     int       Count of entries marked dirty.
+ * @retval     -1        Bad argument or the store is not initialized.
+ */
+int rb_pstore_write_rp(const rp_app_params_t src[]);
+
+/**
+ * @brief Writes back the values the worker has changed, e.g. read back from the FPGA
+ *
+ * An entry is written when cur and prev differ and the store still holds prev, thus a value the
+ * client has written in the meantime is never overwritten. Written entries are not marked dirty.
+ *
+ * @param[in]  cur       Snapshot modified by the worker.
+ * @param[in]  prev      The same snapshot before the modifications.
+ *
+ * @retval     int       Count of entries written.
+ * @retval     -1        Bad argument.
+ */
+int rb_pstore_write_back(const rb_app_params_t cur[], const rb_app_params_t prev[]);
+
+/**
+ * @brief Consistent copy of all parameters, without allocating
+ *
+ * Lock-free for the reader: the copy is retried while a writer is active. The names of dst point
+ * to the interned strings and must not be freed, i.e. do not call rb_free_params() on dst.
+ *
+ * @param[out] dst       List of at least RB_PSTORE_LEN + 1 entries, it is terminated by a NULL name.
+ *
+ * @retval     int       Count of parameters copied.
+ * @retval     -1        Bad argument.
+ */
+int rb_pstore_snapshot(rb_app_params_t dst[]);
+
+/**
+ * @brief Takes the dirty bitmap and clears it atomically
+ *
+ * @param[out] dirty     Bit (idx & 31) of word (idx >> 5) is set for each dirty entry.
+ *
+ * @retval     int       Count of dirty entries.
+ */
+int rb_pstore_take_dirty(uint32_t dirty[RB_PSTORE_DIRTY_WORDS]);
+
+/**
+ * @brief Count of rb_pstore_write_back() calls since rb_pstore_init()
+ *
+ * @retval     uint32_t  0 as long as the worker has not exported any values.
+ */
+uint32_t rb_pstore_generation(void);
+
+/** @} */
+
+
+#endif /* __RB_PSTORE_H */
@@ -21,6 +21,7 @@
 
 #include "cb_http.h"
 #include "fpga.h"
+#include "rb_pstore.h"
 
 #include "worker.h"
 
@@ -32,19 +33,28 @@ static pthread_t*               s_worker_thread_handler = NULL;
 static worker_state_t           s_worker_ctrl_state;
 /** @brief Mutex for work_ctrl_state */
 static pthread_mutex_t          s_worker_ctrl_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Signals a posted command or the quit request to the worker thread */
+static pthread_cond_t           s_worker_ctrl_cond = PTHREAD_COND_INITIALIZER;
 
-/** @brief Parameter list for the worker thread */
-static rb_app_params_t*         s_worker_params = NULL;
+/** @brief Command queue of the worker thread, ring buffer guarded by s_worker_ctrl_mutex */
+static worker_cmd_t             s_worker_cmd_queue[WORKER_CMD_QUEUE_LEN];
+/** @brief Index of the oldest command in s_worker_cmd_queue */
+static int                      s_worker_cmd_head = 0;
+/** @brief Count of commands in s_worker_cmd_queue */
+static int                      s_worker_cmd_cnt  = 0;
+
+/** @brief Snapshot of the parameter store processed by the worker thread */
+static rb_app_params_t          s_worker_params[RB_PSTORE_LEN + 1];
+/** @brief s_worker_params as taken from the store, to find the values changed by the worker */
+static rb_app_params_t          s_worker_params_prev[RB_PSTORE_LEN + 1];
 
-/** @brief CallBack copy of params to inform the worker */
-extern rp_app_params_t*         g_rp_cb_in_params;
 /** @brief Holds mutex to access on parameters from outside to the worker thread */
 extern pthread_mutex_t          g_rp_cb_in_params_mutex;
 
-/** @brief Current copy of params of the worker thread */
-extern rb_app_params_t*         g_rb_info_worker_params;
 /** @brief Holds mutex to access parameters from the worker thread to any other context */
 extern pthread_mutex_t          g_rb_info_worker_params_mutex;
+/** @brief Signals that the worker has exported its current params data */
+extern pthread_cond_t           g_rb_info_worker_params_cond;
 
 static pthread_mutex_t          s_worker_traces_mutex = PTHREAD_MUTEX_INITIALIZER;
 static float**                  s_worker_traces;
@@ -72,10 +82,13 @@ int worker_init(rb_app_params_t* params, int params_len)
     }
 
     s_worker_ctrl_state = worker_idle_state;
+    s_worker_cmd_head   = 0;
+    s_worker_cmd_cnt    = 0;
 
-    /* create a new parameter list to the worker context */
-    rb_copy_params((rb_app_params_t**) &s_worker_params, params, params_len, 1);
-    //print_rb_params(s_worker_params);
+    /* intern the parameters and load their default values, all of them are marked dirty */
+    if (rb_pstore_init(params) < 0) {
+        return -1;
+    }
 
     s_worker_thread_handler = (pthread_t*) malloc(sizeof(pthread_t));
     if (!s_worker_thread_handler) {
@@ -92,6 +105,9 @@ int worker_init(rb_app_params_t* params, int params_len)
         return -1;
     }
 
+    /* let the worker configure the FPGA with the initial parameters */
+    (void) worker_post(worker_cmd_params);
+
     //fprintf(stderr, "DEBUG worker_init: END\n");
     return 0;
 }
@@ -104,9 +120,7 @@ int worker_exit(void)
     //fprintf(stderr, "DEBUG worker_exit: BEGIN\n");
 
     //fprintf(stderr, "worker_exit: before signaling quit\n");
-    pthread_mutex_lock(&s_worker_ctrl_mutex);
-    s_worker_ctrl_state = worker_quit_state;
-    pthread_mutex_unlock(&s_worker_ctrl_mutex);
+    (void) worker_post(worker_cmd_quit);
     //fprintf(stderr, "worker_exit: after signaling quit\n");
 
     if (s_worker_thread_handler) {
@@ -131,7 +145,7 @@ int worker_exit(void)
 
     //fprintf(stderr, "worker_exit: before freeing worker_params\n");
     //fprintf(stderr, "INFO pthread_join: freeing (1) ...\n");
-    rb_free_params(&s_worker_params);
+    rb_pstore_exit();
     //fprintf(stderr, "worker_exit: after freeing worker_params\n");
 
     //fprintf(stderr, "DEBUG worker_exit: END\n");
@@ -139,133 +153,113 @@ int worker_exit(void)
 }
 
 /*----------------------------------------------------------------------------------*/
-void* worker_thread(void* args)
+int worker_post(worker_cmd_t cmd)
 {
-    rb_app_params_t* l_cb_in_copy_params  = NULL;
-    worker_state_t l_state;
-    int l_do_normal_state = 0;
+    int i;
 
-    //fprintf(stderr, "worker_thread: BEGIN\n");
+    if (cmd < worker_cmd_params || cmd >= worker_cmd_nonexisting) {
+        return -1;
+    }
 
     pthread_mutex_lock(&s_worker_ctrl_mutex);
-    s_worker_ctrl_state = l_state = worker_idle_state;
-    pthread_mutex_unlock(&s_worker_ctrl_mutex);
-
-    while (1) {
-        pthread_mutex_lock(&s_worker_ctrl_mutex);
-        l_state = s_worker_ctrl_state;
-        pthread_mutex_unlock(&s_worker_ctrl_mutex);
+    if (cmd == worker_cmd_quit) {
+        s_worker_ctrl_state = worker_quit_state;  // a state, thus it does not need a free queue entry
 
-        pthread_mutex_lock(&g_rp_cb_in_params_mutex);
-        int l_params_init_done = g_params_init_done;
-        if (!l_params_init_done) {
-            /* the FPGA is going to be configured by these entries */
-            //fprintf(stderr, "DEBUG worker_thread: rp_cb_in_params - INITIAL data, copying ...\n");
-            rb_copy_params(&l_cb_in_copy_params, s_worker_params, -1, 1);
-            //print_rb_params(s_worker_params);
-            //fprintf(stderr, "DEBUG worker_thread: rp_cb_in_params - INITIAL data, ... done.\n");
-
-            /* take FSM out of idle l_state */
-            l_do_normal_state = 1;
-
-        } else if (g_rp_cb_in_params) {
-            /* check if new parameters are available */
-            //fprintf(stderr, "DEBUG worker_thread: g_rp_cb_in_params - new data, copying ...\n");
-            rp_copy_params_rp2rb(&l_cb_in_copy_params, g_rp_cb_in_params);
-
-            //fprintf(stderr, "DEBUG worker_thread: g_rp_cb_in_params - freeing (2) ...\n");
-            rp_free_params(&g_rp_cb_in_params);
-
-            /* take FSM out of idle */
-            l_do_normal_state = 1;
-
-            //print_rb_params(l_cb_in_copy_params);
-            //fprintf(stderr, "DEBUG worker_thread: rp_cb_in_params - ... done\n");
+    } else {
+        for (i = 0; i < s_worker_cmd_cnt; i++) {
+            if (s_worker_cmd_queue[(s_worker_cmd_head + i) % WORKER_CMD_QUEUE_LEN] == cmd) {
+                break;  // still pending - it picks up the newest data when processed
+            }
         }
-        pthread_mutex_unlock(&g_rp_cb_in_params_mutex);
-
-        /* when new data is seen, purge old revisions at the interfaces */
-        if (l_cb_in_copy_params) {
-            /* drop outdated output data */
-            pthread_mutex_lock(&g_rb_info_worker_params_mutex);
-            {
-                //fprintf(stderr, "INFO worker_thread: g_rb_info_worker_params - freeing (5) ...\n");
-                rb_free_params(&g_rb_info_worker_params);
+        if (i == s_worker_cmd_cnt) {
+            if (s_worker_cmd_cnt == WORKER_CMD_QUEUE_LEN) {
+                pthread_mutex_unlock(&s_worker_ctrl_mutex);
+                return -2;
             }
-            pthread_mutex_unlock(&g_rb_info_worker_params_mutex);
+            s_worker_cmd_queue[(s_worker_cmd_head + s_worker_cmd_cnt) % WORKER_CMD_QUEUE_LEN] = cmd;
+            s_worker_cmd_cnt++;
         }
+    }
+    pthread_cond_signal(&s_worker_ctrl_cond);
+    pthread_mutex_unlock(&s_worker_ctrl_mutex);
+    return 0;
+}
 
-        if (l_do_normal_state) {
-            pthread_mutex_lock(&s_worker_ctrl_mutex);
-            s_worker_ctrl_state = l_state = worker_normal_state;
-            pthread_mutex_unlock(&s_worker_ctrl_mutex);
+/*----------------------------------------------------------------------------------*/
+void* worker_thread(void* args)
+{
+    worker_state_t l_state;
+    worker_cmd_t l_cmd;
+    uint32_t l_dirty[RB_PSTORE_DIRTY_WORDS];
 
-            l_do_normal_state = 0;
+    //fprintf(stderr, "worker_thread: BEGIN\n");
+
+    while (1) {
+        pthread_mutex_lock(&s_worker_ctrl_mutex);
+        while (!s_worker_cmd_cnt && (s_worker_ctrl_state != worker_quit_state)) {
+            /* sleep until a command is posted - no wake-ups while idle */
+            pthread_cond_wait(&s_worker_ctrl_cond, &s_worker_ctrl_mutex);
+        }
+        l_cmd = worker_cmd_nonexisting;
+        if (s_worker_cmd_cnt) {
+            l_cmd = s_worker_cmd_queue[s_worker_cmd_head];
+            s_worker_cmd_head = (s_worker_cmd_head + 1) % WORKER_CMD_QUEUE_LEN;
+            s_worker_cmd_cnt--;
         }
+        if (l_cmd == worker_cmd_params && s_worker_ctrl_state != worker_quit_state) {
+            /* take FSM out of idle */
+            s_worker_ctrl_state = worker_normal_state;
+        }
+        l_state = s_worker_ctrl_state;
+        pthread_mutex_unlock(&s_worker_ctrl_mutex);
 
         /* request to stop worker thread, we will shut down */
         if (l_state == worker_quit_state) {
             //fprintf(stderr, "worker_thread: worker_quit_state received\n");
-            //fprintf(stderr, "worker_thread: before freeing curr_params\n");
-#if 1
-            //fprintf(stderr, "INFO worker_thread: rp_cb_in_params - freeing (9a) ...\n");
-            rp_free_params(&g_rp_cb_in_params);
-#else
-            //fprintf(stderr, "INFO worker_thread: rp_cb_in_params - NULLing (9b) ...\n");
-            g_rp_cb_in_params = NULL;
-#endif
-
-            //fprintf(stderr, "INFO worker_thread: rp_cb_in_params - freeing (9c) ...\n");
-            rb_free_params(&l_cb_in_copy_params);
-            //fprintf(stderr, "INFO worker_thread: rp_cb_in_params - freeing (9d) ...\n");
-            rb_free_params(&g_rb_info_worker_params);
-            //fprintf(stderr, "worker_thread: after freeing curr_params\n");
             break;
 
         } else if (l_state == worker_idle_state) {
-            usleep(10000);  // request for a 10 ms delay
             continue;
 
         } else if (l_state == worker_normal_state) {
-            if (l_cb_in_copy_params) {
-                int fpga_update_count = mark_changed_fpga_update_entries(s_worker_params, l_cb_in_copy_params, !l_params_init_done);  // return count of modified FPGA update values
-
-                //fprintf(stderr, "INFO worker_thread: worker_normal_state, processing new data --> update_count = %d\n", fpga_update_count);
-                if (fpga_update_count > 0) {
-                    //fprintf(stderr, "DEBUG worker_thread: fpga_update: -->  delegate to fpga_rb_update_all_params()\n");
-                    if (fpga_rb_update_all_params(s_worker_params, &l_cb_in_copy_params)) {
-                        fprintf(stderr, "ERROR worker - RadioBox: setting/getting of FPGA registers failed\n");
-                    }
-
-                    pthread_mutex_lock(&g_rp_cb_in_params_mutex);
-                    g_params_init_done = 1;
-                    pthread_mutex_unlock(&g_rp_cb_in_params_mutex);
-                }
+            rb_app_params_t* l_params = s_worker_params;
 
-                /* read back current values of automatic FPGA registers */
-                fpga_rb_get_fpga_params(s_worker_params, &l_cb_in_copy_params);
+            /* take the dirty entries before the snapshot - a value written in between is processed twice, but never lost */
+            (void) rb_pstore_take_dirty(l_dirty);
+            rb_pstore_snapshot(s_worker_params);
+            memcpy(s_worker_params_prev, s_worker_params, sizeof(s_worker_params));
 
-                /* update worker_params */
-                //fprintf(stderr, "DEBUG worker_thread: updating worker_params\n");
-                rb_copy_params(&s_worker_params, l_cb_in_copy_params, -1, 0);  // copy back changed values
+            int fpga_update_count = mark_changed_fpga_update_entries(s_worker_params, l_dirty);  // return count of modified FPGA update values
 
-                // new position of returning values
-                pthread_mutex_lock(&g_rb_info_worker_params_mutex);
-                rb_free_params(&g_rb_info_worker_params);  // invalidate old data
-                //fprintf(stderr, "DEBUG worker_thread: UPDATE RETURNED DATA  g_rb_info_worker_params\n");
-                rb_copy_params(&g_rb_info_worker_params, s_worker_params, -1, 1);
-                //print_rb_params(g_rb_info_worker_params);
-                pthread_mutex_unlock(&g_rb_info_worker_params_mutex);
+            //fprintf(stderr, "INFO worker_thread: worker_normal_state, processing new data --> update_count = %d\n", fpga_update_count);
+            if (fpga_update_count > 0) {
+                //fprintf(stderr, "DEBUG worker_thread: fpga_update: -->  delegate to fpga_rb_update_all_params()\n");
+                if (fpga_rb_update_all_params(s_worker_params, &l_params)) {
+                    fprintf(stderr, "ERROR worker - RadioBox: setting/getting of FPGA registers failed\n");
+                }
 
-                //fprintf(stderr, "INFO worker_thread: rp_cb_in_params - freeing (1) ...\n");
-                rb_free_params(&l_cb_in_copy_params);
+                pthread_mutex_lock(&g_rp_cb_in_params_mutex);
+                g_params_init_done = 1;
+                pthread_mutex_unlock(&g_rp_cb_in_params_mutex);
             }
-            /* drop working flag */
+
+            /* read back current values of automatic FPGA registers */
+            fpga_rb_get_fpga_params(s_worker_params, &l_params);
+
+            /* publish the values changed by the worker, e.g. single-shot tags and read back registers */
+            (void) rb_pstore_write_back(s_worker_params, s_worker_params_prev);
+
+            /* drop working flag and wake up rp_get_params() */
+            pthread_mutex_lock(&g_rb_info_worker_params_mutex);
             g_transport_pktIdx &= 0x7f;
+            pthread_cond_broadcast(&g_rb_info_worker_params_cond);
+            pthread_mutex_unlock(&g_rb_info_worker_params_mutex);
 
             //fprintf(stderr, "DEBUG worker_thread: mutex - before l_state change to idle\n");
             pthread_mutex_lock(&s_worker_ctrl_mutex);
-            s_worker_ctrl_state = worker_idle_state;
+            if (s_worker_ctrl_state != worker_quit_state) {
+                s_worker_ctrl_state = worker_idle_state;
+            }
             pthread_mutex_unlock(&s_worker_ctrl_mutex);
             //fprintf(stderr, "DEBUG worker_thread: mutex - after l_state change to idle\n");
 
@@ -282,53 +276,26 @@ void* worker_thread(void* args)
 
 
 /*----------------------------------------------------------------------------------*/
-int mark_changed_fpga_update_entries(const rb_app_params_t* ref, rb_app_params_t* cmp, int do_init)
+int mark_changed_fpga_update_entries(rb_app_params_t* params, const uint32_t dirty[])
 {
-    //fprintf(stderr, "mark_changed_fpga_update_entries: BEGIN\n");
-    if (!ref || !cmp) {
-        fprintf(stderr, "ERROR mark_changed_fpga_update_entries - bad arguments: ref = %p, cmp = %p\n", ref, cmp);
-        return -1;
-    }
-
-    //fprintf(stderr, "INFO mark_changed_fpga_update_entries: starting loop\n");
     int count = 0;
-    int i = 0;
-    while (cmp[i].name) {  // for each cmp parameter entry of the list do a check and mark
-        //fprintf(stderr, "INFO mark_changed_fpga_update_entries: processing name = %s, value = %f\n", cmp[i].name, cmp[i].value);
-        int idx = -1;
-        int j = 0;
-        while (ref[j].name) {
-            if (!strcmp(ref[j].name, cmp[i].name)) {  // known parameter
-                idx = j;
-                //fprintf(stderr, "INFO mark_changed_fpga_update_entries: matching idx = %d\n", idx);
-                break;
-            }
-            j++;
-        }
+    int idx;
 
-        if (idx == -1) {  // ignore unknown parameter
-            fprintf(stderr, "WARNING mark_changed_fpga_update_entries - unknown param: name = %s\n", cmp[i].name);
-            i++;
-            continue;
-        }
+    if (!params || !dirty) {
+        fprintf(stderr, "ERROR mark_changed_fpga_update_entries - bad arguments: params = %p, dirty = %p\n", params, dirty);
+        return -1;
+    }
 
-        if (do_init || (ref[idx].value != cmp[i].value)) {
-            //fprintf(stderr, "INFO mark_changed_fpga_update_entries: values differ for '%s' (do_init=%d, ref=%lf, cmp=%lf)\n", ref[idx].name, do_init, ref[idx].value, cmp[i].value);
-            if (ref[idx].fpga_update & ~0x80) {  // if fpga_update is set but the MARKER is masked out before the comparison
-                //fprintf(stderr, "INFO mark_changed_fpga_update_entries: fpga_update='1' and changed value --> MARK\n");
-                cmp[i].fpga_update |= 0x80;  // add FPGA update MARKER
-                count++;
-            }
+    for (idx = 0; params[idx].name; idx++) {
+        if ((dirty[idx >> 5] & (1U << (idx & 31))) && (params[idx].fpga_update & ~0x80)) {  // changed value and fpga_update is set
+            params[idx].fpga_update |= 0x80;  // add FPGA update MARKER
+            count++;
         }
-        i++;
     }
-    //fprintf(stderr, "INFO mark_changed_fpga_update_entries: FPGA update count = %d, do_init = %d\n", count, do_init);
-
-    //fprintf(stderr, "mark_changed_fpga_update_entries: END\n");
+    //fprintf(stderr, "INFO mark_changed_fpga_update_entries: FPGA update count = %d\n", count);
     return count;
 }
 
-
 /*----------------------------------------------------------------------------------*/
 int worker_get_signals(float*** traces, int* trc_idx)
 {
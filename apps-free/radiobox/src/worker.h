@@ -40,6 +40,22 @@ typedef enum worker_state_e {
 } worker_state_t;
 
 
+/** @brief Capacity of the command queue of the worker thread */
+#define WORKER_CMD_QUEUE_LEN    8
+
+/** @brief Commands posted to the worker thread */
+typedef enum worker_cmd_e {
+    /** @brief new parameter values are waiting in the parameter store */
+    worker_cmd_params = 0,
+
+    /** @brief shutdown worker */
+    worker_cmd_quit,
+
+    /** @brief must be last entry */
+    worker_cmd_nonexisting
+} worker_cmd_t;
+
+
 /** @brief Sets-up a running worker thread
  *
  * @param[in]    params        The initial parameter list the worker thread will take a copy from.
@@ -54,10 +70,23 @@ int worker_init(rb_app_params_t* params, int params_len);
  */
 int worker_exit(void);
 
+/** @brief Posts a command to the worker thread and wakes it up
+ *
+ * A command that is already pending is not queued twice. worker_cmd_quit is never lost,
+ * even when the queue is full.
+ *
+ * @param[in]    cmd   Command to be processed by the worker thread.
+ * @retval       0     Success.
+ * @retval       -1    Bad command.
+ * @retval       -2    Queue is full.
+ */
+int worker_post(worker_cmd_t cmd);
+
 /** @brief The worker thread that runs the state-machine for parameter handling
  *
  * All data transfered between this thread and outer context has to be handled
- * strictly by mutex access.
+ * strictly by mutex access. The thread sleeps on a condition variable until a
+ * command is posted by worker_post(), an idle worker does not wake up at all.
  *
  * @param[in]    args  @see pthread_create for details. Not used in this context.
  * @retval       void* @see pthread_create for details. Not used in this context.
@@ -65,17 +94,16 @@ int worker_exit(void);
 void* worker_thread(void* args);
 
 
-/** @brief Marks all changed values for that entries which are having a fpga_update flag set
+/** @brief Marks all dirty entries which are having a fpga_update flag set
  *
- * This function marks all changed parameter entries which are having the fpga_update attribute set.
+ * This function marks all parameter entries of the dirty bitmap which are having the fpga_update attribute set.
  * Additional the count of this modified parameter entries is returned.
  *
- * @param[in]    ref      Reference parameter list for old values taken as reference.
- * @param[inout] cmp      Comparison parameter list for new values to be compare against the reference.
- * @param[in]    do_init  If true all comparisons will indicate a changed state.
+ * @param[inout] params   Snapshot of the parameter store, @see rb_pstore_snapshot().
+ * @param[in]    dirty    Dirty bitmap taken by rb_pstore_take_dirty().
  * @retval       int      Number of parameters that changed the value AND their attribute fpga_update is set.
  */
-int mark_changed_fpga_update_entries(const rb_app_params_t* ref, rb_app_params_t* cmp, int do_init);
+int mark_changed_fpga_update_entries(rb_app_params_t* params, const uint32_t dirty[]);
 
 
 /** @brief Removes 'dirty' flags */
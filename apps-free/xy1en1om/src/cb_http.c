@@ -16,6 +16,9 @@
 #include "main.h"
 #include "worker.h"
 #include "fpga.h"
+#include "sha256_sw.h"
+#include "pipeline.h"
+#include "xy_stats.h"
 
 #include "cb_http.h"
 
@@ -30,11 +33,15 @@ extern xy_app_params_t      g_xy_default_params[];
 extern rp_app_params_t*     g_rp_cb_in_params;
 /** @brief Holds mutex to access on parameters from outside to the worker thread */
 extern pthread_mutex_t      g_rp_cb_in_params_mutex;
+/** @brief Signals that the worker thread has taken over g_rp_cb_in_params */
+extern pthread_cond_t       g_rp_cb_in_params_cond;
 
 /** @brief Current copy of params of the worker thread */
 extern xy_app_params_t*     g_xy_info_worker_params;
 /** @brief Holds mutex to access parameters from the worker thread to any other context */
 extern pthread_mutex_t      g_xy_info_worker_params_mutex;
+/** @brief Signals that the worker thread has exported its current params data */
+extern pthread_cond_t       g_xy_info_worker_params_cond;
 
 /** @brief params initialized */
 extern int                  g_params_init_done;
@@ -42,6 +49,12 @@ extern int                  g_params_init_done;
 /** @brief Holds last received transport frame index number and flag 0x80 for processing data */
 extern unsigned char        g_transport_pktIdx;
 
+/** @brief Hash chain run by the pipeline scheduler: the first two X11 stages */
+static const pipeline_stage_cfg_t s_app_pipeline_cfg[] = {
+    { pipeline_hash_sha256d,    pipeline_backend_auto },
+    { pipeline_hash_keccak512,  pipeline_backend_auto }
+};
+
 
 
 /*----------------------------------------------------------------------------*/
@@ -49,6 +62,11 @@ int rp_app_init(void)
 {
     fprintf(stderr, "\n<=== Loading xy1en1om version %s-%s ===>\n\n", VERSION, REVISION);
 
+    /* the software hash engine takes over whenever the PL is not available */
+    if (sha256_sw_init()) {
+        fprintf(stderr, "WARNING rp_app_init - software SHA-256 engine runs on a single core, only.\n");
+    }
+
     fpga_init();
 
     /* Set check pattern @ HK LEDs */
@@ -56,6 +74,11 @@ int rp_app_init(void)
     fpga_hk_setLeds(0, 0xff, 0xaa);
     //fprintf(stderr, "rp_app_init: setting pattern HK LEDs done.\n");
 
+    /* start the hash pipeline after the self-tests of fpga_init(), its scheduler threads sleep until messages are submitted */
+    if (pipeline_init(s_app_pipeline_cfg, sizeof(s_app_pipeline_cfg) / sizeof(s_app_pipeline_cfg[0]))) {
+        fprintf(stderr, "WARNING rp_app_init - hash pipeline not started\n");
+    }
+
 #if 0
     // no worker at this point of development
     /* start-up worker thread */
@@ -78,9 +101,15 @@ int rp_app_exit(void)
     /* turn off all LEDs */
     fpga_hk_setLeds(0, 0xff, 0x00);
 
+    /* stop the hash pipeline before its engines go away */
+    pipeline_exit();
+
     //fprintf(stderr, "rp_app_exit: calling fpga_exit()\n");
     fpga_exit();
 
+    /* stop the helper thread of the software hash engine */
+    sha256_sw_exit();
+
 #if 0
     //fprintf(stderr, "rp_app_exit: calling worker_exit()\n");
     /* shut-down worker thread */
@@ -97,8 +126,6 @@ int rp_app_exit(void)
 int rp_set_params(rp_app_params_t* p, int len)
 {
 #if 0
-	rp_app_params_t* p_copy = NULL;
-
     //fprintf(stderr, "!!! rp_set_params: BEGIN\n");
 
     if (!p || (len < 0)) {
@@ -111,25 +138,20 @@ int rp_set_params(rp_app_params_t* p, int len)
 
     /* create a local copy to release the caller */
     pthread_mutex_lock(&g_rp_cb_in_params_mutex);
-    do {
-        p_copy = g_rp_cb_in_params;
-        if (!p_copy) {
-            //fprintf(stderr, "DEBUG rp_set_params: g_rp_cb_in_params - rp_copy_params(&g_rp_cb_in_params, p, ) ...\n");
-            rp_copy_params(&g_rp_cb_in_params, p, len, !g_params_init_done);                            // piping to the worker thread
-            break;
-
-        } else {
-            pthread_mutex_unlock(&g_rp_cb_in_params_mutex);
-            /* wait for the worker to process previous job */
-            usleep(10000);
-            pthread_mutex_lock(&g_rp_cb_in_params_mutex);
-        }
-    } while (1);
-    pthread_mutex_unlock(&g_rp_cb_in_params_mutex);
+    while (g_rp_cb_in_params) {
+        /* wait for the worker to take over the previous job */
+        pthread_cond_wait(&g_rp_cb_in_params_cond, &g_rp_cb_in_params_mutex);
+    }
+    //fprintf(stderr, "DEBUG rp_set_params: g_rp_cb_in_params - rp_copy_params(&g_rp_cb_in_params, p, ) ...\n");
+    rp_copy_params(&g_rp_cb_in_params, p, len, !g_params_init_done);                                    // piping to the worker thread
 
-    /* set current pktIdx */
+    /* set current pktIdx - before the worker is able to drop the flag */
     int idx = rp_find_parms_index(p, TRANSPORT_pktIdx);
     g_transport_pktIdx = (int) (p[idx].value) | 0x80;                                                   // 0x80 flag: processing changed data
+    pthread_mutex_unlock(&g_rp_cb_in_params_mutex);
+
+    /* wake up the worker */
+    (void) worker_post(worker_cmd_params);
 
     //fprintf(stderr, "!!! rp_set_params: END - pktIdx = %s = %lf\n", p[0].name, p[0].value);
 #endif
@@ -145,35 +167,14 @@ int rp_get_params(rp_app_params_t** p)
 
     //fprintf(stderr, "??? rp_get_params: BEGIN\n");
 
-    /* wait until the worker has processed the input data */
-    //fprintf(stderr, "?.. rp_get_params: waiting for worker has processed the input data - waiting ...\n");
-    do {
-        if (!(g_transport_pktIdx & 0x80)) {
-            break;
-
-        } else {
-            /* wait for the worker to process previous job */
-            usleep(1000);
-        }
-    } while (1);
-    //fprintf(stderr, "?.. rp_get_params: waiting for worker has processed data - done.\n");
-
+    /* wait until the worker has processed the input data and has exported the current params data */
     //fprintf(stderr, "?.. rp_get_params: waiting for worker has exported the current params data - waiting ...\n");
     pthread_mutex_lock(&g_xy_info_worker_params_mutex);
-    do {
-        if (g_xy_info_worker_params) {
-            /* get the memory - free() is called by the caller */
-            count = rp_copy_params_xy2rp(&p_copy, g_xy_info_worker_params);
-            break;
-
-        } else {
-            pthread_mutex_unlock(&g_xy_info_worker_params_mutex);
-            /* wait for the worker to export its current params data */
-            //pthread_yield();
-            usleep(1000);
-            pthread_mutex_lock(&g_xy_info_worker_params_mutex);
-        }
-    } while (1);
+    while ((g_transport_pktIdx & 0x80) || !g_xy_info_worker_params) {
+        pthread_cond_wait(&g_xy_info_worker_params_cond, &g_xy_info_worker_params_mutex);
+    }
+    /* get the memory - free() is called by the caller */
+    count = rp_copy_params_xy2rp(&p_copy, g_xy_info_worker_params);
     pthread_mutex_unlock(&g_xy_info_worker_params_mutex);
     //fprintf(stderr, "?.. rp_get_params: waiting for worker has exported the current params data - done.\n");
 
@@ -181,6 +182,15 @@ int rp_get_params(rp_app_params_t** p)
     *p = p_copy;
 
     //fprintf(stderr, "??? rp_get_params: END\n\n");
+#else
+    /* the worker is not running - export the latency statistics of the hashing stages, at least */
+    xy_app_params_t* l_stats_params = NULL;
+
+    if (xy_stats_export(&l_stats_params) > 0) {
+        /* get the memory - free() is called by the caller */
+        count = rp_copy_params_xy2rp(p, l_stats_params);
+    }
+    xy_free_params(&l_stats_params);
 #endif
     return count;
 }
@@ -0,0 +1,383 @@
+/**
+ * @brief Red Pitaya DMA buffer manager of the xy1en1om sub-module.
+ *
+ * The ring is allocated once at fpga_xy_init() time. Its physical address is known by the
+ * backend, so there is no need for resolving it through /proc/self/pagemap and no need for
+ * dropping the page cache of the whole system for a single hash.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+
+#include "dma_ring.h"
+
+
+/** @brief Names of the u-dma-buf sysfs attributes, in the order of dma_ring_t.sync_fd[] */
+static const char* s_udmabuf_sync_attr[5] = {
+    "sync_offset", "sync_size", "sync_direction", "sync_for_cpu", "sync_for_device"
+};
+
+
+/*----------------------------------------------------------------------------*/
+static int dma_ring_sysfs_read_ulong(const char* attr, unsigned long* val)
+{
+    char  fn[128];
+    FILE* fp;
+    int   ret;
+
+    snprintf(fn, sizeof(fn), "%s/%s", DMA_RING_UDMABUF_SYSFS, attr);
+    if (!(fp = fopen(fn, "r"))) {
+        return -1;
+    }
+    ret = (fscanf(fp, "%li", (long*) val) == 1) ?  0 : -1;
+    fclose(fp);
+    return ret;
+}
+
+static void dma_ring_sysfs_write_ulong(int fd, unsigned long val)
+{
+    char buf[24];
+    int  len = snprintf(buf, sizeof(buf), "%lu", val);
+
+    if (pwrite(fd, buf, len, 0) != len) {
+        fprintf(stderr, "ERROR - dma_ring: sysfs write failed: %s\n", strerror(errno));
+    }
+}
+
+static void dma_ring_close_fds(dma_ring_t* ring)
+{
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        if (ring->sync_fd[i] >= 0) {
+            close(ring->sync_fd[i]);
+            ring->sync_fd[i] = -1;
+        }
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+        ring->fd = -1;
+    }
+}
+
+static void dma_ring_common_close(dma_ring_t* ring)
+{
+    if (ring->virt) {
+        munmap(ring->virt, ring->size);
+        ring->virt = NULL;
+    }
+    dma_ring_close_fds(ring);
+}
+
+
+/* --- u-dma-buf backend --- */
+
+static int dma_ring_udmabuf_open(dma_ring_t* ring, size_t size)
+{
+    unsigned long phys = 0;
+    unsigned long dev_size = 0;
+    char fn[128];
+    int  i;
+
+    if (dma_ring_sysfs_read_ulong("phys_addr", &phys) || dma_ring_sysfs_read_ulong("size", &dev_size)) {
+        return -1;
+    }
+    if (dev_size < size) {
+        fprintf(stderr, "ERROR - dma_ring: %s too small, size = 0x%lx\n", DMA_RING_UDMABUF_DEV, dev_size);
+        return -1;
+    }
+
+    for (i = 0; i < 5; i++) {
+        snprintf(fn, sizeof(fn), "%s/%s", DMA_RING_UDMABUF_SYSFS, s_udmabuf_sync_attr[i]);
+        ring->sync_fd[i] = open(fn, O_WRONLY);
+        if (ring->sync_fd[i] < 0) {
+            break;
+        }
+    }
+
+    /* without the sync attributes the memory is used uncached */
+    ring->fd = open(DMA_RING_UDMABUF_DEV, (i == 5) ?  O_RDWR : (O_RDWR | O_SYNC));
+    if (ring->fd < 0) {
+        dma_ring_close_fds(ring);
+        return -1;
+    }
+    if (i < 5) {
+        int j;
+        for (j = 0; j < i; j++) {
+            close(ring->sync_fd[j]);
+            ring->sync_fd[j] = -1;
+        }
+    }
+
+    ring->virt = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (ring->virt == MAP_FAILED) {
+        ring->virt = NULL;
+        dma_ring_close_fds(ring);
+        return -1;
+    }
+    ring->phys = (uint32_t) phys;
+    ring->size = size;
+    return 0;
+}
+
+static void dma_ring_udmabuf_sync(dma_ring_t* ring, size_t ofs, size_t len, dma_ring_dir_t dir)
+{
+    if (ring->sync_fd[0] < 0) {
+        __sync_synchronize();  // uncached mapping: drain the write buffer, only
+        return;
+    }
+
+    dma_ring_sysfs_write_ulong(ring->sync_fd[0], ofs);
+    dma_ring_sysfs_write_ulong(ring->sync_fd[1], len);
+    dma_ring_sysfs_write_ulong(ring->sync_fd[2], dir);
+    dma_ring_sysfs_write_ulong(ring->sync_fd[(dir == dma_ring_to_device) ?  4 : 3], 1);
+}
+
+const dma_ring_backend_t dma_ring_backend_udmabuf = {
+    "udmabuf", dma_ring_udmabuf_open, dma_ring_common_close, dma_ring_udmabuf_sync
+};
+
+
+/* --- /dev/mem reserved-memory backend --- */
+
+/** @brief Reads a device tree property of big-endian cells, returns the count of cells or -1 */
+static int dma_ring_dt_read_cells(const char* fn, uint32_t* cells, int max)
+{
+    uint8_t buf[64];
+    int     fd, len, i;
+
+    if ((fd = open(fn, O_RDONLY)) < 0) {
+        return -1;
+    }
+    len = (int) read(fd, buf, sizeof(buf));
+    close(fd);
+    if (len < 4 || (len & 3)) {
+        return -1;
+    }
+
+    len >>= 2;
+    if (len > max) {
+        len = max;
+    }
+    for (i = 0; i < len; i++) {
+        cells[i] = ((uint32_t) buf[(i << 2)] << 24) | ((uint32_t) buf[(i << 2) + 1] << 16) |
+                   ((uint32_t) buf[(i << 2) + 2] << 8) | (uint32_t) buf[(i << 2) + 3];
+    }
+    return len;
+}
+
+/** @brief Checks that one region of the reserved-memory node covers base .. base + size - 1 */
+static int dma_ring_devmem_reserved(uint64_t base, size_t size)
+{
+    char           fn[sizeof(DMA_RING_RESERVED_DT) + sizeof(((struct dirent*) 0)->d_name) + 8];
+    uint32_t       addr_cells = 1, size_cells = 1, reg[16];
+    DIR*           dir;
+    struct dirent* de;
+    int            found = 0;
+
+    if (dma_ring_dt_read_cells(DMA_RING_RESERVED_DT "/#address-cells", reg, 1) == 1) {
+        addr_cells = reg[0];
+    }
+    if (dma_ring_dt_read_cells(DMA_RING_RESERVED_DT "/#size-cells", reg, 1) == 1) {
+        size_cells = reg[0];
+    }
+    if (addr_cells < 1 || addr_cells > 2 || size_cells < 1 || size_cells > 2) {
+        return 0;
+    }
+
+    if (!(dir = opendir(DMA_RING_RESERVED_DT))) {
+        return 0;
+    }
+    while (!found && (de = readdir(dir))) {
+        int n, i;
+
+        if (de->d_name[0] == '.') {
+            continue;
+        }
+        snprintf(fn, sizeof(fn), "%s/%s/reg", DMA_RING_RESERVED_DT, de->d_name);
+        n = dma_ring_dt_read_cells(fn, reg, 16);
+
+        /* each entry of reg is an address and a size */
+        for (i = 0; i + (int) (addr_cells + size_cells) <= n; i += addr_cells + size_cells) {
+            uint64_t r_base = (addr_cells == 2) ?  ((uint64_t) reg[i] << 32) | reg[i + 1] : reg[i];
+            uint64_t r_size = (size_cells == 2) ?  ((uint64_t) reg[i + addr_cells] << 32) | reg[i + addr_cells + 1] : reg[i + addr_cells];
+
+            if (r_base <= base && base + size <= r_base + r_size) {
+                found = 1;
+                break;
+            }
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+static int dma_ring_devmem_open(dma_ring_t* ring, size_t size)
+{
+    if (!dma_ring_devmem_reserved(DMA_RING_RESERVED_BASE, size)) {
+        fprintf(stderr, "ERROR - dma_ring: 0x%08x .. 0x%08zx is not reserved in %s, /dev/mem not used\n",
+                DMA_RING_RESERVED_BASE, DMA_RING_RESERVED_BASE + size - 1, DMA_RING_RESERVED_DT);
+        return -1;
+    }
+
+    ring->fd = open("/dev/mem", O_RDWR | O_SYNC);
+    if (ring->fd < 0) {
+        return -1;
+    }
+
+    ring->virt = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, DMA_RING_RESERVED_BASE);
+    if (ring->virt == MAP_FAILED) {
+        ring->virt = NULL;
+        dma_ring_close_fds(ring);
+        return -1;
+    }
+    ring->phys = DMA_RING_RESERVED_BASE;
+    ring->size = size;
+    return 0;
+}
+
+static void dma_ring_devmem_sync(dma_ring_t* ring, size_t ofs, size_t len, dma_ring_dir_t dir)
+{
+    /* O_SYNC maps the region uncached: drain the write buffer, only */
+    __sync_synchronize();
+}
+
+const dma_ring_backend_t dma_ring_backend_devmem = {
+    "devmem", dma_ring_devmem_open, dma_ring_common_close, dma_ring_devmem_sync
+};
+
+
+/* --- anonymous mapping backend --- */
+
+static int dma_ring_anon_open(dma_ring_t* ring, size_t size)
+{
+    ring->virt = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring->virt == MAP_FAILED) {
+        ring->virt = NULL;
+        return -1;
+    }
+    ring->phys = (uint32_t) (uintptr_t) ring->virt;  // faked, no device attached
+    ring->size = size;
+    return 0;
+}
+
+static void dma_ring_anon_sync(dma_ring_t* ring, size_t ofs, size_t len, dma_ring_dir_t dir)
+{
+    __sync_synchronize();
+}
+
+const dma_ring_backend_t dma_ring_backend_anon = {
+    "anon", dma_ring_anon_open, dma_ring_common_close, dma_ring_anon_sync
+};
+
+
+/*----------------------------------------------------------------------------*/
+int dma_ring_init(dma_ring_t* ring, const dma_ring_backend_t* backend, size_t size)
+{
+    int i;
+
+    if (!ring || !backend) {
+        return -1;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    for (i = 0; i < 5; i++) {
+        ring->sync_fd[i] = -1;
+    }
+
+    /* an empty ring is a caller's choice, not a failure of the backend */
+    if (!size) {
+        return -1;
+    }
+
+    size = (size + DMA_RING_SLOT_SIZE - 1) & ~((size_t) DMA_RING_SLOT_SIZE - 1);
+    if (backend->open(ring, size)) {
+        fprintf(stderr, "ERROR - dma_ring_init: backend %s failed to map 0x%zx bytes\n", backend->name, size);
+        ring->backend = NULL;
+        return -1;
+    }
+
+    ring->backend = backend;
+    ring->slots   = (int) (ring->size / DMA_RING_SLOT_SIZE);
+    fprintf(stderr, "INFO - dma_ring_init: backend %s, virt = %p, phys = 0x%08x, slots = %d\n",
+            backend->name, ring->virt, ring->phys, ring->slots);
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int dma_ring_init_auto(dma_ring_t* ring, size_t size)
+{
+    if (!dma_ring_init(ring, &dma_ring_backend_udmabuf, size)) {
+        return 0;
+    }
+    return dma_ring_init(ring, &dma_ring_backend_devmem, size);
+}
+
+/*----------------------------------------------------------------------------*/
+void dma_ring_exit(dma_ring_t* ring)
+{
+    if (!ring || !ring->backend) {
+        return;
+    }
+
+    ring->backend->close(ring);
+    ring->backend = NULL;
+    ring->slots   = 0;
+    ring->head    = 0;
+    ring->used    = 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int dma_ring_get_slot(dma_ring_t* ring, dma_ring_slot_t* slot)
+{
+    if (!ring || !ring->backend || !slot || ring->used >= ring->slots) {
+        return -1;
+    }
+
+    slot->idx  = (ring->head + ring->used) % ring->slots;
+    slot->virt = ring->virt + (size_t) slot->idx * DMA_RING_SLOT_SIZE;
+    slot->phys = ring->phys + (uint32_t) slot->idx * DMA_RING_SLOT_SIZE;
+    ring->used++;
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int dma_ring_put_slot(dma_ring_t* ring)
+{
+    if (!ring || !ring->used) {
+        return -1;
+    }
+
+    ring->head = (ring->head + 1) % ring->slots;
+    ring->used--;
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+void dma_ring_sync_slot(dma_ring_t* ring, const dma_ring_slot_t* slot, size_t len, dma_ring_dir_t dir)
+{
+    if (!ring || !ring->backend || !slot) {
+        return;
+    }
+
+    if (len > DMA_RING_SLOT_SIZE) {
+        len = DMA_RING_SLOT_SIZE;
+    }
+    ring->backend->sync(ring, (size_t) slot->idx * DMA_RING_SLOT_SIZE, len, dir);
+    ring->sync_count++;
+}
@@ -0,0 +1,195 @@
+/**
+ * @brief Red Pitaya DMA buffer manager of the xy1en1om sub-module.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __DMA_RING_H
+#define __DMA_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/** @defgroup dma_ring_h Physically contiguous DMA ring with message slots
+ * @{
+ */
+
+/** @brief Size of a message slot. Each slot starts on a 4 kB page, thus axi_datamover_s_axi_hp0 operates with the basic command mode. */
+#define DMA_RING_SLOT_SIZE          0x1000
+
+/** @brief Default size of the whole ring. */
+#define DMA_RING_DEFAULT_SIZE       0x100000
+
+/** @brief The u-dma-buf device node (CMA allocated, physically contiguous). */
+#define DMA_RING_UDMABUF_DEV        "/dev/udmabuf0"
+
+/** @brief The sysfs directory of the u-dma-buf device. */
+#define DMA_RING_UDMABUF_SYSFS      "/sys/class/udmabuf/udmabuf0"
+
+/** @brief Physical base address of the reserved-memory region used with /dev/mem (last MB of the 512 MB DDR). */
+#define DMA_RING_RESERVED_BASE      0x1FF00000
+
+/** @brief Device tree node whose children describe the reserved-memory regions. */
+#define DMA_RING_RESERVED_DT        "/proc/device-tree/reserved-memory"
+
+
+/** @brief Direction of a cache maintenance operation */
+typedef enum dma_ring_dir_e {
+    /** @brief CPU has written the slot, the FPGA is going to read it (clean) */
+    dma_ring_to_device = 1,
+
+    /** @brief FPGA has written the slot, the CPU is going to read it (invalidate) */
+    dma_ring_from_device = 2
+} dma_ring_dir_t;
+
+struct dma_ring_s;
+
+/** @brief Backend of the DMA ring, it provides the memory and its cache maintenance */
+typedef struct dma_ring_backend_s {
+    /** @brief name  Name of the backend for messages */
+    const char* name;
+
+    /** @brief open  Maps size bytes, sets virt, phys and size of the ring - returns 0 on success */
+    int  (*open)(struct dma_ring_s* ring, size_t size);
+
+    /** @brief close  Releases the memory and all handles */
+    void (*close)(struct dma_ring_s* ring);
+
+    /** @brief sync  Cache maintenance of a part of the ring */
+    void (*sync)(struct dma_ring_s* ring, size_t ofs, size_t len, dma_ring_dir_t dir);
+} dma_ring_backend_t;
+
+/** @brief DMA ring state */
+typedef struct dma_ring_s {
+    /** @brief backend  Backend in use */
+    const dma_ring_backend_t* backend;
+
+    /** @brief virt  Start of the ring as seen by the CPU */
+    uint8_t*  virt;
+
+    /** @brief phys  Start of the ring as seen by the FPGA on the AMBA bus */
+    uint32_t  phys;
+
+    /** @brief size  Size of the ring in bytes, a multiple of DMA_RING_SLOT_SIZE */
+    size_t    size;
+
+    /** @brief slots  Count of message slots */
+    int       slots;
+
+    /** @brief head  Index of the oldest slot in use */
+    int       head;
+
+    /** @brief used  Count of slots in use */
+    int       used;
+
+    /** @brief fd  File descriptor of the memory device, -1 if not used */
+    int       fd;
+
+    /** @brief sync_fd  File descriptors of the sysfs sync attributes (offset, size, direction, for_cpu, for_device), -1 if not used */
+    int       sync_fd[5];
+
+    /** @brief sync_count  Count of cache maintenance operations done */
+    unsigned long sync_count;
+} dma_ring_t;
+
+/** @brief A message slot handed out by dma_ring_get_slot() */
+typedef struct dma_ring_slot_s {
+    /** @brief idx  Slot index inside of the ring */
+    int       idx;
+
+    /** @brief virt  Slot memory as seen by the CPU */
+    uint8_t*  virt;
+
+    /** @brief phys  Slot memory as seen by the FPGA */
+    uint32_t  phys;
+} dma_ring_slot_t;
+
+
+/** @brief u-dma-buf backend: CMA memory, cached, cache maintenance through the sysfs sync attributes */
+extern const dma_ring_backend_t dma_ring_backend_udmabuf;
+
+/** @brief /dev/mem backend: reserved-memory region at DMA_RING_RESERVED_BASE, mapped uncached.
+ *  It refuses to map the region unless a node below DMA_RING_RESERVED_DT covers all of it. */
+extern const dma_ring_backend_t dma_ring_backend_devmem;
+
+/** @brief Anonymous mapping backend for unit tests on a host, the physical address is faked */
+extern const dma_ring_backend_t dma_ring_backend_anon;
+
+
+/* function declarations, detailed descriptions is in apparent implementation file  */
+
+/**
+ * @brief Allocates the DMA ring through the given backend
+ *
+ * @param[out] ring     Ring to be set-up.
+ * @param[in]  backend  Backend to be used.
+ * @param[in]  size     Requested size in bytes, rounded up to DMA_RING_SLOT_SIZE.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, error message is printed on standard error device - a size of 0 is refused silently
+ */
+int dma_ring_init(dma_ring_t* ring, const dma_ring_backend_t* backend, size_t size);
+
+/**
+ * @brief Allocates the DMA ring through the first backend that succeeds: u-dma-buf, then /dev/mem
+ *
+ * The /dev/mem backend is used only when the device tree reserves its region, otherwise the FPGA
+ * would write into memory the kernel hands out.
+ *
+ * @param[out] ring     Ring to be set-up.
+ * @param[in]  size     Requested size in bytes.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, no DMA capable memory available
+ */
+int dma_ring_init_auto(dma_ring_t* ring, size_t size);
+
+/**
+ * @brief Releases the DMA ring
+ *
+ * @param[inout] ring   Ring to be released, can be called multiple times.
+ */
+void dma_ring_exit(dma_ring_t* ring);
+
+/**
+ * @brief Hands out the next free message slot
+ *
+ * @param[in]  ring     The ring.
+ * @param[out] slot     The slot with its virtual and physical address.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, all slots are in use
+ */
+int dma_ring_get_slot(dma_ring_t* ring, dma_ring_slot_t* slot);
+
+/**
+ * @brief Returns the oldest slot in use to the ring
+ *
+ * @param[in]  ring     The ring.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, no slot in use
+ */
+int dma_ring_put_slot(dma_ring_t* ring);
+
+/**
+ * @brief Cache maintenance for the first len bytes of a slot
+ *
+ * @param[in]  ring     The ring.
+ * @param[in]  slot     The slot.
+ * @param[in]  len      Count of bytes written or to be read, clipped to DMA_RING_SLOT_SIZE.
+ * @param[in]  dir      dma_ring_to_device after the CPU has written, dma_ring_from_device before the CPU reads.
+ */
+void dma_ring_sync_slot(dma_ring_t* ring, const dma_ring_slot_t* slot, size_t len, dma_ring_dir_t dir);
+
+/** @} */
+
+
+#endif /* __DMA_RING_H */
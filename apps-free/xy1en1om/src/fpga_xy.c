@@ -8,15 +8,30 @@
  * for more details on the language used herein.
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <limits.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/eventfd.h>
 
 #include "main.h"
 #include "fpga.h"
 #include "cb_http.h"
+#include "keccak_sw.h"
+#include "xy_stats.h"
+#include "test_sha256_sw.h"
+#include "test_keccak_sw.h"
+#include "test_pipeline.h"
+#include "test_dma_ring.h"
 #include "test_sha256_fifo.h"
 #include "test_sha256_dma.h"
 
@@ -30,6 +45,10 @@ extern pthread_mutex_t      g_xy_info_worker_params_mutex;
 extern int                  g_fpga_xy_mem_fd;
 /** @brief The xy1en1om memory layout of the FPGA registers. */
 extern fpga_xy_reg_mem_t*   g_fpga_xy_reg_mem;
+/** @brief The xy1en1om DMA ring for the SHA-256 DMA engine. */
+extern dma_ring_t           g_fpga_xy_dma_ring;
+/** @brief The xy1en1om register backend in use. */
+extern fpga_xy_backend_t    g_fpga_xy_backend;
 
 
 /** @brief Filename of the default FPGA configuration. */
@@ -42,16 +61,133 @@ const char fn_bit_orig[]  = "/opt/redpitaya/fpga/fpga.bit_orig";
 const char fn_bit_fresh[] = "/opt/redpitaya/www/apps/xy1en1om/fpga.bit";
 
 
+/** @brief Queue of the submitted SHA-256 jobs, ring buffer */
+static xy_sha256_job_t      s_sha256_queue[XY_SHA256_QUEUE_LEN];
+/** @brief Index of the oldest job in s_sha256_queue */
+static int                  s_sha256_queue_head = 0;
+/** @brief Count of jobs in s_sha256_queue */
+static int                  s_sha256_queue_cnt  = 0;
+
+/** @brief Double buffer of padded FIFO words, one message is pushed while the next one is prepared */
+static uint32_t             s_sha256_stage[2][XY_SHA256_MAX_BLOCKS << 4];
+/** @brief Count of words in each of the stage buffers, 0: not prepared */
+static int                  s_sha256_stage_len[2] = { 0, 0 };
+/** @brief Stage buffer holding the words of the oldest job */
+static int                  s_sha256_stage_cur = 0;
+/** @brief Failure of xy_sha256_collect() held back while hash values were returned, 0: none */
+static int                  s_sha256_collect_err = 0;
+
+
+/** @brief Register backend requested for the next fpga_xy_init() */
+static fpga_xy_backend_t    s_xy_backend_req = fpga_xy_backend_hw;
+
+/** @brief Strategy of the completion wait layer */
+static xy_wait_mode_t       s_wait_mode       = xy_wait_adaptive;
+/** @brief Count of status reads of the spin phase */
+static int                  s_wait_spin_max   = XY_WAIT_SPIN_MAX;
+/** @brief Count of sched_yield() calls of the yield phase */
+static int                  s_wait_yield_max  = XY_WAIT_YIELD_MAX;
+/** @brief Timeout of each wait in microseconds */
+static int                  s_wait_timeout_us = XY_WAIT_TIMEOUT_US;
+/** @brief UIO device of the xy1en1om interrupt, -1: not available */
+static int                  s_wait_uio_fd     = -1;
+/** @brief eventfd for the block phase when no interrupt is available */
+static int                  s_wait_event_fd   = -1;
+/** @brief Statistics of the completion wait layer */
+static xy_wait_stats_t      s_wait_stats;
+/** @brief Mutex for s_wait_stats */
+static pthread_mutex_t      s_wait_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** @brief Queue of the submitted Keccak-512 jobs, ring buffer */
+static xy_keccak512_job_t   s_keccak512_queue[XY_KECCAK512_QUEUE_LEN];
+/** @brief Index of the oldest job in s_keccak512_queue */
+static int                  s_keccak512_queue_head = 0;
+/** @brief Count of jobs in s_keccak512_queue */
+static int                  s_keccak512_queue_cnt  = 0;
+
+
+/*----------------------------------------------------------------------------*/
+int fpga_xy_set_backend(fpga_xy_backend_t backend)
+{
+    if (backend < fpga_xy_backend_hw || backend >= fpga_xy_backend_nonexisting) {
+        return -1;
+    }
+
+    s_xy_backend_req = backend;
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Opens the UIO device whose name is XY_WAIT_UIO_NAME, the others belong to other devices
+ *
+ * @retval int  File descriptor, -1: the interrupt is not routed to a UIO device.
+ */
+static int xy_wait_open_uio(void)
+{
+    char           fn[sizeof(XY_WAIT_UIO_SYSFS) + sizeof(((struct dirent*) 0)->d_name) + 8];
+    char           name[64];
+    DIR*           dir;
+    struct dirent* de;
+    int            fd = -1;
+
+    if (!(dir = opendir(XY_WAIT_UIO_SYSFS))) {
+        return -1;
+    }
+    while (fd < 0 && (de = readdir(dir))) {
+        FILE* fp;
+
+        if (strncmp(de->d_name, "uio", 3)) {
+            continue;
+        }
+        snprintf(fn, sizeof(fn), "%s/%s/name", XY_WAIT_UIO_SYSFS, de->d_name);
+        if (!(fp = fopen(fn, "r"))) {
+            continue;
+        }
+        if (fgets(name, sizeof(name), fp)) {
+            name[strcspn(name, "\n")] = 0;
+            if (!strcmp(name, XY_WAIT_UIO_NAME)) {
+                snprintf(fn, sizeof(fn), "/dev/%s", de->d_name);
+                fd = open(fn, O_RDWR | O_CLOEXEC);
+            }
+        }
+        fclose(fp);
+    }
+    closedir(dir);
+    return fd;
+}
+
 /*----------------------------------------------------------------------------*/
 int fpga_xy_init(void)
 {
+    const char* env = getenv(FPGA_XY_BACKEND_ENV);
+
     //fprintf(stderr, "DEBUG fpga_xy_init: BEGIN\n");
 
     /* make sure all previous data is vanished */
     fpga_xy_exit();
 
+    g_fpga_xy_backend = s_xy_backend_req;
+    if (env && !strcmp(env, "sim")) {
+        g_fpga_xy_backend = fpga_xy_backend_sim;
+    } else if (env && !strcmp(env, "hw")) {
+        g_fpga_xy_backend = fpga_xy_backend_hw;
+    }
+
+    if (g_fpga_xy_backend == fpga_xy_backend_sim) {
+        /* the simulated DMA engine reads from ordinary memory - never probe /dev/mem off the board */
+        if (dma_ring_init(&g_fpga_xy_dma_ring, &dma_ring_backend_anon, DMA_RING_DEFAULT_SIZE)) {
+            fprintf(stderr, "WARNING - fpga_xy_init: no DMA memory available, SHA-256 DMA mode disabled\n");
+        }
+        if (fpga_xy_sim_init(&g_fpga_xy_reg_mem, &g_fpga_xy_dma_ring)) {
+            fprintf(stderr, "ERROR - fpga_xy_init: g_fpga_xy_reg_mem - simulation failed\n");
+            dma_ring_exit(&g_fpga_xy_dma_ring);
+            return -1;
+        }
+        fprintf(stderr, "INFO - fpga_xy_init: register simulation backend selected\n");
+
     /* init the xy1en1om FPGA sub-module access */
-    if (fpga_mmap_area(&g_fpga_xy_mem_fd, (void**) &g_fpga_xy_reg_mem, FPGA_XY_BASE_ADDR, FPGA_XY_BASE_SIZE)) {
+    } else if (fpga_mmap_area(&g_fpga_xy_mem_fd, (void**) &g_fpga_xy_reg_mem, FPGA_XY_BASE_ADDR, FPGA_XY_BASE_SIZE)) {
         fprintf(stderr, "ERROR - fpga_xy_init: g_fpga_xy_reg_mem - mmap() failed: %s\n", strerror(errno));
         fpga_exit();
         return -1;
@@ -66,6 +202,19 @@ int fpga_xy_init(void)
         return -1;
     }
 
+    // the interrupt of the xy1en1om sub-module, if the bitstream routes it to a UIO device
+    s_wait_uio_fd = xy_wait_open_uio();
+    s_wait_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (s_wait_uio_fd < 0 && s_wait_event_fd < 0) {
+        fprintf(stderr, "WARNING - fpga_xy_init: neither UIO device %s nor an eventfd available, blocking waits sleep in slices\n", XY_WAIT_UIO_NAME);
+    }
+    s_wait_stats.irq = (s_wait_uio_fd >= 0);
+
+    // allocate the DMA ring once - the FIFO mode is still available without it
+    if (g_fpga_xy_backend == fpga_xy_backend_hw && dma_ring_init_auto(&g_fpga_xy_dma_ring, DMA_RING_DEFAULT_SIZE)) {
+        fprintf(stderr, "WARNING - fpga_xy_init: no DMA capable memory available, SHA-256 DMA mode disabled\n");
+    }
+
     // enable xy1en1om sub-module
     fpga_xy_enable(0);
     fpga_xy_enable(1);
@@ -73,6 +222,10 @@ int fpga_xy_init(void)
     // studying section as quick hack
     {
         fprintf(stderr, "INFO study section: INIT - BEGIN\n");
+        test_sha256_sw_INIT();
+        test_keccak_sw_INIT();
+        test_pipeline_INIT();
+        test_dma_ring_INIT();
 #if 0
         test_sha256_fifo_INIT();
 #else
@@ -81,6 +234,10 @@ int fpga_xy_init(void)
         fprintf(stderr, "INFO study section: INIT - END\n");
 
         fprintf(stderr, "INFO study section: TEST - BEGIN\n");
+        test_sha256_sw_TEST();
+        test_keccak_sw_TEST();
+        test_pipeline_TEST();
+        test_dma_ring_TEST();
 #if 0
         test_sha256_fifo_TEST();
 #else
@@ -104,13 +261,34 @@ int fpga_xy_exit(void)
 #else
     test_sha256_dma_FINALIZE();
 #endif
+    test_dma_ring_FINALIZE();
+    test_pipeline_FINALIZE();
+    test_keccak_sw_FINALIZE();
+    test_sha256_sw_FINALIZE();
     fprintf(stderr, "INFO study section: FINALIZE - END\n");
 
 	/* disable xy1en1om sub-module */
     fpga_xy_enable(0);
 
+    /* release the DMA ring */
+    dma_ring_exit(&g_fpga_xy_dma_ring);
+
+    /* release the wait layer handles */
+    if (s_wait_uio_fd >= 0) {
+        close(s_wait_uio_fd);
+        s_wait_uio_fd = -1;
+    }
+    if (s_wait_event_fd >= 0) {
+        close(s_wait_event_fd);
+        s_wait_event_fd = -1;
+    }
+
     /* unmap the xy1en1om sub-module */
-    if (fpga_munmap_area(&g_fpga_xy_mem_fd, (void**) &g_fpga_xy_reg_mem, FPGA_XY_BASE_ADDR, FPGA_XY_BASE_SIZE)) {
+    if (g_fpga_xy_backend == fpga_xy_backend_sim) {
+        fpga_xy_sim_exit(&g_fpga_xy_reg_mem);
+        g_fpga_xy_backend = fpga_xy_backend_hw;
+
+    } else if (fpga_munmap_area(&g_fpga_xy_mem_fd, (void**) &g_fpga_xy_reg_mem, FPGA_XY_BASE_ADDR, FPGA_XY_BASE_SIZE)) {
         fprintf(stderr, "ERROR - fpga_xy_exit: g_fpga_xy_reg_mem - munmap() failed: %s\n", strerror(errno));
     }
 
@@ -129,21 +307,21 @@ void fpga_xy_enable(int enable)
 
     if (enable) {
         // enable xy1en1om
-        g_fpga_xy_reg_mem->ctrl           = 0x00000001;    // enable xy1en1om sub-module
+        FPGA_XY_REG_WR(ctrl,          0x00000001);    // enable xy1en1om sub-module
 
         //fprintf(stderr, "fpga_xy_enable(1): enabling SHA-256 part\n");
-        g_fpga_xy_reg_mem->sha256_ctrl    = 0x00000001;    // enable SHA-256 part of the xy1en1om sub-module
+        FPGA_XY_REG_WR(sha256_ctrl,   0x00000001);    // enable SHA-256 part of the xy1en1om sub-module
 
     } else {
         // disable xy1en1om
         //fprintf(stderr, "fpga_xy_enable(0): disabling SHA-256 part\n");
-        g_fpga_xy_reg_mem->sha256_ctrl    = 0x00000000;    // disable SHA-256 part of the xy1en1om sub-module
+        FPGA_XY_REG_WR(sha256_ctrl,   0x00000000);    // disable SHA-256 part of the xy1en1om sub-module
 
         //fprintf(stderr, "fpga_xy_enable(0): disabling KEK-512 part\n");
-        g_fpga_xy_reg_mem->kek512_ctrl    = 0x00000000;    // disable KEK-512 part of the xy1en1om sub-module
+        FPGA_XY_REG_WR(kek512_ctrl,   0x00000000);    // disable KEK-512 part of the xy1en1om sub-module
 
         //fprintf(stderr, "fpga_xy_enable(0): disabling xy1en1om sub-module\n");
-        g_fpga_xy_reg_mem->ctrl           = 0x00000000;    // disable xy1en1om sub-module
+        FPGA_XY_REG_WR(ctrl,          0x00000000);    // disable xy1en1om sub-module
     }
 
     //fprintf(stderr, "DEBUG - fpga_xy_enable(%d): END\n", enable);
@@ -159,7 +337,7 @@ void fpga_xy_reset(void)
     //fprintf(stderr, "INFO - fpga_xy_reset\n");
 
     /* set reset flag of the SHA-256 part which falls back by its own */
-    g_fpga_xy_reg_mem->sha256_ctrl = 0x00000003;
+    FPGA_XY_REG_WR(sha256_ctrl, 0x00000003);
     usleep(1);
 }
 
@@ -190,6 +368,437 @@ uint32_t fpga_get_version()
 }
 
 
+/*----------------------------------------------------------------------------*/
+int xy_wait_set_mode(xy_wait_mode_t mode, int spin_max, int yield_max, int timeout_us)
+{
+    if (mode < 0 || mode >= xy_wait_nonexisting) {
+        return -1;
+    }
+
+    s_wait_spin_max   = (spin_max   > 0) ?  spin_max   : XY_WAIT_SPIN_MAX;
+    s_wait_yield_max  = (yield_max  > 0) ?  yield_max  : XY_WAIT_YIELD_MAX;
+    s_wait_timeout_us = (timeout_us > 0) ?  timeout_us : XY_WAIT_TIMEOUT_US;
+    s_wait_mode       = mode;
+    return 0;
+}
+
+static uint64_t xy_wait_ns_since(const struct timespec* t0)
+{
+    struct timespec t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (uint64_t) (t1.tv_sec - t0->tv_sec) * 1000000000ULL + (uint64_t) t1.tv_nsec - (uint64_t) t0->tv_nsec;
+}
+
+static void xy_wait_account(int phase, uint64_t ns)
+{
+    pthread_mutex_lock(&s_wait_stats_mutex);
+    s_wait_stats.waits++;
+    if (phase < 0) {
+        s_wait_stats.timeouts++;
+    } else {
+        s_wait_stats.done[phase]++;
+        s_wait_stats.lat_sum_ns[phase] += ns;
+        if (ns > s_wait_stats.lat_max_ns[phase]) {
+            s_wait_stats.lat_max_ns[phase] = ns;
+        }
+    }
+    pthread_mutex_unlock(&s_wait_stats_mutex);
+}
+
+/**
+ * @brief Sleeps until the interrupt fires, the eventfd is signaled or the time is over
+ *
+ * @param[in]  mask    Status bits waited for, re-checked after the interrupt is unmasked.
+ * @param[in]  ns      Remaining time of the wait.
+ */
+static void xy_wait_sleep(uint32_t mask, uint64_t ns)
+{
+    struct pollfd   pfd;
+    struct timespec ts;
+
+    if (s_wait_uio_fd >= 0) {
+        uint32_t unmask = 1;
+
+        /* unmask the interrupt and check once more - the completion may have been before */
+        if (write(s_wait_uio_fd, &unmask, sizeof(unmask)) != sizeof(unmask)) {
+            // the UIO driver does not support masking - the interrupt stays enabled
+        }
+        if (g_fpga_xy_reg_mem->sha256_status & mask) {
+            return;
+        }
+        pfd.fd = s_wait_uio_fd;
+
+    } else {
+        pfd.fd = s_wait_event_fd;
+    }
+
+    /* re-check in slices - a missed or unrouted interrupt costs one slice, only */
+    if (ns > XY_WAIT_BLOCK_SLICE_US * 1000ULL) {
+        ns = XY_WAIT_BLOCK_SLICE_US * 1000ULL;
+    }
+
+    ts.tv_sec  = ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+
+    if (pfd.fd < 0) {
+        (void) nanosleep(&ts, NULL);
+
+    } else if (ppoll(&pfd, 1, &ts, NULL) > 0 && (pfd.revents & POLLIN)) {
+        uint64_t cnt;
+
+        /* consume the event: 4 byte interrupt count of UIO, 8 byte counter of the eventfd */
+        if (read(pfd.fd, &cnt, (pfd.fd == s_wait_uio_fd) ?  sizeof(uint32_t) : sizeof(uint64_t)) < 0) {
+            // nothing to consume
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+int xy_sha256_wait(uint32_t mask)
+{
+    const xy_wait_mode_t mode  = s_wait_mode;
+    const uint64_t       limit = (uint64_t) s_wait_timeout_us * 1000ULL;
+    struct timespec t0;
+    uint64_t ns;
+    int spin_max, yield_max, i;
+
+    if (!g_fpga_xy_reg_mem) {
+        return -1;
+    }
+
+    spin_max  = (mode == xy_wait_spin)  ?  INT_MAX : ((mode == xy_wait_adaptive) ?  s_wait_spin_max  : 0);
+    yield_max = (mode == xy_wait_yield) ?  INT_MAX : ((mode == xy_wait_adaptive) ?  s_wait_yield_max : 0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    /* spin phase - the clock is read every 256 status reads, only */
+    for (i = 0; i < spin_max; i++) {
+        if (g_fpga_xy_reg_mem->sha256_status & mask) {
+            xy_wait_account(xy_wait_phase_spin, xy_wait_ns_since(&t0));
+            return 0;
+        }
+        if (!(i & 0xff) && xy_wait_ns_since(&t0) > limit) {
+            xy_wait_account(-1, 0);
+            return -2;
+        }
+    }
+
+    /* yield phase */
+    for (i = 0; i < yield_max; i++) {
+        if (g_fpga_xy_reg_mem->sha256_status & mask) {
+            xy_wait_account(xy_wait_phase_yield, xy_wait_ns_since(&t0));
+            return 0;
+        }
+        if (xy_wait_ns_since(&t0) > limit) {
+            xy_wait_account(-1, 0);
+            return -2;
+        }
+        sched_yield();
+    }
+
+    /* block phase */
+    while (1) {
+        if (g_fpga_xy_reg_mem->sha256_status & mask) {
+            xy_wait_account(xy_wait_phase_block, xy_wait_ns_since(&t0));
+            return 0;
+        }
+        ns = xy_wait_ns_since(&t0);
+        if (ns > limit) {
+            xy_wait_account(-1, 0);
+            return -2;
+        }
+        xy_wait_sleep(mask, limit - ns);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+void xy_wait_notify(void)
+{
+    const uint64_t one = 1;
+
+    if (s_wait_event_fd >= 0) {
+        if (write(s_wait_event_fd, &one, sizeof(one)) != sizeof(one)) {
+            // counter saturated - the waiter is woken up anyway
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+void xy_wait_get_stats(xy_wait_stats_t* stats, int reset)
+{
+    if (!stats) {
+        return;
+    }
+
+    pthread_mutex_lock(&s_wait_stats_mutex);
+    *stats = s_wait_stats;
+    if (reset) {
+        const int irq = s_wait_stats.irq;
+
+        memset(&s_wait_stats, 0, sizeof(s_wait_stats));
+        s_wait_stats.irq = irq;
+    }
+    pthread_mutex_unlock(&s_wait_stats_mutex);
+}
+
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Pads the message of a job and converts it to the big-endian FIFO words
+ *
+ * @param[out] words  Buffer of XY_SHA256_MAX_BLOCKS blocks.
+ * @param[in]  job    Job to be prepared.
+ *
+ * @retval     int    Count of words to be pushed.
+ */
+static int xy_sha256_stage(uint32_t* words, const xy_sha256_job_t* job)
+{
+    const uint64_t bit_len = (uint64_t) job->len << 3;
+    const int      cnt     = ((job->len + 8) >> 6) + 1;  // count of blocks incl. '1' bit and the length
+    uint32_t       i;
+
+    memset(words, 0, cnt << 6);
+    for (i = 0; i < job->len; i++) {
+        words[i >> 2] |= (uint32_t) job->msg[i] << (24 - ((i & 3) << 3));
+    }
+    words[job->len >> 2] |= 0x80U << (24 - ((job->len & 3) << 3));
+    words[(cnt << 4) - 2]  = (uint32_t) (bit_len >> 32);
+    words[(cnt << 4) - 1]  = (uint32_t)  bit_len;
+    return cnt << 4;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Resets the SHA-256 engine and its FIFO and waits until the engine is ready again
+ *
+ * In contrast to fpga_xy_reset() the ready flag is waited for instead of sleeping a fixed time.
+ *
+ * @param[in]  dbl    0: SHA-256, else: SHA-256d for the next message.
+ *
+ * @retval     0      Success.
+ * @retval     -1     Failure, the engine did not get ready.
+ */
+static int xy_sha256_restart(int dbl)
+{
+    const uint32_t ctrl = SHA256_CTRL_ENABLE | (dbl ?  SHA256_CTRL_DBL_HASH : 0);
+
+    FPGA_XY_REG_WR(sha256_ctrl, ctrl | SHA256_CTRL_RESET);
+    FPGA_XY_REG_WR(sha256_ctrl, ctrl);
+    return xy_sha256_wait(SHA256_STAT_RDY) ?  -1 : 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Pushes the words into the FIFO, flow controlled by the FIFO write count
+ */
+static void xy_sha256_push(const uint32_t* words, int cnt)
+{
+    while (cnt > 0) {
+        int room = XY_SHA256_FIFO_DEPTH - 1 - (int) g_fpga_xy_reg_mem->sha256_fifo_wr_count;
+        if (room > cnt) {
+            room = cnt;
+        }
+        cnt -= room;
+        while (room-- > 0) {
+            FPGA_XY_REG_WR(sha256_data_push, *(words++));
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+int xy_sha256_submit_batch(const xy_sha256_job_t* jobs, int count)
+{
+    int i;
+
+    if (!jobs || count < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        if ((!jobs[i].msg && jobs[i].len) || (((jobs[i].len + 8) >> 6) + 1) > XY_SHA256_MAX_BLOCKS) {
+            return -1;
+        }
+    }
+
+    for (i = 0; i < count && s_sha256_queue_cnt < XY_SHA256_QUEUE_LEN; i++) {
+        s_sha256_queue[(s_sha256_queue_head + s_sha256_queue_cnt) % XY_SHA256_QUEUE_LEN] = jobs[i];
+        s_sha256_queue_cnt++;
+    }
+    return i;
+}
+
+/*----------------------------------------------------------------------------*/
+int xy_sha256_collect(uint32_t h[][8], int max)
+{
+    uint64_t t0;
+    int n = 0;
+
+    if (!g_fpga_xy_reg_mem) {
+        return -1;
+    }
+
+    /* the failure that ended the previous call after some hash values were already returned */
+    if (s_sha256_collect_err) {
+        n = s_sha256_collect_err;
+        s_sha256_collect_err = 0;
+        return n;
+    }
+
+    while (n < max && s_sha256_queue_cnt > 0) {
+        const xy_sha256_job_t* job = &s_sha256_queue[s_sha256_queue_head];
+
+        if (!s_sha256_stage_len[s_sha256_stage_cur]) {
+            s_sha256_stage_len[s_sha256_stage_cur] = xy_sha256_stage(s_sha256_stage[s_sha256_stage_cur], job);
+        }
+
+        if (xy_sha256_restart(job->dbl)) {
+            break;
+        }
+        t0 = xy_stats_now();
+        xy_sha256_push(s_sha256_stage[s_sha256_stage_cur], s_sha256_stage_len[s_sha256_stage_cur]);
+        xy_stats_record(xy_stats_push, t0);
+
+        /* the engine is busy now - prepare the words of the following job meanwhile */
+        if (s_sha256_queue_cnt > 1) {
+            const int nxt = s_sha256_stage_cur ^ 1;
+            s_sha256_stage_len[nxt] = xy_sha256_stage(s_sha256_stage[nxt], &s_sha256_queue[(s_sha256_queue_head + 1) % XY_SHA256_QUEUE_LEN]);
+        }
+
+        t0 = xy_stats_now();
+        if (xy_sha256_wait(SHA256_STAT_HASH_VALID)) {
+            break;  // the job stays queued, its words are still staged
+        }
+        xy_stats_record(xy_stats_wait, t0);
+
+        t0 = xy_stats_now();
+        h[n][0] = g_fpga_xy_reg_mem->sha256_hash_h0;
+        h[n][1] = g_fpga_xy_reg_mem->sha256_hash_h1;
+        h[n][2] = g_fpga_xy_reg_mem->sha256_hash_h2;
+        h[n][3] = g_fpga_xy_reg_mem->sha256_hash_h3;
+        h[n][4] = g_fpga_xy_reg_mem->sha256_hash_h4;
+        h[n][5] = g_fpga_xy_reg_mem->sha256_hash_h5;
+        h[n][6] = g_fpga_xy_reg_mem->sha256_hash_h6;
+        h[n][7] = g_fpga_xy_reg_mem->sha256_hash_h7;
+        xy_stats_record(xy_stats_readout, t0);
+        xy_stats_count_hashes(1);
+        n++;
+
+        s_sha256_stage_len[s_sha256_stage_cur] = 0;
+        s_sha256_stage_cur ^= 1;
+        s_sha256_queue_head = (s_sha256_queue_head + 1) % XY_SHA256_QUEUE_LEN;
+        s_sha256_queue_cnt--;
+    }
+
+    if (n < max && s_sha256_queue_cnt > 0) {
+        /* the hash values read so far are returned, the failure is reported by the next call */
+        if (!n) {
+            return -2;
+        }
+        s_sha256_collect_err = -2;
+    }
+    return n;
+}
+
+/*----------------------------------------------------------------------------*/
+int xy_sha256_pending(void)
+{
+    return s_sha256_queue_cnt;
+}
+
+/*----------------------------------------------------------------------------*/
+void xy_sha256_drop(void)
+{
+    s_sha256_queue_head   = 0;
+    s_sha256_queue_cnt    = 0;
+    s_sha256_stage_len[0] = 0;
+    s_sha256_stage_len[1] = 0;
+    s_sha256_stage_cur    = 0;
+    s_sha256_collect_err  = 0;
+}
+
+
+/*----------------------------------------------------------------------------*/
+int xy_keccak512_pl_available(void)
+{
+    if (!g_fpga_xy_reg_mem) {
+        return 0;
+    }
+    return (g_fpga_xy_reg_mem->status & XY_STAT_KEK512_EN) ?  1 : 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int xy_keccak512_submit_batch(const xy_keccak512_job_t* jobs, int count)
+{
+    int i;
+
+    if (!jobs || count < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!jobs[i].msg && jobs[i].len) {
+            return -1;
+        }
+    }
+
+    for (i = 0; i < count && s_keccak512_queue_cnt < XY_KECCAK512_QUEUE_LEN; i++) {
+        s_keccak512_queue[(s_keccak512_queue_head + s_keccak512_queue_cnt) % XY_KECCAK512_QUEUE_LEN] = jobs[i];
+        s_keccak512_queue_cnt++;
+    }
+    return i;
+}
+
+/*----------------------------------------------------------------------------*/
+int xy_keccak512_collect(uint8_t digest[][64], int max)
+{
+    const uint8_t* msgs[KECCAK_SW_LANES_MAX];
+    int n = 0;
+
+    if (!digest || max < 0) {
+        return -1;
+    }
+
+    /* The PL keccak_f1600_round instance has no state registers mapped yet, thus the jobs are done
+     * by the software engine even when xy_keccak512_pl_available() reports the KECCAK-512 part. */
+    while (n < max && s_keccak512_queue_cnt > 0) {
+        const uint32_t len = s_keccak512_queue[s_keccak512_queue_head].len;
+        int lanes = 1;
+
+        /* gather the following jobs of the same length into the SIMD lanes */
+        msgs[0] = s_keccak512_queue[s_keccak512_queue_head].msg;
+        while (lanes < KECCAK_SW_LANES_MAX && lanes < s_keccak512_queue_cnt && n + lanes < max) {
+            const xy_keccak512_job_t* job = &s_keccak512_queue[(s_keccak512_queue_head + lanes) % XY_KECCAK512_QUEUE_LEN];
+            if (job->len != len) {
+                break;
+            }
+            msgs[lanes++] = job->msg;
+        }
+        if (lanes == KECCAK_SW_LANES_MAX - 1) {
+            lanes = KECCAK_SW_LANES;
+        }
+
+        if (lanes == 1) {
+            keccak512_sw_hash(digest[n], msgs[0], len, KECCAK_SW_PAD_KECCAK);
+        } else {
+            (void) keccak512_sw_hash_lanes(digest + n, msgs, len, lanes, KECCAK_SW_PAD_KECCAK);
+        }
+
+        n += lanes;
+        s_keccak512_queue_head = (s_keccak512_queue_head + lanes) % XY_KECCAK512_QUEUE_LEN;
+        s_keccak512_queue_cnt -= lanes;
+    }
+    return n;
+}
+
+/*----------------------------------------------------------------------------*/
+int xy_keccak512_pending(void)
+{
+    return s_keccak512_queue_cnt;
+}
+
+
 #if 0
 /* --------------------------------------------------------------------------- *
  * FPGA SECOND ACCESS METHOD
@@ -12,8 +12,11 @@
 #define __FPGA_XY_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "main.h"
+#include "dma_ring.h"
+#include "fpga_xy_sim.h"
 
 #include "test_sha256_fifo.h"
 
@@ -62,6 +65,148 @@ enum {
 
 } FPGA_XY_REG_ENUMS;
 
+/** @brief Bits of the xy1en1om status register REG_RD_STATUS.
+ */
+enum {
+    XY_STAT_X11_EN                        =  0x001,   // X11 sub-module enabled
+    XY_STAT_SHA256_EN                     =  0x010,   // SHA-256 part enabled
+    XY_STAT_KEK512_EN                     =  0x100    // KECCAK-512 part enabled, '0' as long as the bitstream lacks it
+} FPGA_XY_STAT_ENUMS;
+
+/** @brief Bits of the SHA256 control register REG_RW_SHA256_CTRL.
+ */
+enum {
+    SHA256_CTRL_ENABLE                    =  0x001,   // '1' enables the SHA-256 part
+    SHA256_CTRL_RESET                     =  0x002,   // one-shot: resets the engine and the FIFO
+    SHA256_CTRL_DBL_HASH                  =  0x010,   // '1' does a SHA-256(SHA-256(x)) operation
+    SHA256_CTRL_DMA_MODE                  =  0x020,   // '1' DMA mode, '0' FIFO mode
+    SHA256_CTRL_DMA_MULTIHASH             =  0x040,   // '1' re-do with nonce incrementation (not yet enabled)
+    SHA256_CTRL_DMA_START                 =  0x080    // one-shot: starts the DMA engine
+} FPGA_XY_SHA256_CTRL_ENUMS;
+
+/** @brief Bits of the SHA256 status register REG_RD_SHA256_STATUS.
+ */
+enum {
+    SHA256_STAT_RDY                       =  0x001,   // engine is ready to start
+    SHA256_STAT_HASH_VALID                =  0x002,   // engine presents a valid hash
+    SHA256_STAT_DMA_IN_PROGRESS           =  0x004,   // DMA engine feeds the FIFO
+    SHA256_STAT_FIFO_EMPTY                =  0x010,   // FIFO is empty
+    SHA256_STAT_FIFO_ALMOST_FULL          =  0x020,   // FIFO does accept one more word, only
+    SHA256_STAT_FIFO_FULL                 =  0x040    // FIFO is full
+} FPGA_XY_SHA256_STAT_ENUMS;
+
+/** @brief Bits of the KECCAK512 control register REG_RW_KECCAK512_CTRL.
+ */
+enum {
+    KEK512_CTRL_ENABLE                    =  0x001,   // '1' enables the KECCAK-512 part
+    KEK512_CTRL_RESET                     =  0x002    // '1' resets the engine
+} FPGA_XY_KEK512_CTRL_ENUMS;
+
+/** @brief Depth of the SHA256 FIFO in 32 bit words. */
+#define XY_SHA256_FIFO_DEPTH    512
+
+/** @brief Maximum count of jobs being queued by xy_sha256_submit_batch() and not yet collected. */
+#define XY_SHA256_QUEUE_LEN     64
+
+/** @brief Maximum message length of a job in 512 bit blocks, padding included. */
+#define XY_SHA256_MAX_BLOCKS    16
+
+/** @brief Default timeout in microseconds until the engine presents its hash value. */
+#define XY_WAIT_TIMEOUT_US      10000
+
+/** @brief Default count of status reads of the spin phase. */
+#define XY_WAIT_SPIN_MAX        2000
+
+/** @brief Default count of sched_yield() calls of the yield phase. */
+#define XY_WAIT_YIELD_MAX       20
+
+/** @brief Longest sleep of the block phase in microseconds, the status is checked again after each slice. */
+#define XY_WAIT_BLOCK_SLICE_US  100
+
+/** @brief The sysfs directory of the UIO devices, searched for the one delivering the xy1en1om interrupt. */
+#define XY_WAIT_UIO_SYSFS       "/sys/class/uio"
+
+/** @brief Name of the UIO device of the xy1en1om sub-module, as given by its device tree node. */
+#define XY_WAIT_UIO_NAME        "xy1en1om"
+
+/** @brief Strategy of the completion wait layer */
+typedef enum xy_wait_mode_e {
+    /** @brief reads the status register until the timeout, lowest latency, one core is busy */
+    xy_wait_spin = 0,
+
+    /** @brief calls sched_yield() between the status reads, other threads of this core may run */
+    xy_wait_yield,
+
+    /** @brief sleeps on the UIO interrupt fd or on the eventfd, no CPU use */
+    xy_wait_block,
+
+    /** @brief spins first, then yields, then blocks */
+    xy_wait_adaptive,
+
+    /** @brief must be last entry */
+    xy_wait_nonexisting
+} xy_wait_mode_t;
+
+/** @brief Phase of the wait layer that saw the completion, index of the statistics arrays */
+enum xy_wait_phase_e {
+    xy_wait_phase_spin = 0,
+    xy_wait_phase_yield,
+    xy_wait_phase_block,
+    xy_wait_phases
+};
+
+/** @brief Statistics of the completion wait layer */
+typedef struct xy_wait_stats_s {
+    /** @brief waits  Count of calls of xy_sha256_wait() */
+    uint64_t        waits;
+
+    /** @brief timeouts  Count of waits that ran into the timeout */
+    uint64_t        timeouts;
+
+    /** @brief done  Count of completions seen in each phase */
+    uint64_t        done[xy_wait_phases];
+
+    /** @brief lat_sum_ns  Sum of the wait latencies in each phase, nanoseconds */
+    uint64_t        lat_sum_ns[xy_wait_phases];
+
+    /** @brief lat_max_ns  Longest wait latency in each phase, nanoseconds */
+    uint64_t        lat_max_ns[xy_wait_phases];
+
+    /** @brief irq  1: the block phase sleeps on the UIO interrupt, 0: on the eventfd */
+    int             irq;
+} xy_wait_stats_t;
+
+
+/** @brief Job description for the batched SHA-256 FIFO interface.
+ *
+ * The message is not copied when it is submitted, it has to stay valid until its hash is collected.
+ */
+typedef struct xy_sha256_job_s {
+    /** @brief msg  Message bytes, not padded */
+    const uint8_t*  msg;
+
+    /** @brief len  Length of the message in bytes */
+    uint32_t        len;
+
+    /** @brief dbl  0: SHA-256(msg), else: SHA-256(SHA-256(msg)) */
+    int             dbl;
+} xy_sha256_job_t;
+
+/** @brief Maximum count of jobs being queued by xy_keccak512_submit_batch() and not yet collected. */
+#define XY_KECCAK512_QUEUE_LEN  64
+
+/** @brief Job description for the batched Keccak-512 interface.
+ *
+ * The message is not copied when it is submitted, it has to stay valid until its digest is collected.
+ */
+typedef struct xy_keccak512_job_s {
+    /** @brief msg  Message bytes, not padded */
+    const uint8_t*  msg;
+
+    /** @brief len  Length of the message in bytes */
+    uint32_t        len;
+} xy_keccak512_job_t;
+
 /** @brief FPGA registry structure for the xy1en1om sub-module.
  *
  * This structure is the direct image of the physical FPGA memory for the xy1en1om sub-module.
@@ -313,15 +458,43 @@ typedef struct fpga_xy_reg_mem_s {
 } fpga_xy_reg_mem_t;
 
 
+/** @brief Writes a register with side effects (control bits, FIFO push) of the xy1en1om sub-module.
+ *
+ * The FPGA sees a plain store. With the simulation backend the register model is informed about
+ * the register written. The translation unit needs the extern declarations of g_fpga_xy_reg_mem
+ * and g_fpga_xy_backend.
+ */
+#define FPGA_XY_REG_WR(reg, val)                                                \
+    do {                                                                        \
+        g_fpga_xy_reg_mem->reg = (val);                                         \
+        if (g_fpga_xy_backend == fpga_xy_backend_sim) {                         \
+            fpga_xy_sim_write(offsetof(fpga_xy_reg_mem_t, reg));                \
+        }                                                                       \
+    } while (0)
+
+
 /* function declarations, detailed descriptions is in apparent implementation file  */
 
 
 // xy1en1om FPGA accessors
 
+/**
+ * @brief Selects the register backend used by the next call of fpga_xy_init()
+ *
+ * The environment variable FPGA_XY_BACKEND_ENV overrides this setting.
+ *
+ * @param[in]  backend  fpga_xy_backend_hw (default) or fpga_xy_backend_sim.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, bad backend
+ */
+int fpga_xy_set_backend(fpga_xy_backend_t backend);
+
 /**
  * @brief Initialize interface to xy1en1om FPGA sub-module
  *
- * Set-up for FPGA access to the xy1en1om sub-module.
+ * Set-up for FPGA access to the xy1en1om sub-module, either through /dev/mem or
+ * by the register simulation, see fpga_xy_set_backend().
  *
  * @retval  0 Success
  * @retval -1 Failure, error message is printed on standard error device
@@ -361,6 +534,131 @@ void fpga_xy_reset(void);
 uint32_t fpga_get_version();
 
 
+/**
+ * @brief Selects the strategy of the completion wait layer, can be changed at any time
+ *
+ * @param[in]  mode        Strategy.
+ * @param[in]  spin_max    Count of status reads of the spin phase (xy_wait_adaptive), 0: default.
+ * @param[in]  yield_max   Count of sched_yield() calls of the yield phase (xy_wait_adaptive), 0: default.
+ * @param[in]  timeout_us  Timeout of each wait, 0: default.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, bad mode
+ */
+int xy_wait_set_mode(xy_wait_mode_t mode, int spin_max, int yield_max, int timeout_us);
+
+/**
+ * @brief Waits until one of the bits of mask is set in the SHA-256 status register
+ *
+ * @param[in]  mask    Status bits, e.g. SHA256_STAT_HASH_VALID.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, FPGA not initialized
+ * @retval -2 Failure, timeout
+ */
+int xy_sha256_wait(uint32_t mask);
+
+/**
+ * @brief Wakes up a waiter of the block phase, for completion sources other than the UIO interrupt
+ */
+void xy_wait_notify(void);
+
+/**
+ * @brief Reads the statistics of the completion wait layer
+ *
+ * @param[out] stats   Statistics.
+ * @param[in]  reset   Not 0: the statistics are cleared after reading.
+ */
+void xy_wait_get_stats(xy_wait_stats_t* stats, int reset);
+
+
+/**
+ * @brief Queues SHA-256 jobs for the FPGA FIFO engine
+ *
+ * The jobs are hashed by xy_sha256_collect() in the order of their submission.
+ * To be called out of the worker context.
+ *
+ * @param[in]  jobs    Job descriptions, see xy_sha256_job_t for the life time of the messages.
+ * @param[in]  count   Count of jobs.
+ *
+ * @retval     int     Count of jobs accepted, less than count when the queue is full.
+ * @retval     -1      Failure, bad arguments or a message exceeds XY_SHA256_MAX_BLOCKS.
+ */
+int xy_sha256_submit_batch(const xy_sha256_job_t* jobs, int count);
+
+/**
+ * @brief Feeds the queued jobs through the FPGA FIFO engine and returns their hash values
+ *
+ * While the engine hashes one message the next one is padded and converted to FIFO words, so the
+ * FIFO is filled again as soon as the previous hash value is read out.
+ *
+ * @param[out] h       Hash values H0..H7 in the order of submission.
+ * @param[in]  max     Maximum count of hash values to be returned.
+ *
+ * When the engine stops responding after some hash values are read, these are returned and the
+ * failure is reported by the next call. xy_sha256_drop() discards a held back failure, too.
+ *
+ * @retval     int     Count of hash values returned.
+ * @retval     -1      Failure, FPGA not initialized.
+ * @retval     -2      Failure, engine did not respond - the pending job stays queued.
+ */
+int xy_sha256_collect(uint32_t h[][8], int max);
+
+/**
+ * @brief Count of jobs submitted but not collected yet
+ *
+ * @retval     int     Count of queued jobs.
+ */
+int xy_sha256_pending(void);
+
+/**
+ * @brief Discards all SHA-256 jobs submitted but not collected yet
+ *
+ * Used after xy_sha256_collect() has given up on an engine that did not respond.
+ */
+void xy_sha256_drop(void);
+
+
+/**
+ * @brief Checks whether the FPGA bitstream provides the KECCAK-512 part
+ *
+ * @retval     1       KECCAK-512 part is reported by the status register.
+ * @retval     0       Not available, the jobs are done by the software engine.
+ */
+int xy_keccak512_pl_available(void);
+
+/**
+ * @brief Queues Keccak-512 jobs, the counterpart of xy_sha256_submit_batch()
+ *
+ * @param[in]  jobs    Job descriptions, see xy_keccak512_job_t for the life time of the messages.
+ * @param[in]  count   Count of jobs.
+ *
+ * @retval     int     Count of jobs accepted, less than count when the queue is full.
+ * @retval     -1      Failure, bad arguments.
+ */
+int xy_keccak512_submit_batch(const xy_keccak512_job_t* jobs, int count);
+
+/**
+ * @brief Hashes the queued jobs and returns their digests
+ *
+ * Consecutive jobs of the same length are hashed together in the SIMD lanes of the software engine.
+ *
+ * @param[out] digest  Keccak-512 digests in the order of submission.
+ * @param[in]  max     Maximum count of digests to be returned.
+ *
+ * @retval     int     Count of digests returned.
+ * @retval     -1      Failure, bad arguments.
+ */
+int xy_keccak512_collect(uint8_t digest[][64], int max);
+
+/**
+ * @brief Count of Keccak-512 jobs submitted but not collected yet
+ *
+ * @retval     int     Count of queued jobs.
+ */
+int xy_keccak512_pending(void);
+
+
 #if 0
 /**
  * @brief Move current fpga.bit file out of the way and copy local file to the central directory
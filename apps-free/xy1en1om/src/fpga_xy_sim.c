@@ -0,0 +1,272 @@
+/**
+ * @brief Red Pitaya register-level simulation of the xy1en1om FPGA sub-module.
+ *
+ * The register file is plain memory, reads need no special treatment. Writes to registers with
+ * side effects go through FPGA_XY_REG_WR(), that calls fpga_xy_sim_write() when this backend is
+ * selected. The SHA-256 engine follows fpga/rtl/sha256_engine.sv: after a reset it presents RDY,
+ * the DBL_HASH bit is latched with the first word, each 16 FIFO words are compressed as one block
+ * and the hash is finished as soon as the FIFO runs empty after a block.
+ *
+ * The model behaves as a CPU that always outpaces the engine: the hash is published after each
+ * block and withdrawn again when the next word is pushed. The DMA engine streams the 32 bit words
+ * of the slot in memory order, the same as axi_datamover_s_axi_hp0 does.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fpga_xy.h"
+#include "sha256_sw.h"
+#include "fpga_xy_sim.h"
+
+
+/** @brief Simulated register file */
+static fpga_xy_reg_mem_t*   s_sim_mem = NULL;
+/** @brief DMA ring the simulated DMA engine reads from */
+static const dma_ring_t*    s_sim_ring = NULL;
+
+/** @brief Chaining value of the engine, ha[] of the RTL */
+static uint32_t             s_sim_h[SHA256_SW_HASH_WORDS];
+/** @brief Words of the block being filled from the FIFO */
+static uint32_t             s_sim_w[16];
+/** @brief Count of words in s_sim_w */
+static int                  s_sim_wcnt = 0;
+/** @brief Count of blocks compressed since the reset */
+static int                  s_sim_blocks = 0;
+/** @brief Engine left the ready state */
+static int                  s_sim_started = 0;
+/** @brief DBL_HASH latched when the engine started */
+static int                  s_sim_dbl = 0;
+/** @brief Engine presents a valid hash */
+static int                  s_sim_valid = 0;
+
+
+/** @brief Master clock of the FPGA, 125 MHz */
+static uint32_t fpga_xy_sim_clock(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (((uint64_t) ts.tv_sec * FPGA_XY_SIM_CLK_HZ) + ((uint64_t) ts.tv_nsec * FPGA_XY_SIM_CLK_HZ) / 1000000000ULL);
+}
+
+static int fpga_xy_sim_enabled(void)
+{
+    return (s_sim_mem->ctrl & 0x1) && (s_sim_mem->sha256_ctrl & SHA256_CTRL_ENABLE);
+}
+
+/** @brief Derives the status and the FIFO count registers from the engine state */
+static void fpga_xy_sim_status(void)
+{
+    uint32_t stat = 0;
+
+    if (fpga_xy_sim_enabled()) {
+        if (!s_sim_started) {
+            stat |= SHA256_STAT_RDY;
+        }
+        if (s_sim_valid) {
+            stat |= SHA256_STAT_HASH_VALID;
+        }
+        if (!s_sim_wcnt) {
+            stat |= SHA256_STAT_FIFO_EMPTY;
+        }
+    }
+    s_sim_mem->sha256_status        = stat;
+    s_sim_mem->sha256_fifo_wr_count = s_sim_wcnt;
+    s_sim_mem->sha256_fifo_rd_count = s_sim_wcnt;
+
+    s_sim_mem->status = (s_sim_mem->ctrl & 0x1) ?  XY_STAT_X11_EN : 0;
+    if (fpga_xy_sim_enabled()) {
+        s_sim_mem->status |= XY_STAT_SHA256_EN;
+    }
+}
+
+static void fpga_xy_sim_reset(void)
+{
+    sha256_sw_block_init(s_sim_h);
+    s_sim_wcnt    = 0;
+    s_sim_blocks  = 0;
+    s_sim_started = 0;
+    s_sim_dbl     = 0;
+    s_sim_valid   = 0;
+
+    s_sim_mem->sha256_hash_h0 = 0;
+    s_sim_mem->sha256_hash_h1 = 0;
+    s_sim_mem->sha256_hash_h2 = 0;
+    s_sim_mem->sha256_hash_h3 = 0;
+    s_sim_mem->sha256_hash_h4 = 0;
+    s_sim_mem->sha256_hash_h5 = 0;
+    s_sim_mem->sha256_hash_h6 = 0;
+    s_sim_mem->sha256_hash_h7 = 0;
+
+    s_sim_mem->sha256_dma_state          = 0;
+    s_sim_mem->sha256_dma_axi_r_state    = 0;
+    s_sim_mem->sha256_dma_clock_start    = 0;
+    s_sim_mem->sha256_dma_clock_last     = 0;
+    s_sim_mem->sha256_dma_clock_stop     = 0;
+    s_sim_mem->sha256_eng_clock_continue = 0;
+    s_sim_mem->sha256_eng_clock_dblhash  = 0;
+    s_sim_mem->sha256_eng_clock_complete = 0;
+    s_sim_mem->sha256_eng_clock_finish   = 0;
+}
+
+/** @brief Publishes the hash of the blocks compressed so far, the FIFO ran empty */
+static void fpga_xy_sim_finish(void)
+{
+    uint32_t h[SHA256_SW_HASH_WORDS];
+
+    memcpy(h, s_sim_h, sizeof(h));
+    if (s_sim_dbl) {
+        const uint32_t w[16] = { h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+                                 0x80000000, 0, 0, 0, 0, 0, 0, 0x00000100 };
+
+        s_sim_mem->sha256_eng_clock_dblhash = fpga_xy_sim_clock();
+        sha256_sw_block_init(h);
+        sha256_sw_block(h, w);
+    }
+
+    s_sim_mem->sha256_hash_h0 = h[0];
+    s_sim_mem->sha256_hash_h1 = h[1];
+    s_sim_mem->sha256_hash_h2 = h[2];
+    s_sim_mem->sha256_hash_h3 = h[3];
+    s_sim_mem->sha256_hash_h4 = h[4];
+    s_sim_mem->sha256_hash_h5 = h[5];
+    s_sim_mem->sha256_hash_h6 = h[6];
+    s_sim_mem->sha256_hash_h7 = h[7];
+
+    s_sim_mem->sha256_eng_clock_complete = fpga_xy_sim_clock();
+    s_sim_mem->sha256_eng_clock_finish   = s_sim_mem->sha256_eng_clock_complete;
+    s_sim_valid = 1;
+}
+
+static void fpga_xy_sim_push(uint32_t word)
+{
+    if (!fpga_xy_sim_enabled()) {
+        return;
+    }
+
+    if (!s_sim_started) {
+        s_sim_started = 1;
+        s_sim_dbl     = !!(s_sim_mem->sha256_ctrl & SHA256_CTRL_DBL_HASH);
+    }
+    if (s_sim_valid) {
+        /* the FIFO did not run empty on a real engine - withdraw the hash */
+        s_sim_valid = 0;
+        if (!s_sim_mem->sha256_eng_clock_continue) {
+            s_sim_mem->sha256_eng_clock_continue = fpga_xy_sim_clock();
+        }
+    }
+
+    s_sim_w[s_sim_wcnt++] = word;
+    if (s_sim_wcnt == 16) {
+        sha256_sw_block(s_sim_h, s_sim_w);
+        s_sim_wcnt = 0;
+        s_sim_blocks++;
+        fpga_xy_sim_finish();
+    }
+}
+
+/** @brief Streams the DMA slot into the FIFO */
+static void fpga_xy_sim_dma(void)
+{
+    const uint32_t bytes = (s_sim_mem->sha256_dma_bit_len + 7) >> 3;
+    const uint32_t ofs   = s_sim_mem->sha256_dma_base_addr - (s_sim_ring ?  s_sim_ring->phys : 0);
+    const uint32_t* src;
+    uint32_t i;
+
+    if (!fpga_xy_sim_enabled() || s_sim_started) {
+        return;
+    }
+
+    s_sim_mem->sha256_dma_clock_start = fpga_xy_sim_clock();
+    if (!s_sim_ring || !s_sim_ring->virt || (ofs & 0x3) || (size_t) ofs + bytes > s_sim_ring->size) {
+        s_sim_mem->sha256_dma_axi_r_state = 0x3;  // DECERR, no memory behind that address
+        return;
+    }
+
+    src = (const uint32_t*) (s_sim_ring->virt + ofs);
+    for (i = 0; i < ((bytes + 3) >> 2); i++) {
+        s_sim_mem->sha256_dma_last_data = src[i];
+        fpga_xy_sim_push(src[i]);
+    }
+    s_sim_mem->sha256_dma_clock_last = fpga_xy_sim_clock();
+    s_sim_mem->sha256_dma_clock_stop = s_sim_mem->sha256_dma_clock_last;
+}
+
+
+/*----------------------------------------------------------------------------*/
+int fpga_xy_sim_init(struct fpga_xy_reg_mem_s** mem, const struct dma_ring_s* ring)
+{
+    if (!mem) {
+        return -1;
+    }
+
+    s_sim_mem = calloc(1, FPGA_XY_BASE_SIZE);
+    if (!s_sim_mem) {
+        fprintf(stderr, "ERROR - fpga_xy_sim_init: out of memory\n");
+        return -1;
+    }
+    s_sim_ring = ring;
+
+    s_sim_mem->version = FPGA_VERSION_MIN;
+    fpga_xy_sim_reset();
+    fpga_xy_sim_status();
+
+    *mem = s_sim_mem;
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+void fpga_xy_sim_exit(struct fpga_xy_reg_mem_s** mem)
+{
+    if (mem && *mem == s_sim_mem) {
+        *mem = NULL;
+    }
+    free(s_sim_mem);
+    s_sim_mem  = NULL;
+    s_sim_ring = NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+void fpga_xy_sim_write(size_t ofs)
+{
+    if (!s_sim_mem) {
+        return;
+    }
+
+    switch (ofs) {
+    case REG_RW_CTRL:
+        if (!(s_sim_mem->ctrl & 0x1)) {
+            fpga_xy_sim_reset();
+        }
+        break;
+
+    case REG_RW_SHA256_CTRL:
+        if ((s_sim_mem->sha256_ctrl & SHA256_CTRL_RESET) || !(s_sim_mem->sha256_ctrl & SHA256_CTRL_ENABLE)) {
+            fpga_xy_sim_reset();
+        }
+        if ((s_sim_mem->sha256_ctrl & (SHA256_CTRL_DMA_MODE | SHA256_CTRL_DMA_START)) == (SHA256_CTRL_DMA_MODE | SHA256_CTRL_DMA_START)) {
+            fpga_xy_sim_dma();
+        }
+        s_sim_mem->sha256_ctrl &= ~(SHA256_CTRL_RESET | SHA256_CTRL_DMA_START);  // one-shot bits fall back by their own
+        break;
+
+    case REG_WR_SHA256_DATA_PUSH:
+        fpga_xy_sim_push(s_sim_mem->sha256_data_push);
+        break;
+
+    default:
+        break;
+    }
+    fpga_xy_sim_status();
+}
@@ -0,0 +1,80 @@
+/**
+ * @brief Red Pitaya register-level simulation of the xy1en1om FPGA sub-module.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __FPGA_XY_SIM_H
+#define __FPGA_XY_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/** @defgroup fpga_xy_sim_h Software model of the xy1en1om registers, for running the drivers off the board
+ * @{
+ */
+
+/** @brief Environment variable selecting the register backend of fpga_xy_init(): "hw" or "sim". */
+#define FPGA_XY_BACKEND_ENV     "XY_FPGA_BACKEND"
+
+/** @brief Frequency of the simulated FPGA master clock, used for the debug clock registers. */
+#define FPGA_XY_SIM_CLK_HZ      125000000ULL
+
+
+struct fpga_xy_reg_mem_s;
+struct dma_ring_s;
+
+
+/** @brief Register backends of the xy1en1om sub-module */
+typedef enum fpga_xy_backend_e {
+    /** @brief FPGA registers mapped through /dev/mem */
+    fpga_xy_backend_hw = 0,
+
+    /** @brief Registers held in memory, the SHA-256 engine is modelled by fpga_xy_sim_write() */
+    fpga_xy_backend_sim,
+
+    /** @brief must be last entry */
+    fpga_xy_backend_nonexisting
+} fpga_xy_backend_t;
+
+
+/* function declarations, detailed descriptions is in apparent implementation file  */
+
+/**
+ * @brief Allocates the simulated register file and presets it with the reset values of the FPGA
+ *
+ * @param[out] mem     Register file, released by fpga_xy_sim_exit().
+ * @param[in]  ring    DMA ring the simulated DMA engine reads from, may be NULL.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, error message is printed on standard error device
+ */
+int fpga_xy_sim_init(struct fpga_xy_reg_mem_s** mem, const struct dma_ring_s* ring);
+
+/**
+ * @brief Releases the simulated register file
+ *
+ * @param[inout] mem   Register file, set to NULL.
+ */
+void fpga_xy_sim_exit(struct fpga_xy_reg_mem_s** mem);
+
+/**
+ * @brief Applies the side effects of a register write to the simulated register file
+ *
+ * Called by FPGA_XY_REG_WR() after the value has been stored.
+ *
+ * @param[in]  ofs     Offset of the register written, e.g. REG_WR_SHA256_DATA_PUSH.
+ */
+void fpga_xy_sim_write(size_t ofs);
+
+/** @} */
+
+
+#endif /* __FPGA_XY_SIM_H */
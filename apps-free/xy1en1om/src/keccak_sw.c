@@ -0,0 +1,369 @@
+/**
+ * @brief Red Pitaya software Keccak-512 engine of the xy1en1om sub-module.
+ *
+ * The lane-interleaved engine keeps the same state word of two messages in the two 64 bit
+ * lanes of a SIMD vector. The vector type is a GCC vector extension, thus the same code is
+ * translated to NEON instructions on the Cortex-A9 (-mfpu=neon) and to SSE2 instructions on
+ * x86 hosts. Two of those vector states are interleaved to hide the latencies of the
+ * dependent theta / chi steps.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "keccak_sw.h"
+
+
+/** @brief One SIMD register holding the same 64 bit state word of KECCAK_SW_LANES messages. */
+typedef uint64_t keccak_vec_t __attribute__ ((vector_size (KECCAK_SW_LANES * sizeof(uint64_t))));
+
+/** @brief Count of SIMD states needed for KECCAK_SW_LANES_MAX messages. */
+#define KECCAK_SW_GROUPS_MAX    (KECCAK_SW_LANES_MAX / KECCAK_SW_LANES)
+
+/** @brief Count of rounds of Keccak-f[1600]. */
+#define KECCAK_SW_ROUNDS        24
+
+
+/** @brief Round constants of the iota step. */
+static const uint64_t s_keccak_rc[KECCAK_SW_ROUNDS] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+/** @brief Rotation offsets of the rho step, in the order of the pi step walk. */
+static const int s_keccak_rotc[24] = {
+     1,  3,  6, 10, 15, 21, 28, 36, 45, 55,  2, 14,
+    27, 41, 56,  8, 25, 43, 62, 18, 39, 61, 20, 44
+};
+
+/** @brief State word indices visited by the pi step walk, starting at lane (1, 0). */
+static const int s_keccak_piln[24] = {
+    10,  7, 11, 17, 18,  3,  5, 16,  8, 21, 24,  4,
+    15, 23, 19, 13, 12,  2, 20, 14, 22,  9,  6,  1
+};
+
+
+/** @brief Rotation of a 64 bit word or of each lane of a vector, 0 < n < 64. */
+#define ROL64(x, n)     (((x) << (n)) | ((x) >> (64 - (n))))
+
+
+static inline uint64_t keccak_sw_le64(const uint8_t* p)
+{
+    return  (uint64_t) p[0]        | ((uint64_t) p[1] <<  8) | ((uint64_t) p[2] << 16) | ((uint64_t) p[3] << 24) |
+           ((uint64_t) p[4] << 32) | ((uint64_t) p[5] << 40) | ((uint64_t) p[6] << 48) | ((uint64_t) p[7] << 56);
+}
+
+static inline void keccak_sw_set_le64(uint8_t* p, uint64_t v)
+{
+    int i;
+    for (i = 0; i < 8; i++, v >>= 8) {
+        p[i] = (uint8_t) v;
+    }
+}
+
+/**
+ * @brief Builds the padded tail block of a message
+ *
+ * @param[out] tail   Buffer of one block receiving the last partial block and the padding.
+ * @param[in]  msg    Message bytes.
+ * @param[in]  len    Message length in bytes.
+ * @param[in]  pad    Domain separation padding byte.
+ */
+static void keccak_sw_pad_tail(uint8_t tail[KECCAK512_SW_RATE], const uint8_t* msg, size_t len, uint8_t pad)
+{
+    size_t rem = len % KECCAK512_SW_RATE;
+
+    memset(tail, 0, KECCAK512_SW_RATE);
+    memcpy(tail, msg + (len - rem), rem);
+    tail[rem]                   ^= pad;
+    tail[KECCAK512_SW_RATE - 1] ^= 0x80;
+}
+
+
+/* --- scalar engine --- */
+
+/*----------------------------------------------------------------------------*/
+void keccak_sw_f1600(uint64_t st[KECCAK_SW_STATE_WORDS])
+{
+    uint64_t bc[5], t;
+    int i, j, r;
+
+    for (r = 0; r < KECCAK_SW_ROUNDS; r++) {
+        /* theta */
+        for (i = 0; i < 5; i++) {
+            bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+        }
+        for (i = 0; i < 5; i++) {
+            t = bc[(i + 4) % 5] ^ ROL64(bc[(i + 1) % 5], 1);
+            for (j = 0; j < 25; j += 5) {
+                st[j + i] ^= t;
+            }
+        }
+
+        /* rho and pi */
+        t = st[1];
+        for (i = 0; i < 24; i++) {
+            j      = s_keccak_piln[i];
+            bc[0]  = st[j];
+            st[j]  = ROL64(t, s_keccak_rotc[i]);
+            t      = bc[0];
+        }
+
+        /* chi */
+        for (j = 0; j < 25; j += 5) {
+            for (i = 0; i < 5; i++) {
+                bc[i] = st[j + i];
+            }
+            for (i = 0; i < 5; i++) {
+                st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+            }
+        }
+
+        /* iota */
+        st[0] ^= s_keccak_rc[r];
+    }
+}
+
+static void keccak_sw_absorb_block(uint64_t st[KECCAK_SW_STATE_WORDS], const uint8_t* p)
+{
+    int i;
+    for (i = 0; i < (KECCAK512_SW_RATE >> 3); i++) {
+        st[i] ^= keccak_sw_le64(p + (i << 3));
+    }
+    keccak_sw_f1600(st);
+}
+
+/*----------------------------------------------------------------------------*/
+void keccak512_sw_hash(uint8_t digest[KECCAK512_SW_DIGEST], const uint8_t* msg, size_t len, uint8_t pad)
+{
+    uint64_t st[KECCAK_SW_STATE_WORDS];
+    uint8_t  tail[KECCAK512_SW_RATE];
+    size_t   full = len / KECCAK512_SW_RATE;
+    size_t   b;
+    int      i;
+
+    memset(st, 0, sizeof(st));
+    for (b = 0; b < full; b++) {
+        keccak_sw_absorb_block(st, msg + b * KECCAK512_SW_RATE);
+    }
+    keccak_sw_pad_tail(tail, msg, len, pad);
+    keccak_sw_absorb_block(st, tail);
+
+    for (i = 0; i < (KECCAK512_SW_DIGEST >> 3); i++) {
+        keccak_sw_set_le64(digest + (i << 3), st[i]);
+    }
+}
+
+
+/* --- lane-interleaved SIMD engine --- */
+
+/**
+ * @brief Applies Keccak-f[1600] to each lane of the vector states
+ *
+ * The groups argument is a compile-time constant at each call site, thus the loops over the groups
+ * are unrolled and the independent states of the 4-lane variant are interleaved step by step.
+ */
+static inline __attribute__ ((always_inline))
+void keccak_sw_f1600_vec(keccak_vec_t st[][KECCAK_SW_STATE_WORDS], const int groups)
+{
+    keccak_vec_t bc[KECCAK_SW_GROUPS_MAX][5];
+    keccak_vec_t t[KECCAK_SW_GROUPS_MAX];
+    int g, i, j, r;
+
+    for (r = 0; r < KECCAK_SW_ROUNDS; r++) {
+        const keccak_vec_t rc = { s_keccak_rc[r], s_keccak_rc[r] };
+
+        /* theta */
+        for (i = 0; i < 5; i++) {
+            for (g = 0; g < groups; g++) {
+                bc[g][i] = st[g][i] ^ st[g][i + 5] ^ st[g][i + 10] ^ st[g][i + 15] ^ st[g][i + 20];
+            }
+        }
+        for (i = 0; i < 5; i++) {
+            for (g = 0; g < groups; g++) {
+                t[g] = bc[g][(i + 4) % 5] ^ ROL64(bc[g][(i + 1) % 5], 1);
+                for (j = 0; j < 25; j += 5) {
+                    st[g][j + i] ^= t[g];
+                }
+            }
+        }
+
+        /* rho and pi */
+        for (g = 0; g < groups; g++) {
+            t[g] = st[g][1];
+        }
+        for (i = 0; i < 24; i++) {
+            const int n = s_keccak_rotc[i];
+
+            j = s_keccak_piln[i];
+            for (g = 0; g < groups; g++) {
+                bc[g][0] = st[g][j];
+                st[g][j] = ROL64(t[g], n);
+                t[g]     = bc[g][0];
+            }
+        }
+
+        /* chi */
+        for (j = 0; j < 25; j += 5) {
+            for (g = 0; g < groups; g++) {
+                for (i = 0; i < 5; i++) {
+                    bc[g][i] = st[g][j + i];
+                }
+                for (i = 0; i < 5; i++) {
+                    st[g][j + i] ^= (~bc[g][(i + 1) % 5]) & bc[g][(i + 2) % 5];
+                }
+            }
+        }
+
+        /* iota */
+        for (g = 0; g < groups; g++) {
+            st[g][0] ^= rc;
+        }
+    }
+}
+
+/**
+ * @brief Hashes groups * KECCAK_SW_LANES messages of the same length
+ */
+static inline __attribute__ ((always_inline))
+void keccak512_sw_hash_vec(uint8_t digest[][KECCAK512_SW_DIGEST], const uint8_t* const msgs[], size_t len, uint8_t pad, const int groups)
+{
+    const int    lanes = groups * KECCAK_SW_LANES;
+    uint8_t      tail[KECCAK_SW_LANES_MAX][KECCAK512_SW_RATE];
+    keccak_vec_t st[KECCAK_SW_GROUPS_MAX][KECCAK_SW_STATE_WORDS];
+    size_t       full = len / KECCAK512_SW_RATE;
+    size_t       b;
+    int          g, i, l;
+
+    for (l = 0; l < lanes; l++) {
+        keccak_sw_pad_tail(tail[l], msgs[l], len, pad);
+    }
+    memset(st, 0, sizeof(st));
+
+    for (b = 0; b <= full; b++) {
+        for (g = 0; g < groups; g++) {
+            const uint8_t* p0 = (b < full) ?  (msgs[(g << 1) + 0] + b * KECCAK512_SW_RATE) : tail[(g << 1) + 0];
+            const uint8_t* p1 = (b < full) ?  (msgs[(g << 1) + 1] + b * KECCAK512_SW_RATE) : tail[(g << 1) + 1];
+
+            for (i = 0; i < (KECCAK512_SW_RATE >> 3); i++) {
+                st[g][i] ^= (keccak_vec_t) { keccak_sw_le64(p0 + (i << 3)), keccak_sw_le64(p1 + (i << 3)) };
+            }
+        }
+        keccak_sw_f1600_vec(st, groups);
+    }
+
+    for (g = 0; g < groups; g++) {
+        for (l = 0; l < KECCAK_SW_LANES; l++) {
+            for (i = 0; i < (KECCAK512_SW_DIGEST >> 3); i++) {
+                keccak_sw_set_le64(digest[g * KECCAK_SW_LANES + l] + (i << 3), st[g][i][l]);
+            }
+        }
+    }
+}
+
+static void keccak512_sw_hash_x2(uint8_t digest[][KECCAK512_SW_DIGEST], const uint8_t* const msgs[], size_t len, uint8_t pad)
+{
+    keccak512_sw_hash_vec(digest, msgs, len, pad, 1);
+}
+
+static void keccak512_sw_hash_x4(uint8_t digest[][KECCAK512_SW_DIGEST], const uint8_t* const msgs[], size_t len, uint8_t pad)
+{
+    keccak512_sw_hash_vec(digest, msgs, len, pad, KECCAK_SW_GROUPS_MAX);
+}
+
+/*----------------------------------------------------------------------------*/
+int keccak512_sw_hash_lanes(uint8_t digest[][KECCAK512_SW_DIGEST], const uint8_t* const msgs[], size_t len, int lanes, uint8_t pad)
+{
+    if (!digest || !msgs) {
+        return -1;
+    }
+
+    switch (lanes) {
+    case KECCAK_SW_LANES:
+        keccak512_sw_hash_x2(digest, msgs, len, pad);
+        return 0;
+
+    case KECCAK_SW_LANES_MAX:
+        keccak512_sw_hash_x4(digest, msgs, len, pad);
+        return 0;
+
+    default:
+        return -1;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+int keccak512_sw_hash_batch(uint8_t digest[][KECCAK512_SW_DIGEST], const uint8_t* msgs, size_t stride, size_t len, int count, uint8_t pad)
+{
+    const uint8_t* p[KECCAK_SW_LANES_MAX];
+    int n = 0;
+    int l;
+
+    if (!digest || !msgs || count < 0) {
+        return -1;
+    }
+
+    while (count - n >= KECCAK_SW_LANES_MAX) {
+        for (l = 0; l < KECCAK_SW_LANES_MAX; l++) {
+            p[l] = msgs + (n + l) * stride;
+        }
+        keccak512_sw_hash_x4(digest + n, p, len, pad);
+        n += KECCAK_SW_LANES_MAX;
+    }
+
+    if (count - n >= KECCAK_SW_LANES) {
+        for (l = 0; l < KECCAK_SW_LANES; l++) {
+            p[l] = msgs + (n + l) * stride;
+        }
+        keccak512_sw_hash_x2(digest + n, p, len, pad);
+        n += KECCAK_SW_LANES;
+    }
+
+    for (; n < count; n++) {
+        keccak512_sw_hash(digest[n], msgs + n * stride, len, pad);
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+double keccak512_sw_benchmark(double seconds)
+{
+    enum { BENCH_COUNT = 256, BENCH_LEN = 64 };
+    static uint8_t s_msgs[BENCH_COUNT][BENCH_LEN];
+    static uint8_t s_digest[BENCH_COUNT][KECCAK512_SW_DIGEST];
+    struct timespec t0, t1;
+    double elapsed = 0.0;
+    long   hashes  = 0;
+    uint32_t nonce = 0;
+    int i;
+
+    memset(s_msgs, 0x5a, sizeof(s_msgs));
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    do {
+        for (i = 0; i < BENCH_COUNT; i++, nonce++) {
+            memcpy(&s_msgs[i][0], &nonce, sizeof(nonce));
+        }
+        keccak512_sw_hash_batch(s_digest, &s_msgs[0][0], BENCH_LEN, BENCH_LEN, BENCH_COUNT, KECCAK_SW_PAD_KECCAK);
+        hashes += BENCH_COUNT;
+
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    } while (elapsed < seconds);
+
+    return hashes / elapsed;
+}
@@ -0,0 +1,113 @@
+/**
+ * @brief Red Pitaya software Keccak-512 engine of the xy1en1om sub-module.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __KECCAK_SW_H
+#define __KECCAK_SW_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/** @defgroup keccak_sw_h Software Keccak-f[1600] engine, lane-interleaved SIMD variant
+ * @{
+ */
+
+/** @brief Count of 64 bit words of the Keccak-f[1600] state. */
+#define KECCAK_SW_STATE_WORDS   25
+
+/** @brief Rate of Keccak-512 in bytes, (1600 - 2 * 512) / 8. */
+#define KECCAK512_SW_RATE       72
+
+/** @brief Length of the Keccak-512 digest in bytes. */
+#define KECCAK512_SW_DIGEST     64
+
+/** @brief Count of states being permuted in parallel by one SIMD vector (NEON Q register / SSE XMM register). */
+#define KECCAK_SW_LANES         2
+
+/** @brief Maximum count of messages being hashed in parallel by one call of keccak512_sw_hash_lanes(). */
+#define KECCAK_SW_LANES_MAX     (KECCAK_SW_LANES << 1)
+
+
+/** @brief Domain separation padding byte.
+ */
+enum keccak_sw_pad_e {
+    KECCAK_SW_PAD_KECCAK                  =  0x01,    // original Keccak submission, as used by X11
+    KECCAK_SW_PAD_SHA3                    =  0x06     // FIPS 202 SHA3-512
+};
+
+
+/* function declarations, detailed descriptions is in apparent implementation file  */
+
+/**
+ * @brief Applies the 24 rounds of the Keccak-f[1600] permutation to a single state (scalar reference implementation)
+ *
+ * @param[inout] st    State words, lane (x, y) is st[x + 5 * y].
+ */
+void keccak_sw_f1600(uint64_t st[KECCAK_SW_STATE_WORDS]);
+
+/**
+ * @brief Hashes a single message of any length
+ *
+ * @param[out] digest  Resulting digest bytes.
+ * @param[in]  msg     Message bytes to be hashed.
+ * @param[in]  len     Message length in bytes.
+ * @param[in]  pad     KECCAK_SW_PAD_KECCAK or KECCAK_SW_PAD_SHA3.
+ */
+void keccak512_sw_hash(uint8_t digest[KECCAK512_SW_DIGEST], const uint8_t* msg, size_t len, uint8_t pad);
+
+/**
+ * @brief Hashes 2 or 4 independent messages of the same length in the SIMD lanes of one core
+ *
+ * @param[out] digest  Resulting digests, one entry for each of the lanes.
+ * @param[in]  msgs    Message pointers, one entry for each of the lanes.
+ * @param[in]  len     Message length in bytes, the same for all messages.
+ * @param[in]  lanes   Count of messages: KECCAK_SW_LANES or KECCAK_SW_LANES_MAX.
+ * @param[in]  pad     KECCAK_SW_PAD_KECCAK or KECCAK_SW_PAD_SHA3.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, bad arguments
+ */
+int keccak512_sw_hash_lanes(uint8_t digest[][KECCAK512_SW_DIGEST], const uint8_t* const msgs[], size_t len, int lanes, uint8_t pad);
+
+/**
+ * @brief Hashes a batch of messages of the same length being stored with a fixed stride
+ *
+ * The batch is cut into 4-lane and 2-lane groups, a single remaining message is done with the scalar code.
+ *
+ * @param[out] digest  Resulting digests, count entries.
+ * @param[in]  msgs    First message of the batch.
+ * @param[in]  stride  Distance in bytes between the start of two consecutive messages.
+ * @param[in]  len     Message length in bytes, the same for all messages.
+ * @param[in]  count   Count of messages.
+ * @param[in]  pad     KECCAK_SW_PAD_KECCAK or KECCAK_SW_PAD_SHA3.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, bad arguments
+ */
+int keccak512_sw_hash_batch(uint8_t digest[][KECCAK512_SW_DIGEST], const uint8_t* msgs, size_t stride, size_t len, int count, uint8_t pad);
+
+/**
+ * @brief Measures the CPU baseline throughput of the software engine
+ *
+ * 64 byte messages, the size of the previous X11 stage digest, are hashed with keccak512_sw_hash_batch()
+ * for the given duration.
+ *
+ * @param[in]  seconds  Duration of the measurement.
+ *
+ * @retval     double   Count of hashes per second.
+ */
+double keccak512_sw_benchmark(double seconds);
+
+/** @} */
+
+
+#endif /* __KECCAK_SW_H */
@@ -62,6 +62,10 @@ fpga_hk_reg_mem_t*              g_fpga_hk_reg_mem = NULL;
 int                             g_fpga_xy_mem_fd = -1;
 /** @brief xy1en1om memory layout of the FPGA registers */
 fpga_xy_reg_mem_t*              g_fpga_xy_reg_mem = NULL;
+/** @brief xy1en1om DMA ring, physically contiguous memory for the SHA-256 DMA engine */
+dma_ring_t                      g_fpga_xy_dma_ring = { 0 };
+/** @brief xy1en1om register backend in use, the FPGA or its simulation */
+fpga_xy_backend_t               g_fpga_xy_backend = fpga_xy_backend_hw;
 
 /** @brief Describes app. parameters with some info/limitations in high definition - compare initial values with: fpga_xy.fpga_xy_enable() */
 const xy_app_params_t g_xy_default_params[XY_PARAMS_NUM + 1] = {
@@ -74,11 +78,15 @@ const xy_app_params_t g_xy_default_params[XY_PARAMS_NUM + 1] = {
 rp_app_params_t*                g_rp_cb_in_params = NULL;
 /** @brief Holds mutex to access on parameters from outside to the worker thread */
 pthread_mutex_t                 g_rp_cb_in_params_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Signals that the worker thread has taken over g_rp_cb_in_params */
+pthread_cond_t                  g_rp_cb_in_params_cond = PTHREAD_COND_INITIALIZER;
 
 /** @brief Current copy of params of the worker thread */
 xy_app_params_t*                g_xy_info_worker_params = NULL;
 /** @brief Holds mutex to access parameters from the worker thread to any other context */
 pthread_mutex_t                 g_xy_info_worker_params_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Signals that the worker thread has exported its current params data */
+pthread_cond_t                  g_xy_info_worker_params_cond = PTHREAD_COND_INITIALIZER;
 
 
 /** @brief params initialized */
@@ -0,0 +1,584 @@
+/**
+ * @brief Red Pitaya multi-stage hash pipeline scheduler of the xy1en1om sub-module.
+ *
+ * Each stage owns a bounded queue in front of it, the last stage feeds the output queue.
+ * The scheduler threads are not bound to a stage: whenever a thread is free it takes a batch
+ * out of the fullest queue whose stage is runnable, thus both cores steal the work of any
+ * stage. A stage is runnable when its engine is free - the FPGA stages share one engine and its
+ * driver state, which is used by one thread at a time, a CPU stage by both - and when the queue
+ * behind it has room for the results.
+ * The queues are guarded by one scheduler mutex, the hashing is done outside of it.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "main.h"
+#include "fpga_xy.h"
+#include "sha256_sw.h"
+#include "keccak_sw.h"
+
+#include "pipeline.h"
+
+
+/** @brief A message travelling through the chain, each stage replaces the data by its digest */
+typedef struct pipeline_item_s {
+    uint32_t        id;
+    uint32_t        len;
+    uint8_t         data[PIPELINE_ITEM_MAX];
+} pipeline_item_t;
+
+/** @brief Bounded queue of items */
+typedef struct pipeline_queue_s {
+    pipeline_item_t*    ring[PIPELINE_QUEUE_LEN];
+    int                 head;
+    int                 cnt;
+
+    /** @brief reserved  Room promised to a batch being hashed right now */
+    int                 reserved;
+} pipeline_queue_t;
+
+/** @brief State of a stage */
+typedef struct pipeline_stage_s {
+    pipeline_hash_t     hash;
+    pipeline_backend_t  backend;
+
+    /** @brief running  Count of scheduler threads hashing for this stage */
+    int                 running;
+
+    /** @brief in  Queue in front of the stage */
+    pipeline_queue_t    in;
+
+    uint64_t            done;
+    uint64_t            fallbacks;
+    uint64_t            busy_ns;
+    int                 peak;
+    uint64_t            fill_sum;
+    uint64_t            fill_samples;
+} pipeline_stage_t;
+
+
+/** @brief The xy1en1om memory layout of the FPGA registers. */
+extern fpga_xy_reg_mem_t*   g_fpga_xy_reg_mem;
+
+
+/** @brief Stages of the chain */
+static pipeline_stage_t     s_pipeline_stage[PIPELINE_STAGES_MAX];
+/** @brief Count of stages of the chain, 0: pipeline not running */
+static int                  s_pipeline_stages = 0;
+/** @brief Output queue of the last stage */
+static pipeline_queue_t     s_pipeline_out;
+
+/** @brief Storage of all items */
+static pipeline_item_t      s_pipeline_items[PIPELINE_ITEMS];
+/** @brief Stack of unused items */
+static pipeline_item_t*     s_pipeline_free[PIPELINE_ITEMS];
+/** @brief Count of entries in s_pipeline_free */
+static int                  s_pipeline_free_cnt = 0;
+
+/** @brief Scheduler threads */
+static pthread_t            s_pipeline_thread[PIPELINE_THREADS];
+/** @brief Count of started scheduler threads */
+static int                  s_pipeline_threads = 0;
+/** @brief 1: scheduler threads are requested to quit */
+static int                  s_pipeline_quit = 0;
+/** @brief Mutex for all queues and statistics */
+static pthread_mutex_t      s_pipeline_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Signals any queue change */
+static pthread_cond_t       s_pipeline_cond = PTHREAD_COND_INITIALIZER;
+/** @brief 1: a scheduler thread drives the FPGA engine, for whichever of the FPGA stages */
+static int                  s_pipeline_fpga_busy = 0;
+/** @brief Start time of the chain for the throughput statistics */
+static struct timespec      s_pipeline_t0;
+
+
+static uint64_t pipeline_ns_since(const struct timespec* t0)
+{
+    struct timespec t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (uint64_t) (t1.tv_sec - t0->tv_sec) * 1000000000ULL + (uint64_t) t1.tv_nsec - (uint64_t) t0->tv_nsec;
+}
+
+static inline pipeline_queue_t* pipeline_out_queue(int stage)
+{
+    return (stage + 1 < s_pipeline_stages) ?  &s_pipeline_stage[stage + 1].in : &s_pipeline_out;
+}
+
+static inline int pipeline_queue_room(const pipeline_queue_t* q)
+{
+    return PIPELINE_QUEUE_LEN - q->cnt - q->reserved;
+}
+
+static void pipeline_queue_push(pipeline_queue_t* q, pipeline_item_t* item)
+{
+    q->ring[(q->head + q->cnt) % PIPELINE_QUEUE_LEN] = item;
+    q->cnt++;
+}
+
+static pipeline_item_t* pipeline_queue_pop(pipeline_queue_t* q)
+{
+    pipeline_item_t* item = q->ring[q->head];
+
+    q->head = (q->head + 1) % PIPELINE_QUEUE_LEN;
+    q->cnt--;
+    return item;
+}
+
+
+/* --- engines --- */
+
+/** @brief Count of the following items having the same length as the first one, up to max */
+static int pipeline_same_len(pipeline_item_t* const items[], int n, int max)
+{
+    int i;
+
+    for (i = 1; i < n && i < max; i++) {
+        if (items[i]->len != items[0]->len) {
+            break;
+        }
+    }
+    return i;
+}
+
+static void pipeline_cpu_sha256(pipeline_item_t* const items[], int n, int dbl)
+{
+    uint32_t       h[SHA256_SW_LANES_MAX][SHA256_SW_HASH_WORDS];
+    const uint8_t* msgs[SHA256_SW_LANES_MAX];
+    int i = 0;
+
+    while (i < n) {
+        int run   = pipeline_same_len(items + i, n - i, SHA256_SW_LANES_MAX);
+        int lanes = (run == SHA256_SW_LANES_MAX) ?  SHA256_SW_LANES_MAX : ((run >= SHA256_SW_LANES) ?  SHA256_SW_LANES : 1);
+        int l;
+
+        for (l = 0; l < lanes; l++) {
+            msgs[l] = items[i + l]->data;
+        }
+        if (lanes == 1) {
+            sha256_sw_hash(h[0], msgs[0], items[i]->len, dbl);
+        } else {
+            (void) sha256_sw_hash_lanes(h, msgs, items[i]->len, lanes, dbl);
+        }
+
+        for (l = 0; l < lanes; l++, i++) {
+            sha256_sw_to_bytes(items[i]->data, h[l]);
+            items[i]->len = 32;
+        }
+    }
+}
+
+/** @retval 0 Success, -1 the FPGA did not respond */
+static int pipeline_fpga_sha256(pipeline_item_t* const items[], int n, int dbl)
+{
+    xy_sha256_job_t jobs[PIPELINE_BATCH];
+    uint32_t        h[PIPELINE_BATCH][8];
+    int i;
+
+    for (i = 0; i < n; i++) {
+        jobs[i].msg = items[i]->data;
+        jobs[i].len = items[i]->len;
+        jobs[i].dbl = dbl;
+    }
+
+    if (xy_sha256_submit_batch(jobs, n) != n) {
+        xy_sha256_drop();
+        return -1;
+    }
+    if (xy_sha256_collect(h, n) != n) {
+        xy_sha256_drop();
+        return -1;
+    }
+
+    for (i = 0; i < n; i++) {
+        sha256_sw_to_bytes(items[i]->data, h[i]);
+        items[i]->len = 32;
+    }
+    return 0;
+}
+
+static void pipeline_cpu_keccak512(pipeline_item_t* const items[], int n)
+{
+    uint8_t        digest[KECCAK_SW_LANES_MAX][KECCAK512_SW_DIGEST];
+    const uint8_t* msgs[KECCAK_SW_LANES_MAX];
+    int i = 0;
+
+    while (i < n) {
+        int run   = pipeline_same_len(items + i, n - i, KECCAK_SW_LANES_MAX);
+        int lanes = (run == KECCAK_SW_LANES_MAX) ?  KECCAK_SW_LANES_MAX : ((run >= KECCAK_SW_LANES) ?  KECCAK_SW_LANES : 1);
+        int l;
+
+        for (l = 0; l < lanes; l++) {
+            msgs[l] = items[i + l]->data;
+        }
+        if (lanes == 1) {
+            keccak512_sw_hash(digest[0], msgs[0], items[i]->len, KECCAK_SW_PAD_KECCAK);
+        } else {
+            (void) keccak512_sw_hash_lanes(digest, msgs, items[i]->len, lanes, KECCAK_SW_PAD_KECCAK);
+        }
+
+        for (l = 0; l < lanes; l++, i++) {
+            memcpy(items[i]->data, digest[l], KECCAK512_SW_DIGEST);
+            items[i]->len = KECCAK512_SW_DIGEST;
+        }
+    }
+}
+
+/** @retval 0 Success, -1 the FPGA did not respond */
+static int pipeline_fpga_keccak512(pipeline_item_t* const items[], int n)
+{
+    xy_keccak512_job_t jobs[PIPELINE_BATCH];
+    uint8_t            digest[PIPELINE_BATCH][64];
+    int i;
+
+    for (i = 0; i < n; i++) {
+        jobs[i].msg = items[i]->data;
+        jobs[i].len = items[i]->len;
+    }
+
+    if (xy_keccak512_submit_batch(jobs, n) != n || xy_keccak512_collect(digest, n) != n) {
+        return -1;
+    }
+
+    for (i = 0; i < n; i++) {
+        memcpy(items[i]->data, digest[i], KECCAK512_SW_DIGEST);
+        items[i]->len = KECCAK512_SW_DIGEST;
+    }
+    return 0;
+}
+
+/**
+ * @brief Hashes a batch with the engine of the stage
+ *
+ * @retval 0 Success, 1 the CPU had to redo the batch of an FPGA stage
+ */
+static int pipeline_run_stage(const pipeline_stage_t* st, pipeline_item_t* const items[], int n)
+{
+    const int dbl = (st->hash == pipeline_hash_sha256d);
+
+    switch (st->hash) {
+    case pipeline_hash_sha256:
+    case pipeline_hash_sha256d:
+        if (st->backend == pipeline_backend_fpga) {
+            if (!pipeline_fpga_sha256(items, n, dbl)) {
+                return 0;
+            }
+            pipeline_cpu_sha256(items, n, dbl);
+            return 1;
+        }
+        pipeline_cpu_sha256(items, n, dbl);
+        return 0;
+
+    case pipeline_hash_keccak512:
+        if (st->backend == pipeline_backend_fpga) {
+            if (!pipeline_fpga_keccak512(items, n)) {
+                return 0;
+            }
+            pipeline_cpu_keccak512(items, n);
+            return 1;
+        }
+        pipeline_cpu_keccak512(items, n);
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+
+/* --- scheduler --- */
+
+/**
+ * @brief Picks the stage to be served next, to be called with s_pipeline_mutex held
+ *
+ * The fullest queue wins, on a tie the later stage is preferred to drain the chain.
+ *
+ * @retval int  Index of the stage, -1: nothing runnable.
+ */
+static int pipeline_pick(void)
+{
+    int best = -1;
+    int best_cnt = 0;
+    int i;
+
+    for (i = s_pipeline_stages - 1; i >= 0; i--) {
+        pipeline_stage_t* st = &s_pipeline_stage[i];
+
+        st->fill_sum += st->in.cnt;
+        st->fill_samples++;
+
+        if (!st->in.cnt || pipeline_queue_room(pipeline_out_queue(i)) <= 0) {
+            continue;
+        }
+        if (st->backend == pipeline_backend_fpga && s_pipeline_fpga_busy) {
+            continue;  // the engine is busy - leave this stage, steal work elsewhere
+        }
+        if (st->in.cnt > best_cnt) {
+            best     = i;
+            best_cnt = st->in.cnt;
+        }
+    }
+    return best;
+}
+
+/** @brief Scheduler thread, one for each core */
+static void* pipeline_thread(void* args)
+{
+    pipeline_item_t* items[PIPELINE_BATCH];
+
+    pthread_mutex_lock(&s_pipeline_mutex);
+    while (!s_pipeline_quit) {
+        pipeline_queue_t* out;
+        pipeline_stage_t* st;
+        struct timespec   t0;
+        int idx, n, i, fallback;
+
+        idx = pipeline_pick();
+        if (idx < 0) {
+            pthread_cond_wait(&s_pipeline_cond, &s_pipeline_mutex);
+            continue;
+        }
+
+        st  = &s_pipeline_stage[idx];
+        out = pipeline_out_queue(idx);
+        n   = st->in.cnt;
+        if (n > PIPELINE_BATCH) {
+            n = PIPELINE_BATCH;
+        }
+        if (n > pipeline_queue_room(out)) {
+            n = pipeline_queue_room(out);
+        }
+        for (i = 0; i < n; i++) {
+            items[i] = pipeline_queue_pop(&st->in);
+        }
+        out->reserved += n;
+        st->running++;
+        if (st->backend == pipeline_backend_fpga) {
+            s_pipeline_fpga_busy = 1;
+        }
+        pthread_cond_broadcast(&s_pipeline_cond);  // room in front of the stage
+        pthread_mutex_unlock(&s_pipeline_mutex);
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        fallback = pipeline_run_stage(st, items, n);
+
+        pthread_mutex_lock(&s_pipeline_mutex);
+        st->busy_ns += pipeline_ns_since(&t0);
+        st->done    += n;
+        st->fallbacks += fallback;
+        st->running--;
+        if (st->backend == pipeline_backend_fpga) {
+            s_pipeline_fpga_busy = 0;
+        }
+        out->reserved -= n;
+        for (i = 0; i < n; i++) {
+            pipeline_queue_push(out, items[i]);
+        }
+        if (out != &s_pipeline_out && out->cnt > s_pipeline_stage[idx + 1].peak) {
+            s_pipeline_stage[idx + 1].peak = out->cnt;
+        }
+        pthread_cond_broadcast(&s_pipeline_cond);
+    }
+    pthread_mutex_unlock(&s_pipeline_mutex);
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------*/
+int pipeline_init(const pipeline_stage_cfg_t* cfg, int stages)
+{
+    int i, ret_val;
+
+    /* make sure all previous data is vanished */
+    pipeline_exit();
+
+    if (!cfg || stages < 1 || stages > PIPELINE_STAGES_MAX) {
+        fprintf(stderr, "ERROR - pipeline_init: bad arguments, stages = %d\n", stages);
+        return -1;
+    }
+
+    memset(s_pipeline_stage, 0, sizeof(s_pipeline_stage));
+    memset(&s_pipeline_out, 0, sizeof(s_pipeline_out));
+    s_pipeline_fpga_busy = 0;
+    for (i = 0; i < stages; i++) {
+        pipeline_stage_t* st = &s_pipeline_stage[i];
+
+        if (cfg[i].hash < 0 || cfg[i].hash >= pipeline_hash_nonexisting) {
+            fprintf(stderr, "ERROR - pipeline_init: stage %d has no valid hash function\n", i);
+            return -1;
+        }
+        st->hash    = cfg[i].hash;
+        st->backend = cfg[i].backend;
+
+        if (st->backend == pipeline_backend_auto) {
+            if (st->hash == pipeline_hash_keccak512) {
+                st->backend = xy_keccak512_pl_available() ?  pipeline_backend_fpga : pipeline_backend_cpu;
+            } else {
+                st->backend = g_fpga_xy_reg_mem ?  pipeline_backend_fpga : pipeline_backend_cpu;
+            }
+        }
+    }
+
+    for (i = 0; i < PIPELINE_ITEMS; i++) {
+        s_pipeline_free[i] = &s_pipeline_items[i];
+    }
+    s_pipeline_free_cnt = PIPELINE_ITEMS;
+
+    s_pipeline_quit   = 0;
+    s_pipeline_stages = stages;
+    clock_gettime(CLOCK_MONOTONIC, &s_pipeline_t0);
+
+    for (i = 0; i < PIPELINE_THREADS; i++) {
+        ret_val = pthread_create(&s_pipeline_thread[i], NULL, pipeline_thread, NULL);
+        if (ret_val) {
+            fprintf(stderr, "ERROR - pipeline_init: pthread_create() failed: %s\n", strerror(ret_val));
+            pipeline_exit();
+            return -1;
+        }
+        s_pipeline_threads++;
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int pipeline_exit(void)
+{
+    int i;
+
+    pthread_mutex_lock(&s_pipeline_mutex);
+    s_pipeline_quit = 1;
+    pthread_cond_broadcast(&s_pipeline_cond);
+    pthread_mutex_unlock(&s_pipeline_mutex);
+
+    for (i = 0; i < s_pipeline_threads; i++) {
+        pthread_join(s_pipeline_thread[i], NULL);
+    }
+    s_pipeline_threads = 0;
+
+    pthread_mutex_lock(&s_pipeline_mutex);
+    s_pipeline_stages   = 0;
+    s_pipeline_free_cnt = 0;
+    pthread_cond_broadcast(&s_pipeline_cond);  // wake up blocked collectors
+    pthread_mutex_unlock(&s_pipeline_mutex);
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int pipeline_running(void)
+{
+    int running;
+
+    pthread_mutex_lock(&s_pipeline_mutex);
+    running = (s_pipeline_stages > 0);
+    pthread_mutex_unlock(&s_pipeline_mutex);
+    return running;
+}
+
+/*----------------------------------------------------------------------------*/
+int pipeline_submit(uint32_t id, const uint8_t* msg, uint32_t len)
+{
+    pipeline_item_t* item;
+
+    if ((!msg && len) || len > PIPELINE_ITEM_MAX) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&s_pipeline_mutex);
+    if (!s_pipeline_stages) {
+        pthread_mutex_unlock(&s_pipeline_mutex);
+        return -1;
+    }
+    if (!s_pipeline_free_cnt || pipeline_queue_room(&s_pipeline_stage[0].in) <= 0) {
+        pthread_mutex_unlock(&s_pipeline_mutex);
+        return -2;
+    }
+
+    item = s_pipeline_free[--s_pipeline_free_cnt];
+    item->id  = id;
+    item->len = len;
+    memcpy(item->data, msg, len);
+
+    pipeline_queue_push(&s_pipeline_stage[0].in, item);
+    if (s_pipeline_stage[0].in.cnt > s_pipeline_stage[0].peak) {
+        s_pipeline_stage[0].peak = s_pipeline_stage[0].in.cnt;
+    }
+    pthread_cond_broadcast(&s_pipeline_cond);
+    pthread_mutex_unlock(&s_pipeline_mutex);
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int pipeline_collect(uint32_t* id, uint8_t* digest, int wait)
+{
+    pipeline_item_t* item;
+    int len;
+
+    if (!id || !digest) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&s_pipeline_mutex);
+    while (s_pipeline_stages && !s_pipeline_out.cnt && wait) {
+        pthread_cond_wait(&s_pipeline_cond, &s_pipeline_mutex);
+    }
+    if (!s_pipeline_stages) {
+        pthread_mutex_unlock(&s_pipeline_mutex);
+        return -1;
+    }
+    if (!s_pipeline_out.cnt) {
+        pthread_mutex_unlock(&s_pipeline_mutex);
+        return -2;
+    }
+
+    item = pipeline_queue_pop(&s_pipeline_out);
+    *id  = item->id;
+    len  = (int) item->len;
+    memcpy(digest, item->data, len);
+
+    s_pipeline_free[s_pipeline_free_cnt++] = item;
+    pthread_cond_broadcast(&s_pipeline_cond);  // room for the last stage
+    pthread_mutex_unlock(&s_pipeline_mutex);
+    return len;
+}
+
+/*----------------------------------------------------------------------------*/
+int pipeline_get_stats(int stage, pipeline_stage_stats_t* stats)
+{
+    const pipeline_stage_t* st;
+    double elapsed;
+
+    if (!stats) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&s_pipeline_mutex);
+    if (stage < 0 || stage >= s_pipeline_stages) {
+        pthread_mutex_unlock(&s_pipeline_mutex);
+        return -1;
+    }
+
+    st = &s_pipeline_stage[stage];
+    elapsed = (double) pipeline_ns_since(&s_pipeline_t0);
+
+    stats->backend     = st->backend;
+    stats->done        = st->done;
+    stats->fallbacks   = st->fallbacks;
+    stats->queued      = st->in.cnt;
+    stats->queued_peak = st->peak;
+    stats->queued_avg  = st->fill_samples ?  ((double) st->fill_sum / st->fill_samples) : 0.0;
+    stats->occupancy   = (elapsed > 0.0) ?  (st->busy_ns / elapsed) : 0.0;
+    stats->throughput  = (elapsed > 0.0) ?  (st->done * 1e9 / elapsed) : 0.0;
+    pthread_mutex_unlock(&s_pipeline_mutex);
+    return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * @brief Red Pitaya multi-stage hash pipeline scheduler of the xy1en1om sub-module.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __PIPELINE_H
+#define __PIPELINE_H
+
+#include <stdint.h>
+
+
+/** @defgroup pipeline_h Chained hash stages with bounded queues and two scheduler threads
+ * @{
+ */
+
+/** @brief Maximum count of stages of a chain. */
+#define PIPELINE_STAGES_MAX     11
+
+/** @brief Maximum length of a message entering the chain, also the room for the digests. */
+#define PIPELINE_ITEM_MAX       128
+
+/** @brief Capacity of each queue in front of a stage and of the output queue. */
+#define PIPELINE_QUEUE_LEN      32
+
+/** @brief Count of items in flight, all queues together. */
+#define PIPELINE_ITEMS          (PIPELINE_QUEUE_LEN << 2)
+
+/** @brief Maximum count of items taken by a scheduler thread out of one queue at once. */
+#define PIPELINE_BATCH          8
+
+/** @brief Count of scheduler threads, one for each Cortex-A9 core. */
+#define PIPELINE_THREADS        2
+
+
+/** @brief Hash function of a stage */
+typedef enum pipeline_hash_e {
+    /** @brief SHA-256, 32 byte digest */
+    pipeline_hash_sha256 = 0,
+
+    /** @brief SHA-256d = SHA-256(SHA-256(x)), 32 byte digest */
+    pipeline_hash_sha256d,
+
+    /** @brief Keccak-512 as used by X11, 64 byte digest */
+    pipeline_hash_keccak512,
+
+    /** @brief must be last entry */
+    pipeline_hash_nonexisting
+} pipeline_hash_t;
+
+/** @brief Engine backing a stage */
+typedef enum pipeline_backend_e {
+    /** @brief FPGA engine when available, else CPU */
+    pipeline_backend_auto = 0,
+
+    /** @brief FPGA engine, exclusive to one scheduler thread at a time */
+    pipeline_backend_fpga,
+
+    /** @brief Software engine, both scheduler threads may run it concurrently */
+    pipeline_backend_cpu
+} pipeline_backend_t;
+
+/** @brief Configuration of a stage */
+typedef struct pipeline_stage_cfg_s {
+    /** @brief hash  Hash function */
+    pipeline_hash_t     hash;
+
+    /** @brief backend  Requested engine */
+    pipeline_backend_t  backend;
+} pipeline_stage_cfg_t;
+
+/** @brief Statistics of a stage, as returned by pipeline_get_stats() */
+typedef struct pipeline_stage_stats_s {
+    /** @brief backend  Engine in use, pipeline_backend_fpga or pipeline_backend_cpu */
+    pipeline_backend_t  backend;
+
+    /** @brief done  Count of items hashed */
+    uint64_t            done;
+
+    /** @brief fallbacks  Count of FPGA batches that had to be redone by the CPU */
+    uint64_t            fallbacks;
+
+    /** @brief queued  Current fill of the queue in front of the stage */
+    int                 queued;
+
+    /** @brief queued_peak  Highest fill of the queue in front of the stage */
+    int                 queued_peak;
+
+    /** @brief queued_avg  Mean fill of the queue in front of the stage, sampled at each scheduling decision */
+    double              queued_avg;
+
+    /** @brief occupancy  Busy time of the engine per elapsed time, > 1.0 when both threads run a CPU stage */
+    double              occupancy;
+
+    /** @brief throughput  Items per second since pipeline_init() */
+    double              throughput;
+} pipeline_stage_stats_t;
+
+
+/* function declarations, detailed descriptions is in apparent implementation file  */
+
+/**
+ * @brief Sets-up the chain and starts the scheduler threads
+ *
+ * @param[in]  cfg     Stage configurations, in the order of the chain.
+ * @param[in]  stages  Count of stages, 1 .. PIPELINE_STAGES_MAX.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, error message is printed on standard error device
+ */
+int pipeline_init(const pipeline_stage_cfg_t* cfg, int stages);
+
+/**
+ * @brief Stops the scheduler threads, items still in flight are dropped
+ *
+ * @retval 0 Success, never fails
+ */
+int pipeline_exit(void);
+
+/**
+ * @brief Tells whether the scheduler threads are running
+ *
+ * @retval 1 pipeline_init() has succeeded and pipeline_exit() has not been called since
+ * @retval 0 No pipeline is running
+ */
+int pipeline_running(void);
+
+/**
+ * @brief Hands a message over to the first stage, the message is copied
+ *
+ * @param[in]  id      Tag of the message returned by pipeline_collect().
+ * @param[in]  msg     Message bytes.
+ * @param[in]  len     Message length in bytes, at most PIPELINE_ITEM_MAX.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, bad arguments or pipeline not running
+ * @retval -2 Queue of the first stage is full, retry later
+ */
+int pipeline_submit(uint32_t id, const uint8_t* msg, uint32_t len);
+
+/**
+ * @brief Takes a digest out of the output queue of the last stage
+ *
+ * @param[out] id      Tag given to pipeline_submit().
+ * @param[out] digest  Digest bytes of the last stage, room for PIPELINE_ITEM_MAX bytes.
+ * @param[in]  wait    0: return at once, else: block until a digest is ready.
+ *
+ * @retval  int  Length of the digest in bytes
+ * @retval -1    Failure, pipeline not running
+ * @retval -2    No digest ready
+ */
+int pipeline_collect(uint32_t* id, uint8_t* digest, int wait);
+
+/**
+ * @brief Reads the statistics of a stage
+ *
+ * @param[in]  stage   Index of the stage in the chain.
+ * @param[out] stats   Statistics.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, bad stage index or pipeline not running
+ */
+int pipeline_get_stats(int stage, pipeline_stage_stats_t* stats);
+
+/** @} */
+
+
+#endif /* __PIPELINE_H */
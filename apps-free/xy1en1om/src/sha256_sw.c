@@ -0,0 +1,579 @@
+/**
+ * @brief Red Pitaya software SHA-256 / SHA-256d engine of the xy1en1om sub-module.
+ *
+ * The multi-buffer engine keeps one message in each 32 bit lane of a SIMD vector.
+ * The vector type is a GCC vector extension, thus the same code is translated to
+ * NEON instructions on the Cortex-A9 (-mfpu=neon) and to SSE2 instructions on x86 hosts.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "sha256_sw.h"
+
+
+/** @brief One SIMD register holding the same 32 bit variable of SHA256_SW_LANES messages. */
+typedef uint32_t sha256_vec_t __attribute__ ((vector_size (SHA256_SW_LANES * sizeof(uint32_t))));
+
+/** @brief Count of SIMD registers needed for SHA256_SW_LANES_MAX messages. */
+#define SHA256_SW_GROUPS_MAX    (SHA256_SW_LANES_MAX / SHA256_SW_LANES)
+
+/** @brief Job description handed over to the helper thread. */
+typedef struct sha256_sw_job_s {
+    /** @brief 0: idle, 1: job pending, 2: quit thread */
+    int             state;
+
+    uint32_t      (*h)[SHA256_SW_HASH_WORDS];
+    const uint8_t*  msgs;
+    size_t          stride;
+    size_t          len;
+    int             count;
+    int             dbl;
+} sha256_sw_job_t;
+
+
+/** @brief SHA-256 round constants. */
+static const uint32_t s_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/** @brief SHA-256 initial hash value H0..H7. */
+static const uint32_t s_sha256_h_init[SHA256_SW_HASH_WORDS] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+
+/** @brief Thread handler for the helper thread doing the second half of a batch */
+static pthread_t*               s_sha256_sw_thread_handler = NULL;
+/** @brief Mutex for s_sha256_sw_job */
+static pthread_mutex_t          s_sha256_sw_job_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Signals a state change of s_sha256_sw_job */
+static pthread_cond_t           s_sha256_sw_job_cond = PTHREAD_COND_INITIALIZER;
+/** @brief Serializes concurrent users of the helper thread */
+static pthread_mutex_t          s_sha256_sw_batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** @brief The job currently delegated to the helper thread */
+static sha256_sw_job_t          s_sha256_sw_job;
+
+
+#define ROR(x, n)       (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)     (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z)    (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define EP0(x)          (ROR(x,  2) ^ ROR(x, 13) ^ ROR(x, 22))
+#define EP1(x)          (ROR(x,  6) ^ ROR(x, 11) ^ ROR(x, 25))
+#define SIG0(x)         (ROR(x,  7) ^ ROR(x, 18) ^ ((x) >>  3))
+#define SIG1(x)         (ROR(x, 17) ^ ROR(x, 19) ^ ((x) >> 10))
+
+/** @brief One compression round, the rotation of the working variables is done by renaming the arguments. */
+#define ROUND(a, b, c, d, e, f, g, h, k, w)                 \
+    do {                                                    \
+        t1 = (h) + EP1(e) + CH(e, f, g) + (k) + (w);        \
+        t2 = EP0(a) + MAJ(a, b, c);                         \
+        (d) += t1;                                          \
+        (h)  = t1 + t2;                                     \
+    } while (0)
+
+
+static inline uint32_t sha256_sw_be32(const uint8_t* p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static inline void sha256_sw_set_be64(uint8_t* p, uint64_t v)
+{
+    int i;
+    for (i = 7; i >= 0; i--, v >>= 8) {
+        p[i] = (uint8_t) v;
+    }
+}
+
+/**
+ * @brief Builds the padded tail blocks of a message
+ *
+ * @param[out] tail   Buffer of two blocks receiving the last partial block, the '1' bit and the length.
+ * @param[in]  msg    Message bytes.
+ * @param[in]  len    Message length in bytes.
+ * @retval     int    Count of tail blocks, 1 or 2.
+ */
+static int sha256_sw_pad_tail(uint8_t tail[128], const uint8_t* msg, size_t len)
+{
+    size_t rem    = len & 63;
+    int    blocks = (rem < 56) ?  1 : 2;
+
+    memset(tail, 0, blocks << 6);
+    memcpy(tail, msg + (len - rem), rem);
+    tail[rem] = 0x80;
+    sha256_sw_set_be64(tail + (blocks << 6) - 8, (uint64_t) len << 3);
+    return blocks;
+}
+
+
+/* --- scalar engine --- */
+
+static void sha256_sw_compress(uint32_t s[SHA256_SW_HASH_WORDS], uint32_t w[16])
+{
+    uint32_t a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    uint32_t t1, t2;
+    int r;
+
+    for (r = 0; r < 64; r += 8) {
+        if (r >= 16) {
+            int i;
+            for (i = (r & 15); i < (r & 15) + 8; i++) {
+                w[i] += SIG0(w[(i + 1) & 15]) + w[(i + 9) & 15] + SIG1(w[(i + 14) & 15]);
+            }
+        }
+        ROUND(a, b, c, d, e, f, g, h, s_sha256_k[r + 0], w[(r + 0) & 15]);
+        ROUND(h, a, b, c, d, e, f, g, s_sha256_k[r + 1], w[(r + 1) & 15]);
+        ROUND(g, h, a, b, c, d, e, f, s_sha256_k[r + 2], w[(r + 2) & 15]);
+        ROUND(f, g, h, a, b, c, d, e, s_sha256_k[r + 3], w[(r + 3) & 15]);
+        ROUND(e, f, g, h, a, b, c, d, s_sha256_k[r + 4], w[(r + 4) & 15]);
+        ROUND(d, e, f, g, h, a, b, c, s_sha256_k[r + 5], w[(r + 5) & 15]);
+        ROUND(c, d, e, f, g, h, a, b, s_sha256_k[r + 6], w[(r + 6) & 15]);
+        ROUND(b, c, d, e, f, g, h, a, s_sha256_k[r + 7], w[(r + 7) & 15]);
+    }
+
+    s[0] += a;  s[1] += b;  s[2] += c;  s[3] += d;
+    s[4] += e;  s[5] += f;  s[6] += g;  s[7] += h;
+}
+
+static void sha256_sw_load_block(uint32_t w[16], const uint8_t* p)
+{
+    int i;
+    for (i = 0; i < 16; i++) {
+        w[i] = sha256_sw_be32(p + (i << 2));
+    }
+}
+
+/** @brief Second pass of SHA-256d, the 32 byte digest fits into a single pre-padded block. */
+static void sha256_sw_rehash(uint32_t h[SHA256_SW_HASH_WORDS])
+{
+    uint32_t w[16] = { h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+                       0x80000000, 0, 0, 0, 0, 0, 0, 0x00000100 };
+
+    memcpy(h, s_sha256_h_init, sizeof(s_sha256_h_init));
+    sha256_sw_compress(h, w);
+}
+
+/*----------------------------------------------------------------------------*/
+void sha256_sw_hash(uint32_t h[SHA256_SW_HASH_WORDS], const uint8_t* msg, size_t len, int dbl)
+{
+    uint8_t  tail[128];
+    uint32_t w[16];
+    size_t   full = len >> 6;
+    size_t   b;
+    int      tail_blocks;
+
+    memcpy(h, s_sha256_h_init, sizeof(s_sha256_h_init));
+    for (b = 0; b < full; b++) {
+        sha256_sw_load_block(w, msg + (b << 6));
+        sha256_sw_compress(h, w);
+    }
+
+    tail_blocks = sha256_sw_pad_tail(tail, msg, len);
+    for (b = 0; b < (size_t) tail_blocks; b++) {
+        sha256_sw_load_block(w, tail + (b << 6));
+        sha256_sw_compress(h, w);
+    }
+
+    if (dbl) {
+        sha256_sw_rehash(h);
+    }
+}
+
+
+/* --- multi-buffer SIMD engine --- */
+
+/**
+ * @brief Compresses one block of each lane
+ *
+ * The groups argument is a compile-time constant at each call site, thus the loops over the groups
+ * are unrolled and the two register sets of the 8-lane variant are interleaved to fill the dual-issue
+ * NEON pipeline of the Cortex-A9.
+ */
+static inline __attribute__ ((always_inline))
+void sha256_sw_compress_vec(sha256_vec_t s[][SHA256_SW_HASH_WORDS], sha256_vec_t w[][16], const int groups)
+{
+    sha256_vec_t v[SHA256_SW_GROUPS_MAX][SHA256_SW_HASH_WORDS];
+    sha256_vec_t t1, t2;
+    int g, i, r;
+
+    for (g = 0; g < groups; g++) {
+        for (i = 0; i < SHA256_SW_HASH_WORDS; i++) {
+            v[g][i] = s[g][i];
+        }
+    }
+
+    for (r = 0; r < 64; r += 8) {
+        sha256_vec_t k[8];
+
+        for (i = 0; i < 8; i++) {
+            uint32_t kr = s_sha256_k[r + i];
+            k[i] = (sha256_vec_t) { kr, kr, kr, kr };
+        }
+
+        for (g = 0; g < groups; g++) {
+            sha256_vec_t* x  = v[g];
+            sha256_vec_t* wg = w[g];
+
+            if (r >= 16) {
+                for (i = (r & 15); i < (r & 15) + 8; i++) {
+                    wg[i] += SIG0(wg[(i + 1) & 15]) + wg[(i + 9) & 15] + SIG1(wg[(i + 14) & 15]);
+                }
+            }
+
+            ROUND(x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7], k[0], wg[(r + 0) & 15]);
+            ROUND(x[7], x[0], x[1], x[2], x[3], x[4], x[5], x[6], k[1], wg[(r + 1) & 15]);
+            ROUND(x[6], x[7], x[0], x[1], x[2], x[3], x[4], x[5], k[2], wg[(r + 2) & 15]);
+            ROUND(x[5], x[6], x[7], x[0], x[1], x[2], x[3], x[4], k[3], wg[(r + 3) & 15]);
+            ROUND(x[4], x[5], x[6], x[7], x[0], x[1], x[2], x[3], k[4], wg[(r + 4) & 15]);
+            ROUND(x[3], x[4], x[5], x[6], x[7], x[0], x[1], x[2], k[5], wg[(r + 5) & 15]);
+            ROUND(x[2], x[3], x[4], x[5], x[6], x[7], x[0], x[1], k[6], wg[(r + 6) & 15]);
+            ROUND(x[1], x[2], x[3], x[4], x[5], x[6], x[7], x[0], k[7], wg[(r + 7) & 15]);
+        }
+    }
+
+    for (g = 0; g < groups; g++) {
+        for (i = 0; i < SHA256_SW_HASH_WORDS; i++) {
+            s[g][i] += v[g][i];
+        }
+    }
+}
+
+/**
+ * @brief Hashes groups * SHA256_SW_LANES messages of the same length
+ */
+static inline __attribute__ ((always_inline))
+void sha256_sw_hash_vec(uint32_t h[][SHA256_SW_HASH_WORDS], const uint8_t* const msgs[], size_t len, int dbl, const int groups)
+{
+    const int    lanes = groups * SHA256_SW_LANES;
+    uint8_t      tail[SHA256_SW_LANES_MAX][128];
+    sha256_vec_t s[SHA256_SW_GROUPS_MAX][SHA256_SW_HASH_WORDS];
+    sha256_vec_t w[SHA256_SW_GROUPS_MAX][16];
+    size_t       full = len >> 6;
+    size_t       blocks = 0;
+    size_t       b;
+    int          g, i, l;
+
+    for (l = 0; l < lanes; l++) {
+        blocks = full + sha256_sw_pad_tail(tail[l], msgs[l], len);
+    }
+
+    for (g = 0; g < groups; g++) {
+        for (i = 0; i < SHA256_SW_HASH_WORDS; i++) {
+            uint32_t hi = s_sha256_h_init[i];
+            s[g][i] = (sha256_vec_t) { hi, hi, hi, hi };
+        }
+    }
+
+    for (b = 0; b < blocks; b++) {
+        for (g = 0; g < groups; g++) {
+            const uint8_t* p[SHA256_SW_LANES];
+
+            for (l = 0; l < SHA256_SW_LANES; l++) {
+                int lg = g * SHA256_SW_LANES + l;
+                p[l] = (b < full) ?  (msgs[lg] + (b << 6)) : (tail[lg] + ((b - full) << 6));
+            }
+            for (i = 0; i < 16; i++) {
+                w[g][i] = (sha256_vec_t) { sha256_sw_be32(p[0] + (i << 2)), sha256_sw_be32(p[1] + (i << 2)),
+                                           sha256_sw_be32(p[2] + (i << 2)), sha256_sw_be32(p[3] + (i << 2)) };
+            }
+        }
+        sha256_sw_compress_vec(s, w, groups);
+    }
+
+    if (dbl) {
+        /* the digests of the first pass are already transposed - no lane shuffling needed */
+        const sha256_vec_t pad_one = { 0x80000000, 0x80000000, 0x80000000, 0x80000000 };
+        const sha256_vec_t pad_len = { 0x00000100, 0x00000100, 0x00000100, 0x00000100 };
+        const sha256_vec_t zero    = { 0, 0, 0, 0 };
+
+        for (g = 0; g < groups; g++) {
+            for (i = 0; i < SHA256_SW_HASH_WORDS; i++) {
+                uint32_t hi = s_sha256_h_init[i];
+                w[g][i] = s[g][i];
+                s[g][i] = (sha256_vec_t) { hi, hi, hi, hi };
+            }
+            w[g][8] = pad_one;
+            for (i = 9; i < 15; i++) {
+                w[g][i] = zero;
+            }
+            w[g][15] = pad_len;
+        }
+        sha256_sw_compress_vec(s, w, groups);
+    }
+
+    for (g = 0; g < groups; g++) {
+        for (l = 0; l < SHA256_SW_LANES; l++) {
+            for (i = 0; i < SHA256_SW_HASH_WORDS; i++) {
+                h[g * SHA256_SW_LANES + l][i] = s[g][i][l];
+            }
+        }
+    }
+}
+
+static void sha256_sw_hash_x4(uint32_t h[][SHA256_SW_HASH_WORDS], const uint8_t* const msgs[], size_t len, int dbl)
+{
+    sha256_sw_hash_vec(h, msgs, len, dbl, 1);
+}
+
+static void sha256_sw_hash_x8(uint32_t h[][SHA256_SW_HASH_WORDS], const uint8_t* const msgs[], size_t len, int dbl)
+{
+    sha256_sw_hash_vec(h, msgs, len, dbl, SHA256_SW_GROUPS_MAX);
+}
+
+/*----------------------------------------------------------------------------*/
+int sha256_sw_hash_lanes(uint32_t h[][SHA256_SW_HASH_WORDS], const uint8_t* const msgs[], size_t len, int lanes, int dbl)
+{
+    if (!h || !msgs) {
+        return -1;
+    }
+
+    switch (lanes) {
+    case SHA256_SW_LANES:
+        sha256_sw_hash_x4(h, msgs, len, dbl);
+        return 0;
+
+    case SHA256_SW_LANES_MAX:
+        sha256_sw_hash_x8(h, msgs, len, dbl);
+        return 0;
+
+    default:
+        return -1;
+    }
+}
+
+
+/* --- batch processing on both cores --- */
+
+/** @brief Hashes a range of the batch on the calling core */
+static void sha256_sw_hash_range(uint32_t h[][SHA256_SW_HASH_WORDS], const uint8_t* msgs, size_t stride, size_t len, int count, int dbl)
+{
+    const uint8_t* p[SHA256_SW_LANES_MAX];
+    int n = 0;
+    int l;
+
+    while (count - n >= SHA256_SW_LANES_MAX) {
+        for (l = 0; l < SHA256_SW_LANES_MAX; l++) {
+            p[l] = msgs + (n + l) * stride;
+        }
+        sha256_sw_hash_x8(h + n, p, len, dbl);
+        n += SHA256_SW_LANES_MAX;
+    }
+
+    if (count - n >= SHA256_SW_LANES) {
+        for (l = 0; l < SHA256_SW_LANES; l++) {
+            p[l] = msgs + (n + l) * stride;
+        }
+        sha256_sw_hash_x4(h + n, p, len, dbl);
+        n += SHA256_SW_LANES;
+    }
+
+    for (; n < count; n++) {
+        sha256_sw_hash(h[n], msgs + n * stride, len, dbl);
+    }
+}
+
+/** @brief The helper thread waits for jobs delegated by sha256_sw_hash_batch() */
+static void* sha256_sw_thread(void* args)
+{
+    pthread_mutex_lock(&s_sha256_sw_job_mutex);
+    while (1) {
+        while (s_sha256_sw_job.state == 0) {
+            pthread_cond_wait(&s_sha256_sw_job_cond, &s_sha256_sw_job_mutex);
+        }
+        if (s_sha256_sw_job.state == 2) {
+            break;
+        }
+
+        pthread_mutex_unlock(&s_sha256_sw_job_mutex);
+        sha256_sw_hash_range(s_sha256_sw_job.h, s_sha256_sw_job.msgs, s_sha256_sw_job.stride, s_sha256_sw_job.len,
+                             s_sha256_sw_job.count, s_sha256_sw_job.dbl);
+        pthread_mutex_lock(&s_sha256_sw_job_mutex);
+
+        s_sha256_sw_job.state = 0;
+        pthread_cond_broadcast(&s_sha256_sw_job_cond);
+    }
+    pthread_mutex_unlock(&s_sha256_sw_job_mutex);
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int sha256_sw_init(void)
+{
+    int ret_val;
+
+    /* make sure all previous data is vanished */
+    sha256_sw_exit();
+
+    s_sha256_sw_job.state = 0;
+
+    s_sha256_sw_thread_handler = (pthread_t*) malloc(sizeof(pthread_t));
+    if (!s_sha256_sw_thread_handler) {
+        return -1;
+    }
+
+    ret_val = pthread_create(s_sha256_sw_thread_handler, NULL, sha256_sw_thread, NULL);
+    if (ret_val) {
+        fprintf(stderr, "ERROR - sha256_sw_init: pthread_create() failed: %s\n", strerror(ret_val));
+        free(s_sha256_sw_thread_handler);
+        s_sha256_sw_thread_handler = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int sha256_sw_exit(void)
+{
+    if (!s_sha256_sw_thread_handler) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&s_sha256_sw_batch_mutex);
+    pthread_mutex_lock(&s_sha256_sw_job_mutex);
+    s_sha256_sw_job.state = 2;
+    pthread_cond_broadcast(&s_sha256_sw_job_cond);
+    pthread_mutex_unlock(&s_sha256_sw_job_mutex);
+
+    pthread_join(*s_sha256_sw_thread_handler, NULL);
+    free(s_sha256_sw_thread_handler);
+    s_sha256_sw_thread_handler = NULL;
+    pthread_mutex_unlock(&s_sha256_sw_batch_mutex);
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int sha256_sw_hash_batch(uint32_t h[][SHA256_SW_HASH_WORDS], const uint8_t* msgs, size_t stride, size_t len, int count, int dbl)
+{
+    int split;
+
+    if (!h || !msgs || count < 0) {
+        return -1;
+    }
+
+    /* small batches or a busy helper thread: do everything on this core */
+    if (count < (SHA256_SW_LANES_MAX << 1) || pthread_mutex_trylock(&s_sha256_sw_batch_mutex)) {
+        sha256_sw_hash_range(h, msgs, stride, len, count, dbl);
+        return 0;
+    }
+    if (!s_sha256_sw_thread_handler) {
+        pthread_mutex_unlock(&s_sha256_sw_batch_mutex);
+        sha256_sw_hash_range(h, msgs, stride, len, count, dbl);
+        return 0;
+    }
+
+    /* the first half is kept on SIMD group boundaries */
+    split = (count >> 1) & ~(SHA256_SW_LANES - 1);
+
+    pthread_mutex_lock(&s_sha256_sw_job_mutex);
+    s_sha256_sw_job.h      = h + split;
+    s_sha256_sw_job.msgs   = msgs + split * stride;
+    s_sha256_sw_job.stride = stride;
+    s_sha256_sw_job.len    = len;
+    s_sha256_sw_job.count  = count - split;
+    s_sha256_sw_job.dbl    = dbl;
+    s_sha256_sw_job.state  = 1;
+    pthread_cond_broadcast(&s_sha256_sw_job_cond);
+    pthread_mutex_unlock(&s_sha256_sw_job_mutex);
+
+    sha256_sw_hash_range(h, msgs, stride, len, split, dbl);
+
+    pthread_mutex_lock(&s_sha256_sw_job_mutex);
+    while (s_sha256_sw_job.state == 1) {
+        pthread_cond_wait(&s_sha256_sw_job_cond, &s_sha256_sw_job_mutex);
+    }
+    pthread_mutex_unlock(&s_sha256_sw_job_mutex);
+
+    pthread_mutex_unlock(&s_sha256_sw_batch_mutex);
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------*/
+int sha256_sw_verify(const uint32_t h_fpga[SHA256_SW_HASH_WORDS], const uint8_t* msg, size_t len, int dbl)
+{
+    uint32_t h[SHA256_SW_HASH_WORDS];
+
+    if (!h_fpga || (!msg && len)) {
+        return 0;
+    }
+
+    sha256_sw_hash(h, msg, len, dbl);
+    return !memcmp(h, h_fpga, sizeof(h));
+}
+
+/*----------------------------------------------------------------------------*/
+void sha256_sw_block_init(uint32_t h[SHA256_SW_HASH_WORDS])
+{
+    memcpy(h, s_sha256_h_init, sizeof(s_sha256_h_init));
+}
+
+/*----------------------------------------------------------------------------*/
+void sha256_sw_block(uint32_t h[SHA256_SW_HASH_WORDS], const uint32_t w[16])
+{
+    uint32_t x[16];
+
+    memcpy(x, w, sizeof(x));  // the message schedule is expanded in place
+    sha256_sw_compress(h, x);
+}
+
+/*----------------------------------------------------------------------------*/
+void sha256_sw_to_bytes(uint8_t digest[32], const uint32_t h[SHA256_SW_HASH_WORDS])
+{
+    int i;
+    for (i = 0; i < SHA256_SW_HASH_WORDS; i++) {
+        digest[(i << 2) + 0] = (uint8_t) (h[i] >> 24);
+        digest[(i << 2) + 1] = (uint8_t) (h[i] >> 16);
+        digest[(i << 2) + 2] = (uint8_t) (h[i] >>  8);
+        digest[(i << 2) + 3] = (uint8_t)  h[i];
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+double sha256_sw_benchmark(int dbl, double seconds)
+{
+    enum { BENCH_COUNT = 256, BENCH_LEN = 80 };
+    static uint8_t  s_msgs[BENCH_COUNT][BENCH_LEN];
+    static uint32_t s_h[BENCH_COUNT][SHA256_SW_HASH_WORDS];
+    struct timespec t0, t1;
+    double elapsed = 0.0;
+    long   hashes  = 0;
+    uint32_t nonce = 0;
+    int i;
+
+    memset(s_msgs, 0x5a, sizeof(s_msgs));
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    do {
+        /* vary the nonce at its block header position to defeat any caching effects */
+        for (i = 0; i < BENCH_COUNT; i++, nonce++) {
+            memcpy(&s_msgs[i][76], &nonce, sizeof(nonce));
+        }
+        sha256_sw_hash_batch(s_h, &s_msgs[0][0], BENCH_LEN, BENCH_LEN, BENCH_COUNT, dbl);
+        hashes += BENCH_COUNT;
+
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    } while (elapsed < seconds);
+
+    return hashes / elapsed;
+}
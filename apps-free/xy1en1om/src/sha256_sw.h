@@ -0,0 +1,148 @@
+/**
+ * @brief Red Pitaya software SHA-256 / SHA-256d engine of the xy1en1om sub-module.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __SHA256_SW_H
+#define __SHA256_SW_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/** @defgroup sha256_sw_h Software SHA-256 engine, multi-buffer SIMD variant
+ * @{
+ */
+
+/** @brief Count of 32 bit words of a SHA-256 hash value, H0 (MSB) .. H7 (LSB). */
+#define SHA256_SW_HASH_WORDS    8
+
+/** @brief Count of messages being hashed in parallel by one SIMD vector (NEON Q register / SSE XMM register). */
+#define SHA256_SW_LANES         4
+
+/** @brief Maximum count of messages being hashed in parallel by one call of sha256_sw_hash_lanes(). */
+#define SHA256_SW_LANES_MAX     (SHA256_SW_LANES << 1)
+
+
+/* function declarations, detailed descriptions is in apparent implementation file  */
+
+/**
+ * @brief Starts the helper thread that does the second half of each batch on the other CPU core
+ *
+ * The engine is usable without calling this function, but sha256_sw_hash_batch() then runs on the
+ * calling core, only.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, error message is printed on standard error device
+ */
+int sha256_sw_init(void);
+
+/**
+ * @brief Shuts-down the helper thread of the software SHA-256 engine
+ *
+ * @retval 0 Success, never fails
+ */
+int sha256_sw_exit(void);
+
+/**
+ * @brief Hashes a single message of any length (scalar reference implementation)
+ *
+ * @param[out] h       Resulting hash value H0..H7 in the same word order as the FPGA hash registers.
+ * @param[in]  msg     Message bytes to be hashed.
+ * @param[in]  len     Message length in bytes.
+ * @param[in]  dbl     0: SHA-256(msg), else: SHA-256d = SHA-256(SHA-256(msg)).
+ */
+void sha256_sw_hash(uint32_t h[SHA256_SW_HASH_WORDS], const uint8_t* msg, size_t len, int dbl);
+
+/**
+ * @brief Hashes 4 or 8 independent messages of the same length in the SIMD lanes of one core
+ *
+ * @param[out] h       Resulting hash values, one entry for each of the lanes.
+ * @param[in]  msgs    Message pointers, one entry for each of the lanes.
+ * @param[in]  len     Message length in bytes, the same for all messages.
+ * @param[in]  lanes   Count of messages: SHA256_SW_LANES or SHA256_SW_LANES_MAX.
+ * @param[in]  dbl     0: SHA-256(msg), else: SHA-256d = SHA-256(SHA-256(msg)).
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, bad arguments
+ */
+int sha256_sw_hash_lanes(uint32_t h[][SHA256_SW_HASH_WORDS], const uint8_t* const msgs[], size_t len, int lanes, int dbl);
+
+/**
+ * @brief Hashes a batch of messages of the same length being stored with a fixed stride
+ *
+ * The batch is cut into 8-lane and 4-lane groups. The second half of the batch is delegated to
+ * the helper thread when sha256_sw_init() has been called, so that both Cortex-A9 cores are busy.
+ * A remainder smaller than SHA256_SW_LANES is done with the scalar code.
+ *
+ * @param[out] h       Resulting hash values, count entries.
+ * @param[in]  msgs    First message of the batch.
+ * @param[in]  stride  Distance in bytes between the start of two consecutive messages.
+ * @param[in]  len     Message length in bytes, the same for all messages.
+ * @param[in]  count   Count of messages.
+ * @param[in]  dbl     0: SHA-256(msg), else: SHA-256d = SHA-256(SHA-256(msg)).
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, bad arguments
+ */
+int sha256_sw_hash_batch(uint32_t h[][SHA256_SW_HASH_WORDS], const uint8_t* msgs, size_t stride, size_t len, int count, int dbl);
+
+/**
+ * @brief Cross-checks a hash value read from the FPGA hash registers
+ *
+ * @param[in]  h_fpga  Hash value H0..H7 as read from the FPGA.
+ * @param[in]  msg     Message bytes (not padded) that were hashed by the FPGA.
+ * @param[in]  len     Message length in bytes.
+ * @param[in]  dbl     0: SHA-256(msg), else: SHA-256d = SHA-256(SHA-256(msg)).
+ *
+ * @retval  1 Hash values are identical
+ * @retval  0 Hash values differ
+ */
+int sha256_sw_verify(const uint32_t h_fpga[SHA256_SW_HASH_WORDS], const uint8_t* msg, size_t len, int dbl);
+
+/**
+ * @brief Presets the hash value words H0..H7 with the initial hash value of FIPS 180-4
+ *
+ * @param[out] h       Hash value H0..H7.
+ */
+void sha256_sw_block_init(uint32_t h[SHA256_SW_HASH_WORDS]);
+
+/**
+ * @brief Compresses a single 512 bit block, the way the FPGA engine consumes its FIFO
+ *
+ * @param[inout] h     Hash value H0..H7, updated by the block.
+ * @param[in]    w     Block words in big-endian order as pushed into the FPGA FIFO.
+ */
+void sha256_sw_block(uint32_t h[SHA256_SW_HASH_WORDS], const uint32_t w[16]);
+
+/**
+ * @brief Converts the hash value words H0..H7 to the 32 bytes of the digest
+ *
+ * @param[out] digest  Digest bytes in big-endian order as defined by FIPS 180-4.
+ * @param[in]  h       Hash value H0..H7.
+ */
+void sha256_sw_to_bytes(uint8_t digest[32], const uint32_t h[SHA256_SW_HASH_WORDS]);
+
+/**
+ * @brief Measures the CPU baseline throughput of the software engine
+ *
+ * 80 byte block headers are hashed with sha256_sw_hash_batch() for the given duration.
+ *
+ * @param[in]  dbl      0: SHA-256, else: SHA-256d.
+ * @param[in]  seconds  Duration of the measurement.
+ *
+ * @retval     double   Count of hashes per second.
+ */
+double sha256_sw_benchmark(int dbl, double seconds);
+
+/** @} */
+
+
+#endif /* __SHA256_SW_H */
@@ -0,0 +1,102 @@
+/**
+ * @brief Red Pitaya Validity tester for the DMA ring
+ * of the xy1en1om sub-module.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_dma_ring.h"
+#include "dma_ring.h"
+
+
+/** @brief Requested size, not a multiple of the slot size */
+#define TEST_DMA_RING_SIZE      ((3 * DMA_RING_SLOT_SIZE) + 1)
+
+/** @brief Count of slots after rounding up */
+#define TEST_DMA_RING_SLOTS     4
+
+
+/* --- */
+
+void test_dma_ring_INIT()
+{
+
+}
+
+void test_dma_ring_TEST()
+{
+    test_dma_ring_anon();
+}
+
+void test_dma_ring_FINALIZE()
+{
+
+}
+
+/* --- */
+
+void test_dma_ring_anon()
+{
+    dma_ring_t      ring;
+    dma_ring_slot_t slot;
+    int             ok = 1;
+    int             i;
+
+    if (!dma_ring_init(&ring, &dma_ring_backend_anon, 0)) {
+        ok = 0;  // an empty ring is refused
+        dma_ring_exit(&ring);
+    }
+
+    if (dma_ring_init(&ring, &dma_ring_backend_anon, TEST_DMA_RING_SIZE)) {
+        fprintf(stderr, "INFO DMA ring anon backend  (FAILED)\n");
+        return;
+    }
+    if (ring.slots != TEST_DMA_RING_SLOTS || ring.size != TEST_DMA_RING_SLOTS * DMA_RING_SLOT_SIZE) {
+        ok = 0;
+    }
+
+    /* the slots are handed out in order, each one on its own page */
+    for (i = 0; i < TEST_DMA_RING_SLOTS; i++) {
+        if (dma_ring_get_slot(&ring, &slot) || slot.idx != i ||
+                slot.virt != ring.virt + i * DMA_RING_SLOT_SIZE || slot.phys != ring.phys + i * DMA_RING_SLOT_SIZE) {
+            ok = 0;
+        }
+        memset(slot.virt, i, DMA_RING_SLOT_SIZE);
+        dma_ring_sync_slot(&ring, &slot, DMA_RING_SLOT_SIZE << 1, dma_ring_to_device);
+    }
+    if (!dma_ring_get_slot(&ring, &slot)) {
+        ok = 0;  // all slots are in use
+    }
+
+    /* releasing the oldest slot makes it the next one to be handed out */
+    if (dma_ring_put_slot(&ring) || dma_ring_get_slot(&ring, &slot) || slot.idx != 0 || slot.virt[DMA_RING_SLOT_SIZE - 1] != 0) {
+        ok = 0;
+    }
+    for (i = 0; i < TEST_DMA_RING_SLOTS; i++) {
+        if (dma_ring_put_slot(&ring)) {
+            ok = 0;
+        }
+    }
+    if (!dma_ring_put_slot(&ring) || ring.used || ring.head != 1) {
+        ok = 0;
+    }
+    if (ring.sync_count != TEST_DMA_RING_SLOTS || ring.virt[TEST_DMA_RING_SLOTS * DMA_RING_SLOT_SIZE - 1] != TEST_DMA_RING_SLOTS - 1) {
+        ok = 0;
+    }
+
+    /* released twice without harm, and no slots afterwards */
+    dma_ring_exit(&ring);
+    dma_ring_exit(&ring);
+    if (ring.slots || !dma_ring_get_slot(&ring, &slot)) {
+        ok = 0;
+    }
+
+    fprintf(stderr, "INFO DMA ring anon backend: %d slots  (%s)\n", TEST_DMA_RING_SLOTS, ok ?  "OK" : "FAILED");
+}
@@ -0,0 +1,38 @@
+/*
+ * test_dma_ring.h
+ *
+ *  Created on: 16.10.2016
+ *      Author: espero
+ */
+
+#ifndef APPS_FREE_XY1EN1OM_SRC_TEST_DMA_RING_H_
+#define APPS_FREE_XY1EN1OM_SRC_TEST_DMA_RING_H_
+
+
+/**
+ * @brief Initializing for validity check of the DMA ring
+ *
+ */
+void test_dma_ring_INIT();
+
+/**
+ * @brief Testing and doing the validity check of the DMA ring
+ *
+ */
+void test_dma_ring_TEST();
+
+/**
+ * @brief Finalizing for validity check of the DMA ring
+ *
+ */
+void test_dma_ring_FINALIZE();
+
+
+/**
+ * @brief Checks slot hand-out, wrap-around and release with the anonymous mapping backend
+ *
+ */
+void test_dma_ring_anon();
+
+
+#endif /* APPS_FREE_XY1EN1OM_SRC_TEST_DMA_RING_H_ */
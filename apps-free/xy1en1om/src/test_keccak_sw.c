@@ -0,0 +1,162 @@
+/**
+ * @brief Red Pitaya Validity tester for the software Keccak-512 engine
+ * of the xy1en1om sub-module.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_keccak_sw.h"
+#include "keccak_sw.h"
+#include "main.h"
+#include "fpga_xy.h"
+
+
+/** @brief Known answers of the original Keccak-512 (as used by X11) and of FIPS 202 SHA3-512.
+ *  A NULL text stands for a message of len letters 'A'. */
+static const struct {
+    uint8_t     pad;
+    int         len;
+    const char* text;
+    uint8_t     digest[KECCAK512_SW_DIGEST];
+} s_kat[] = {
+    { KECCAK_SW_PAD_KECCAK,   0, NULL,
+        {
+            0x0e, 0xab, 0x42, 0xde, 0x4c, 0x3c, 0xeb, 0x92, 0x35, 0xfc, 0x91, 0xac, 0xff, 0xe7, 0x46, 0xb2,
+            0x9c, 0x29, 0xa8, 0xc3, 0x66, 0xb7, 0xc6, 0x0e, 0x4e, 0x67, 0xc4, 0x66, 0xf3, 0x6a, 0x43, 0x04,
+            0xc0, 0x0f, 0xa9, 0xca, 0xf9, 0xd8, 0x79, 0x76, 0xba, 0x46, 0x9b, 0xcb, 0xe0, 0x67, 0x13, 0xb4,
+            0x35, 0xf0, 0x91, 0xef, 0x27, 0x69, 0xfb, 0x16, 0x0c, 0xda, 0xb3, 0x3d, 0x36, 0x70, 0x68, 0x0e } },
+    { KECCAK_SW_PAD_KECCAK,   3, "abc",
+        {
+            0x18, 0x58, 0x7d, 0xc2, 0xea, 0x10, 0x6b, 0x9a, 0x15, 0x63, 0xe3, 0x2b, 0x33, 0x12, 0x42, 0x1c,
+            0xa1, 0x64, 0xc7, 0xf1, 0xf0, 0x7b, 0xc9, 0x22, 0xa9, 0xc8, 0x3d, 0x77, 0xce, 0xa3, 0xa1, 0xe5,
+            0xd0, 0xc6, 0x99, 0x10, 0x73, 0x90, 0x25, 0x37, 0x2d, 0xc1, 0x4a, 0xc9, 0x64, 0x26, 0x29, 0x37,
+            0x95, 0x40, 0xc1, 0x7e, 0x2a, 0x65, 0xb1, 0x9d, 0x77, 0xaa, 0x51, 0x1a, 0x9d, 0x00, 0xbb, 0x96 } },
+    { KECCAK_SW_PAD_KECCAK, 200, NULL,
+        {
+            0xfc, 0xb5, 0x11, 0x64, 0x02, 0x85, 0x13, 0x85, 0x76, 0xfe, 0x34, 0x83, 0xd3, 0x94, 0x7e, 0x79,
+            0xf3, 0x78, 0x15, 0x90, 0x6c, 0x69, 0x6f, 0xcc, 0x38, 0xd1, 0x08, 0x03, 0x13, 0x0c, 0xb8, 0xa1,
+            0x79, 0x4d, 0x91, 0xf8, 0x5b, 0x95, 0xb3, 0xf7, 0xb8, 0xf7, 0x66, 0xe9, 0x19, 0xc4, 0xd5, 0xcd,
+            0xc8, 0x09, 0xb0, 0x7b, 0xf0, 0x8f, 0xc5, 0xae, 0x0a, 0x82, 0x3f, 0xf5, 0x2f, 0x9f, 0x81, 0x44 } },
+    { KECCAK_SW_PAD_SHA3,   0, NULL,
+        {
+            0xa6, 0x9f, 0x73, 0xcc, 0xa2, 0x3a, 0x9a, 0xc5, 0xc8, 0xb5, 0x67, 0xdc, 0x18, 0x5a, 0x75, 0x6e,
+            0x97, 0xc9, 0x82, 0x16, 0x4f, 0xe2, 0x58, 0x59, 0xe0, 0xd1, 0xdc, 0xc1, 0x47, 0x5c, 0x80, 0xa6,
+            0x15, 0xb2, 0x12, 0x3a, 0xf1, 0xf5, 0xf9, 0x4c, 0x11, 0xe3, 0xe9, 0x40, 0x2c, 0x3a, 0xc5, 0x58,
+            0xf5, 0x00, 0x19, 0x9d, 0x95, 0xb6, 0xd3, 0xe3, 0x01, 0x75, 0x85, 0x86, 0x28, 0x1d, 0xcd, 0x26 } },
+    { KECCAK_SW_PAD_SHA3,   3, "abc",
+        {
+            0xb7, 0x51, 0x85, 0x0b, 0x1a, 0x57, 0x16, 0x8a, 0x56, 0x93, 0xcd, 0x92, 0x4b, 0x6b, 0x09, 0x6e,
+            0x08, 0xf6, 0x21, 0x82, 0x74, 0x44, 0xf7, 0x0d, 0x88, 0x4f, 0x5d, 0x02, 0x40, 0xd2, 0x71, 0x2e,
+            0x10, 0xe1, 0x16, 0xe9, 0x19, 0x2a, 0xf3, 0xc9, 0x1a, 0x7e, 0xc5, 0x76, 0x47, 0xe3, 0x93, 0x40,
+            0x57, 0x34, 0x0b, 0x4c, 0xf4, 0x08, 0xd5, 0xa5, 0x65, 0x92, 0xf8, 0x27, 0x4e, 0xec, 0x53, 0xf0 } },
+    { KECCAK_SW_PAD_SHA3, 200, NULL,
+        {
+            0x2f, 0x1a, 0x4e, 0x74, 0x9b, 0x55, 0xd1, 0xe2, 0x33, 0xe6, 0x9b, 0xdb, 0x49, 0x4d, 0x00, 0xf5,
+            0xa2, 0x61, 0x15, 0x8a, 0xad, 0x4b, 0x55, 0x9d, 0x65, 0xe9, 0x94, 0xdb, 0xb1, 0xd4, 0x0f, 0xb0,
+            0xa7, 0xac, 0x37, 0x4a, 0x1f, 0x06, 0xe0, 0x4b, 0xc2, 0xbd, 0x69, 0xe0, 0xeb, 0x10, 0x33, 0xac,
+            0x8b, 0x65, 0x34, 0x41, 0x5e, 0xe7, 0x3b, 0x20, 0x70, 0x06, 0xf7, 0x5e, 0x49, 0x2d, 0x7b, 0xcd } }
+};
+
+/* --- */
+
+void test_keccak_sw_INIT()
+{
+
+}
+
+void test_keccak_sw_TEST()
+{
+    test_keccak_sw_known_answers();
+    test_keccak_sw_batch();
+    test_keccak_sw_benchmark();
+}
+
+void test_keccak_sw_FINALIZE()
+{
+
+}
+
+/* --- */
+
+void test_keccak_sw_known_answers()
+{
+    uint8_t        msg[256];
+    const uint8_t* msgs[KECCAK_SW_LANES_MAX];
+    uint8_t        digest[KECCAK_SW_LANES_MAX][KECCAK512_SW_DIGEST];
+    int            i, l;
+
+    for (l = 0; l < KECCAK_SW_LANES_MAX; l++) {
+        msgs[l] = msg;
+    }
+
+    for (i = 0; i < (int) (sizeof(s_kat) / sizeof(s_kat[0])); i++) {
+        int ok = 1;
+
+        if (s_kat[i].text) {
+            memcpy(msg, s_kat[i].text, s_kat[i].len);
+        } else {
+            memset(msg, 'A', s_kat[i].len);
+        }
+
+        keccak512_sw_hash(digest[0], msg, s_kat[i].len, s_kat[i].pad);
+        if (memcmp(digest[0], s_kat[i].digest, KECCAK512_SW_DIGEST)) {
+            ok = 0;
+        }
+
+        (void) keccak512_sw_hash_lanes(digest, msgs, s_kat[i].len, KECCAK_SW_LANES_MAX, s_kat[i].pad);
+        for (l = 0; l < KECCAK_SW_LANES_MAX; l++) {
+            if (memcmp(digest[l], s_kat[i].digest, KECCAK512_SW_DIGEST)) {
+                ok = 0;
+            }
+        }
+
+        fprintf(stderr, "INFO SW %s %3d bytes = 0x%02x%02x%02x%02x...%02x%02x%02x%02x  (%s)\n",
+                (s_kat[i].pad == KECCAK_SW_PAD_KECCAK) ?  "KECCAK-512" : "SHA3-512  ", s_kat[i].len,
+                digest[0][0], digest[0][1], digest[0][2], digest[0][3],
+                digest[0][60], digest[0][61], digest[0][62], digest[0][63], ok ?  "OK" : "FAILED");
+    }
+}
+
+void test_keccak_sw_batch()
+{
+    enum { BATCH_COUNT = 7 };
+    static const uint32_t lens[BATCH_COUNT] = { 64, 64, 64, 64, 64, 71, 72 };
+    uint8_t            msgs[BATCH_COUNT][80];
+    uint8_t            digest[BATCH_COUNT][KECCAK512_SW_DIGEST];
+    uint8_t            ref[KECCAK512_SW_DIGEST];
+    xy_keccak512_job_t jobs[BATCH_COUNT];
+    int                i, n, ok = 1;
+
+    for (i = 0; i < BATCH_COUNT; i++) {
+        memset(msgs[i], 'a' + i, sizeof(msgs[i]));
+        jobs[i].msg = msgs[i];
+        jobs[i].len = lens[i];
+    }
+
+    if (xy_keccak512_submit_batch(jobs, BATCH_COUNT) != BATCH_COUNT) {
+        fprintf(stderr, "ERROR test_keccak_sw_batch - submission failed\n");
+        return;
+    }
+    n = xy_keccak512_collect(digest, BATCH_COUNT);
+
+    for (i = 0; i < n; i++) {
+        keccak512_sw_hash(ref, msgs[i], lens[i], KECCAK_SW_PAD_KECCAK);
+        if (memcmp(ref, digest[i], KECCAK512_SW_DIGEST)) {
+            ok = 0;
+        }
+    }
+    fprintf(stderr, "INFO KECCAK-512 batch: %d of %d collected, PL engine %s  (%s)\n", n, BATCH_COUNT,
+            xy_keccak512_pl_available() ?  "reported" : "not available", (ok && n == BATCH_COUNT) ?  "OK" : "FAILED");
+}
+
+void test_keccak_sw_benchmark()
+{
+    fprintf(stderr, "INFO SW KECCAK-512 baseline = %11.1lf hashes/s\n", keccak512_sw_benchmark(0.25));
+}
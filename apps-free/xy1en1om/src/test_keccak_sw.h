@@ -0,0 +1,50 @@
+/*
+ * test_keccak_sw.h
+ *
+ *  Created on: 16.10.2016
+ *      Author: espero
+ */
+
+#ifndef APPS_FREE_XY1EN1OM_SRC_TEST_KECCAK_SW_H_
+#define APPS_FREE_XY1EN1OM_SRC_TEST_KECCAK_SW_H_
+
+
+/**
+ * @brief Initializing for validity check of the software Keccak-512 engine
+ *
+ */
+void test_keccak_sw_INIT();
+
+/**
+ * @brief Testing and doing the validity check of the software Keccak-512 engine
+ *
+ */
+void test_keccak_sw_TEST();
+
+/**
+ * @brief Finalizing for validity check of the software Keccak-512 engine
+ *
+ */
+void test_keccak_sw_FINALIZE();
+
+
+/**
+ * @brief Check validity of the scalar and the SIMD code against Keccak-512 and SHA3-512 known answers
+ *
+ */
+void test_keccak_sw_known_answers();
+
+/**
+ * @brief Check the batched Keccak-512 driver interface against the scalar code
+ *
+ */
+void test_keccak_sw_batch();
+
+/**
+ * @brief Reports the CPU baseline of the software engine in hashes/s
+ *
+ */
+void test_keccak_sw_benchmark();
+
+
+#endif /* APPS_FREE_XY1EN1OM_SRC_TEST_KECCAK_SW_H_ */
@@ -0,0 +1,154 @@
+/**
+ * @brief Red Pitaya Validity tester for the hash pipeline scheduler
+ * of the xy1en1om sub-module.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_pipeline.h"
+#include "pipeline.h"
+#include "sha256_sw.h"
+#include "keccak_sw.h"
+
+
+/** @brief Count of block headers run through the chain */
+#define TEST_PIPELINE_COUNT     1024
+
+/** @brief Length of a block header */
+#define TEST_PIPELINE_LEN       80
+
+
+/* --- */
+
+void test_pipeline_INIT()
+{
+
+}
+
+void test_pipeline_TEST()
+{
+    test_pipeline_x11_prefix();
+    test_pipeline_fpga_shared();
+}
+
+void test_pipeline_FINALIZE()
+{
+
+}
+
+/* --- */
+
+static void test_pipeline_header(uint8_t hdr[TEST_PIPELINE_LEN], uint32_t nonce)
+{
+    memset(hdr, 0x5a, TEST_PIPELINE_LEN);
+    memcpy(hdr + 76, &nonce, sizeof(nonce));
+}
+
+/** @brief Serial reference of the chain, returns the length of the final digest */
+static int test_pipeline_reference(uint8_t ref[PIPELINE_ITEM_MAX], const pipeline_stage_cfg_t* cfg, int stages, uint32_t nonce)
+{
+    uint8_t  msg[PIPELINE_ITEM_MAX];
+    uint32_t h[SHA256_SW_HASH_WORDS];
+    int len = TEST_PIPELINE_LEN;
+    int i;
+
+    test_pipeline_header(msg, nonce);
+    for (i = 0; i < stages; i++) {
+        if (cfg[i].hash == pipeline_hash_keccak512) {
+            keccak512_sw_hash(ref, msg, len, KECCAK_SW_PAD_KECCAK);
+            len = KECCAK512_SW_DIGEST;
+        } else {
+            sha256_sw_hash(h, msg, len, cfg[i].hash == pipeline_hash_sha256d);
+            sha256_sw_to_bytes(ref, h);
+            len = 32;
+        }
+        memcpy(msg, ref, len);
+    }
+    return len;
+}
+
+/** @brief Runs TEST_PIPELINE_COUNT block headers through the chain and compares with the serial computation */
+static void test_pipeline_run(const pipeline_stage_cfg_t* cfg, int stages, const char* name)
+{
+    uint8_t  hdr[TEST_PIPELINE_LEN];
+    uint8_t  digest[PIPELINE_ITEM_MAX];
+    uint8_t  ref[PIPELINE_ITEM_MAX];
+    uint32_t id;
+    int submitted = 0, collected = 0, errors = 0;
+    int i, len, ref_len;
+
+    /* the pipeline is a single instance - never tear down the one of the app */
+    if (pipeline_running()) {
+        fprintf(stderr, "INFO pipeline %s: skipped, the pipeline of the app is running\n", name);
+        return;
+    }
+
+    if (pipeline_init(cfg, stages)) {
+        fprintf(stderr, "ERROR test_pipeline_run - pipeline_init() failed\n");
+        return;
+    }
+
+    while (collected < TEST_PIPELINE_COUNT) {
+        /* keep the first queue filled, the scheduler threads work meanwhile */
+        while (submitted < TEST_PIPELINE_COUNT) {
+            test_pipeline_header(hdr, submitted);
+            if (pipeline_submit(submitted, hdr, TEST_PIPELINE_LEN)) {
+                break;
+            }
+            submitted++;
+        }
+
+        len = pipeline_collect(&id, digest, 1);
+        if (len < 0) {
+            break;
+        }
+        collected++;
+
+        ref_len = test_pipeline_reference(ref, cfg, stages, id);
+        if (len != ref_len || memcmp(ref, digest, ref_len)) {
+            errors++;
+        }
+    }
+
+    for (i = 0; i < stages; i++) {
+        pipeline_stage_stats_t st;
+
+        if (!pipeline_get_stats(i, &st)) {
+            fprintf(stderr, "INFO pipeline stage %d (%s): done = %llu, fallbacks = %llu, queue avg = %5.1lf peak = %2d, occupancy = %5.3lf, %11.1lf items/s\n",
+                    i, (st.backend == pipeline_backend_fpga) ?  "FPGA" : "CPU ", (unsigned long long) st.done, (unsigned long long) st.fallbacks,
+                    st.queued_avg, st.queued_peak, st.occupancy, st.throughput);
+        }
+    }
+    fprintf(stderr, "INFO pipeline %s: %d of %d collected  (%s)\n",
+            name, collected, TEST_PIPELINE_COUNT, (!errors && collected == TEST_PIPELINE_COUNT) ?  "OK" : "FAILED");
+
+    pipeline_exit();
+}
+
+void test_pipeline_x11_prefix()
+{
+    static const pipeline_stage_cfg_t cfg[] = {
+        { pipeline_hash_sha256d,    pipeline_backend_auto },
+        { pipeline_hash_keccak512,  pipeline_backend_auto }
+    };
+
+    test_pipeline_run(cfg, sizeof(cfg) / sizeof(cfg[0]), "SHA-256d -> KECCAK-512");
+}
+
+void test_pipeline_fpga_shared()
+{
+    static const pipeline_stage_cfg_t cfg[] = {
+        { pipeline_hash_sha256d,    pipeline_backend_auto },
+        { pipeline_hash_sha256,     pipeline_backend_auto },
+        { pipeline_hash_keccak512,  pipeline_backend_auto }
+    };
+
+    test_pipeline_run(cfg, sizeof(cfg) / sizeof(cfg[0]), "SHA-256d -> SHA-256 -> KECCAK-512");
+}
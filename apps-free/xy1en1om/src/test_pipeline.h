@@ -0,0 +1,44 @@
+/*
+ * test_pipeline.h
+ *
+ *  Created on: 16.10.2016
+ *      Author: espero
+ */
+
+#ifndef APPS_FREE_XY1EN1OM_SRC_TEST_PIPELINE_H_
+#define APPS_FREE_XY1EN1OM_SRC_TEST_PIPELINE_H_
+
+
+/**
+ * @brief Initializing for validity check of the hash pipeline scheduler
+ *
+ */
+void test_pipeline_INIT();
+
+/**
+ * @brief Testing and doing the validity check of the hash pipeline scheduler
+ *
+ */
+void test_pipeline_TEST();
+
+/**
+ * @brief Finalizing for validity check of the hash pipeline scheduler
+ *
+ */
+void test_pipeline_FINALIZE();
+
+
+/**
+ * @brief Runs block headers through the SHA-256d / Keccak-512 chain and compares with the serial computation
+ *
+ */
+void test_pipeline_x11_prefix();
+
+/**
+ * @brief Runs two SHA-256 stages, both on the one FPGA engine when it is available, and compares with the serial computation
+ *
+ */
+void test_pipeline_fpga_shared();
+
+
+#endif /* APPS_FREE_XY1EN1OM_SRC_TEST_PIPELINE_H_ */
@@ -15,11 +15,11 @@
 #include <string.h>
 #include <pthread.h>
 #include <sys/time.h>
-//#include <asm/cachectl.h>
 
 #include "test_sha256_dma.h"
 #include "main.h"
 #include "fpga_xy.h"
+#include "xy_stats.h"
 
 
 const uint64_t testmsg_rom[] = {
@@ -70,24 +70,17 @@ extern pthread_mutex_t      g_xy_info_worker_params_mutex;
 /** @brief The xy1en1om memory layout of the FPGA registers. */
 extern fpga_xy_reg_mem_t*   g_fpga_xy_reg_mem;
 
-/* @brief DMA memory as virtual memory seen by the software module */
-void* g_dma_buf = NULL;
-
-/* @brief DMA memory as physical memory seen by the FPGA on the AMBA bus */
-intptr_t g_dma_paddr = 0;
+/** @brief The xy1en1om DMA ring for the SHA-256 DMA engine. */
+extern dma_ring_t           g_fpga_xy_dma_ring;
+/** @brief The xy1en1om register backend in use. */
+extern fpga_xy_backend_t    g_fpga_xy_backend;
 
 
 /* --- */
 
 void test_sha256_dma_INIT()
 {
-#if 1
-    // get DMA memory on a 4kB page - this allows axi_datamover_s_axi_hp0 to operate with the basic command mode
-    g_dma_buf = valloc(1UL << 12);  // 4kB
-#else
-    // get DMA memory on an 64bit-alignment (at least)
-    posix_memalign(&g_dma_buf, sizeof(uint64_t), 1UL << 20);
-#endif
+
 }
 
 void test_sha256_dma_TEST()
@@ -97,11 +90,7 @@ void test_sha256_dma_TEST()
 
 void test_sha256_dma_FINALIZE()
 {
-    if (g_dma_buf) {
-        g_dma_paddr = 0;
-        free(g_dma_buf);
-        g_dma_buf = NULL;
-    }
+
 }
 
 /* --- */
@@ -111,101 +100,58 @@ void test_sha256_dma_blockchain_example()
 {
     uint32_t h7, h6, h5, h4, h3, h2, h1, h0;
     uint32_t status = 0;
+    dma_ring_slot_t slot;
     struct timeval t0 = { 0 };
     struct timeval t1 = { 0 };
     struct timeval t2 = { 0 };
     struct timeval t3 = { 0 };
+    uint64_t ts_setup, ts_wait;
+
+    fpga_xy_reset();
 
     // ---
     // Prepare DMA memory
+    ts_setup = xy_stats_now();
     {
-        if (!g_dma_buf)
+        // the slot is page aligned - this allows axi_datamover_s_axi_hp0 to operate with the basic command mode
+        if (dma_ring_get_slot(&g_fpga_xy_dma_ring, &slot)) {
+            fprintf(stderr, "ERROR test_sha256_dma_blockchain_example - no DMA slot available\n");
             return;
-
-        // prepare the DMA data
-        (void) memcpy(g_dma_buf, testmsg_rom, sizeof(testmsg_rom));
-
-        // flush the D-cache
-        {
-            FILE *dropcaches;
-            if ((dropcaches = fopen("/proc/sys/vm/drop_caches", "w"))) {
-                fprintf(stderr, "dropping caches. Got filehandle = %p, filehandle ID = %d\n", dropcaches, fileno(dropcaches));
-                fprintf(dropcaches, "1\n");
-                fclose(dropcaches);
-            }
         }
 
-        {
-            // https://www.kernel.org/doc/Documentation/vm/pagemap.txt
-            FILE *pagemap;
-            intptr_t paddr = 0;
-            uint64_t e;
-            int offset = (((uint32_t) g_dma_buf) / sysconf(_SC_PAGESIZE)) * sizeof(uint64_t);
-
-            //fprintf(stderr, "INFO sysconf(_SC_PAGESIZE) = %ld, sizeof(uint64_t) = %d, offset = %d\n", sysconf(_SC_PAGESIZE), sizeof(uint64_t), offset);
-
-            if ((pagemap = fopen("/proc/self/pagemap", "r"))) {
-                if (lseek(fileno(pagemap), offset, SEEK_SET) == offset) {
-                    if (fread(&e, sizeof(uint64_t), 1, pagemap)) {
-                        if (e & (1ULL << 63)) { // page present ?
-                            paddr  = e & ((1ULL << 55) - 1); // pfn mask
-                            paddr *= sysconf(_SC_PAGESIZE);
-                            // add offset within page
-                            paddr |= (((uint32_t) g_dma_buf) & (sysconf(_SC_PAGESIZE) - 1));
-                        }
-                    }
-                }
-                fclose(pagemap);
-            }
-            g_dma_paddr = paddr;
-
-            fprintf(stderr, "INFO g_dma_buf = %p\tg_dma_paddr = 0x%08x\n", g_dma_buf, g_dma_paddr);
-        }
+        // prepare the DMA data and clean the D-cache lines of this slot, only
+        (void) memcpy(slot.virt, testmsg_rom, sizeof(testmsg_rom));
+        dma_ring_sync_slot(&g_fpga_xy_dma_ring, &slot, sizeof(testmsg_rom), dma_ring_to_device);
+
+        fprintf(stderr, "INFO slot.virt = %p\tslot.phys = 0x%08x\n", slot.virt, slot.phys);
     }
 
     // ---
 
-    fpga_xy_reset();
-
     (void) gettimeofday(&t0, NULL);
-    g_fpga_xy_reg_mem->sha256_dma_base_addr = g_dma_paddr;    // SHA256 DMA - base address
+    g_fpga_xy_reg_mem->sha256_dma_base_addr = slot.phys;      // SHA256 DMA - base address
     g_fpga_xy_reg_mem->sha256_dma_bit_len   = sizeof(testmsg_rom) << 3;  // SHA256 DMA - bit len
     g_fpga_xy_reg_mem->sha256_dma_nonce_ofs = 0x00000260;     // SHA256 DMA - nonce entry offset in bits
-    g_fpga_xy_reg_mem->sha256_ctrl          = 0x00000033;     // SHA256 control: DMA_START | DBL_HASH | DMA_MODE | RESET trigger | ENABLE
-    g_fpga_xy_reg_mem->sha256_ctrl          = 0x000000B1;     // SHA256 control: DMA_START | DBL_HASH | DMA_MODE | RESET trigger | ENABLE
+    FPGA_XY_REG_WR(sha256_ctrl, 0x00000033);                  // SHA256 control: DMA_START | DBL_HASH | DMA_MODE | RESET trigger | ENABLE
+    FPGA_XY_REG_WR(sha256_ctrl, 0x000000B1);                  // SHA256 control: DMA_START | DBL_HASH | DMA_MODE | RESET trigger | ENABLE
     (void) gettimeofday(&t1, NULL);  // t1-t0 = x.xµs
+    xy_stats_record(xy_stats_dma_setup, ts_setup);
 
     // wait until ready
-    const int maxiter = 256;
-    int iter = maxiter;
-    status = g_fpga_xy_reg_mem->sha256_status;
-    while (!(status & (1L << 1)) && iter) {
-#if 0
-        uint32_t fifo_wr_cnt          = g_fpga_xy_reg_mem->sha256_fifo_wr_count;
-        uint32_t fifo_rd_cnt          = g_fpga_xy_reg_mem->sha256_fifo_rd_count;
-        //uint32_t fifo_rd_last         = g_fpga_xy_reg_mem->sha256_data_push;
-        uint32_t dma_state            = g_fpga_xy_reg_mem->sha256_dma_state;
-        uint32_t dma_axi_r_state      = g_fpga_xy_reg_mem->sha256_dma_axi_r_state;
-        uint32_t dma_axi_w_state      = g_fpga_xy_reg_mem->sha256_dma_axi_w_state;
-        uint32_t sha256_dma_last_data = g_fpga_xy_reg_mem->sha256_dma_last_data;
-        fprintf(stderr, "INFO waiting - status = %08x,  " \
-                "fifo_wr_cnt = %03d, fifo_rd_cnt = %03d,  " \
-                "fifo_rd_last = 0x%08x,  " \
-                "dma_state = 0x%02x,  " \
-                "dma_axi_r_state = 0x%08x, dma_axi_w_state = 0x%08x,  " \
-                "sha256_dma_last_data = 0x%08x\n",
-                status,
-                fifo_wr_cnt, fifo_rd_cnt,
-                0, //fifo_rd_last,
-                dma_state,
-                dma_axi_r_state, dma_axi_w_state,
-                sha256_dma_last_data);
-#endif
+    ts_wait = xy_stats_now();
+    if (xy_sha256_wait(SHA256_STAT_HASH_VALID)) {
         status = g_fpga_xy_reg_mem->sha256_status;
-       --iter;
+        fprintf(stderr, "ERROR test_sha256_dma_blockchain_example - no hash value presented, status = %08x, " \
+                "dma_state = 0x%02x, dma_axi_r_state = 0x%08x, dma_axi_w_state = 0x%08x, sha256_dma_last_data = 0x%08x\n",
+                status,
+                g_fpga_xy_reg_mem->sha256_dma_state,
+                g_fpga_xy_reg_mem->sha256_dma_axi_r_state, g_fpga_xy_reg_mem->sha256_dma_axi_w_state,
+                g_fpga_xy_reg_mem->sha256_dma_last_data);
     }
     (void) gettimeofday(&t2, NULL);  // t2-t0 = x.xµs
+    xy_stats_record(xy_stats_wait, ts_wait);
 
+    ts_wait = xy_stats_now();
     h7 = g_fpga_xy_reg_mem->sha256_hash_h7;
     h6 = g_fpga_xy_reg_mem->sha256_hash_h6;
     h5 = g_fpga_xy_reg_mem->sha256_hash_h5;
@@ -215,6 +161,8 @@ void test_sha256_dma_blockchain_example()
     h1 = g_fpga_xy_reg_mem->sha256_hash_h1;
     h0 = g_fpga_xy_reg_mem->sha256_hash_h0;
     (void) gettimeofday(&t3, NULL);  // t3-t0 = x.xµs
+    xy_stats_record(xy_stats_readout, ts_wait);
+    xy_stats_count_hashes(1);
 
     uint32_t sha256_dma_clock_start    =  g_fpga_xy_reg_mem->sha256_dma_clock_start;
     uint32_t sha256_dma_clock_last     =  g_fpga_xy_reg_mem->sha256_dma_clock_last;
@@ -226,8 +174,8 @@ void test_sha256_dma_blockchain_example()
     uint32_t sha256_eng_state_loop     =  g_fpga_xy_reg_mem->sha256_eng_state_loop;
 
     fpga_xy_enable(0);
+    (void) dma_ring_put_slot(&g_fpga_xy_dma_ring);
 
-    fprintf(stderr, "INFO waiting iterations = %d\n", maxiter - iter);
     fprintf(stderr, "INFO DMA-FIFO    starting clock = %d last_dta clock = %d, time used = %05d clocks = %11.6lf µs\n",
             sha256_dma_clock_start, sha256_dma_clock_last,     sha256_dma_clock_last     - sha256_dma_clock_start, (sha256_dma_clock_last - sha256_dma_clock_start) / 125.0);
     fprintf(stderr, "INFO DMA-FIFO    starting clock = %d stopping clock = %d, time used = %05d clocks = %11.6lf µs\n",
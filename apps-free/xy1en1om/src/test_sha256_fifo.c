@@ -10,12 +10,14 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <pthread.h>
 #include <sys/time.h>
 
 #include "test_sha256_fifo.h"
 #include "main.h"
 #include "fpga_xy.h"
+#include "sha256_sw.h"
 
 
 /** @brief CallBack copy of params from the worker when requested */
@@ -25,6 +27,8 @@ extern pthread_mutex_t      g_xy_info_worker_params_mutex;
 
 /** @brief The xy1en1om memory layout of the FPGA registers. */
 extern fpga_xy_reg_mem_t*   g_fpga_xy_reg_mem;
+/** @brief The xy1en1om register backend in use. */
+extern fpga_xy_backend_t    g_fpga_xy_backend;
 
 /* --- */
 
@@ -44,8 +48,10 @@ void test_sha256_fifo_TEST()
     test_sha256_fifo_55x_A();
 #elif 0
     test_sha256_fifo_56x_A();
-#else
+#elif 0
     test_sha256_fifo_119x_A();
+#else
+    test_sha256_fifo_batch();
 #endif
 
 }
@@ -60,7 +66,6 @@ void test_sha256_fifo_FINALIZE()
 void test_sha256_fifo_1x_A()
 {
     uint32_t h7, h6, h5, h4, h3, h2, h1, h0;
-    uint32_t state = 0;
     struct timeval t0 = { 0 };
     struct timeval t1 = { 0 };
     struct timeval t2 = { 0 };
@@ -71,28 +76,28 @@ void test_sha256_fifo_1x_A()
     // write data to the FIFO - MSB first
     // variant 1: have a single letter 'A'
     (void) gettimeofday(&t0, NULL);
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41800000;         // SHA256 FIFO MSB - #0 - one bit after the last data message is set
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #0
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #1
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #1
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #2
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #2
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #3
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #3
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #4
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #4
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #5
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #5
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #6
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #6
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #7
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000008;         // SHA256 FIFO LSB - #7
+    FPGA_XY_REG_WR(sha256_data_push, 0x41800000);             // SHA256 FIFO MSB - #0 - one bit after the last data message is set
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #0
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #1
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #1
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #2
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #2
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #3
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #3
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #4
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #4
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #5
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #5
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #6
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #6
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #7
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000008);             // SHA256 FIFO LSB - #7
     (void) gettimeofday(&t1, NULL);  // t1-t0 = 3.5µs
 
     // wait until ready
-    state = g_fpga_xy_reg_mem->sha256_status;
-    while (!(state & (1L << 1)))
-        state = g_fpga_xy_reg_mem->sha256_status;
+    if (xy_sha256_wait(SHA256_STAT_HASH_VALID)) {
+        fprintf(stderr, "ERROR test_sha256_fifo_1x_A - no hash value presented\n");
+    }
     (void) gettimeofday(&t2, NULL);  // t2-t0 = 5.9µs
 
     h7 = g_fpga_xy_reg_mem->sha256_hash_h7;
@@ -118,7 +123,6 @@ void test_sha256_fifo_1x_A()
 void test_sha256_fifo_2x_A()
 {
     uint32_t h7, h6, h5, h4, h3, h2, h1, h0;
-    uint32_t state = 0;
     struct timeval t0 = { 0 };
     struct timeval t1 = { 0 };
     struct timeval t2 = { 0 };
@@ -129,28 +133,28 @@ void test_sha256_fifo_2x_A()
     // write data to the FIFO - MSB first
     // variant 2: have a double letter 'A'
     (void) gettimeofday(&t0, NULL);
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41418000;         // SHA256 FIFO MSB - #0 - one bit after the last data message is set
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #0
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #1
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #1
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #2
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #2
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #3
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #3
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #4
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #4
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #5
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #5
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #6
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #6
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #7
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000010;         // SHA256 FIFO LSB - #7
+    FPGA_XY_REG_WR(sha256_data_push, 0x41418000);             // SHA256 FIFO MSB - #0 - one bit after the last data message is set
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #0
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #1
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #1
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #2
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #2
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #3
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #3
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #4
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #4
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #5
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #5
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #6
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #6
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #7
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000010);             // SHA256 FIFO LSB - #7
     (void) gettimeofday(&t1, NULL);  // t1-t0 = 4µs
 
     // wait until ready
-    state = g_fpga_xy_reg_mem->sha256_status;
-    while (!(state & (1L << 1)))
-        state = g_fpga_xy_reg_mem->sha256_status;
+    if (xy_sha256_wait(SHA256_STAT_HASH_VALID)) {
+        fprintf(stderr, "ERROR test_sha256_fifo_2x_A - no hash value presented\n");
+    }
     (void) gettimeofday(&t2, NULL);  // t2-t0 = 6.5µs
 
     h7 = g_fpga_xy_reg_mem->sha256_hash_h7;
@@ -176,7 +180,6 @@ void test_sha256_fifo_2x_A()
 void test_sha256_fifo_55x_A()
 {
     uint32_t h7, h6, h5, h4, h3, h2, h1, h0;
-    uint32_t state = 0;
     struct timeval t0 = { 0 };
     struct timeval t1 = { 0 };
     struct timeval t2 = { 0 };
@@ -187,28 +190,28 @@ void test_sha256_fifo_55x_A()
     // write data to the FIFO - MSB first
     // variant 2: have a double letter 'A'
     (void) gettimeofday(&t0, NULL);
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #0
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #0
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #1
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #1
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #2
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #2
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #3
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #3
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #4
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #4
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #5
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #5
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #6
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414180;         // SHA256 FIFO LSB - #6 - one bit after the last data message is set
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #7
-    g_fpga_xy_reg_mem->sha256_data_push = 0x000001B8;         // SHA256 FIFO LSB - #7
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #0
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #0
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #1
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #1
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #2
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #2
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #3
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #3
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #4
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #4
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #5
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #5
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #6
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414180);             // SHA256 FIFO LSB - #6 - one bit after the last data message is set
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #7
+    FPGA_XY_REG_WR(sha256_data_push, 0x000001B8);             // SHA256 FIFO LSB - #7
     (void) gettimeofday(&t1, NULL);  // t1-t0 = 4µs
 
     // wait until ready
-    state = g_fpga_xy_reg_mem->sha256_status;
-    while (!(state & (1L << 1)))
-        state = g_fpga_xy_reg_mem->sha256_status;
+    if (xy_sha256_wait(SHA256_STAT_HASH_VALID)) {
+        fprintf(stderr, "ERROR test_sha256_fifo_55x_A - no hash value presented\n");
+    }
     (void) gettimeofday(&t2, NULL);  // t2-t0 = 6µs
 
     h7 = g_fpga_xy_reg_mem->sha256_hash_h7;
@@ -234,7 +237,6 @@ void test_sha256_fifo_55x_A()
 void test_sha256_fifo_56x_A()
 {
     uint32_t h7, h6, h5, h4, h3, h2, h1, h0;
-    uint32_t state = 0;
     struct timeval t0 = { 0 };
     struct timeval t1 = { 0 };
     struct timeval t2 = { 0 };
@@ -245,45 +247,45 @@ void test_sha256_fifo_56x_A()
     // write data to the FIFO - MSB first
     // variant 2: have a double letter 'A'
     (void) gettimeofday(&t0, NULL);
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #0
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #0
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #1
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #1
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #2
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #2
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #3
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #3
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #4
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #4
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #5
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #5
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #6
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #6
-    g_fpga_xy_reg_mem->sha256_data_push = 0x80000000;         // SHA256 FIFO MSB - #7 - one bit after the last data message is set
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #7
-
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #8
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #8
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #9
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #9
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #10
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #10
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #11
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #11
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #12
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #12
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #13
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #13
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #14
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO LSB - #14
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #15
-    g_fpga_xy_reg_mem->sha256_data_push = 0x000001C0;         // SHA256 FIFO LSB - #15
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #0
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #0
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #1
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #1
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #2
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #2
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #3
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #3
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #4
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #4
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #5
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #5
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #6
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #6
+    FPGA_XY_REG_WR(sha256_data_push, 0x80000000);             // SHA256 FIFO MSB - #7 - one bit after the last data message is set
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #7
+
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #8
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #8
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #9
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #9
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #10
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #10
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #11
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #11
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #12
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #12
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #13
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #13
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #14
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO LSB - #14
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #15
+    FPGA_XY_REG_WR(sha256_data_push, 0x000001C0);             // SHA256 FIFO LSB - #15
     (void) gettimeofday(&t1, NULL);  // t1-t0 = 6µs
 
     // wait until ready
-    state = g_fpga_xy_reg_mem->sha256_status;
-    while (!(state & (1L << 1)))
-        state = g_fpga_xy_reg_mem->sha256_status;
+    if (xy_sha256_wait(SHA256_STAT_HASH_VALID)) {
+        fprintf(stderr, "ERROR test_sha256_fifo_56x_A - no hash value presented\n");
+    }
     (void) gettimeofday(&t2, NULL);  // t2-t0 = 8.7µs
 
     h7 = g_fpga_xy_reg_mem->sha256_hash_h7;
@@ -309,7 +311,6 @@ void test_sha256_fifo_56x_A()
 void test_sha256_fifo_119x_A()
 {
     uint32_t h7, h6, h5, h4, h3, h2, h1, h0;
-    uint32_t state = 0;
     struct timeval t0 = { 0 };
     struct timeval t1 = { 0 };
     struct timeval t2 = { 0 };
@@ -320,45 +321,45 @@ void test_sha256_fifo_119x_A()
     // write data to the FIFO - MSB first
     // variant 2: have a double letter 'A'
     (void) gettimeofday(&t0, NULL);
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #0
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #0
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #1
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #1
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #2
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #2
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #3
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #3
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #4
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #4
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #5
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #5
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #6
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #6
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #7
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #7
-
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #8
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #8
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #9
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #9
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #10
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #10
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #11
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #11
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #12
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #12
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #13
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO LSB - #13
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414141;         // SHA256 FIFO MSB - #14
-    g_fpga_xy_reg_mem->sha256_data_push = 0x41414180;         // SHA256 FIFO LSB - #14 - one bit after the last data message is set
-    g_fpga_xy_reg_mem->sha256_data_push = 0x00000000;         // SHA256 FIFO MSB - #15
-    g_fpga_xy_reg_mem->sha256_data_push = 0x000003B8;         // SHA256 FIFO LSB - #15
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #0
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #0
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #1
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #1
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #2
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #2
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #3
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #3
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #4
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #4
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #5
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #5
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #6
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #6
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #7
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #7
+
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #8
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #8
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #9
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #9
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #10
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #10
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #11
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #11
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #12
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #12
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #13
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO LSB - #13
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414141);             // SHA256 FIFO MSB - #14
+    FPGA_XY_REG_WR(sha256_data_push, 0x41414180);             // SHA256 FIFO LSB - #14 - one bit after the last data message is set
+    FPGA_XY_REG_WR(sha256_data_push, 0x00000000);             // SHA256 FIFO MSB - #15
+    FPGA_XY_REG_WR(sha256_data_push, 0x000003B8);             // SHA256 FIFO LSB - #15
     (void) gettimeofday(&t1, NULL);  // t1-t0 = 6.2µs
 
     // wait until ready
-    state = g_fpga_xy_reg_mem->sha256_status;
-    while (!(state & (1L << 1)))
-        state = g_fpga_xy_reg_mem->sha256_status;
+    if (xy_sha256_wait(SHA256_STAT_HASH_VALID)) {
+        fprintf(stderr, "ERROR test_sha256_fifo_119x_A - no hash value presented\n");
+    }
     (void) gettimeofday(&t2, NULL);  // t2-t0 = 9.2µs
 
     h7 = g_fpga_xy_reg_mem->sha256_hash_h7;
@@ -380,3 +381,48 @@ void test_sha256_fifo_119x_A()
     fprintf(stderr, "INFO t2 = %ld.%06ld\n", t2.tv_sec, t2.tv_usec);
     fprintf(stderr, "INFO t3 = %ld.%06ld\n", t3.tv_sec, t3.tv_usec);
 }
+
+void test_sha256_fifo_batch()
+{
+    static const int lens[] = { 1, 2, 55, 56, 119 };
+    const int        cnt    = sizeof(lens) / sizeof(lens[0]);
+    uint8_t          msg[128];
+    xy_sha256_job_t  jobs[2 * (sizeof(lens) / sizeof(lens[0]))];
+    uint32_t         h[2 * (sizeof(lens) / sizeof(lens[0]))][8];
+    struct timeval   t0 = { 0 };
+    struct timeval   t1 = { 0 };
+    int              i, n;
+
+    memset(msg, 'A', sizeof(msg));
+    for (i = 0; i < (cnt << 1); i++) {
+        jobs[i].msg = msg;
+        jobs[i].len = lens[i % cnt];
+        jobs[i].dbl = (i >= cnt);
+    }
+
+    (void) gettimeofday(&t0, NULL);
+    (void) xy_sha256_submit_batch(jobs, cnt << 1);
+    n = xy_sha256_collect(h, cnt << 1);
+    (void) gettimeofday(&t1, NULL);
+
+    fpga_xy_enable(0);
+
+    for (i = 0; i < n; i++) {
+        fprintf(stderr, "INFO HASH %s %3dx 'A' = 0x%08x%08x%08x%08x%08x%08x%08x%08x  (%s)\n", jobs[i].dbl ?  "dbl" : "sgl", jobs[i].len,
+                h[i][0], h[i][1], h[i][2], h[i][3], h[i][4], h[i][5], h[i][6], h[i][7],
+                sha256_sw_verify(h[i], jobs[i].msg, jobs[i].len, jobs[i].dbl) ?  "OK" : "FAILED");
+    }
+    fprintf(stderr, "INFO collected = %d, t1-t0 = %ldus\n", n, (t1.tv_sec - t0.tv_sec) * 1000000L + (t1.tv_usec - t0.tv_usec));
+
+    {
+        static const char* phase[xy_wait_phases] = { "spin ", "yield", "block" };
+        xy_wait_stats_t st;
+
+        xy_wait_get_stats(&st, 1);
+        for (i = 0; i < xy_wait_phases; i++) {
+            fprintf(stderr, "INFO wait %s: done = %llu, avg = %8.3lfus, max = %8.3lfus\n", phase[i], (unsigned long long) st.done[i],
+                    st.done[i] ?  (st.lat_sum_ns[i] / 1000.0 / st.done[i]) : 0.0, st.lat_max_ns[i] / 1000.0);
+        }
+        fprintf(stderr, "INFO wait timeouts = %llu, interrupt = %s\n", (unsigned long long) st.timeouts, st.irq ?  "UIO" : "none");
+    }
+}
@@ -58,5 +58,11 @@ void test_sha256_fifo_56x_A();
  */
 void test_sha256_fifo_119x_A();
 
+/**
+ * @brief Check validity of the batched FIFO interface with all letter 'A' messages, cross-checked by the software engine
+ *
+ */
+void test_sha256_fifo_batch();
+
 
 #endif /* APPS_FREE_XY1EN1OM_SRC_TEST_SHA256_FIFO_H_ */
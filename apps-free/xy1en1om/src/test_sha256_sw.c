@@ -0,0 +1,174 @@
+/**
+ * @brief Red Pitaya Validity tester for the software SHA-256 engine
+ * of the xy1en1om sub-module.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_sha256_sw.h"
+#include "sha256_sw.h"
+
+
+/** @brief Known answers for messages of n letters 'A', the same references as used by test_sha256_fifo.c */
+static const struct {
+    int      len;
+    uint32_t h[SHA256_SW_HASH_WORDS];
+} s_kat_A[] = {
+    {   1, { 0x559aead0, 0x8264d579, 0x5d390971, 0x8cdd05ab, 0xd49572e8, 0x4fe55590, 0xeef31a88, 0xa08fdffd } },
+    {   2, { 0x58bb119c, 0x35513a45, 0x1d24dc20, 0xef0e9031, 0xec85b35b, 0xfc919d26, 0x3e7e5d98, 0x68909cb5 } },
+    {  55, { 0x8963cc0a, 0xfd622cc7, 0x574ac201, 0x1f93a305, 0x9b3d6554, 0x8a77542a, 0x1559e3d2, 0x02e6ab00 } },
+    {  56, { 0x6ea719ce, 0xfa4b3186, 0x2035a7fa, 0x606b7cc3, 0x602f4623, 0x1117d135, 0xcc7119b3, 0xc1412314 } },
+    { 119, { 0x17d2f0f7, 0x197a6612, 0xe311d141, 0x781f2b95, 0x39c4aef7, 0xaffd7292, 0x46c40189, 0x0e000dde } }
+};
+
+/** @brief Known answers of SHA-256d for messages of n letters 'A' */
+static const struct {
+    int      len;
+    uint32_t h[SHA256_SW_HASH_WORDS];
+} s_kat_A_dbl[] = {
+    {   1, { 0x1cd6ef71, 0xe6e0ff46, 0xad2609d4, 0x03dc3fee, 0x24441708, 0x9aa44612, 0x45a4e4fe, 0x23a55e42 } },
+    {   2, { 0x01e0655f, 0xb754d104, 0x18a73760, 0xf57515f4, 0x903b298e, 0x6d67dda6, 0xbf0987fa, 0x79c22c88 } },
+    {  55, { 0xff7d9978, 0x045a76d7, 0x4350c1b7, 0x866cf3cf, 0xe058a8c6, 0x249213a6, 0x9aed843b, 0xa1e1680f } },
+    {  56, { 0xf4570ea6, 0x735a75a8, 0x554515d0, 0xbf8782cd, 0xe2916a74, 0xc07a7403, 0x8b5f610b, 0x677f3a3f } },
+    { 119, { 0xa92a39ec, 0x5fbe3bf3, 0xd35f4f67, 0x003a3f6d, 0xcf4bc0db, 0xc9bc5a83, 0xc0b4e092, 0xd2730a23 } }
+};
+
+/** @brief Batch sizes up to two helper thread halves of 8-lane and 4-lane groups plus a scalar remainder */
+#define TEST_SHA256_SW_BATCH_MAX    (((SHA256_SW_LANES_MAX << 1) << 1) + SHA256_SW_LANES + 3)
+
+/** @brief Block header size, the stride leaves a gap between the messages */
+#define TEST_SHA256_SW_BATCH_LEN    80
+#define TEST_SHA256_SW_BATCH_STRIDE 96
+
+/* --- */
+
+void test_sha256_sw_INIT()
+{
+
+}
+
+void test_sha256_sw_TEST()
+{
+    test_sha256_sw_known_answers();
+    test_sha256_sw_known_answers_dbl();
+    test_sha256_sw_batch();
+    test_sha256_sw_benchmark();
+}
+
+void test_sha256_sw_FINALIZE()
+{
+
+}
+
+/* --- */
+
+void test_sha256_sw_known_answers()
+{
+    uint8_t        msg[128];
+    const uint8_t* msgs[SHA256_SW_LANES_MAX];
+    uint32_t       h[SHA256_SW_LANES_MAX][SHA256_SW_HASH_WORDS];
+    int            i, l;
+
+    memset(msg, 'A', sizeof(msg));
+    for (l = 0; l < SHA256_SW_LANES_MAX; l++) {
+        msgs[l] = msg;
+    }
+
+    for (i = 0; i < (int) (sizeof(s_kat_A) / sizeof(s_kat_A[0])); i++) {
+        int ok = sha256_sw_verify(s_kat_A[i].h, msg, s_kat_A[i].len, 0);
+
+        (void) sha256_sw_hash_lanes(h, msgs, s_kat_A[i].len, SHA256_SW_LANES_MAX, 0);
+        for (l = 0; l < SHA256_SW_LANES_MAX; l++) {
+            if (memcmp(h[l], s_kat_A[i].h, sizeof(h[l]))) {
+                ok = 0;
+            }
+        }
+
+        fprintf(stderr, "INFO SW HASH %3dx 'A' = 0x%08x%08x%08x%08x%08x%08x%08x%08x  (%s)\n", s_kat_A[i].len,
+                h[0][0], h[0][1], h[0][2], h[0][3], h[0][4], h[0][5], h[0][6], h[0][7], ok ?  "OK" : "FAILED");
+    }
+}
+
+void test_sha256_sw_known_answers_dbl()
+{
+    uint8_t        msg[128];
+    const uint8_t* msgs[SHA256_SW_LANES_MAX];
+    uint32_t       h[SHA256_SW_LANES_MAX][SHA256_SW_HASH_WORDS];
+    uint32_t       hb[SHA256_SW_LANES_MAX + SHA256_SW_LANES + 1][SHA256_SW_HASH_WORDS];
+    int            i, l;
+
+    memset(msg, 'A', sizeof(msg));
+    for (l = 0; l < SHA256_SW_LANES_MAX; l++) {
+        msgs[l] = msg;
+    }
+
+    for (i = 0; i < (int) (sizeof(s_kat_A_dbl) / sizeof(s_kat_A_dbl[0])); i++) {
+        int ok = sha256_sw_verify(s_kat_A_dbl[i].h, msg, s_kat_A_dbl[i].len, 1);
+
+        (void) sha256_sw_hash_lanes(h, msgs, s_kat_A_dbl[i].len, SHA256_SW_LANES_MAX, 1);
+        for (l = 0; l < SHA256_SW_LANES_MAX; l++) {
+            if (memcmp(h[l], s_kat_A_dbl[i].h, sizeof(h[l]))) {
+                ok = 0;
+            }
+        }
+
+        /* one 8-lane group, one 4-lane group and the scalar code, all on the same message */
+        (void) sha256_sw_hash_batch(hb, msg, 0, s_kat_A_dbl[i].len, SHA256_SW_LANES_MAX + SHA256_SW_LANES + 1, 1);
+        for (l = 0; l < SHA256_SW_LANES_MAX + SHA256_SW_LANES + 1; l++) {
+            if (memcmp(hb[l], s_kat_A_dbl[i].h, sizeof(hb[l]))) {
+                ok = 0;
+            }
+        }
+
+        fprintf(stderr, "INFO SW HASH %3dx 'A' = 0x%08x%08x%08x%08x%08x%08x%08x%08x  SHA-256d (%s)\n", s_kat_A_dbl[i].len,
+                h[0][0], h[0][1], h[0][2], h[0][3], h[0][4], h[0][5], h[0][6], h[0][7], ok ?  "OK" : "FAILED");
+    }
+}
+
+void test_sha256_sw_batch()
+{
+    static uint8_t  msgs[TEST_SHA256_SW_BATCH_MAX * TEST_SHA256_SW_BATCH_STRIDE];
+    static uint32_t h[TEST_SHA256_SW_BATCH_MAX][SHA256_SW_HASH_WORDS];
+    uint32_t        h_ref[SHA256_SW_HASH_WORDS];
+    int             dbl, count, i;
+
+    /* distinct messages, so a result landing in the slot of another message is detected */
+    for (i = 0; i < (int) sizeof(msgs); i++) {
+        msgs[i] = (uint8_t) (i * 31 + (i / TEST_SHA256_SW_BATCH_STRIDE));
+    }
+
+    for (dbl = 0; dbl <= 1; dbl++) {
+        int ok = 1;
+
+        for (count = 1; count <= TEST_SHA256_SW_BATCH_MAX; count++) {
+            memset(h, 0, sizeof(h));
+            if (sha256_sw_hash_batch(h, msgs, TEST_SHA256_SW_BATCH_STRIDE, TEST_SHA256_SW_BATCH_LEN, count, dbl)) {
+                ok = 0;
+                continue;
+            }
+
+            for (i = 0; i < count; i++) {
+                sha256_sw_hash(h_ref, msgs + i * TEST_SHA256_SW_BATCH_STRIDE, TEST_SHA256_SW_BATCH_LEN, dbl);
+                if (memcmp(h[i], h_ref, sizeof(h_ref))) {
+                    ok = 0;
+                }
+            }
+        }
+
+        fprintf(stderr, "INFO SW BATCH %s of 1 .. %d messages against the scalar code  (%s)\n",
+                dbl ?  "SHA-256d" : "SHA-256 ", TEST_SHA256_SW_BATCH_MAX, ok ?  "OK" : "FAILED");
+    }
+}
+
+void test_sha256_sw_benchmark()
+{
+    fprintf(stderr, "INFO SW SHA-256  baseline = %11.1lf hashes/s\n", sha256_sw_benchmark(0, 0.25));
+    fprintf(stderr, "INFO SW SHA-256d baseline = %11.1lf hashes/s\n", sha256_sw_benchmark(1, 0.25));
+}
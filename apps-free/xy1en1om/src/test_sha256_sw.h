@@ -0,0 +1,56 @@
+/*
+ * test_sha256_sw.h
+ *
+ *  Created on: 16.10.2016
+ *      Author: espero
+ */
+
+#ifndef APPS_FREE_XY1EN1OM_SRC_TEST_SHA256_SW_H_
+#define APPS_FREE_XY1EN1OM_SRC_TEST_SHA256_SW_H_
+
+
+/**
+ * @brief Initializing for validity check of the software SHA-256 engine
+ *
+ */
+void test_sha256_sw_INIT();
+
+/**
+ * @brief Testing and doing the validity check of the software SHA-256 engine
+ *
+ */
+void test_sha256_sw_TEST();
+
+/**
+ * @brief Finalizing for validity check of the software SHA-256 engine
+ *
+ */
+void test_sha256_sw_FINALIZE();
+
+
+/**
+ * @brief Check validity of the scalar and the SIMD code with the same letter 'A' messages as the FIFO tests use
+ *
+ */
+void test_sha256_sw_known_answers();
+
+/**
+ * @brief Check validity of SHA-256d with the scalar code, the lanes and the batch groups
+ *
+ */
+void test_sha256_sw_known_answers_dbl();
+
+/**
+ * @brief Check batches that are split into helper thread halves, lane groups and a scalar remainder
+ *
+ */
+void test_sha256_sw_batch();
+
+/**
+ * @brief Reports the CPU baseline of the software engine in hashes/s
+ *
+ */
+void test_sha256_sw_benchmark();
+
+
+#endif /* APPS_FREE_XY1EN1OM_SRC_TEST_SHA256_SW_H_ */
@@ -21,6 +21,7 @@
 
 #include "cb_http.h"
 #include "fpga.h"
+#include "xy_stats.h"
 
 #include "worker.h"
 
@@ -32,6 +33,15 @@ static pthread_t*               s_worker_thread_handler = NULL;
 static worker_state_t           s_worker_ctrl_state;
 /** @brief Mutex for work_ctrl_state */
 static pthread_mutex_t          s_worker_ctrl_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** @brief Signals a posted command or the quit request to the worker thread */
+static pthread_cond_t           s_worker_ctrl_cond = PTHREAD_COND_INITIALIZER;
+
+/** @brief Command queue of the worker thread, ring buffer guarded by s_worker_ctrl_mutex */
+static worker_cmd_t             s_worker_cmd_queue[WORKER_CMD_QUEUE_LEN];
+/** @brief Index of the oldest command in s_worker_cmd_queue */
+static int                      s_worker_cmd_head = 0;
+/** @brief Count of commands in s_worker_cmd_queue */
+static int                      s_worker_cmd_cnt  = 0;
 
 /** @brief Parameter list for the worker thread */
 static xy_app_params_t*         s_worker_params = NULL;
@@ -40,11 +50,15 @@ static xy_app_params_t*         s_worker_params = NULL;
 extern rp_app_params_t*         g_rp_cb_in_params;
 /** @brief Holds mutex to access on parameters from outside to the worker thread */
 extern pthread_mutex_t          g_rp_cb_in_params_mutex;
+/** @brief Signals that the worker has taken over g_rp_cb_in_params */
+extern pthread_cond_t           g_rp_cb_in_params_cond;
 
 /** @brief Current copy of params of the worker thread */
 extern xy_app_params_t*         g_xy_info_worker_params;
 /** @brief Holds mutex to access parameters from the worker thread to any other context */
 extern pthread_mutex_t          g_xy_info_worker_params_mutex;
+/** @brief Signals that the worker has exported its current params data */
+extern pthread_cond_t           g_xy_info_worker_params_cond;
 
 /** @brief params initialized */
 extern int                      g_params_init_done;  /* @see main.c */
@@ -66,6 +80,8 @@ int worker_init(xy_app_params_t* params, int params_len)
     }
 
     s_worker_ctrl_state = worker_idle_state;
+    s_worker_cmd_head   = 0;
+    s_worker_cmd_cnt    = 0;
 
     /* create a new parameter list to the worker context */
     xy_copy_params((xy_app_params_t**) &s_worker_params, params, params_len, 1);
@@ -86,6 +102,9 @@ int worker_init(xy_app_params_t* params, int params_len)
         return -1;
     }
 
+    /* let the worker configure the FPGA with the initial parameters */
+    (void) worker_post(worker_cmd_params);
+
     //fprintf(stderr, "DEBUG worker_init: END\n");
     return 0;
 }
@@ -98,9 +117,7 @@ int worker_exit(void)
     //fprintf(stderr, "DEBUG worker_exit: BEGIN\n");
 
     //fprintf(stderr, "worker_exit: before signaling quit\n");
-    pthread_mutex_lock(&s_worker_ctrl_mutex);
-    s_worker_ctrl_state = worker_quit_state;
-    pthread_mutex_unlock(&s_worker_ctrl_mutex);
+    (void) worker_post(worker_cmd_quit);
     //fprintf(stderr, "worker_exit: after signaling quit\n");
 
     if (s_worker_thread_handler) {
@@ -127,27 +144,70 @@ int worker_exit(void)
     return 0;
 }
 
+/*----------------------------------------------------------------------------------*/
+int worker_post(worker_cmd_t cmd)
+{
+    int i;
+
+    if (cmd < worker_cmd_params || cmd >= worker_cmd_nonexisting) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&s_worker_ctrl_mutex);
+    if (cmd == worker_cmd_quit) {
+        s_worker_ctrl_state = worker_quit_state;  // a state, thus it does not need a free queue entry
+
+    } else {
+        for (i = 0; i < s_worker_cmd_cnt; i++) {
+            if (s_worker_cmd_queue[(s_worker_cmd_head + i) % WORKER_CMD_QUEUE_LEN] == cmd) {
+                break;  // still pending - it picks up the newest data when processed
+            }
+        }
+        if (i == s_worker_cmd_cnt) {
+            if (s_worker_cmd_cnt == WORKER_CMD_QUEUE_LEN) {
+                pthread_mutex_unlock(&s_worker_ctrl_mutex);
+                return -2;
+            }
+            s_worker_cmd_queue[(s_worker_cmd_head + s_worker_cmd_cnt) % WORKER_CMD_QUEUE_LEN] = cmd;
+            s_worker_cmd_cnt++;
+        }
+    }
+    pthread_cond_signal(&s_worker_ctrl_cond);
+    pthread_mutex_unlock(&s_worker_ctrl_mutex);
+    return 0;
+}
+
 /*----------------------------------------------------------------------------------*/
 void* worker_thread(void* args)
 {
     xy_app_params_t* l_cb_in_copy_params  = NULL;
     worker_state_t l_state;
+    worker_cmd_t l_cmd;
     int l_do_normal_state = 0;
 
     //fprintf(stderr, "worker_thread: BEGIN\n");
 
-    pthread_mutex_lock(&s_worker_ctrl_mutex);
-    s_worker_ctrl_state = l_state = worker_idle_state;
-    pthread_mutex_unlock(&s_worker_ctrl_mutex);
-
     while (1) {
         pthread_mutex_lock(&s_worker_ctrl_mutex);
+        while (!s_worker_cmd_cnt && (s_worker_ctrl_state != worker_quit_state)) {
+            /* sleep until a command is posted - no wake-ups while idle */
+            pthread_cond_wait(&s_worker_ctrl_cond, &s_worker_ctrl_mutex);
+        }
+        l_cmd = worker_cmd_nonexisting;
+        if (s_worker_cmd_cnt) {
+            l_cmd = s_worker_cmd_queue[s_worker_cmd_head];
+            s_worker_cmd_head = (s_worker_cmd_head + 1) % WORKER_CMD_QUEUE_LEN;
+            s_worker_cmd_cnt--;
+        }
         l_state = s_worker_ctrl_state;
         pthread_mutex_unlock(&s_worker_ctrl_mutex);
 
         pthread_mutex_lock(&g_rp_cb_in_params_mutex);
         int l_params_init_done = g_params_init_done;
-        if (!l_params_init_done) {
+        if (l_cmd != worker_cmd_params) {
+            /* nothing to take over */
+
+        } else if (!l_params_init_done) {
             /* the FPGA is going to be configured by these entries */
             //fprintf(stderr, "DEBUG worker_thread: rp_cb_in_params - INITIAL data, copying ...\n");
             xy_copy_params(&l_cb_in_copy_params, s_worker_params, -1, 1);
@@ -164,6 +224,7 @@ void* worker_thread(void* args)
 
             //fprintf(stderr, "DEBUG worker_thread: g_rp_cb_in_params - freeing (2) ...\n");
             rp_free_params(&g_rp_cb_in_params);
+            pthread_cond_broadcast(&g_rp_cb_in_params_cond);  // rp_set_params() may pass the next job
 
             /* take FSM out of idle */
             l_do_normal_state = 1;
@@ -186,7 +247,10 @@ void* worker_thread(void* args)
 
         if (l_do_normal_state) {
             pthread_mutex_lock(&s_worker_ctrl_mutex);
-            s_worker_ctrl_state = l_state = worker_normal_state;
+            if (s_worker_ctrl_state != worker_quit_state) {
+                s_worker_ctrl_state = worker_normal_state;
+            }
+            l_state = s_worker_ctrl_state;
             pthread_mutex_unlock(&s_worker_ctrl_mutex);
 
             l_do_normal_state = 0;
@@ -212,7 +276,6 @@ void* worker_thread(void* args)
             break;
 
         } else if (l_state == worker_idle_state) {
-            usleep(10000);  // request for a 10 ms delay
             continue;
 
         } else if (l_state == worker_normal_state) {
@@ -237,21 +300,34 @@ void* worker_thread(void* args)
                 xy_free_params(&g_xy_info_worker_params);  // invalidate old data
                 //fprintf(stderr, "DEBUG worker_thread: UPDATE RETURNED DATA  g_xy_info_worker_params\n");
                 xy_copy_params(&g_xy_info_worker_params, s_worker_params, -1, 1);
+                xy_stats_export(&g_xy_info_worker_params);
                 //print_xy_params(g_xy_info_worker_params);
                 pthread_mutex_unlock(&g_xy_info_worker_params_mutex);
 
                 //fprintf(stderr, "INFO worker_thread: rp_cb_in_params - freeing (1) ...\n");
                 xy_free_params(&l_cb_in_copy_params);
             }
-            /* drop working flag */
+            /* drop working flag and wake up rp_get_params() */
+            pthread_mutex_lock(&g_xy_info_worker_params_mutex);
             g_transport_pktIdx &= 0x7f;
+            pthread_cond_broadcast(&g_xy_info_worker_params_cond);
+            pthread_mutex_unlock(&g_xy_info_worker_params_mutex);
 
             //fprintf(stderr, "DEBUG worker_thread: mutex - before l_state change to idle\n");
             pthread_mutex_lock(&s_worker_ctrl_mutex);
-            s_worker_ctrl_state = worker_idle_state;
+            if (s_worker_ctrl_state != worker_quit_state) {
+                s_worker_ctrl_state = worker_idle_state;
+            }
             pthread_mutex_unlock(&s_worker_ctrl_mutex);
             //fprintf(stderr, "DEBUG worker_thread: mutex - after l_state change to idle\n");
 
+            /* data posted during the initial pass is still waiting to be taken over */
+            pthread_mutex_lock(&g_rp_cb_in_params_mutex);
+            if (g_params_init_done && g_rp_cb_in_params) {
+                (void) worker_post(worker_cmd_params);
+            }
+            pthread_mutex_unlock(&g_rp_cb_in_params_mutex);
+
         } else {  // any unknown states are mapped to QUIT
             pthread_mutex_lock(&s_worker_ctrl_mutex);
             s_worker_ctrl_state = worker_quit_state;
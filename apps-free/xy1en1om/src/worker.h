@@ -39,7 +39,25 @@ typedef enum worker_state_e {
 } worker_state_t;
 
 
+/** @brief Capacity of the command queue of the worker thread */
+#define WORKER_CMD_QUEUE_LEN    8
+
+/** @brief Commands posted to the worker thread */
+typedef enum worker_cmd_e {
+    /** @brief new parameters are waiting in g_rp_cb_in_params */
+    worker_cmd_params = 0,
+
+    /** @brief shutdown worker */
+    worker_cmd_quit,
+
+    /** @brief must be last entry */
+    worker_cmd_nonexisting
+} worker_cmd_t;
+
+
 /** @brief Sets-up a running worker thread
+ *
+ * Not called yet - rp_app_init() keeps the worker disabled at this point of development, see cb_http.c.
  *
  * @param[in]    params        The initial parameter list the worker thread will take a copy from.
  * @param[in]    params_len    Count of parameters that params holds.
@@ -53,10 +71,23 @@ int worker_init(xy_app_params_t* params, int params_len);
  */
 int worker_exit(void);
 
+/** @brief Posts a command to the worker thread and wakes it up
+ *
+ * A command that is already pending is not queued twice. worker_cmd_quit is never lost,
+ * even when the queue is full.
+ *
+ * @param[in]    cmd   Command to be processed by the worker thread.
+ * @retval       0     Success.
+ * @retval       -1    Bad command.
+ * @retval       -2    Queue is full.
+ */
+int worker_post(worker_cmd_t cmd);
+
 /** @brief The worker thread that runs the state-machine for parameter handling
  *
  * All data transfered between this thread and outer context has to be handled
- * strictly by mutex access.
+ * strictly by mutex access. The thread sleeps on a condition variable until a
+ * command is posted by worker_post(), an idle worker does not wake up at all.
  *
  * @param[in]    args  @see pthread_create for details. Not used in this context.
  * @retval       void* @see pthread_create for details. Not used in this context.
@@ -0,0 +1,301 @@
+/**
+ * @brief Red Pitaya throughput benchmark of the xy1en1om SHA-256 paths.
+ *
+ * Hashes 80 byte block headers with SHA-256d through the FIFO, the batched FIFO, the DMA and the
+ * software engine and reports hashes/s and the latency percentiles of each mode. Every digest is
+ * verified against the scalar software reference, a mismatch makes the program fail.
+ *
+ * Off the board the register simulation is used (-b sim, the default), thus the host side code
+ * paths can be checked for performance regressions without flashing a board.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "main.h"
+#include "fpga_xy.h"
+#include "sha256_sw.h"
+
+
+/** @brief The xy1en1om DMA ring for the SHA-256 DMA engine. */
+extern dma_ring_t           g_fpga_xy_dma_ring;
+/** @brief The xy1en1om memory layout of the FPGA registers. */
+extern fpga_xy_reg_mem_t*   g_fpga_xy_reg_mem;
+/** @brief The xy1en1om register backend in use. */
+extern fpga_xy_backend_t    g_fpga_xy_backend;
+
+
+/** @brief Length of a block header in bytes. */
+#define XY_BENCH_LEN            80
+
+/** @brief Default count of hashes of each mode. */
+#define XY_BENCH_COUNT          4096
+
+/** @brief Count of hashes of each batch of the batched and the software mode. */
+#define XY_BENCH_BATCH          XY_SHA256_QUEUE_LEN
+
+
+/** @brief Benchmarked modes */
+typedef enum xy_bench_mode_e {
+    xy_bench_fifo = 0,
+    xy_bench_batch,
+    xy_bench_dma,
+    xy_bench_sw,
+    xy_bench_modes
+} xy_bench_mode_t;
+
+static const char*          s_bench_mode_names[xy_bench_modes] = { "fifo", "batch", "dma", "sw" };
+
+/** @brief Block headers to be hashed */
+static uint8_t              (*s_bench_msgs)[XY_BENCH_LEN] = NULL;
+/** @brief Resulting hash values */
+static uint32_t             (*s_bench_h)[8] = NULL;
+/** @brief Latency of each operation in nanoseconds */
+static uint64_t*            s_bench_lat = NULL;
+
+
+static uint64_t xy_bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static int xy_bench_cmp(const void* a, const void* b)
+{
+    const uint64_t x = *(const uint64_t*) a;
+    const uint64_t y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Pads a block header to the two blocks streamed by the DMA engine
+ *
+ * The FIFO consumes big-endian words, the DMA engine streams the 32 bit words in memory order.
+ */
+static void xy_bench_dma_words(uint32_t words[32], const uint8_t* msg)
+{
+    int i;
+
+    memset(words, 0, 32 * sizeof(uint32_t));
+    for (i = 0; i < XY_BENCH_LEN; i++) {
+        words[i >> 2] |= (uint32_t) msg[i] << (24 - ((i & 3) << 3));
+    }
+    words[XY_BENCH_LEN >> 2] = 0x80000000;
+    words[31]                = XY_BENCH_LEN << 3;
+}
+
+/**
+ * @brief Hashes s_bench_msgs[ofs .. ofs + n - 1] by one operation of the mode
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, the engine did not respond
+ */
+static int xy_bench_op(xy_bench_mode_t mode, int ofs, int n)
+{
+    xy_sha256_job_t jobs[XY_BENCH_BATCH];
+    dma_ring_slot_t slot;
+    int i;
+
+    switch (mode) {
+    case xy_bench_fifo:
+    case xy_bench_batch:
+        for (i = 0; i < n; i++) {
+            jobs[i].msg = s_bench_msgs[ofs + i];
+            jobs[i].len = XY_BENCH_LEN;
+            jobs[i].dbl = 1;
+        }
+        if (xy_sha256_submit_batch(jobs, n) != n || xy_sha256_collect(&s_bench_h[ofs], n) != n) {
+            xy_sha256_drop();
+            return -1;
+        }
+        return 0;
+
+    case xy_bench_dma:
+        if (dma_ring_get_slot(&g_fpga_xy_dma_ring, &slot)) {
+            return -1;
+        }
+        xy_bench_dma_words((uint32_t*) slot.virt, s_bench_msgs[ofs]);
+        dma_ring_sync_slot(&g_fpga_xy_dma_ring, &slot, 32 * sizeof(uint32_t), dma_ring_to_device);
+
+        g_fpga_xy_reg_mem->sha256_dma_base_addr = slot.phys;
+        g_fpga_xy_reg_mem->sha256_dma_bit_len   = 32 * 32;
+        FPGA_XY_REG_WR(sha256_ctrl, SHA256_CTRL_DMA_MODE | SHA256_CTRL_DBL_HASH | SHA256_CTRL_RESET | SHA256_CTRL_ENABLE);
+        FPGA_XY_REG_WR(sha256_ctrl, SHA256_CTRL_DMA_START | SHA256_CTRL_DMA_MODE | SHA256_CTRL_DBL_HASH | SHA256_CTRL_ENABLE);
+        i = xy_sha256_wait(SHA256_STAT_HASH_VALID);
+        (void) dma_ring_put_slot(&g_fpga_xy_dma_ring);
+        if (i) {
+            return -1;
+        }
+
+        s_bench_h[ofs][0] = g_fpga_xy_reg_mem->sha256_hash_h0;
+        s_bench_h[ofs][1] = g_fpga_xy_reg_mem->sha256_hash_h1;
+        s_bench_h[ofs][2] = g_fpga_xy_reg_mem->sha256_hash_h2;
+        s_bench_h[ofs][3] = g_fpga_xy_reg_mem->sha256_hash_h3;
+        s_bench_h[ofs][4] = g_fpga_xy_reg_mem->sha256_hash_h4;
+        s_bench_h[ofs][5] = g_fpga_xy_reg_mem->sha256_hash_h5;
+        s_bench_h[ofs][6] = g_fpga_xy_reg_mem->sha256_hash_h6;
+        s_bench_h[ofs][7] = g_fpga_xy_reg_mem->sha256_hash_h7;
+        return 0;
+
+    case xy_bench_sw:
+        return sha256_sw_hash_batch(&s_bench_h[ofs], s_bench_msgs[ofs], XY_BENCH_LEN, XY_BENCH_LEN, n, 1);
+
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief Runs one mode, prints the result line
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, the engine did not respond or a digest is wrong
+ */
+static int xy_bench_run(xy_bench_mode_t mode, int count)
+{
+    const int per_op = (mode == xy_bench_batch || mode == xy_bench_sw) ?  XY_BENCH_BATCH : 1;
+    uint64_t  t_start, t_total;
+    int       ops = 0, bad = 0;
+    int       ofs, n, i;
+
+    if (mode == xy_bench_dma && !g_fpga_xy_dma_ring.virt) {
+        printf("%-6s  skipped, no DMA ring\n", s_bench_mode_names[mode]);
+        return 0;
+    }
+
+    memset(s_bench_h, 0, count * sizeof(*s_bench_h));
+    t_start = xy_bench_now();
+    for (ofs = 0; ofs < count; ofs += n) {
+        const uint64_t t0 = xy_bench_now();
+
+        n = (count - ofs < per_op) ?  (count - ofs) : per_op;
+        if (xy_bench_op(mode, ofs, n)) {
+            fprintf(stderr, "ERROR - xy_bench_run: %s - engine did not respond at hash %d\n", s_bench_mode_names[mode], ofs);
+            return -1;
+        }
+        s_bench_lat[ops++] = xy_bench_now() - t0;
+    }
+    t_total = xy_bench_now() - t_start;
+
+    for (i = 0; i < count; i++) {
+        if (!sha256_sw_verify(s_bench_h[i], s_bench_msgs[i], XY_BENCH_LEN, 1)) {
+            bad++;
+        }
+    }
+
+    qsort(s_bench_lat, ops, sizeof(*s_bench_lat), xy_bench_cmp);
+    printf("%-6s  %10.0lf hashes/s  latency/op (%2d hash) p50 = %9.3lfus  p99 = %9.3lfus  max = %9.3lfus  %s\n",
+            s_bench_mode_names[mode], count * 1e9 / t_total, per_op,
+            s_bench_lat[ops / 2] / 1000.0, s_bench_lat[(ops * 99) / 100] / 1000.0, s_bench_lat[ops - 1] / 1000.0,
+            bad ?  "FAILED" : "OK");
+    fflush(stdout);
+    return bad ?  -1 : 0;
+}
+
+static void xy_bench_usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-b hw|sim] [-m fifo|batch|dma|sw|all] [-n count]\n", name);
+}
+
+
+int main(int argc, char* argv[])
+{
+    fpga_xy_backend_t backend = fpga_xy_backend_sim;
+    int               mode    = -1;  // all
+    int               count   = XY_BENCH_COUNT;
+    int               ret     = 0;
+    int               opt, i;
+
+    while ((opt = getopt(argc, argv, "b:m:n:h")) != -1) {
+        switch (opt) {
+        case 'b':
+            if (!strcmp(optarg, "hw")) {
+                backend = fpga_xy_backend_hw;
+            } else if (!strcmp(optarg, "sim")) {
+                backend = fpga_xy_backend_sim;
+            } else {
+                xy_bench_usage(argv[0]);
+                return 2;
+            }
+            break;
+
+        case 'm':
+            for (mode = 0; mode < xy_bench_modes; mode++) {
+                if (!strcmp(optarg, s_bench_mode_names[mode])) {
+                    break;
+                }
+            }
+            if (!strcmp(optarg, "all")) {
+                mode = -1;
+            } else if (mode == xy_bench_modes) {
+                xy_bench_usage(argv[0]);
+                return 2;
+            }
+            break;
+
+        case 'n':
+            count = atoi(optarg);
+            if (count < 1) {
+                xy_bench_usage(argv[0]);
+                return 2;
+            }
+            break;
+
+        default:
+            xy_bench_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    s_bench_msgs = malloc(count * sizeof(*s_bench_msgs));
+    s_bench_h    = malloc(count * sizeof(*s_bench_h));
+    s_bench_lat  = malloc(count * sizeof(*s_bench_lat));
+    if (!s_bench_msgs || !s_bench_h || !s_bench_lat) {
+        fprintf(stderr, "ERROR - main: out of memory\n");
+        return 1;
+    }
+    srand(0x16081001);
+    for (i = 0; i < count * XY_BENCH_LEN; i++) {
+        ((uint8_t*) s_bench_msgs)[i] = (uint8_t) rand();
+    }
+
+    /* the helper thread runs before the study section as in rp_app_init() */
+    (void) sha256_sw_init();
+    (void) fpga_xy_set_backend(backend);
+    if (fpga_xy_init()) {
+        fprintf(stderr, "ERROR - main: fpga_xy_init() failed\n");
+        sha256_sw_exit();
+        return 1;
+    }
+    fpga_xy_enable(1);
+
+    printf("INFO xy_bench: backend = %s, SHA-256d of %d headers of %d bytes\n",
+            (g_fpga_xy_backend == fpga_xy_backend_sim) ?  "sim" : "hw", count, XY_BENCH_LEN);
+    for (i = 0; i < xy_bench_modes; i++) {
+        if (mode < 0 || mode == i) {
+            if (xy_bench_run(i, count)) {
+                ret = 1;
+            }
+        }
+    }
+
+    sha256_sw_exit();
+    fpga_xy_exit();
+    free(s_bench_lat);
+    free(s_bench_h);
+    free(s_bench_msgs);
+    return ret;
+}
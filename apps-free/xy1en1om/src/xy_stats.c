@@ -0,0 +1,254 @@
+/**
+ * @brief Red Pitaya latency instrumentation of the xy1en1om sub-module.
+ *
+ * Each stage owns a log-linear histogram: every power of two of nanoseconds is split into
+ * XY_STATS_SUB buckets. Recording is a relaxed atomic increment of one bucket, thus the
+ * hashing threads never block on the instrumentation and a reader sees consistent counts
+ * within one bucket granularity.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "xy_stats.h"
+
+
+/** @brief Histograms of the stages, counts of each bucket */
+static uint32_t             s_stats_hist[xy_stats_stages][XY_STATS_BUCKETS];
+/** @brief Longest duration of each stage in nanoseconds */
+static uint32_t             s_stats_max[xy_stats_stages];
+/** @brief Count of finished hashes */
+static uint64_t             s_stats_hashes = 0;
+
+/** @brief Count of hashes at the previous export */
+static uint64_t             s_stats_export_hashes = 0;
+/** @brief Time stamp of the previous export */
+static struct timespec      s_stats_export_ts = { 0, 0 };
+/** @brief Serializes the exporters, the recorders do not use it */
+static pthread_mutex_t      s_stats_export_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** @brief Parameter names of the stages */
+static const char*          s_stats_stage_names[xy_stats_stages] = { "push", "wait", "readout", "dma_setup" };
+
+
+/*----------------------------------------------------------------------------*/
+uint64_t xy_stats_now(void)
+{
+#if defined(__arm__) && defined(XY_STATS_CCNT)
+    uint32_t ccnt;
+
+    __asm__ __volatile__ ("mrc p15, 0, %0, c9, c13, 0" : "=r" (ccnt));
+    return ccnt;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+static inline uint32_t xy_stats_elapsed_ns(uint64_t t0)
+{
+#if defined(__arm__) && defined(XY_STATS_CCNT)
+    const uint32_t cycles = (uint32_t) xy_stats_now() - (uint32_t) t0;  // wraps after 6.4 s
+    return (uint32_t) (((uint64_t) cycles * 1000000000ULL) / XY_STATS_CPU_HZ);
+#else
+    const uint64_t ns = xy_stats_now() - t0;
+    return (ns > 0xffffffffULL) ?  0xffffffffU : (uint32_t) ns;
+#endif
+}
+
+static inline int xy_stats_bucket(uint32_t ns)
+{
+    int msb;
+
+    if (ns < XY_STATS_SUB) {
+        return (int) ns;
+    }
+    msb = 31 - __builtin_clz(ns);
+    return ((msb - XY_STATS_SUB_BITS + 1) << XY_STATS_SUB_BITS) + (int) ((ns >> (msb - XY_STATS_SUB_BITS)) & (XY_STATS_SUB - 1));
+}
+
+/** @brief Upper bound of a bucket in nanoseconds */
+static double xy_stats_bucket_upper(int idx)
+{
+    int msb, sub;
+
+    if (idx < XY_STATS_SUB) {
+        return idx + 1;
+    }
+    msb = (idx >> XY_STATS_SUB_BITS) - 1 + XY_STATS_SUB_BITS;
+    sub = idx & (XY_STATS_SUB - 1);
+    return (double) ((uint64_t) (XY_STATS_SUB + sub + 1) << (msb - XY_STATS_SUB_BITS));
+}
+
+/*----------------------------------------------------------------------------*/
+void xy_stats_record(xy_stats_stage_t stage, uint64_t t0)
+{
+    const uint32_t ns = xy_stats_elapsed_ns(t0);
+    uint32_t max;
+
+    if (stage < 0 || stage >= xy_stats_stages) {
+        return;
+    }
+
+    __atomic_fetch_add(&s_stats_hist[stage][xy_stats_bucket(ns)], 1, __ATOMIC_RELAXED);
+
+    max = __atomic_load_n(&s_stats_max[stage], __ATOMIC_RELAXED);
+    while (ns > max) {
+        if (__atomic_compare_exchange_n(&s_stats_max[stage], &max, ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+void xy_stats_count_hashes(uint32_t n)
+{
+    __atomic_fetch_add(&s_stats_hashes, n, __ATOMIC_RELAXED);
+}
+
+/*----------------------------------------------------------------------------*/
+double xy_stats_percentile(xy_stats_stage_t stage, double p)
+{
+    uint32_t snap[XY_STATS_BUCKETS];
+    uint64_t total = 0;
+    uint64_t rank, sum = 0;
+    int i;
+
+    if (stage < 0 || stage >= xy_stats_stages) {
+        return 0.0;
+    }
+
+    for (i = 0; i < XY_STATS_BUCKETS; i++) {
+        snap[i] = __atomic_load_n(&s_stats_hist[stage][i], __ATOMIC_RELAXED);
+        total  += snap[i];
+    }
+    if (!total) {
+        return 0.0;
+    }
+
+    rank = (uint64_t) (p * 0.01 * total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    for (i = 0; i < XY_STATS_BUCKETS; i++) {
+        sum += snap[i];
+        if (sum >= rank) {
+            break;
+        }
+    }
+    if (i == XY_STATS_BUCKETS) {
+        i--;
+    }
+    return xy_stats_bucket_upper(i) * 1e-3;
+}
+
+/*----------------------------------------------------------------------------*/
+void xy_stats_reset(void)
+{
+    int s, i;
+
+    for (s = 0; s < xy_stats_stages; s++) {
+        for (i = 0; i < XY_STATS_BUCKETS; i++) {
+            __atomic_store_n(&s_stats_hist[s][i], 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&s_stats_max[s], 0, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Updates or appends a read-only entry of a parameter list
+ *
+ * @retval  0 Success
+ * @retval -1 Failure, out of memory
+ */
+static int xy_stats_set_param(xy_app_params_t** dst, int* cnt, const char* name, double value)
+{
+    xy_app_params_t* p = *dst;
+    int idx = p ?  xy_find_parms_index(p, name) : -1;
+
+    if (idx < 0) {
+        p = realloc(p, sizeof(xy_app_params_t) * (*cnt + 2));
+        if (!p) {
+            return -1;
+        }
+        *dst = p;
+
+        idx = (*cnt)++;
+        p[idx].name = strdup(name);
+        if (!p[idx].name) {
+            p[idx].name = NULL;
+            return -1;
+        }
+        p[idx + 1].name = NULL;
+    }
+
+    p[idx].value       = value;
+    p[idx].fpga_update = 0;
+    p[idx].read_only   = 1;
+    p[idx].min_val     = 0.0;
+    p[idx].max_val     = 1e12;
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int xy_stats_export(xy_app_params_t** dst)
+{
+    struct timespec now;
+    char     name[32];
+    uint64_t hashes;
+    double   dt, hps = 0.0;
+    int      cnt = 0;
+    int      s;
+
+    if (!dst) {
+        return -1;
+    }
+    if (*dst) {
+        while ((*dst)[cnt].name) {
+            cnt++;
+        }
+    }
+
+    pthread_mutex_lock(&s_stats_export_mutex);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    hashes = __atomic_load_n(&s_stats_hashes, __ATOMIC_RELAXED);
+    dt = (now.tv_sec - s_stats_export_ts.tv_sec) + (now.tv_nsec - s_stats_export_ts.tv_nsec) * 1e-9;
+    if (s_stats_export_ts.tv_sec && dt > 0.0) {
+        hps = (hashes - s_stats_export_hashes) / dt;
+    }
+    s_stats_export_hashes = hashes;
+    s_stats_export_ts     = now;
+    pthread_mutex_unlock(&s_stats_export_mutex);
+
+    for (s = 0; s < xy_stats_stages; s++) {
+        snprintf(name, sizeof(name), "xy_stat_%s_p50", s_stats_stage_names[s]);
+        if (xy_stats_set_param(dst, &cnt, name, xy_stats_percentile(s, 50.0))) {
+            return -1;
+        }
+        snprintf(name, sizeof(name), "xy_stat_%s_p99", s_stats_stage_names[s]);
+        if (xy_stats_set_param(dst, &cnt, name, xy_stats_percentile(s, 99.0))) {
+            return -1;
+        }
+        snprintf(name, sizeof(name), "xy_stat_%s_max", s_stats_stage_names[s]);
+        if (xy_stats_set_param(dst, &cnt, name, __atomic_load_n(&s_stats_max[s], __ATOMIC_RELAXED) * 1e-3)) {
+            return -1;
+        }
+    }
+    if (xy_stats_set_param(dst, &cnt, "xy_stat_hps", hps)) {
+        return -1;
+    }
+    return cnt;
+}
@@ -0,0 +1,114 @@
+/**
+ * @brief Red Pitaya latency instrumentation of the xy1en1om sub-module.
+ *
+ * @author Ulrich Habel (DF4IAH) <espero7757@gmx.net>
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __XY_STATS_H
+#define __XY_STATS_H
+
+#include <stdint.h>
+
+#include "main.h"
+
+
+/** @defgroup xy_stats_h Lock-free latency histograms of the hashing stages
+ * @{
+ */
+
+/** @brief Count of sub-buckets of each power of two, the relative resolution is 1 / XY_STATS_SUB. */
+#define XY_STATS_SUB_BITS       2
+#define XY_STATS_SUB            (1 << XY_STATS_SUB_BITS)
+
+/** @brief Count of histogram buckets, covering 1 ns .. 2^32 ns. */
+#define XY_STATS_BUCKETS        (32 * XY_STATS_SUB)
+
+/** @brief Clock frequency of the Cortex-A9 cycle counter, used with XY_STATS_CCNT, only. */
+#define XY_STATS_CPU_HZ         666666666ULL
+
+
+/** @brief Instrumented stages */
+typedef enum xy_stats_stage_e {
+    /** @brief pushing the words of a message into the FIFO */
+    xy_stats_push = 0,
+
+    /** @brief waiting until the engine presents a valid hash */
+    xy_stats_wait,
+
+    /** @brief reading out the hash registers */
+    xy_stats_readout,
+
+    /** @brief preparing the DMA slot and the DMA registers */
+    xy_stats_dma_setup,
+
+    /** @brief must be last entry */
+    xy_stats_stages
+} xy_stats_stage_t;
+
+
+/* function declarations, detailed descriptions is in apparent implementation file  */
+
+/**
+ * @brief Time stamp for the start of a stage
+ *
+ * CLOCK_MONOTONIC_RAW in nanoseconds. Compiled with XY_STATS_CCNT the Cortex-A9 cycle counter is read
+ * instead, that needs user access to the PMU granted by the kernel (PMUSERENR).
+ *
+ * @retval     uint64_t  Time stamp in nanoseconds (CLOCK_MONOTONIC_RAW) or cycles (XY_STATS_CCNT).
+ */
+uint64_t xy_stats_now(void);
+
+/**
+ * @brief Records the duration of a stage since the time stamp t0
+ *
+ * Lock-free, can be called from any thread.
+ *
+ * @param[in]  stage   Instrumented stage.
+ * @param[in]  t0      Time stamp taken by xy_stats_now() at the start of the stage.
+ */
+void xy_stats_record(xy_stats_stage_t stage, uint64_t t0);
+
+/**
+ * @brief Counts finished hashes for the hashes/s rate
+ *
+ * @param[in]  n       Count of hashes.
+ */
+void xy_stats_count_hashes(uint32_t n);
+
+/**
+ * @brief Percentile of the recorded durations of a stage
+ *
+ * @param[in]  stage   Instrumented stage.
+ * @param[in]  p       Percentile 0.0 .. 100.0.
+ *
+ * @retval     double  Upper bound of the matching histogram bucket in microseconds, 0.0 when empty.
+ */
+double xy_stats_percentile(xy_stats_stage_t stage, double p);
+
+/**
+ * @brief Clears all histograms and counters
+ */
+void xy_stats_reset(void);
+
+/**
+ * @brief Appends the read-only parameters xy_stat_<stage>_p50/_p99/_max (µs) and xy_stat_hps to a parameter list
+ *
+ * The hashes/s rate is calculated over the time since the previous call.
+ *
+ * @param[inout] dst   Parameter list, may be NULL. Entries of the same name are updated.
+ *
+ * @retval       int   Count of entries of the list.
+ * @retval       -1    Failure, out of memory.
+ */
+int xy_stats_export(xy_app_params_t** dst);
+
+/** @} */
+
+
+#endif /* __XY_STATS_H */
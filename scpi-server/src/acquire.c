@@ -15,9 +15,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 
 #include "acquire.h"
 #include "common.h"
+#include "scpi-server.h"
 
 #include "scpi/parser.h"
 #include "scpi/units.h"
@@ -25,6 +28,15 @@
 #include "redpitaya/rp.h"
 
 rp_scpi_acq_unit_t unit     = RP_SCPI_VOLTS;        // default value
+rp_scpi_acq_order_t order   = RP_SCPI_BIG_ENDIAN;   // default value
+
+/* Samples of the data queries, one buffer of one channel is the most a query returns. The pool
+ * is locked into memory by the first query, so neither the stack nor page faults are involved. */
+static union {
+    float v[ADC_BUFFER_SIZE];
+    int16_t raw[ADC_BUFFER_SIZE];
+} data_pool;
+static bool data_pool_locked = false;
 
 /* These structures are a direct API mirror 
 and should not be altered! */
@@ -34,6 +46,12 @@ const scpi_choice_def_t scpi_RpUnits[] = {
     SCPI_CHOICE_LIST_END
 };
 
+const scpi_choice_def_t scpi_RpByteOrder[] = {
+    {"BE", 0},
+    {"LE", 1},
+    SCPI_CHOICE_LIST_END
+};
+
 const scpi_choice_def_t scpi_RpGain[] = {
     {"LV", 0},
     {"HV", 1},
@@ -78,6 +96,71 @@ const scpi_choice_def_t scpi_RpTrigStat[] = {
     SCPI_CHOICE_LIST_END
 };
 
+/* True if the byte order set by ACQ:DATA:BORDER is not the one of the host */
+bool RP_AcqNeedsSwap() {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return order == RP_SCPI_BIG_ENDIAN;
+#else
+    return order == RP_SCPI_LITTLE_ENDIAN;
+#endif
+}
+
+static void lockDataPool() {
+    if (!data_pool_locked) {
+        if (mlock(&data_pool, sizeof(data_pool))) {
+            RP_LOG(LOG_INFO, "Failed to lock the data buffer into memory.\n");
+        }
+        data_pool_locked = true;
+    }
+}
+
+/**
+ * Sends samples of the pool as an IEEE 488.2 definite length block #<n><length><data>, in the
+ * byte order set by ACQ:DATA:BORDER. The samples are swapped in place if needed. The header,
+ * the samples and the terminator go out with one scatter-gather send.
+ */
+static scpi_result_t resultBlock(scpi_t *context, size_t elem_size, uint32_t size) {
+    char header[16];
+    size_t len = elem_size * size;
+    int digits = snprintf(header + 2, sizeof(header) - 2, "%zu", len);
+
+    header[0] = '#';
+    header[1] = '0' + digits;
+
+    if (RP_AcqNeedsSwap()) {
+        RP_SwapBytes(&data_pool, elem_size, size);
+    }
+
+    struct iovec iov[3] = {
+        { .iov_base = header, .iov_len = 2 + digits },
+        { .iov_base = &data_pool, .iov_len = len },
+        { .iov_base = "\r\n", .iov_len = 2 },
+    };
+    if (context->user_context == NULL ||
+        !RP_ConnWritev((scpi_conn_t *)context->user_context, iov, 3)) {
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t resultDataV(scpi_t *context, uint32_t size) {
+    lockDataPool();
+    if (context->binary_output) {
+        return resultBlock(context, sizeof(float), size);
+    }
+    SCPI_ResultBufferFloat(context, data_pool.v, size);
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t resultDataRaw(scpi_t *context, uint32_t size) {
+    lockDataPool();
+    if (context->binary_output) {
+        return resultBlock(context, sizeof(int16_t), size);
+    }
+    SCPI_ResultBufferInt16(context, data_pool.raw, size);
+    return SCPI_RES_OK;
+}
+
 scpi_result_t RP_AcqSetDataFormat(scpi_t *context) {
     const char * param;
     size_t param_len;
@@ -609,6 +692,38 @@ scpi_result_t RP_AcqScpiDataUnitsQ(scpi_t *context){
     return SCPI_RES_OK;
 }
 
+scpi_result_t RP_AcqByteOrder(scpi_t *context) {
+
+    int32_t choice;
+
+    /* Read BORDER parameters */
+    if(!SCPI_ParamChoice(context, scpi_RpByteOrder, &choice, true)){
+        RP_LOG(LOG_ERR, "*ACQ:DATA:BORDER Missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    /* Set global byte order of the binary blocks */
+    order = choice;
+
+    RP_LOG(LOG_INFO, "*ACQ:DATA:BORDER Successfully set byte order.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqByteOrderQ(scpi_t *context){
+
+    const char *name;
+
+    if(!SCPI_ChoiceToName(scpi_RpByteOrder, order, &name)){
+        RP_LOG(LOG_ERR, "*ACQ:DATA:BORDER? Failed to get byte order.\n");
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultMnemonic(context, name);
+
+    RP_LOG(LOG_INFO, "*ACQ:DATA:BORDER? Successfully returned byte order to client.\n");
+    return SCPI_RES_OK;
+}
+
 scpi_result_t RP_AcqDataPosQ(scpi_t *context) {
     
     uint32_t start, end;
@@ -631,28 +746,32 @@ scpi_result_t RP_AcqDataPosQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
-    uint32_t size = end - start;
+    uint32_t size = ADC_BUFFER_SIZE;
+    scpi_result_t res;
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
-        result = rp_AcqGetDataPosV(channel, start, end, buffer, &size);
+        result = rp_AcqGetDataPosV(channel, start, end, data_pool.v, &size);
         
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA:STA:END? Failed to get data in volts: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
         
-        SCPI_ResultBufferFloat(context, buffer, size);
+        res = resultDataV(context, size);
 
     }else{
-        int16_t buffer[size];
-        result = rp_AcqGetDataPosRaw(channel, start, end, buffer, &size);
+        result = rp_AcqGetDataPosRaw(channel, start, end, data_pool.raw, &size);
         
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA:STA:END? Failed to get raw data: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
 
-        SCPI_ResultBufferInt16(context, buffer, size);
+        res = resultDataRaw(context, size);
+    }
+
+    if(res != SCPI_RES_OK){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA:STA:END? Failed to send data.\n");
+        return res;
     }
 
     RP_LOG(LOG_INFO, "*ACQ:SOUR#:DATA:STA:END? Successfully returned data to client.\n");
@@ -682,29 +801,31 @@ scpi_result_t RP_AcqDataQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
-    uint32_t size_buff;
-    rp_AcqGetBufSize(&size_buff);
+    scpi_result_t res;
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size_buff - start];
-        result = rp_AcqGetDataV(channel, start, &size, buffer);
+        result = rp_AcqGetDataV(channel, start, &size, data_pool.v);
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:DATA:STA:N? Failed to get "
             "data in volts: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
 
-        SCPI_ResultBufferFloat(context, buffer, size);
+        res = resultDataV(context, size);
 
     }else{
-        int16_t buffer[size_buff - start];
-        result = rp_AcqGetDataRaw(channel, start, &size, buffer);
+        result = rp_AcqGetDataRaw(channel, start, &size, data_pool.raw);
 
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:DATA:STA:N? Failed to get raw data: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
 
-        SCPI_ResultBufferInt16(context, buffer, size);
+        res = resultDataRaw(context, size);
+    }
+
+    if(res != SCPI_RES_OK){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:DATA:STA:N? Failed to send data.\n");
+        return res;
     }
 
     RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:DATA:STA:N? Successfully returned data.\n");
@@ -722,27 +843,31 @@ scpi_result_t RP_AcqDataOldestAllQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
     
-    rp_AcqGetBufSize(&size);
+    size = ADC_BUFFER_SIZE;
+    scpi_result_t res;
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
-        result = rp_AcqGetOldestDataV(channel, &size, buffer);
+        result = rp_AcqGetOldestDataV(channel, &size, data_pool.v);
 
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA? Failed to get data in volt: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
 
-        SCPI_ResultBufferFloat(context, buffer, size);
+        res = resultDataV(context, size);
 
     }else{
-        int16_t buffer[size];
-        result = rp_AcqGetOldestDataRaw(channel, &size, buffer);
+        result = rp_AcqGetOldestDataRaw(channel, &size, data_pool.raw);
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA? Failed to get raw data: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
 
-        SCPI_ResultBufferInt16(context, buffer, size);
+        res = resultDataRaw(context, size);
+    }
+
+    if(res != SCPI_RES_OK){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA? Failed to send data.\n");
+        return res;
     }
 
     RP_LOG(LOG_INFO, "*ACQ:SOUR#:DATA? Successfully returned data.\n");
@@ -765,9 +890,9 @@ scpi_result_t RP_AcqOldestDataQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
+    scpi_result_t res;
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
-        result = rp_AcqGetOldestDataV(channel, &size, buffer);
+        result = rp_AcqGetOldestDataV(channel, &size, data_pool.v);
 
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA:OLD:N? Failed to get data in "
@@ -776,17 +901,21 @@ scpi_result_t RP_AcqOldestDataQ(scpi_t *context) {
             return SCPI_RES_ERR;
         }
 
-        SCPI_ResultBufferFloat(context, buffer, size);
+        res = resultDataV(context, size);
 
     }else{
-        int16_t buffer[size];
-        result = rp_AcqGetOldestDataRaw(channel, &size, buffer);
+        result = rp_AcqGetOldestDataRaw(channel, &size, data_pool.raw);
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA:OLD:N? Failed to get raw data: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
 
-        SCPI_ResultBufferInt16(context, buffer, size);
+        res = resultDataRaw(context, size);
+    }
+
+    if(res != SCPI_RES_OK){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA:OLD:N? Failed to send data.\n");
+        return res;
     }
 
     RP_LOG(LOG_INFO, "*ACQ:SOUR#:DATA:OLD:N? Successfully returned data to client.");
@@ -809,9 +938,9 @@ scpi_result_t RP_AcqLatestDataQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
+    scpi_result_t res;
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
-        result = rp_AcqGetLatestDataV(channel, &size, buffer);
+        result = rp_AcqGetLatestDataV(channel, &size, data_pool.v);
 
         if(result != RP_OK){
             RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:DATA:LAT:N? Failed to "
@@ -819,17 +948,22 @@ scpi_result_t RP_AcqLatestDataQ(scpi_t *context) {
             return SCPI_RES_ERR;
         }
 
-        SCPI_ResultBufferFloat(context, buffer, size);
+        res = resultDataV(context, size);
     }else{
-        int16_t buffer[size];
-        result = rp_AcqGetLatestDataRaw(channel, &size, buffer);
+        result = rp_AcqGetLatestDataRaw(channel, &size, data_pool.raw);
 
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:DATA:LAT:N? Failed to "
                 "get raw data: %s\n", rp_GetError(result));
+            return SCPI_RES_ERR;
         }
 
-        SCPI_ResultBufferInt16(context, buffer, size);
+        res = resultDataRaw(context, size);
+    }
+
+    if(res != SCPI_RES_OK){
+        RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:DATA:LAT:N? Failed to send data.\n");
+        return res;
     }
 
     RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:DATA:LAT:N? Successfully returned data to client.\n");
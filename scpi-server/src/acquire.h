@@ -24,7 +24,16 @@ typedef enum {
     RP_SCPI_RAW,
 } rp_scpi_acq_unit_t;
 
+typedef enum {
+    RP_SCPI_BIG_ENDIAN,
+    RP_SCPI_LITTLE_ENDIAN,
+} rp_scpi_acq_order_t;
+
+extern rp_scpi_acq_unit_t unit;
+extern const scpi_choice_def_t scpi_RpTrigSrc[];
+
 int RP_AcqSetDefaultValues();
+bool RP_AcqNeedsSwap();
 scpi_result_t RP_AcqSetDataFormat(scpi_t *context);
 scpi_result_t RP_AcqStart(scpi_t * context);
 scpi_result_t RP_AcqStop(scpi_t *context);
@@ -51,6 +60,8 @@ scpi_result_t RP_AcqWritePointerAtTrigQ(scpi_t * context);
 scpi_result_t RP_AcqScpiDataUnits(scpi_t * context);
 scpi_result_t RP_AcqScpiDataUnitsQ(scpi_t *context);
 scpi_result_t RP_AcqScpiDataFormat(scpi_t * context);
+scpi_result_t RP_AcqByteOrder(scpi_t * context);
+scpi_result_t RP_AcqByteOrderQ(scpi_t *context);
 scpi_result_t RP_AcqDataPosQ(scpi_t * context);
 scpi_result_t RP_AcqDataQ(scpi_t * context);
 scpi_result_t RP_AcqDataOldestAllQ(scpi_t * context);
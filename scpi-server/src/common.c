@@ -29,3 +29,20 @@ int RP_ParseChArgv(scpi_t *context, rp_channel_t *channel){
     
     return RP_OK;
 }
+
+/* Swap the byte order of 16 or 32 bit elements in place */
+void RP_SwapBytes(void *data, size_t elem_size, uint32_t count){
+
+    if (elem_size == sizeof(uint32_t)) {
+        uint32_t *w = data;
+        for (uint32_t i = 0; i < count; i++) {
+            w[i] = __builtin_bswap32(w[i]);
+        }
+    }
+    else if (elem_size == sizeof(uint16_t)) {
+        uint16_t *h = data;
+        for (uint32_t i = 0; i < count; i++) {
+            h[i] = __builtin_bswap16(h[i]);
+        }
+    }
+}
@@ -36,5 +36,6 @@ syslog(__VA_ARGS__);
 #endif
 
 int RP_ParseChArgv(scpi_t *context, rp_channel_t *channel);
+void RP_SwapBytes(void *data, size_t elem_size, uint32_t count);
 
 #endif /* COMMON_H_ */
@@ -15,13 +15,17 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <syslog.h>
 
 #include "api_cmd.h"
 #include "common.h"
+#include "scpi-server.h"
 #include "dpin.h"
 #include "apin.h"
 #include "acquire.h"
+#include "stream.h"
+#include "sequence.h"
 #include "generate.h"
 #include "scpi/error.h"
 #include "scpi/ieee488.h"
@@ -36,24 +40,10 @@ bool RST_executed = FALSE;
  */
 size_t SCPI_Write(scpi_t * context, const char * data, size_t len) {
 
-    size_t total = 0;
-
     if (context->user_context != NULL) {
-        int fd = *(int *)(context->user_context);
-        while (len > 0) {
-            size_t written =  write(fd, data, len);
-            if (written < 0) {
-                syslog(LOG_ERR,
-                    "Failed to write into the socket. Should send %zu bytes. Could send only %zu bytes",
-                    len, written);
-                return total;
-            }
-            len -= written;
-            data += written;
-            total += written;
-        }
+        return RP_ConnWrite((scpi_conn_t *)context->user_context, data, len);
     }
-    return total;
+    return 0;
 }
 
 scpi_result_t SCPI_Flush(scpi_t * context) {
@@ -182,12 +172,35 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "ACQ:DATA:UNITS", .callback             = RP_AcqScpiDataUnits,},
     {.pattern = "ACQ:DATA:UNITS?", .callback            = RP_AcqScpiDataUnitsQ,},
     {.pattern = "ACQ:DATA:FORMAT", .callback            = RP_AcqSetDataFormat,},
+    {.pattern = "ACQ:DATA:BORDER", .callback            = RP_AcqByteOrder,},
+    {.pattern = "ACQ:DATA:BORDER?", .callback           = RP_AcqByteOrderQ,},
     {.pattern = "ACQ:SOUR#:DATA:STA:END?", .callback    = RP_AcqDataPosQ,},
     {.pattern = "ACQ:SOUR#:DATA:STA:N?", .callback      = RP_AcqDataQ,},
     {.pattern = "ACQ:SOUR#:DATA:OLD:N?", .callback      = RP_AcqOldestDataQ,},
     {.pattern = "ACQ:SOUR#:DATA?", .callback            = RP_AcqDataOldestAllQ,},
     {.pattern = "ACQ:SOUR#:DATA:LAT:N?", .callback      = RP_AcqLatestDataQ,},
     {.pattern = "ACQ:BUF:SIZE?", .callback              = RP_AcqBufferSizeQ,},
+    {.pattern = "ACQ:STREAM:DEC", .callback             = RP_AcqStreamDecimation,},
+    {.pattern = "ACQ:STREAM:DEC?", .callback            = RP_AcqStreamDecimationQ,},
+    {.pattern = "ACQ:STREAM:BLOCK", .callback           = RP_AcqStreamBlock,},
+    {.pattern = "ACQ:STREAM:BLOCK?", .callback          = RP_AcqStreamBlockQ,},
+    {.pattern = "ACQ:STREAM:CH", .callback              = RP_AcqStreamChannels,},
+    {.pattern = "ACQ:STREAM:CH?", .callback             = RP_AcqStreamChannelsQ,},
+    {.pattern = "ACQ:STREAM:START", .callback           = RP_AcqStreamStart,},
+    {.pattern = "ACQ:STREAM:STOP", .callback            = RP_AcqStreamStop,},
+    {.pattern = "ACQ:STREAM:STAT?", .callback           = RP_AcqStreamStatQ,},
+    {.pattern = "ACQ:STREAM:PORT?", .callback           = RP_AcqStreamPortQ,},
+    {.pattern = "ACQ:SEQ:N", .callback                  = RP_AcqSeqRecords,},
+    {.pattern = "ACQ:SEQ:N?", .callback                 = RP_AcqSeqRecordsQ,},
+    {.pattern = "ACQ:SEQ:LEN", .callback                = RP_AcqSeqLength,},
+    {.pattern = "ACQ:SEQ:LEN?", .callback               = RP_AcqSeqLengthQ,},
+    {.pattern = "ACQ:SEQ:TRIG", .callback               = RP_AcqSeqTriggerSrc,},
+    {.pattern = "ACQ:SEQ:TRIG?", .callback              = RP_AcqSeqTriggerSrcQ,},
+    {.pattern = "ACQ:SEQ:START", .callback              = RP_AcqSeqStart,},
+    {.pattern = "ACQ:SEQ:STOP", .callback               = RP_AcqSeqStop,},
+    {.pattern = "ACQ:SEQ:COUNT?", .callback             = RP_AcqSeqCountQ,},
+    {.pattern = "ACQ:SEQ:STAT?", .callback              = RP_AcqSeqStatQ,},
+    {.pattern = "ACQ:SEQ:DATA?", .callback              = RP_AcqSeqDataQ,},
 
     /* Generate */
     {.pattern = "GEN:RST", .callback                    = RP_GenReset,},
@@ -230,21 +243,220 @@ static scpi_interface_t scpi_interface = {
     .reset = SCPI_Reset,
 };
 
-#define SCPI_INPUT_BUFFER_LENGTH 538688
-static char scpi_input_buffer[SCPI_INPUT_BUFFER_LENGTH];
+#define SCPI_CMD_COUNT (sizeof(scpi_commands) / sizeof(scpi_commands[0]) - 1)
+
+/* Slots of the dispatch hash table, a power of two of at least 2 * SCPI_CMD_COUNT */
+#define DISPATCH_HASH_LEN 256
+#define DISPATCH_KEY_LEN 48
 
-static scpi_reg_val_t scpi_regs[SCPI_REG_COUNT];
+/* The probing of dispatchBuild() and dispatchFind() ends at an empty slot, there must be one */
+_Static_assert(2 * SCPI_CMD_COUNT <= DISPATCH_HASH_LEN, "DISPATCH_HASH_LEN is too small for scpi_commands[]");
 
+/* Commands of equal dispatch key, in the order of scpi_commands[] */
+typedef struct {
+    char key[DISPATCH_KEY_LEN];
+    uint16_t first;                 // index into dispatch_lists
+} dispatch_group_t;
 
+/* The groups, each terminated by SCPI_CMD_LIST_END */
+static scpi_command_t dispatch_lists[2 * SCPI_CMD_COUNT];
+static dispatch_group_t dispatch_groups[SCPI_CMD_COUNT];
+/* Open addressing hash table of the keys, index + 1 of each group, 0 is empty */
+static uint16_t dispatch_hash[DISPATCH_HASH_LEN];
+static bool dispatch_built = false;
+
+
+/* Template of the contexts of the connections, the buffer and the registers are allocated
+ * for each connection by RP_ContextCreate() */
 scpi_t scpi_context = {
     .cmdlist = scpi_commands,
     .buffer = {
-        .length = SCPI_INPUT_BUFFER_LENGTH,
-        .data = scpi_input_buffer,
+        .length = 0,
+        .data = NULL,
     },
     .interface = &scpi_interface,
-    .registers = scpi_regs,
+    .registers = NULL,
     .units = scpi_units_def,
     .idn = {"REDPITAYA", "INSTR2014", NULL, "01-02"},
 };
 
+
+/* FNV-1a hash of a dispatch key */
+static uint32_t dispatchHash(const char *key) {
+    uint32_t h = 2166136261U;
+
+    while (*key) {
+        h ^= (uint8_t) *key++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/**
+ * Builds the dispatch key of a command header or of a pattern: upper case, without the leading
+ * colon, without the numeric suffixes of the header and the '#' of the pattern. Thus a header
+ * has the key of each pattern it can match, except for the patterns with long forms or optional
+ * parts, which are not hashed.
+ * @param header   Header or pattern
+ * @param len      Length of the header, it ends at the first white space as well
+ * @param pattern  True for a pattern
+ * @param key      Gets the key
+ * @return true, or false if no key is built and the whole command list is used.
+ */
+static bool dispatchKey(const char *header, size_t len, bool pattern, char key[DISPATCH_KEY_LEN]) {
+    size_t n = 0;
+    size_t i = 0;
+
+    if (len && header[0] == ':') {
+        i++;
+    }
+    for (; i < len && !isspace((unsigned char) header[i]); i++) {
+        char c = header[i];
+
+        if (pattern && (islower((unsigned char) c) || c == '[')) {
+            return false;
+        }
+        if (c == ';') {
+            return false;   // compound commands are left to the parser
+        }
+        if (c == '#' && pattern) {
+            continue;
+        }
+        if ((c == ':' || c == '?') && !pattern) {
+            while (n && isdigit((unsigned char) key[n - 1])) {
+                n--;
+            }
+        }
+        if (n + 1 >= DISPATCH_KEY_LEN) {
+            return false;
+        }
+        key[n++] = toupper((unsigned char) c);
+    }
+    if (!pattern) {
+        while (n && isdigit((unsigned char) key[n - 1])) {
+            n--;
+        }
+    }
+    key[n] = '\0';
+    return n > 0;
+}
+
+static int dispatchFind(const char *key) {
+    uint32_t h = dispatchHash(key);
+    int idx;
+
+    while ((idx = dispatch_hash[h & (DISPATCH_HASH_LEN - 1)])) {
+        if (!strcmp(dispatch_groups[idx - 1].key, key)) {
+            return idx - 1;
+        }
+        h++;
+    }
+    return -1;
+}
+
+/**
+ * Groups the hashable commands by their dispatch key.
+ */
+static void dispatchBuild() {
+    int groups = 0;
+    int pos = 0;
+    char key[DISPATCH_KEY_LEN];
+
+    for (int i = 0; scpi_commands[i].pattern != NULL; i++) {
+        const char *pattern = scpi_commands[i].pattern;
+
+        if (!dispatchKey(pattern, strlen(pattern), true, key) || dispatchFind(key) >= 0) {
+            continue;
+        }
+
+        // A new group, with all the commands of its key
+        dispatch_group_t *group = &dispatch_groups[groups];
+        strcpy(group->key, key);
+        group->first = pos;
+        for (int j = i; scpi_commands[j].pattern != NULL; j++) {
+            char other[DISPATCH_KEY_LEN];
+            if (dispatchKey(scpi_commands[j].pattern, strlen(scpi_commands[j].pattern), true, other) &&
+                !strcmp(other, key)) {
+                dispatch_lists[pos++] = scpi_commands[j];
+            }
+        }
+        dispatch_lists[pos].pattern = NULL;
+        dispatch_lists[pos++].callback = NULL;
+
+        uint32_t h = dispatchHash(key);
+        while (dispatch_hash[h & (DISPATCH_HASH_LEN - 1)]) {
+            h++;    // linear probing
+        }
+        dispatch_hash[h & (DISPATCH_HASH_LEN - 1)] = ++groups;
+    }
+    dispatch_built = true;
+}
+
+/**
+ * Executes one command line. The header is looked up in the dispatch table, so the parser
+ * only matches the patterns of its key instead of walking all of scpi_commands[]. Headers
+ * without a key, such as long forms, go through the whole list, as do lines that the parser
+ * splits into several commands at a '\n' before the terminator.
+ * @param context  Context of the connection
+ * @param data     Command line with its terminator
+ * @param len      Length of the line
+ */
+void RP_ContextInput(scpi_t *context, const char *data, size_t len) {
+    char key[DISPATCH_KEY_LEN];
+    int group = -1;
+    size_t body = len;
+
+    while (body && (data[body - 1] == '\r' || data[body - 1] == '\n')) {
+        body--;
+    }
+    if (!memchr(data, ';', len) && !memchr(data, '\r', body) && !memchr(data, '\n', body) &&
+        dispatchKey(data, len, false, key)) {
+        group = dispatchFind(key);
+    }
+
+    if (group >= 0) {
+        context->cmdlist = &dispatch_lists[dispatch_groups[group].first];
+    }
+    SCPI_Input(context, data, len);
+    context->cmdlist = scpi_commands;
+}
+
+/**
+ * Creates the SCPI context of a connection from the template, with its own input buffer
+ * and registers.
+ * @param user_context  Connection the output is written to
+ * @return The context, or NULL if out of memory.
+ */
+scpi_t *RP_ContextCreate(void *user_context) {
+    scpi_t *context = malloc(sizeof(scpi_t));
+    char *buffer = malloc(SCPI_INPUT_BUFFER_LENGTH);
+    scpi_reg_val_t *regs = calloc(SCPI_REG_COUNT, sizeof(scpi_reg_val_t));
+
+    if (!context || !buffer || !regs) {
+        free(context);
+        free(buffer);
+        free(regs);
+        return NULL;
+    }
+
+    *context = scpi_context;
+    context->buffer.data = buffer;
+    context->buffer.length = SCPI_INPUT_BUFFER_LENGTH;
+    context->registers = regs;
+    context->user_context = user_context;
+    context->binary_output = false;
+    SCPI_Init(context);
+
+    if (!dispatch_built) {
+        dispatchBuild();
+    }
+    return context;
+}
+
+void RP_ContextDestroy(scpi_t *context) {
+    if (context) {
+        free(context->buffer.data);
+        free(context->registers);
+        free(context);
+    }
+}
@@ -17,7 +17,14 @@
 
 #include "scpi/scpi.h"
 
+/* Input buffer of the parser, the longest command line a connection can send */
+#define SCPI_INPUT_BUFFER_LENGTH 538688
+
 extern scpi_t scpi_context;
 
+scpi_t *RP_ContextCreate(void *user_context);
+void RP_ContextDestroy(scpi_t *context);
+void RP_ContextInput(scpi_t *context, const char *data, size_t len);
+
 
 #endif /* SCPI_COMMANDS_H_ */
@@ -3,6 +3,20 @@
  *
  * @brief Red Pitaya Scpi server implementation
  *
+ * A single process serves all clients from one epoll event loop on non-blocking sockets. Each
+ * connection has its own parse buffer and SCPI context. All commands received at once are
+ * executed in order as a batch, their responses are queued per connection and sent together,
+ * so a script of many commands costs one round trip. A connection whose queued output exceeds
+ * OUT_HIGH_WATER is not read any more until the queue drains below OUT_LOW_WATER, thus a slow
+ * client does not make the server buffer without bounds.
+ *
+ * The event loop thread is the only one that executes commands, so it owns the hardware and all
+ * clients see the same generator and acquisition state. Work that is not triggered by a client,
+ * such as streaming, is done by the tick callback of RP_SetTick() in the same thread.
+ *
+ * Clients connecting to DATA_PORT open the data connection, it takes no commands and receives
+ * the output of the streaming commands. A new data connection replaces the previous one.
+ *
  * @Author Red Pitaya
  *
  * (c) Red Pitaya  http://www.redpitaya.com
@@ -12,13 +26,18 @@
  * for more details on the language used herein.
  */
 
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 
 #include <netinet/in.h>
-#include <sys/prctl.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
 #include <errno.h>
 #include <arpa/inet.h>
 #include <signal.h>
@@ -26,6 +45,7 @@
 #include <syslog.h>
 
 #include "scpi-commands.h"
+#include "scpi-server.h"
 #include "common.h"
 
 #include "scpi/parser.h"
@@ -37,19 +57,50 @@
 #define LISTEN_BACKLOG 50
 #define LISTEN_PORT 5000
 #define MAX_BUFF_SIZE 1024
+#define MAX_EVENTS 32
 
-static bool app_exit = false;
-static char delimiter[] = "\r\n";
+/* Bytes received at once, and received before the commands are executed at most */
+#define RECV_CHUNK (16 * 1024)
+#define IN_BATCH_MAX (64 * 1024)
 
+/* Reading of a connection is paused above OUT_HIGH_WATER bytes of queued output and
+ * resumed below OUT_LOW_WATER */
+#define OUT_HIGH_WATER (1024 * 1024)
+#define OUT_LOW_WATER  (64 * 1024)
 
-static void handleCloseChildEvents()
-{
-    struct sigaction sigchld_action = {
-            .sa_handler = SIG_DFL,
-            .sa_flags = SA_NOCLDWAIT
-    };
-    sigaction(SIGCHLD, &sigchld_action, NULL);
-}
+struct scpi_conn_s {
+    int fd;
+    struct sockaddr_in addr;
+    scpi_t *context;
+
+    char *in_buff;          // received bytes not parsed yet
+    size_t in_len;
+    size_t in_size;
+
+    char *out_buff;         // queued output, out_buff[out_pos .. out_len - 1] is not sent yet
+    size_t out_pos;
+    size_t out_len;
+    size_t out_size;
+
+    bool reading;           // EPOLLIN is enabled
+    bool writing;           // EPOLLOUT is enabled
+    bool failed;            // the socket failed or the client went away
+    bool eof;               // the client has closed its side, no more input
+    bool corked;            // TCP_CORK is set for a batch of commands
+};
+
+static int epollfd = -1;
+
+/* The event sources besides the connections, their addresses tag the events */
+static int listenfd = -1;
+static int datafd = -1;
+static int tickfd = -1;
+
+static scpi_conn_t *data_conn = NULL;
+static void (*tick_fn)(void) = NULL;
+
+static bool app_exit = false;
+static char delimiter[] = "\r\n";
 
 
 static void termSignalHandler(int signum)
@@ -66,6 +117,9 @@ static void installTermSignalHandler()
     action.sa_handler = termSignalHandler;
     sigaction(SIGTERM, &action, NULL);
     sigaction(SIGINT, &action, NULL);
+
+    // A client closing its socket must not terminate the server
+    signal(SIGPIPE, SIG_IGN);
 }
 
 /**
@@ -113,87 +167,480 @@ void LogMessage(char *m, size_t len) {
     RP_LOG(LOG_INFO, "Processing command: %s\n", buff);
 }
 
+static void updateEvents(scpi_conn_t *conn)
+{
+    bool reading = !conn->failed && !conn->eof &&
+                   conn->out_len - conn->out_pos < (conn->reading ? OUT_HIGH_WATER : OUT_LOW_WATER);
+    bool writing = !conn->failed && conn->out_len > conn->out_pos;
+
+    if (reading != conn->reading || writing != conn->writing) {
+        // A hang up is level-triggered as well, it is watched only while the input is read
+        struct epoll_event ev = {
+            .events = (reading ? EPOLLIN | EPOLLRDHUP : 0) | (writing ? EPOLLOUT : 0),
+            .data.ptr = conn
+        };
+        epoll_ctl(epollfd, EPOLL_CTL_MOD, conn->fd, &ev);
+        conn->reading = reading;
+        conn->writing = writing;
+    }
+}
+
 /**
- * This is main method of every child process. Here communication with client is handled.
- * @param connfd The communication port
- * @return
+ * Sends as much of the queued output as the socket takes.
  */
-static int handleConnection(int connfd) {
-    int read_size;
+static void flushConnection(scpi_conn_t *conn)
+{
+    while (!conn->failed && conn->out_pos < conn->out_len) {
+        ssize_t sent = send(conn->fd, conn->out_buff + conn->out_pos, conn->out_len - conn->out_pos, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                RP_LOG(LOG_ERR, "Failed to write into the socket (%s)", strerror(errno));
+                conn->failed = true;
+            }
+            break;
+        }
+        conn->out_pos += sent;
+    }
 
-    size_t message_len = MAX_BUFF_SIZE;
-    char *message_buff = malloc(message_len);
-    char buffer[MAX_BUFF_SIZE];
-    size_t msg_end = 0;
+    if (conn->out_pos == conn->out_len) {
+        conn->out_pos = 0;
+        conn->out_len = 0;
+    }
+}
 
-    installTermSignalHandler();
+size_t RP_ConnWrite(scpi_conn_t *conn, const char *data, size_t len)
+{
+    if (conn->failed) {
+        return 0;
+    }
 
-    prctl( 1, SIGTERM );
+    // Reclaim the sent part before growing the queue
+    if (conn->out_pos && conn->out_len + len > conn->out_size) {
+        memmove(conn->out_buff, conn->out_buff + conn->out_pos, conn->out_len - conn->out_pos);
+        conn->out_len -= conn->out_pos;
+        conn->out_pos = 0;
+    }
+    if (conn->out_len + len > conn->out_size) {
+        size_t size = MAX(conn->out_size, MAX_BUFF_SIZE);
+        while (size < conn->out_len + len) {
+            size *= 2;
+        }
+        char *buff = realloc(conn->out_buff, size);
+        if (!buff) {
+            RP_LOG(LOG_ERR, "Failed to queue %zu bytes of output", len);
+            conn->failed = true;
+            return 0;
+        }
+        conn->out_buff = buff;
+        conn->out_size = size;
+    }
 
-    RP_LOG(LOG_INFO, "Waiting for first client request.");
+    memcpy(conn->out_buff + conn->out_len, data, len);
+    conn->out_len += len;
+    return len;
+}
 
-    //Receive a message from client
-    while( (read_size = recv(connfd , buffer , MAX_BUFF_SIZE , 0)) > 0 )
-    {
-        if (app_exit) {
+size_t RP_ConnWritev(scpi_conn_t *conn, const struct iovec *iov, int iovcnt)
+{
+    size_t total = 0;
+    size_t sent = 0;
+
+    for (int i = 0; i < iovcnt; i++) {
+        total += iov[i].iov_len;
+    }
+    if (conn->failed) {
+        return 0;
+    }
+
+    // Queued output goes first, the pieces can bypass the queue only when it is empty
+    if (conn->out_pos == conn->out_len) {
+        struct msghdr msg = { .msg_iov = (struct iovec *)iov, .msg_iovlen = iovcnt };
+        ssize_t n;
+
+        while ((n = sendmsg(conn->fd, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                RP_LOG(LOG_ERR, "Failed to write into the socket (%s)", strerror(errno));
+                conn->failed = true;
+                return 0;
+            }
+            n = 0;
+        }
+        sent = n;
+    }
+
+    for (int i = 0; i < iovcnt; i++) {
+        if (sent >= iov[i].iov_len) {
+            sent -= iov[i].iov_len;
+            continue;
+        }
+        if (!RP_ConnWrite(conn, (const char *)iov[i].iov_base + sent, iov[i].iov_len - sent)) {
+            return 0;
+        }
+        sent = 0;
+    }
+    return total;
+}
+
+/**
+ * Holds back partial segments while a batch of commands is executed, the responses of the
+ * batch leave in full segments when the cork is removed.
+ */
+static void setCork(scpi_conn_t *conn, bool on)
+{
+    int value = on;
+
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+    conn->corked = on;
+}
+
+/**
+ * Executes the complete commands of the parse buffer in order, until the output queue is full.
+ * The responses are only queued, they are sent together by flushConnection().
+ */
+static void processCommands(scpi_conn_t *conn)
+{
+    char *m = conn->in_buff;
+    size_t pos = -1;
+    int count = 0;
+
+    while (conn->out_len - conn->out_pos < OUT_HIGH_WATER &&
+           (pos = getNextCommand(m, conn->in_len)) != -1) {
+
+        if (++count == 2 && !conn->corked) {
+            setCork(conn, true);
+        }
+
+        // Log out message
+        LogMessage(m, pos);
+
+        //Parse the message and return response
+        RP_ContextInput(conn->context, m, pos);
+        m += pos;
+        conn->in_len -= pos;
+    }
+
+    // Move the rest of the message to the beginning of the buffer
+    if (conn->in_buff != m && conn->in_len > 0) {
+        memmove(conn->in_buff, m, conn->in_len);
+    }
+}
+
+/**
+ * Executes the commands and sends their responses, as long as the socket takes the output.
+ */
+static void serveConnection(scpi_conn_t *conn)
+{
+    do {
+        processCommands(conn);
+        flushConnection(conn);
+    } while (!conn->failed && conn->out_len - conn->out_pos < OUT_HIGH_WATER &&
+             getNextCommand(conn->in_buff, conn->in_len) != -1);
+
+    if (conn->corked) {
+        setCork(conn, false);
+    }
+}
+
+/**
+ * Reads what the client has sent, IN_BATCH_MAX bytes at most, and executes the complete commands
+ * as one batch, with one send of the responses. The rest is read on the next wake-up, so a client
+ * that sends without pause does not hold up the others.
+ */
+static void readConnection(scpi_conn_t *conn)
+{
+    size_t batch = 0;
+
+    if (conn->eof || conn->out_len - conn->out_pos >= OUT_HIGH_WATER) {
+        return;
+    }
+
+    while (!conn->failed && batch < IN_BATCH_MAX) {
+        // First make sure that message buffer is large enough. A line longer than the
+        // parser takes is never completed, the client is dropped.
+        if (conn->in_len >= SCPI_INPUT_BUFFER_LENGTH) {
+            if (getNextCommand(conn->in_buff, conn->in_len) == -1) {
+                RP_LOG(LOG_ERR, "Command exceeds %d bytes", SCPI_INPUT_BUFFER_LENGTH);
+                conn->failed = true;
+                return;
+            }
             break;
         }
+        if (conn->in_size - conn->in_len < RECV_CHUNK) {
+            size_t size = conn->in_size;
+            while (size - conn->in_len < RECV_CHUNK) {
+                size *= 2;
+            }
+            size = MIN(size, SCPI_INPUT_BUFFER_LENGTH + RECV_CHUNK);
+            char *buff = realloc(conn->in_buff, size);
+            if (!buff) {
+                RP_LOG(LOG_ERR, "Failed to grow the message buffer");
+                conn->failed = true;
+                return;
+            }
+            conn->in_buff = buff;
+            conn->in_size = size;
+        }
+
+        ssize_t read_size = recv(conn->fd, conn->in_buff + conn->in_len, conn->in_size - conn->in_len, 0);
 
-        // First make sure that message buffer is large enough
-        while (msg_end + read_size >= message_len) {
-            message_len *= 2;
-            message_buff = realloc(message_buff, message_len);
+        if (read_size == 0) {
+            // The commands received so far are still executed and answered
+            RP_LOG(LOG_INFO, "Client has closed its side of the connection");
+            conn->eof = true;
+            break;
+        }
+        if (read_size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                RP_LOG(LOG_ERR, "Receive message failed (%s)", strerror(errno));
+                conn->failed = true;
+            }
+            break;
         }
+        batch += read_size;
 
-        // Copy read buffer into message buffer
-        memcpy(message_buff + msg_end, buffer, read_size);
-        msg_end += read_size;
+        // The data connection takes no commands, its input is discarded
+        if (conn->context) {
+            conn->in_len += read_size;
+        }
+    }
 
-        // Now try to parse each command out
-        char *m = message_buff;
-        size_t pos = -1;
-        while ((pos = getNextCommand(m, msg_end)) != -1) {
+    if (conn->context && !conn->failed) {
+        serveConnection(conn);
+    }
+}
 
-            // Log out message
-            LogMessage(m, pos);
+static void closeConnection(scpi_conn_t *conn)
+{
+    RP_LOG(LOG_INFO, "Closing connection with client ip %s.", inet_ntoa(conn->addr.sin_addr));
+
+    if (conn == data_conn) {
+        data_conn = NULL;
+    }
 
-            //Parse the message and return response
-            SCPI_Input(&scpi_context, m, pos);
-            m += pos;
-            msg_end -= pos;
+    epoll_ctl(epollfd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    RP_ContextDestroy(conn->context);
+    free(conn->in_buff);
+    free(conn->out_buff);
+    free(conn);
+}
+
+static void acceptConnections(int fd, bool data)
+{
+    for (;;) {
+        struct sockaddr_in cliaddr;
+        socklen_t clilen = sizeof(cliaddr);
+        int one = 1;
+
+        int connfd = accept4(fd, (struct sockaddr *)&cliaddr, &clilen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (connfd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                RP_LOG(LOG_ERR, "Failed to accept connection (%s)", strerror(errno));
+            }
+            return;
+        }
+        setsockopt(connfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        scpi_conn_t *conn = calloc(1, sizeof(scpi_conn_t));
+        if (conn) {
+            conn->fd = connfd;
+            conn->addr = cliaddr;
+            conn->in_size = MAX_BUFF_SIZE;
+            conn->in_buff = malloc(conn->in_size);
+            conn->context = data ? NULL : RP_ContextCreate(conn);
+        }
+        if (!conn || !conn->in_buff || (!data && !conn->context)) {
+            RP_LOG(LOG_ERR, "Failed to allocate the connection");
+            if (conn) {
+                RP_ContextDestroy(conn->context);
+                free(conn->in_buff);
+                free(conn);
+            }
+            close(connfd);
+            continue;
+        }
+
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = conn };
+        if (epoll_ctl(epollfd, EPOLL_CTL_ADD, connfd, &ev) == -1) {
+            RP_LOG(LOG_ERR, "Failed to watch the connection (%s)", strerror(errno));
+            RP_ContextDestroy(conn->context);
+            free(conn->in_buff);
+            free(conn);
+            close(connfd);
+            continue;
+        }
+        conn->reading = true;
+
+        if (data) {
+            // The previous data connection is closed by its hang up event
+            if (data_conn) {
+                data_conn->failed = true;
+                shutdown(data_conn->fd, SHUT_RDWR);
+            }
+            data_conn = conn;
         }
 
-        // Move the rest of the message to the beginning of the buffer
-        if (message_buff != m && msg_end > 0) {
-            memmove(message_buff, m, msg_end);
+        RP_LOG(LOG_INFO, "%s connection with client ip %s established.",
+               data ? "Data" : "Command", inet_ntoa(cliaddr.sin_addr));
+    }
+}
+
+/**
+ * Handles the events of a connection. Commands are executed and their responses queued, then
+ * the queue is sent as far as possible. Paused commands resume when the queue has drained.
+ */
+static void handleConnection(scpi_conn_t *conn, uint32_t events)
+{
+    if (events & EPOLLERR) {
+        conn->failed = true;
+    }
+    if (events & EPOLLOUT) {
+        flushConnection(conn);
+        if (conn->out_len - conn->out_pos < OUT_LOW_WATER) {
+            serveConnection(conn);
         }
+    }
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+        readConnection(conn);
+    }
 
-        RP_LOG(LOG_INFO, "Waiting for next client request.\n");
+    // A client that has gone away gets no further output, one that has closed its side gets the
+    // responses of all its commands first. The commands are executed while the queue drains, so
+    // an empty queue means that none are left.
+    if (conn->failed || (conn->eof && conn->out_pos == conn->out_len)) {
+        closeConnection(conn);
+        return;
     }
+    updateEvents(conn);
+}
 
-    free(message_buff);
+scpi_conn_t *RP_DataConn(void)
+{
+    return data_conn;
+}
 
-    RP_LOG(LOG_INFO, "Closing client connection...");
+size_t RP_ConnQueued(scpi_conn_t *conn)
+{
+    return conn->out_len - conn->out_pos;
+}
 
-    if(read_size == 0)
+int RP_SetTick(void (*tick)(void), uint32_t period_us)
+{
+    struct itimerspec its;
+
+    if (tick_fn && tick != tick_fn) {
+        if (!period_us) {
+            return 0;
+        }
+        RP_LOG(LOG_ERR, "The tick is used by another command");
+        return -1;
+    }
+
+    memset(&its, 0, sizeof(its));
+    if (period_us) {
+        its.it_interval.tv_sec = period_us / 1000000;
+        its.it_interval.tv_nsec = (period_us % 1000000) * 1000;
+        its.it_value = its.it_interval;
+    }
+    if (timerfd_settime(tickfd, 0, &its, NULL) == -1) {
+        RP_LOG(LOG_ERR, "Failed to set the tick (%s)", strerror(errno));
+        return -1;
+    }
+    tick_fn = period_us ? tick : NULL;
+    return 0;
+}
+
+static void handleTick()
+{
+    uint64_t expirations;
+
+    if (read(tickfd, &expirations, sizeof(expirations)) == sizeof(expirations) && tick_fn) {
+        tick_fn();
+    }
+}
+
+/**
+ * Sends the output a command or the tick has queued for the data connection. It is done after
+ * all events of a wait are handled, so no pending event refers to a closed connection.
+ */
+static void updateDataConn()
+{
+    if (data_conn) {
+        if (data_conn->failed) {
+            closeConnection(data_conn);
+        }
+        else {
+            flushConnection(data_conn);
+            updateEvents(data_conn);
+        }
+    }
+}
+
+/**
+ * Opens a non-blocking socket listening on a port and adds it to the event loop.
+ * @param port  Port to listen on
+ * @param fd    Gets the socket, its address tags the events
+ * @return 0, or -1 on failure.
+ */
+static int openListener(int port, int *fd)
+{
+    struct sockaddr_in serv_addr;
+
+    // Create a socket
+    *fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (*fd == -1)
     {
-        RP_LOG(LOG_INFO, "Client is disconnected");
-        return 0;
+        RP_LOG(LOG_ERR, "Failed to create a socket (%s)", strerror(errno));
+        perror("Failed to create a socket");
+        return -1;
     }
-    else if(read_size == -1)
+
+    int reuse = 1;
+    setsockopt(*fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    memset(&serv_addr, '0', sizeof(serv_addr));
+
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_addr.sin_port = htons(port);
+
+    if (bind(*fd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
     {
-        RP_LOG(LOG_ERR, "Receive message failed (%s)", strerror(errno));
-        perror("Receive message failed");
-        return 1;
+        RP_LOG(LOG_ERR, "Failed to bind the socket (%s)", strerror(errno));
+        perror("Failed to bind the socket");
+        return -1;
     }
+
+    if (listen(*fd, LISTEN_BACKLOG) == -1)
+    {
+        RP_LOG(LOG_ERR, "Failed to listen on the socket (%s)", strerror(errno));
+        perror("Failed to listen on the socket");
+        return -1;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = fd };
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, *fd, &ev) == -1)
+    {
+        RP_LOG(LOG_ERR, "Failed to watch the socket (%s)", strerror(errno));
+        perror("Failed to watch the socket");
+        return -1;
+    }
+
+    RP_LOG(LOG_INFO, "Server is listening on port %d\n", port);
     return 0;
 }
 
 
 /**
- * Main daemon entrance point. Opens a socket and listens for any incoming connection.
- * When client connects, if forks the conversation into a new socket and the daemon (parent process)
- * waits for another connection. It can handle multiple connections simultaneously.
+ * Main daemon entrance point. Opens the sockets and serves all incoming connections from one event
+ * loop, in the same process.
  * @param argc  not used
  * @param argv  not used
  * @return
@@ -209,12 +656,6 @@ int main(int argc, char *argv[])
 
     installTermSignalHandler();
 
-    int listenfd = 0, connfd = 0;
-    struct sockaddr_in serv_addr;
-
-    // Handle close child events
-    handleCloseChildEvents();
-
 
     int result = rp_Init();
     if (result != RP_OK) {
@@ -228,89 +669,64 @@ int main(int argc, char *argv[])
         return (EXIT_FAILURE);
     }
 
-    // user_context will be pointer to socket
-    scpi_context.user_context = NULL;
-    scpi_context.binary_output = false;
-    SCPI_Init(&scpi_context);
-
-    // Create a socket
-    listenfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (listenfd == -1)
+    epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd == -1)
     {
-        RP_LOG(LOG_ERR, "Failed to create a socket (%s)", strerror(errno));
-        perror("Failed to create a socket");
+        RP_LOG(LOG_ERR, "Failed to create the event loop (%s)", strerror(errno));
+        perror("Failed to create the event loop");
         return (EXIT_FAILURE);
     }
 
-    memset(&serv_addr, '0', sizeof(serv_addr));
-
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    serv_addr.sin_port = htons(LISTEN_PORT);
-
-    if (bind(listenfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) == -1)
+    tickfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct epoll_event tick_ev = { .events = EPOLLIN, .data.ptr = &tickfd };
+    if (tickfd == -1 || epoll_ctl(epollfd, EPOLL_CTL_ADD, tickfd, &tick_ev) == -1)
     {
-        RP_LOG(LOG_ERR, "Failed to bind the socket (%s)", strerror(errno));
-        perror("Failed to bind the socket");
+        RP_LOG(LOG_ERR, "Failed to create the tick (%s)", strerror(errno));
+        perror("Failed to create the tick");
         return (EXIT_FAILURE);
     }
 
-    if (listen(listenfd, LISTEN_BACKLOG) == -1)
+    if (openListener(LISTEN_PORT, &listenfd) || openListener(DATA_PORT, &datafd))
     {
-        RP_LOG(LOG_ERR, "Failed to listen on the socket (%s)", strerror(errno));
-        perror("Failed to listen on the socket");
         return (EXIT_FAILURE);
     }
 
-    RP_LOG(LOG_INFO, "Server is listening on port %d\n", LISTEN_PORT);
-
-    // Socket is opened and listening on port. Now we can accept connections
-    while(1)
+    // Sockets are opened and listening on ports. Now we can serve connections
+    while (!app_exit)
     {
-        struct sockaddr_in cliaddr;
-        socklen_t clilen;
-        clilen = sizeof(cliaddr);
+        struct epoll_event events[MAX_EVENTS];
 
-        connfd = accept(listenfd, (struct sockaddr *)&cliaddr, &clilen);
-
-        if (app_exit == true) {
+        int n = epoll_wait(epollfd, events, MAX_EVENTS, -1);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            RP_LOG(LOG_ERR, "Failed to wait for events (%s)", strerror(errno));
+            perror("Failed to wait for events");
             break;
         }
 
-        if (connfd == -1) {
-            RP_LOG(LOG_ERR, "Failed to accept connection (%s)", strerror(errno));
-            perror("Failed to accept connection\n");
-            return (EXIT_FAILURE);
-        }
-
-        // Fork a child process, which will talk to the client
-        if (!fork()) {
-
-            RP_LOG(LOG_INFO, "Connection with client ip %s established.", inet_ntoa(cliaddr.sin_addr));
-
-            // this is the child process
-            close(listenfd); // child doesn't need the listener
-
-            scpi_context.user_context = &connfd;
-
-            result = handleConnection(connfd);
-
-            close(connfd);
-
-            RP_LOG(LOG_INFO, "Closing connection with client ip %s.", inet_ntoa(cliaddr.sin_addr));
-
-            if (result == 0) {
-                return(EXIT_SUCCESS);
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == &listenfd) {
+                acceptConnections(listenfd, false);
+            }
+            else if (events[i].data.ptr == &datafd) {
+                acceptConnections(datafd, true);
+            }
+            else if (events[i].data.ptr == &tickfd) {
+                handleTick();
             }
             else {
-                return(EXIT_FAILURE);
+                handleConnection((scpi_conn_t *)events[i].data.ptr, events[i].events);
             }
         }
-
-        close(connfd);
+        updateDataConn();
     }
 
+    close(datafd);
     close(listenfd);
+    close(tickfd);
+    close(epollfd);
 
     result = rp_Release();
     if (result != RP_OK) {
@@ -0,0 +1,69 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Scpi server connection interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SCPI_SERVER_H_
+#define SCPI_SERVER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+/** Port of the data connection, it receives the streamed data */
+#define DATA_PORT 5001
+
+/** Client connection, it is the user_context of its SCPI context */
+typedef struct scpi_conn_s scpi_conn_t;
+
+/**
+ * Queues data to be sent to the client, the event loop sends it when the socket is writable.
+ * @param conn  Connection
+ * @param data  Data to send
+ * @param len   Data length
+ * @return len, or 0 if the connection is failing.
+ */
+size_t RP_ConnWrite(scpi_conn_t *conn, const char *data, size_t len);
+
+/**
+ * Sends the pieces of a response with one scatter-gather send when nothing is queued before them,
+ * the part the socket does not take is queued. The pieces are not referenced after the call.
+ * @param conn    Connection
+ * @param iov     Pieces to send
+ * @param iovcnt  Count of pieces
+ * @return Total length of the pieces, or 0 if the connection is failing.
+ */
+size_t RP_ConnWritev(scpi_conn_t *conn, const struct iovec *iov, int iovcnt);
+
+/**
+ * Returns the queued output of a connection.
+ * @param conn  Connection
+ * @return Count of bytes not sent yet.
+ */
+size_t RP_ConnQueued(scpi_conn_t *conn);
+
+/**
+ * Returns the data connection.
+ * @return The connection of the last client on DATA_PORT, or NULL if there is none.
+ */
+scpi_conn_t *RP_DataConn(void);
+
+/**
+ * Calls a function periodically from the event loop, in the thread executing the commands.
+ * One function ticks at a time, another one fails until the tick is stopped.
+ * @param tick       Function to call
+ * @param period_us  Period [us], 0 stops the tick of the function
+ * @return 0, or -1 on failure or if another function ticks.
+ */
+int RP_SetTick(void (*tick)(void), uint32_t period_us);
+
+#endif /* SCPI_SERVER_H_ */
@@ -0,0 +1,451 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Scpi server acquisition sequence SCPI commands implementation
+ *
+ * ACQ:SEQ:START arms the acquisition with the source of ACQ:SEQ:TRIG and allocates a ring of
+ * ACQ:SEQ:N records of ACQ:SEQ:LEN samples of both channels. The tick of the event loop polls the
+ * acquisition like the calibration does, a capture is complete once it has triggered and the
+ * write pointer has stopped for two sample periods. The latest ACQ:SEQ:LEN samples are then
+ * copied into the next record with the trigger position, and the acquisition is armed again right
+ * away, so the captures do not wait for the client.
+ *
+ * While the ring is full a complete capture is left in the buffer and the acquisition is not armed
+ * again, triggers are missed until ACQ:SEQ:DATA? takes records. ACQ:SEQ:STAT? counts these stalls.
+ * ACQ:SEQ:DATA? returns the oldest records as one binary block of rp_scpi_seq_header_t and samples.
+ *
+ * The sequence and the stream share the tick, only one of them runs at a time. The other ACQ
+ * commands change the acquisition of a running sequence.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/uio.h>
+
+#include "sequence.h"
+#include "acquire.h"
+#include "common.h"
+#include "scpi-server.h"
+
+#include "scpi/parser.h"
+
+#include "redpitaya/rp.h"
+
+#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+
+#define SEQ_LEN_MIN         64
+#define SEQ_LEN_MAX         ADC_BUFFER_SIZE
+#define SEQ_RECORDS_MAX     4096
+/* Samples of all records, 64 MB */
+#define SEQ_MEMORY_MAX      (64 * 1024 * 1024)
+/* Records returned by one ACQ:SEQ:DATA? at most */
+#define SEQ_DRAIN_MAX       64
+/* Period of polling the acquisition [us] */
+#define SEQ_TICK_US         100
+
+/* Sampling period [ns] */
+#define SEQ_SAMPLE_PERIOD   8
+
+/* Settings */
+static uint32_t seq_records = 16;
+static uint32_t seq_len = ADC_BUFFER_SIZE;
+static rp_acq_trig_src_t seq_trig_src = RP_TRIG_SRC_CHA_PE;
+
+static bool seq_running = false;
+static uint64_t seq_period_ns;
+
+/* Ring of records, the tick writes the head and ACQ:SEQ:DATA? takes the tail */
+static rp_scpi_seq_header_t *ring_header = NULL;
+static int16_t *ring_data = NULL;       // [records][2][len]
+static uint32_t ring_len;               // records
+static uint32_t ring_samples;           // samples per channel of a record
+static uint32_t ring_head;
+static uint32_t ring_tail;
+
+/* Capture being polled */
+static uint32_t last_wp;
+static uint64_t last_wp_ns;             // time the write pointer was first seen at last_wp
+static bool stalled;
+
+static uint64_t seq_captured;
+static uint64_t stat_stalls;
+
+
+static uint64_t getTimeNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int16_t *recordData(uint32_t index, int ch) {
+    return ring_data + ((size_t)(index % ring_len) * 2 + ch) * ring_samples;
+}
+
+static void freeRing() {
+    free(ring_header);
+    free(ring_data);
+    ring_header = NULL;
+    ring_data = NULL;
+    ring_len = 0;
+    ring_head = 0;
+    ring_tail = 0;
+}
+
+static int arm() {
+    int result = rp_AcqStart();
+
+    if (RP_OK == result) {
+        result = rp_AcqSetTriggerSrc(seq_trig_src);
+    }
+    last_wp = UINT32_MAX;
+    stalled = false;
+    return result;
+}
+
+static void seqTick();
+
+static int stopSequence() {
+    RP_SetTick(seqTick, 0);
+    seq_running = false;
+    return rp_AcqStop();
+}
+
+/**
+ * Copies the complete capture into the head record.
+ */
+static int takeRecord() {
+    rp_scpi_seq_header_t *header = &ring_header[ring_head % ring_len];
+    uint32_t trig_pos, pre, size;
+    int result;
+
+    if ((result = rp_AcqGetWritePointerAtTrig(&trig_pos)) != RP_OK ||
+        (result = rp_AcqGetPreTriggerCounter(&pre)) != RP_OK) {
+        return result;
+    }
+    for (int ch = 0; ch < 2; ch++) {
+        size = ring_samples;
+        result = rp_AcqGetLatestDataRaw(ch, &size, recordData(ring_head, ch));
+        if (result != RP_OK) {
+            return result;
+        }
+    }
+
+    // The record ends with the sample at the write pointer
+    uint32_t start = (last_wp + 1 + ADC_BUFFER_SIZE - ring_samples) % ADC_BUFFER_SIZE;
+    int32_t trigger = (trig_pos + ADC_BUFFER_SIZE - start) % ADC_BUFFER_SIZE;
+
+    if (trigger >= (int32_t)ring_samples) {
+        trigger -= ADC_BUFFER_SIZE;
+    }
+
+    header->magic = RP_SEQ_MAGIC;
+    header->samples = ring_samples;
+    header->seq = seq_captured++;
+    // The write pointer stopped after the samples from the trigger to the end of the record
+    header->time_ns = last_wp_ns - (uint64_t)(ring_samples - 1 - trigger) * seq_period_ns;
+    header->trigger = trigger;
+    header->pre = pre;
+
+    ring_head++;
+    return RP_OK;
+}
+
+/**
+ * Takes the capture if it is complete and arms the acquisition again.
+ */
+static int pollCapture() {
+    rp_acq_trig_state_t state;
+    uint32_t wp;
+    uint64_t now = getTimeNs();
+    int result;
+
+    if ((result = rp_AcqGetWritePointer(&wp)) != RP_OK ||
+        (result = rp_AcqGetTriggerState(&state)) != RP_OK) {
+        return result;
+    }
+
+    if (wp != last_wp) {
+        last_wp = wp;
+        last_wp_ns = now;
+        return RP_OK;
+    }
+    if (state != RP_TRIG_STATE_TRIGGERED || now - last_wp_ns < 2 * seq_period_ns) {
+        return RP_OK;
+    }
+
+    if (ring_head - ring_tail >= ring_len) {
+        // The capture stays in the buffer until a record is taken
+        if (!stalled) {
+            stalled = true;
+            stat_stalls++;
+        }
+        return RP_OK;
+    }
+
+    if ((result = takeRecord()) != RP_OK) {
+        return result;
+    }
+    return arm();
+}
+
+/**
+ * Polls the capture, called by the event loop every SEQ_TICK_US.
+ */
+static void seqTick() {
+    int result = pollCapture();
+
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ Failed to take the capture: %s\n", rp_GetError(result));
+        stopSequence();
+    }
+}
+
+scpi_result_t RP_AcqSeqRecords(scpi_t *context) {
+    uint32_t value;
+
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:N is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    if (seq_running) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:N Sequence is running.\n");
+        return SCPI_RES_ERR;
+    }
+    if (value < 1 || value > SEQ_RECORDS_MAX) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:N parameter records is invalid.\n");
+        return SCPI_RES_ERR;
+    }
+
+    seq_records = value;
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:N Successfully set records.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqSeqRecordsQ(scpi_t *context) {
+    SCPI_ResultUInt32Base(context, seq_records, 10);
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:N? Successfully returned records.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqSeqLength(scpi_t *context) {
+    uint32_t value;
+
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:LEN is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    if (seq_running) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:LEN Sequence is running.\n");
+        return SCPI_RES_ERR;
+    }
+    if (value < SEQ_LEN_MIN || value > SEQ_LEN_MAX) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:LEN parameter record length is invalid.\n");
+        return SCPI_RES_ERR;
+    }
+
+    seq_len = value;
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:LEN Successfully set record length.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqSeqLengthQ(scpi_t *context) {
+    SCPI_ResultUInt32Base(context, seq_len, 10);
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:LEN? Successfully returned record length.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqSeqTriggerSrc(scpi_t *context) {
+    int32_t trig_src;
+
+    if (!SCPI_ParamChoice(context, scpi_RpTrigSrc, &trig_src, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:TRIG is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    if (seq_running) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:TRIG Sequence is running.\n");
+        return SCPI_RES_ERR;
+    }
+    if (trig_src == RP_TRIG_SRC_DISABLED) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:TRIG parameter trigger source is invalid.\n");
+        return SCPI_RES_ERR;
+    }
+
+    seq_trig_src = trig_src;
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:TRIG Successfully set trigger source.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqSeqTriggerSrcQ(scpi_t *context) {
+    const char *trig_name;
+
+    if (!SCPI_ChoiceToName(scpi_RpTrigSrc, seq_trig_src, &trig_name)) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:TRIG? Failed to parse trigger source.\n");
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultMnemonic(context, trig_name);
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:TRIG? Successfully returned trigger source.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqSeqStart(scpi_t *context) {
+    uint32_t decimation;
+    int result;
+
+    if (seq_running) {
+        stopSequence();
+    }
+    if ((uint64_t)seq_records * seq_len * 2 * sizeof(int16_t) > SEQ_MEMORY_MAX) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:START Records do not fit into %d MB.\n", SEQ_MEMORY_MAX >> 20);
+        return SCPI_RES_ERR;
+    }
+
+    // The tick is taken first, a running stream must not be disturbed
+    if (RP_SetTick(seqTick, SEQ_TICK_US)) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:START Failed to start polling the acquisition.\n");
+        return SCPI_RES_ERR;
+    }
+
+    // Records of the last sequence that were not taken are discarded
+    freeRing();
+    ring_header = calloc(seq_records, sizeof(rp_scpi_seq_header_t));
+    ring_data = malloc((size_t)seq_records * seq_len * 2 * sizeof(int16_t));
+    if (ring_header == NULL || ring_data == NULL) {
+        freeRing();
+        RP_SetTick(seqTick, 0);
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:START Failed to allocate the records.\n");
+        return SCPI_RES_ERR;
+    }
+    // The pages are faulted in now and not by the first captures
+    memset(ring_data, 0, (size_t)seq_records * seq_len * 2 * sizeof(int16_t));
+    ring_len = seq_records;
+    ring_samples = seq_len;
+
+    result = rp_AcqGetDecimationFactor(&decimation);
+    if (RP_OK == result) {
+        seq_period_ns = (uint64_t)SEQ_SAMPLE_PERIOD * decimation;
+        result = arm();
+    }
+    if (RP_OK != result) {
+        freeRing();
+        RP_SetTick(seqTick, 0);
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:START Failed to arm the acquisition: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    seq_captured = 0;
+    stat_stalls = 0;
+    seq_running = true;
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:START Successfully started the sequence.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqSeqStop(scpi_t *context) {
+    if (!seq_running) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:STOP Sequence is not running.\n");
+        return SCPI_RES_ERR;
+    }
+
+    // The records taken so far are kept for ACQ:SEQ:DATA?
+    int result = stopSequence();
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:STOP Failed to stop the acquisition: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:STOP Successfully stopped the sequence.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqSeqCountQ(scpi_t *context) {
+    SCPI_ResultUInt32Base(context, ring_head - ring_tail, 10);
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:COUNT? Successfully returned records.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqSeqStatQ(scpi_t *context) {
+    // Captures taken, records not taken by the client yet, stalls of a full ring
+    SCPI_ResultUInt32Base(context, (uint32_t)seq_captured, 10);
+    SCPI_ResultUInt32Base(context, ring_head - ring_tail, 10);
+    SCPI_ResultUInt32Base(context, (uint32_t)stat_stalls, 10);
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:STAT? Successfully returned sequence statistics.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqSeqDataQ(scpi_t *context) {
+    uint32_t max;
+
+    if (!SCPI_ParamUInt32(context, &max, false)) {
+        max = SEQ_DRAIN_MAX;
+    }
+    if (context->user_context == NULL) {
+        RP_LOG(LOG_ERR, "*ACQ:SEQ:DATA? No connection.\n");
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t count = MIN(MIN(max, SEQ_DRAIN_MAX), ring_head - ring_tail);
+    size_t data_len = (size_t)ring_samples * sizeof(int16_t);
+    size_t len = count * (sizeof(rp_scpi_seq_header_t) + 2 * data_len);
+    struct iovec iov[2 + 3 * SEQ_DRAIN_MAX];
+    char block[16];
+    int digits = snprintf(block + 2, sizeof(block) - 2, "%zu", len);
+    int cnt = 0;
+
+    block[0] = '#';
+    block[1] = '0' + digits;
+    iov[cnt].iov_base = block;
+    iov[cnt++].iov_len = 2 + digits;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t index = ring_tail + i;
+        rp_scpi_seq_header_t *header = &ring_header[index % ring_len];
+
+        iov[cnt].iov_base = header;
+        iov[cnt++].iov_len = sizeof(*header);
+        for (int ch = 0; ch < 2; ch++) {
+            iov[cnt].iov_base = recordData(index, ch);
+            iov[cnt++].iov_len = data_len;
+        }
+
+        // The records are taken, so they are swapped in place
+        if (RP_AcqNeedsSwap()) {
+            header->magic = __builtin_bswap32(header->magic);
+            header->samples = __builtin_bswap32(header->samples);
+            header->seq = __builtin_bswap64(header->seq);
+            header->time_ns = __builtin_bswap64(header->time_ns);
+            header->trigger = (int32_t)__builtin_bswap32((uint32_t)header->trigger);
+            header->pre = __builtin_bswap32(header->pre);
+            RP_SwapBytes(recordData(index, 0), sizeof(int16_t), 2 * ring_samples);
+        }
+    }
+    iov[cnt].iov_base = "\r\n";
+    iov[cnt++].iov_len = 2;
+
+    // The records are taken even if the connection failed, they may be swapped already
+    ring_tail += count;
+    if (!RP_ConnWritev((scpi_conn_t *)context->user_context, iov, cnt)) {
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:SEQ:DATA? Successfully returned records.\n");
+    return SCPI_RES_OK;
+}
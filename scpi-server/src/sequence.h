@@ -0,0 +1,51 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Scpi server acquisition sequence SCPI commands interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+
+#ifndef SEQUENCE_H_
+#define SEQUENCE_H_
+
+#include <stdint.h>
+
+#include "scpi/types.h"
+
+/* Identifies the header of each record, "RPSQ" in ASCII */
+#define RP_SEQ_MAGIC        0x52505351
+
+/**
+ * Header of each record returned by ACQ:SEQ:DATA?, in the byte order set by ACQ:DATA:BORDER.
+ * The int16 ADC counts of channel 1 and then of channel 2 follow.
+ */
+typedef struct {
+    uint32_t magic;         // RP_SEQ_MAGIC
+    uint32_t samples;       // samples per channel in this record
+    uint64_t seq;           // capture number since ACQ:SEQ:START
+    uint64_t time_ns;       // trigger time on CLOCK_MONOTONIC, estimated within one tick
+    int32_t trigger;        // index of the trigger sample in the record, negative if before it
+    uint32_t pre;           // samples written between arming and the trigger, older ones are stale
+} rp_scpi_seq_header_t;
+
+scpi_result_t RP_AcqSeqRecords(scpi_t *context);
+scpi_result_t RP_AcqSeqRecordsQ(scpi_t *context);
+scpi_result_t RP_AcqSeqLength(scpi_t *context);
+scpi_result_t RP_AcqSeqLengthQ(scpi_t *context);
+scpi_result_t RP_AcqSeqTriggerSrc(scpi_t *context);
+scpi_result_t RP_AcqSeqTriggerSrcQ(scpi_t *context);
+scpi_result_t RP_AcqSeqStart(scpi_t *context);
+scpi_result_t RP_AcqSeqStop(scpi_t *context);
+scpi_result_t RP_AcqSeqCountQ(scpi_t *context);
+scpi_result_t RP_AcqSeqStatQ(scpi_t *context);
+scpi_result_t RP_AcqSeqDataQ(scpi_t *context);
+
+#endif /* SEQUENCE_H_ */
@@ -0,0 +1,420 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Scpi server acquisition streaming SCPI commands implementation
+ *
+ * ACQ:STREAM:START starts the gapless acquisition stream of the library, with software
+ * decimation if ACQ:STREAM:DEC is above 1. The tick of the event loop takes the queued blocks,
+ * collects the samples of the channels in ACQ:STREAM:CH into frames of ACQ:STREAM:BLOCK samples
+ * and pushes each frame with a rp_scpi_stream_header_t to the data connection on DATA_PORT.
+ *
+ * Frames are dropped while the data connection has more than STREAM_QUEUE_MAX bytes queued, or
+ * while there is no data connection at all. Dropped frames are a gap of the frame sequence
+ * numbers, acquisition blocks lost by overruns are reported by the lost field of the next frame,
+ * whose samples start after the gap. ACQ:STREAM:STAT? returns the counts.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "stream.h"
+#include "acquire.h"
+#include "common.h"
+#include "scpi-server.h"
+
+#include "scpi/parser.h"
+
+#include "redpitaya/rp.h"
+
+#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+
+#define STREAM_BLOCK_MIN    64
+#define STREAM_BLOCK_MAX    ADC_BUFFER_SIZE
+#define STREAM_FACTOR_MAX   (50 * 256)
+
+/* Blocks of the library queue, 2 MB hold 4 ms of the undecimated stream */
+#define STREAM_RING_LEN     128
+/* Period of taking the queued blocks [us] */
+#define STREAM_TICK_US      1000
+/* Frames are dropped above this many bytes queued for the data connection */
+#define STREAM_QUEUE_MAX    (4 * 1024 * 1024)
+
+enum {
+    STREAM_FORMAT_RAW = 0,
+    STREAM_FORMAT_VOLTS = 1,
+};
+
+/* Settings */
+static uint32_t stream_factor = 1;
+static uint32_t stream_block_len = RP_ACQ_STREAM_BLOCK_LEN;
+static uint32_t stream_channels = 0x3;
+
+static bool stream_running = false;
+static uint16_t stream_format;
+
+/* Input of the tick */
+static rp_acq_stream_block_t stream_block;
+static float stream_decim[2][RP_ACQ_STREAM_BLOCK_LEN];
+
+/* Frame being collected */
+static union {
+    float v[2][STREAM_BLOCK_MAX];
+    int16_t raw[2][STREAM_BLOCK_MAX];
+} frame;
+static uint32_t frame_len;          // samples per channel collected
+static uint64_t frame_sample;       // number of the first sample of the frame
+static uint32_t frame_lost;         // blocks lost right before the frame
+
+static uint64_t stream_sample;      // number of the next sample
+static uint64_t stream_seq;         // sequence number of the next frame
+
+static uint64_t stat_frames;
+static uint64_t stat_dropped;
+static uint64_t stat_lost;
+
+
+static void sendFrame() {
+    if (!frame_len) {
+        return;
+    }
+
+    scpi_conn_t *conn = RP_DataConn();
+    size_t elem_size = stream_format == STREAM_FORMAT_RAW ? sizeof(int16_t) : sizeof(float);
+
+    if (conn == NULL || RP_ConnQueued(conn) > STREAM_QUEUE_MAX) {
+        stat_dropped++;
+    }
+    else {
+        rp_scpi_stream_header_t header = {
+            .magic = RP_STREAM_MAGIC,
+            .samples = frame_len,
+            .seq = stream_seq,
+            .sample = frame_sample,
+            .lost = frame_lost,
+            .channels = stream_channels,
+            .format = stream_format,
+        };
+        struct iovec iov[3];
+        int cnt = 0;
+
+        iov[cnt].iov_base = &header;
+        iov[cnt++].iov_len = sizeof(header);
+        for (int ch = 0; ch < 2; ch++) {
+            if (stream_channels & (1 << ch)) {
+                iov[cnt].iov_base = stream_format == STREAM_FORMAT_RAW ? (void *)frame.raw[ch] : (void *)frame.v[ch];
+                iov[cnt++].iov_len = frame_len * elem_size;
+            }
+        }
+
+        if (RP_AcqNeedsSwap()) {
+            header.magic = __builtin_bswap32(header.magic);
+            header.samples = __builtin_bswap32(header.samples);
+            header.seq = __builtin_bswap64(header.seq);
+            header.sample = __builtin_bswap64(header.sample);
+            header.lost = __builtin_bswap32(header.lost);
+            header.channels = __builtin_bswap16(header.channels);
+            header.format = __builtin_bswap16(header.format);
+            for (int i = 1; i < cnt; i++) {
+                RP_SwapBytes(iov[i].iov_base, elem_size, frame_len);
+            }
+        }
+
+        if (RP_ConnWritev(conn, iov, cnt)) {
+            stat_frames++;
+        }
+        else {
+            stat_dropped++;
+        }
+    }
+
+    stream_seq++;
+    frame_len = 0;
+    frame_lost = 0;
+}
+
+/**
+ * Appends samples to the frame, full frames are sent. raw is used for the RAW format, raw and
+ * scale for Volts without software decimation, and volts with it.
+ */
+static void appendSamples(int16_t *raw[2], const float scale[2], float *volts[2], uint32_t n) {
+    uint32_t done = 0;
+
+    while (done < n) {
+        uint32_t k = MIN(n - done, stream_block_len - frame_len);
+
+        if (!frame_len) {
+            frame_sample = stream_sample;
+        }
+        for (int ch = 0; ch < 2; ch++) {
+            if (!(stream_channels & (1 << ch))) {
+                continue;
+            }
+            if (stream_format == STREAM_FORMAT_RAW) {
+                memcpy(frame.raw[ch] + frame_len, raw[ch] + done, k * sizeof(int16_t));
+            }
+            else if (volts) {
+                memcpy(frame.v[ch] + frame_len, volts[ch] + done, k * sizeof(float));
+            }
+            else {
+                for (uint32_t i = 0; i < k; i++) {
+                    frame.v[ch][frame_len + i] = raw[ch][done + i] * scale[ch];
+                }
+            }
+        }
+        frame_len += k;
+        stream_sample += k;
+        done += k;
+
+        if (frame_len == stream_block_len) {
+            sendFrame();
+        }
+    }
+}
+
+/**
+ * A gap in the acquisition ends the current frame, the next one starts after the gap.
+ */
+static void skipBlocks(uint64_t lost) {
+    sendFrame();
+    stream_sample += lost * RP_ACQ_STREAM_BLOCK_LEN / stream_factor;
+    frame_lost += lost;
+    stat_lost += lost;
+}
+
+static void streamTick();
+
+static int stopStream() {
+    int result;
+
+    RP_SetTick(streamTick, 0);
+    if (stream_factor > 1) {
+        result = rp_AcqDecimStop();
+    }
+    else {
+        result = rp_AcqStreamStop(NULL, NULL);
+    }
+    stream_running = false;
+
+    // The samples collected so far are sent
+    sendFrame();
+    return result;
+}
+
+/**
+ * Takes all queued blocks, called by the event loop every STREAM_TICK_US.
+ */
+static void streamTick() {
+    for (;;) {
+        int result;
+
+        if (stream_factor > 1) {
+            uint32_t size = RP_ACQ_STREAM_BLOCK_LEN;
+            uint64_t lost;
+            float *volts[2] = { stream_decim[0], stream_decim[1] };
+
+            result = rp_AcqDecimRead(stream_decim[0], stream_decim[1], &size, &lost, 0);
+            if (result == RP_OK) {
+                if (lost) {
+                    skipBlocks(lost);
+                }
+                appendSamples(NULL, NULL, volts, size);
+            }
+        }
+        else {
+            result = rp_AcqStreamRead(&stream_block, 0);
+            if (result == RP_OK) {
+                int16_t *raw[2] = { stream_block.data[0], stream_block.data[1] };
+
+                if (stream_block.lost) {
+                    skipBlocks(stream_block.lost);
+                }
+                appendSamples(raw, stream_block.scale, NULL, RP_ACQ_STREAM_BLOCK_LEN);
+            }
+        }
+
+        if (result == RP_ETMO) {
+            break;
+        }
+        if (result != RP_OK) {
+            RP_LOG(LOG_ERR, "*ACQ:STREAM Failed to read the stream: %s\n", rp_GetError(result));
+            stopStream();
+            break;
+        }
+    }
+}
+
+scpi_result_t RP_AcqStreamDecimation(scpi_t *context) {
+    uint32_t value;
+
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:DEC is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    if (stream_running) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:DEC Stream is running.\n");
+        return SCPI_RES_ERR;
+    }
+    if (value < 1 || value > STREAM_FACTOR_MAX) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:DEC parameter decimation is invalid.\n");
+        return SCPI_RES_ERR;
+    }
+
+    stream_factor = value;
+
+    RP_LOG(LOG_INFO, "*ACQ:STREAM:DEC Successfully set decimation.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqStreamDecimationQ(scpi_t *context) {
+    SCPI_ResultUInt32Base(context, stream_factor, 10);
+
+    RP_LOG(LOG_INFO, "*ACQ:STREAM:DEC? Successfully returned decimation.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqStreamBlock(scpi_t *context) {
+    uint32_t value;
+
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:BLOCK is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    if (stream_running) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:BLOCK Stream is running.\n");
+        return SCPI_RES_ERR;
+    }
+    if (value < STREAM_BLOCK_MIN || value > STREAM_BLOCK_MAX) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:BLOCK parameter block size is invalid.\n");
+        return SCPI_RES_ERR;
+    }
+
+    stream_block_len = value;
+
+    RP_LOG(LOG_INFO, "*ACQ:STREAM:BLOCK Successfully set block size.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqStreamBlockQ(scpi_t *context) {
+    SCPI_ResultUInt32Base(context, stream_block_len, 10);
+
+    RP_LOG(LOG_INFO, "*ACQ:STREAM:BLOCK? Successfully returned block size.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqStreamChannels(scpi_t *context) {
+    uint32_t value;
+
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:CH is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    if (stream_running) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:CH Stream is running.\n");
+        return SCPI_RES_ERR;
+    }
+    if (value < 1 || value > 3) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:CH parameter channel mask is invalid.\n");
+        return SCPI_RES_ERR;
+    }
+
+    stream_channels = value;
+
+    RP_LOG(LOG_INFO, "*ACQ:STREAM:CH Successfully set channel mask.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqStreamChannelsQ(scpi_t *context) {
+    SCPI_ResultUInt32Base(context, stream_channels, 10);
+
+    RP_LOG(LOG_INFO, "*ACQ:STREAM:CH? Successfully returned channel mask.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqStreamStart(scpi_t *context) {
+    int result;
+
+    if (stream_running) {
+        stopStream();
+    }
+
+    // The tick is taken first, an acquisition sequence must not be disturbed
+    if (RP_SetTick(streamTick, STREAM_TICK_US)) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:START Failed to start taking the blocks.\n");
+        return SCPI_RES_ERR;
+    }
+
+    if (stream_factor > 1) {
+        result = rp_AcqDecimStart(stream_factor, STREAM_RING_LEN);
+    }
+    else {
+        result = rp_AcqStreamStart(STREAM_RING_LEN);
+    }
+    if (RP_OK != result) {
+        RP_SetTick(streamTick, 0);
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:START Failed to start the stream: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    // The decimated stream is in Volts only
+    stream_format = (stream_factor == 1 && unit == RP_SCPI_RAW) ? STREAM_FORMAT_RAW : STREAM_FORMAT_VOLTS;
+    frame_len = 0;
+    frame_lost = 0;
+    stream_sample = 0;
+    stream_seq = 0;
+    stat_frames = 0;
+    stat_dropped = 0;
+    stat_lost = 0;
+    stream_running = true;
+
+    RP_LOG(LOG_INFO, "*ACQ:STREAM:START Successfully started the stream.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqStreamStop(scpi_t *context) {
+    if (!stream_running) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:STOP Stream is not running.\n");
+        return SCPI_RES_ERR;
+    }
+
+    // Blocks queued before the stop are still sent
+    streamTick();
+    if (!stream_running) {
+        return SCPI_RES_ERR;
+    }
+
+    int result = stopStream();
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:STREAM:STOP Failed to stop the stream: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:STREAM:STOP Successfully stopped the stream.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqStreamStatQ(scpi_t *context) {
+    // Frames sent, frames dropped, acquisition blocks lost
+    SCPI_ResultUInt32Base(context, (uint32_t)stat_frames, 10);
+    SCPI_ResultUInt32Base(context, (uint32_t)stat_dropped, 10);
+    SCPI_ResultUInt32Base(context, (uint32_t)stat_lost, 10);
+
+    RP_LOG(LOG_INFO, "*ACQ:STREAM:STAT? Successfully returned stream statistics.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqStreamPortQ(scpi_t *context) {
+    SCPI_ResultUInt32Base(context, DATA_PORT, 10);
+
+    RP_LOG(LOG_INFO, "*ACQ:STREAM:PORT? Successfully returned data port.\n");
+    return SCPI_RES_OK;
+}
@@ -0,0 +1,51 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya Scpi server acquisition streaming SCPI commands interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stdint.h>
+
+#include "scpi/types.h"
+
+/* Identifies the header of each streamed frame, "RPST" in ASCII */
+#define RP_STREAM_MAGIC     0x52505354
+
+/**
+ * Header of each frame sent on the data connection, in the byte order set by ACQ:DATA:BORDER.
+ * The samples of the channels in the mask follow, channel 1 first.
+ */
+typedef struct {
+    uint32_t magic;         // RP_STREAM_MAGIC
+    uint32_t samples;       // samples per channel in this frame
+    uint64_t seq;           // frame sequence number, frames dropped for a slow client are a gap
+    uint64_t sample;        // number of the first sample since ACQ:STREAM:START, at the output rate
+    uint32_t lost;          // acquisition blocks lost by overruns right before this frame
+    uint16_t channels;      // channel mask, bit 0 is channel 1
+    uint16_t format;        // 0 - int16 ADC counts, 1 - float32 Volts
+} rp_scpi_stream_header_t;
+
+scpi_result_t RP_AcqStreamDecimation(scpi_t *context);
+scpi_result_t RP_AcqStreamDecimationQ(scpi_t *context);
+scpi_result_t RP_AcqStreamBlock(scpi_t *context);
+scpi_result_t RP_AcqStreamBlockQ(scpi_t *context);
+scpi_result_t RP_AcqStreamChannels(scpi_t *context);
+scpi_result_t RP_AcqStreamChannelsQ(scpi_t *context);
+scpi_result_t RP_AcqStreamStart(scpi_t *context);
+scpi_result_t RP_AcqStreamStop(scpi_t *context);
+scpi_result_t RP_AcqStreamStatQ(scpi_t *context);
+scpi_result_t RP_AcqStreamPortQ(scpi_t *context);
+
+#endif /* STREAM_H_ */